@@ -1,4 +1,5 @@
 #include "Data_Extractor.h"
+#include "memalloc.h"
 
 int ReadPLNZ(int block_y, int block_x, int *cof, int Y, int X)
 {
@@ -17,7 +18,7 @@ int ReadPLNZ(int block_y, int block_x, int *cof, int Y, int X)
 	return PLNZ;
 }
 
-void ExtractBit(int PLNZ, Macroblock currMB)
+void ExtractBit(int PLNZ, int mbAddrX)
 {
 	if (I_finish == 0)
 	{
@@ -89,7 +90,7 @@ void ExtractBit(int PLNZ, Macroblock currMB)
 					}
 					MD_NUM++;
 					MD_State = 0;
-					Allow_MB = currMB.mbAddrX + 1;
+					Allow_MB = mbAddrX + 1;
 					if (EMD_NUM == endInfo.MetaDataNum - 1)
 						I_finish = 1;
 				}
@@ -119,7 +120,7 @@ int ReadPLNZV(int numcoeff, int *Run)
 	return PLNZ;
 }
 
-void ExtractBitV(int PLNZ, Macroblock currMB)
+void ExtractBitV(int PLNZ, int mbAddrX)
 {
 	if (I_finish == 0)
 	{
@@ -190,7 +191,7 @@ void ExtractBitV(int PLNZ, Macroblock currMB)
 					}
 					MD_NUM++;
 					MD_State = 0;
-					Allow_MB = currMB.mbAddrX + 1;
+					Allow_MB = mbAddrX + 1;
 					if (EMD_NUM == endInfo.MetaDataNum - 1)
 						I_finish = 1;
 				}
@@ -207,11 +208,11 @@ void ExtractBitV(int PLNZ, Macroblock currMB)
 		}
 	}
 }
-void ExtractBit16(int *lev, Macroblock currMB)
+void ExtractBit16(int lev15, int mbAddrX)
 {
 	if (I_finish == 0)
 	{
-		if (lev[15] < 0)
+		if (lev15 < 0)
 			BitBuffer++;
 		else
 		{
@@ -278,7 +279,7 @@ void ExtractBit16(int *lev, Macroblock currMB)
 					}
 					MD_NUM++;
 					MD_State = 0;
-					Allow_MB = currMB.mbAddrX + 1;
+					Allow_MB = mbAddrX + 1;
 					if (EMD_NUM == endInfo.MetaDataNum - 1)
 						I_finish = 1;
 				}
@@ -294,4 +295,123 @@ void ExtractBit16(int *lev, Macroblock currMB)
 			MD_Buffer = 0;
 		}
 	}
-}
\ No newline at end of file
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    The extraction state above is shared by the whole stream and has to
+ *    see the blocks in slice order. Parsing only records the extraction
+ *    steps of a slice in its MDLog, they are replayed in slice order once
+ *    all slices of the picture are decoded, which gives the same result
+ *    when slices are decoded concurrently.
+ ************************************************************************
+ */
+static void LogExtractEvent(MDLog *log, int kind, int value, int mbAddrX, int block)
+{
+	MDEvent *event;
+
+	if (log->count == log->size)
+	{
+		int size = log->size ? 2 * log->size : 256;
+		MDEvent *events = (MDEvent *)realloc(log->event, size * sizeof(MDEvent));
+		if (events == NULL)
+			no_mem_exit("LogExtractEvent: md_log");
+		log->event = events;
+		log->size = size;
+	}
+	event = &log->event[log->count++];
+	event->mb_addr = mbAddrX;
+	event->kind = (short)kind;
+	event->value = (short)value;
+	event->block = (short)block;
+}
+
+void LogExtractFinish(Slice *currSlice, int mbAddrX)
+{
+	if (!currSlice->md_log.finish_logged)
+	{
+		LogExtractEvent(&currSlice->md_log, MD_EVENT_FINISH, 0, mbAddrX, 0);
+		currSlice->md_log.finish_logged = 1;
+	}
+}
+
+void LogExtractGate(Slice *currSlice, int mbAddrX)
+{
+	LogExtractEvent(&currSlice->md_log, MD_EVENT_GATE, 0, mbAddrX, 0);
+}
+
+void LogExtractBit(Slice *currSlice, int kind, int value, int mbAddrX, int block)
+{
+	LogExtractEvent(&currSlice->md_log, kind, value, mbAddrX, block);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Marks the block of a step in the payload columns of -mbmeta if a
+ *    bit is extracted from it, called before the ExtractBit* function.
+ ************************************************************************
+ */
+static void MarkPayloadBit(MDEvent *event, int bit, uint16 *payload_mask, uint16 *payload_bits)
+{
+	if ((payload_mask != NULL) && (I_finish == 0))
+	{
+		payload_mask[event->mb_addr] |= (uint16)(1 << event->block);
+		if (bit)
+			payload_bits[event->mb_addr] |= (uint16)(1 << event->block);
+	}
+}
+
+void ReplayExtractLog(MDLog *log, uint16 *payload_mask, uint16 *payload_bits)
+{
+	int gate_open = 0;
+	int i;
+
+	for (i = 0; i < log->count; i++)
+	{
+		MDEvent *event = &log->event[i];
+		switch (event->kind)
+		{
+		case MD_EVENT_FINISH:
+			I_finish1 = 1;
+			break;
+		case MD_EVENT_GATE:
+			gate_open = (I_finish1 == 0) && (Allow_MB <= event->mb_addr);
+			if (gate_open)
+				Allow_MB = 0;
+			break;
+		case MD_EVENT_BIT:
+			if (gate_open && (Allow_MB == 0))
+			{
+				MarkPayloadBit(event, event->value % 2, payload_mask, payload_bits);
+				ExtractBit(event->value, event->mb_addr);
+			}
+			break;
+		case MD_EVENT_BITV:
+			if (gate_open && (Allow_MB == 0))
+			{
+				MarkPayloadBit(event, event->value % 2, payload_mask, payload_bits);
+				ExtractBitV(event->value, event->mb_addr);
+			}
+			break;
+		case MD_EVENT_BIT16:
+			if (gate_open && (Allow_MB == 0))
+			{
+				MarkPayloadBit(event, event->value >= 0, payload_mask, payload_bits);
+				ExtractBit16(event->value, event->mb_addr);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+	log->count = 0;
+	log->finish_logged = 0;
+}
+
+void FreeExtractLog(MDLog *log)
+{
+	free(log->event);
+	memset(log, 0, sizeof(MDLog));
+}
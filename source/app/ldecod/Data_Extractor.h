@@ -2,7 +2,20 @@
 #include "My_Entropy.h"
 
 int ReadPLNZ(int block_y, int block_x, int *cof, int Y, int X);
-void ExtractBit(int PLNZ, Macroblock currMB);
+void ExtractBit(int PLNZ, int mbAddrX);
 int ReadPLNZV(int numcoeff, int *Run);
-void ExtractBitV(int PLNZ, Macroblock currMB);
-void ExtractBit16(int *lev, Macroblock currMB);
\ No newline at end of file
+void ExtractBitV(int PLNZ, int mbAddrX);
+void ExtractBit16(int lev15, int mbAddrX);
+
+// kinds of MDEvent
+#define MD_EVENT_FINISH  0   // I_finish1 = 1
+#define MD_EVENT_GATE    1   // start of a block checked against I_finish1 and Allow_MB
+#define MD_EVENT_BIT     2   // ExtractBit(value)
+#define MD_EVENT_BITV    3   // ExtractBitV(value)
+#define MD_EVENT_BIT16   4   // ExtractBit16(value)
+
+void LogExtractFinish(Slice *currSlice, int mbAddrX);
+void LogExtractGate(Slice *currSlice, int mbAddrX);
+void LogExtractBit(Slice *currSlice, int kind, int value, int mbAddrX, int block);
+void ReplayExtractLog(MDLog *log, uint16 *payload_mask, uint16 *payload_bits);
+void FreeExtractLog(MDLog *log);
\ No newline at end of file
@@ -24,11 +24,143 @@
 #include "transform.h"
 #include "quant.h"
 #include "memalloc.h"
+#include "cpu_features.h"
+
+ITransKernels itrans_kernels;
+
+/*!
+ ***********************************************************************
+ * \brief
+ *    Copies a 4x4 prediction block to the reconstruction
+ ***********************************************************************
+ */
+static inline void copy_pred_4x4(imgpel **mb_rec, imgpel **mb_pred, int pos_y, int pos_x)
+{
+  int j;
+
+  for (j = pos_y; j < pos_y + BLOCK_SIZE; ++j)
+    memcpy(&mb_rec[j][pos_x], &mb_pred[j][pos_x], BLOCK_SIZE * sizeof(imgpel));
+}
+
+/*!
+ ***********************************************************************
+ * \brief
+ *    Adds a constant residual to an n x n prediction block. This is the
+ *    inverse transform of a block whose only non-zero coefficient is DC.
+ ***********************************************************************
+ */
+static void dc_add(imgpel **mb_rec, imgpel **mb_pred, int pos_y, int pos_x, int size, int dc, int max_imgpel_value)
+{
+  int i, j;
+
+  for (j = pos_y; j < pos_y + size; ++j)
+  {
+    for (i = pos_x; i < pos_x + size; ++i)
+      mb_rec[j][i] = (imgpel) iClip1(max_imgpel_value, mb_pred[j][i] + dc);
+  }
+}
+
+/*!
+ ***********************************************************************
+ * \brief
+ *    Returns 1 if all AC coefficients of an n x n block are zero
+ ***********************************************************************
+ */
+static int ac_is_zero(int **cof, int pos_y, int pos_x, int size)
+{
+  int i, j;
+  int acc = 0;
+
+  for (i = pos_x + 1; i < pos_x + size; ++i)
+    acc |= cof[pos_y][i];
+
+  for (j = pos_y + 1; j < pos_y + size; ++j)
+  {
+    for (i = pos_x; i < pos_x + size; ++i)
+      acc |= cof[j][i];
+  }
+  return (acc == 0);
+}
+
+/*!
+ ***********************************************************************
+ * \brief
+ *    Inverse 4x4 transform of cof, added to the prediction and clipped
+ ***********************************************************************
+ */
+static void itrans_add_4x4(imgpel **mb_rec, imgpel **mb_pred, int **cof, int pos_y, int pos_x, int max_imgpel_value)
+{
+  if (ac_is_zero(cof, pos_y, pos_x, BLOCK_SIZE))
+  {
+    if (cof[pos_y][pos_x] == 0)
+      copy_pred_4x4(mb_rec, mb_pred, pos_y, pos_x);
+    else
+      dc_add(mb_rec, mb_pred, pos_y, pos_x, BLOCK_SIZE, rshift_rnd_sf(cof[pos_y][pos_x], DQ_BITS), max_imgpel_value);
+  }
+  else
+  {
+    int tmp[BLOCK_SIZE][MB_BLOCK_SIZE];
+    int *rres[BLOCK_SIZE] = { tmp[0], tmp[1], tmp[2], tmp[3] };
+
+    inverse4x4(&cof[pos_y], rres, 0, pos_x);
+    sample_reconstruct (&mb_rec[pos_y], &mb_pred[pos_y], rres, pos_x, pos_x, BLOCK_SIZE, BLOCK_SIZE, max_imgpel_value, DQ_BITS);
+  }
+}
 
 /*!
  ***********************************************************************
  * \brief
- *    Inverse 4x4 transformation, transforms cof to mb_rres
+ *    Inverse 8x8 transform of cof (in place), added to the prediction
+ *    and clipped
+ ***********************************************************************
+ */
+static void itrans_add_8x8(imgpel **mb_rec, imgpel **mb_pred, int **cof, int pos_y, int pos_x, int max_imgpel_value)
+{
+  if (ac_is_zero(cof, pos_y, pos_x, BLOCK_SIZE_8x8))
+  {
+    dc_add(mb_rec, mb_pred, pos_y, pos_x, BLOCK_SIZE_8x8, rshift_rnd_sf(cof[pos_y][pos_x], DQ_BITS_8), max_imgpel_value);
+  }
+  else
+  {
+    inverse8x8(&cof[pos_y], &cof[pos_y], pos_x);
+    sample_reconstruct (&mb_rec[pos_y], &mb_pred[pos_y], &cof[pos_y], pos_x, pos_x, BLOCK_SIZE_8x8, BLOCK_SIZE_8x8, max_imgpel_value, DQ_BITS_8);
+  }
+}
+
+/*!
+ ***********************************************************************
+ * \brief
+ *    Fills kernels with the inverse transform kernels. The C versions
+ *    are the reference; SIMD versions replace them up to the given
+ *    SimdLevel.
+ ***********************************************************************
+ */
+void set_itrans_kernels(ITransKernels *kernels, int simd_level)
+{
+  kernels->itrans_add_4x4 = itrans_add_4x4;
+  kernels->itrans_add_8x8 = itrans_add_8x8;
+
+  if (simd_level >= SIMD_SSE41)
+    init_itrans_kernels_sse41(kernels);
+  if (simd_level >= SIMD_AVX2)
+    init_itrans_kernels_avx2(kernels);
+}
+
+/*!
+ ***********************************************************************
+ * \brief
+ *    Selects the inverse transform kernels used by the decoder
+ ***********************************************************************
+ */
+void init_itrans_kernels(int simd_level)
+{
+  set_itrans_kernels(&itrans_kernels, simd_level);
+}
+
+/*!
+ ***********************************************************************
+ * \brief
+ *    Inverse 4x4 transformation of cof, reconstructed into mb_rec
  ***********************************************************************
  */
 void itrans4x4(Macroblock *currMB,   //!< current macroblock
@@ -37,11 +169,8 @@ void itrans4x4(Macroblock *currMB,   //!< current macroblock
                int joff)             //!< index to 4x4 block
 {
   Slice *currSlice = currMB->p_Slice;
-  int    **mb_rres = currSlice->mb_rres[pl];
 
-  inverse4x4(currSlice->cof[pl],mb_rres,joff,ioff);
-
-  sample_reconstruct (&currSlice->mb_rec[pl][joff], &currSlice->mb_pred[pl][joff], &mb_rres[joff], ioff, ioff, BLOCK_SIZE, BLOCK_SIZE, currMB->p_Vid->max_pel_value_comp[pl], DQ_BITS);
+  itrans_kernels.itrans_add_4x4(currSlice->mb_rec[pl], currSlice->mb_pred[pl], currSlice->cof[pl], joff, ioff, currMB->p_Vid->max_pel_value_comp[pl]);
 }
 
 /*!
@@ -644,50 +773,23 @@ void iMBtrans4x4(Macroblock *currMB, ColorPlane pl, int smb)
   else
   {
     int **cof = currSlice->cof[pl];
-    int **mb_rres = currSlice->mb_rres[pl];
-
-    if (currMB->is_intra_block == FALSE)
+    imgpel **mb_rec  = currSlice->mb_rec[pl];
+    imgpel **mb_pred = currSlice->mb_pred[pl];
+    int max_imgpel_value = currMB->p_Vid->max_pel_value_comp[pl];
+    // 4x4 blocks without coefficients only need the prediction copied. Intra 16x16 DC
+    // levels and separately coded colour planes are not tracked in the mask.
+    int64 cbp_blk = (currMB->mb_type == I16MB || currMB->p_Vid->separate_colour_plane_flag != 0) ? (int64) 0xFFFF : currMB->s_cbp[pl].blk;
+
+    for (jj = 0; jj < MB_BLOCK_SIZE; jj += BLOCK_SIZE)
     {
-      if (currMB->cbp & 0x01)
+      for (ii = 0; ii < MB_BLOCK_SIZE; ii += BLOCK_SIZE)
       {
-        inverse4x4(cof, mb_rres, 0, 0);
-        inverse4x4(cof, mb_rres, 0, 4);
-        inverse4x4(cof, mb_rres, 4, 0);
-        inverse4x4(cof, mb_rres, 4, 4);
-      }
-      if (currMB->cbp & 0x02)
-      {
-        inverse4x4(cof, mb_rres, 0, 8);
-        inverse4x4(cof, mb_rres, 0, 12);
-        inverse4x4(cof, mb_rres, 4, 8);
-        inverse4x4(cof, mb_rres, 4, 12);
-      }
-      if (currMB->cbp & 0x04)
-      {
-        inverse4x4(cof, mb_rres, 8, 0);
-        inverse4x4(cof, mb_rres, 8, 4);
-        inverse4x4(cof, mb_rres, 12, 0);
-        inverse4x4(cof, mb_rres, 12, 4);
-      }
-      if (currMB->cbp & 0x08)
-      {
-        inverse4x4(cof, mb_rres, 8, 8);
-        inverse4x4(cof, mb_rres, 8, 12);
-        inverse4x4(cof, mb_rres, 12, 8);
-        inverse4x4(cof, mb_rres, 12, 12);
-      }
-    }
-    else
-    {
-      for (jj = 0; jj < MB_BLOCK_SIZE; jj += BLOCK_SIZE)
-      {
-        inverse4x4(cof, mb_rres, jj, 0);
-        inverse4x4(cof, mb_rres, jj, 4);
-        inverse4x4(cof, mb_rres, jj, 8);
-        inverse4x4(cof, mb_rres, jj, 12);
+        if (cbp_blk & i64_power2(jj + (ii >> 2)))
+          itrans_kernels.itrans_add_4x4(mb_rec, mb_pred, cof, jj, ii, max_imgpel_value);
+        else
+          copy_pred_4x4(mb_rec, mb_pred, jj, ii);
       }
     }
-    sample_reconstruct (currSlice->mb_rec[pl], currSlice->mb_pred[pl], mb_rres, 0, 0, MB_BLOCK_SIZE, MB_BLOCK_SIZE, currMB->p_Vid->max_pel_value_comp[pl], DQ_BITS);
   }
 
   // construct picture from 4x4 blocks
@@ -781,8 +883,6 @@ void iTransform(Macroblock *currMB, ColorPlane pl, int smb)
             itrans4x4(currMB, uv, *x_pos++, *y_pos++);
             itrans4x4(currMB, uv, *x_pos  , *y_pos  );
           }
-          sample_reconstruct (mb_rec, currSlice->mb_pred[uv], currSlice->mb_rres[uv], 0, 0, 
-            p_Vid->mb_size[1][0], p_Vid->mb_size[1][1], currMB->p_Vid->max_pel_value_comp[uv], DQ_BITS);
         }
         else
         {
@@ -886,20 +986,6 @@ void copy_image_data_4x4(imgpel  **imgBuf1, imgpel  **imgBuf2, int off1, int off
   memcpy((*imgBuf1   + off1), (*imgBuf2   + off2), BLOCK_SIZE * sizeof (imgpel));
 }
 
-int CheckVertMV(Macroblock *currMB, int vec1_y, int block_size_y)
-{
-  VideoParameters *p_Vid = currMB->p_Vid;  
-  StorablePicture *dec_picture = currMB->p_Slice->dec_picture;
-  int y_pos = vec1_y>>2;
-  int maxold_y = (currMB->mb_field) ? (dec_picture->size_y >> 1) - 1 : dec_picture->size_y_m1;
-
-  if(y_pos < (-p_Vid->iLumaPadY + 2) || y_pos > (maxold_y + p_Vid->iLumaPadY - block_size_y - 2))
-    return 1;
-  else
-    return 0;
-}
-
-
 /*!
  *************************************************************************************
  * \brief
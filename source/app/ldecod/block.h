@@ -102,6 +102,22 @@ static const unsigned char subblk_offset_y[3][8][4] =
 
 static const byte decode_block_scan[16] = {0, 1, 4, 5, 2, 3, 6, 7, 8, 9, 12, 13, 10, 11, 14, 15};
 
+//! Fused inverse transform: dequantized coefficients at cof[pos_y][pos_x] plus prediction -> clipped reconstruction
+typedef void (*ITransAddFunc)(imgpel **mb_rec, imgpel **mb_pred, int **cof, int pos_y, int pos_x, int max_imgpel_value);
+
+typedef struct itrans_kernels
+{
+  ITransAddFunc itrans_add_4x4;
+  ITransAddFunc itrans_add_8x8;
+} ITransKernels;
+
+extern ITransKernels itrans_kernels;
+
+extern void init_itrans_kernels      (int simd_level);
+extern void set_itrans_kernels       (ITransKernels *kernels, int simd_level);
+extern void init_itrans_kernels_sse41(ITransKernels *kernels);
+extern void init_itrans_kernels_avx2 (ITransKernels *kernels);
+
 extern void iMBtrans4x4(Macroblock *currMB, ColorPlane pl, int smb);
 extern void iMBtrans8x8(Macroblock *currMB, ColorPlane pl);
 
@@ -122,6 +138,5 @@ extern void copy_image_data       (imgpel  **imgBuf1, imgpel  **imgBuf2, int off
 extern void copy_image_data_16x16 (imgpel  **imgBuf1, imgpel  **imgBuf2, int off1, int off2);
 extern void copy_image_data_8x8   (imgpel  **imgBuf1, imgpel  **imgBuf2, int off1, int off2);
 extern void copy_image_data_4x4   (imgpel  **imgBuf1, imgpel  **imgBuf2, int off1, int off2);
-extern int CheckVertMV(Macroblock *currMB, int vec1_y, int block_size_y);
 #endif
 
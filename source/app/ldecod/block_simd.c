@@ -0,0 +1,334 @@
+
+/*!
+ *************************************************************************************
+ * \file block_simd.c
+ *
+ * \brief
+ *    SSE4.1 and AVX2 versions of the fused inverse transform kernels of block.c
+ *
+ *    Each kernel runs the inverse transform of a 4x4 or 8x8 block of dequantized
+ *    coefficients, adds the prediction and clips in a single pass. Blocks with only
+ *    a DC coefficient reduce to adding a constant. Arithmetic is done in 32 bit
+ *    lanes, so the results are bit exact with the C versions.
+ *
+ *************************************************************************************
+ */
+#include "global.h"
+#include "block.h"
+#include "cpu_features.h"
+
+#if HAVE_X86_SIMD && (IMGTYPE == 1)
+
+#include <immintrin.h>
+
+static inline __m128i load4_pel(const imgpel *p)
+{
+  return _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *) p));
+}
+
+static inline __m128i load4_int(const int *p)
+{
+  return _mm_loadu_si128((const __m128i *) p);
+}
+
+//! stores pred + ((res + 32) >> 6) for four samples, clipped to [0, max]
+static inline void recon4(imgpel *rec, const imgpel *pred, __m128i res, __m128i rnd, __m128i max)
+{
+  __m128i v = _mm_add_epi32(load4_pel(pred), _mm_srai_epi32(_mm_add_epi32(res, rnd), 6));
+  _mm_storel_epi64((__m128i *) rec, _mm_min_epu16(_mm_packus_epi32(v, v), max));
+}
+
+//! stores pred + dc for four samples, clipped to [0, max]
+static inline void dc_add4(imgpel *rec, const imgpel *pred, __m128i dc, __m128i max)
+{
+  __m128i v = _mm_add_epi32(load4_pel(pred), dc);
+  _mm_storel_epi64((__m128i *) rec, _mm_min_epu16(_mm_packus_epi32(v, v), max));
+}
+
+static inline void transpose4_epi32(__m128i *r0, __m128i *r1, __m128i *r2, __m128i *r3)
+{
+  __m128i t0 = _mm_unpacklo_epi32(*r0, *r1);
+  __m128i t1 = _mm_unpacklo_epi32(*r2, *r3);
+  __m128i t2 = _mm_unpackhi_epi32(*r0, *r1);
+  __m128i t3 = _mm_unpackhi_epi32(*r2, *r3);
+
+  *r0 = _mm_unpacklo_epi64(t0, t1);
+  *r1 = _mm_unpackhi_epi64(t0, t1);
+  *r2 = _mm_unpacklo_epi64(t2, t3);
+  *r3 = _mm_unpackhi_epi64(t2, t3);
+}
+
+//! one dimensional 4 point inverse transform, lane wise
+static inline void ibutterfly4(__m128i *x0, __m128i *x1, __m128i *x2, __m128i *x3)
+{
+  __m128i p0 = _mm_add_epi32(*x0, *x2);
+  __m128i p1 = _mm_sub_epi32(*x0, *x2);
+  __m128i p2 = _mm_sub_epi32(_mm_srai_epi32(*x1, 1), *x3);
+  __m128i p3 = _mm_add_epi32(*x1, _mm_srai_epi32(*x3, 1));
+
+  *x0 = _mm_add_epi32(p0, p3);
+  *x1 = _mm_add_epi32(p1, p2);
+  *x2 = _mm_sub_epi32(p1, p2);
+  *x3 = _mm_sub_epi32(p0, p3);
+}
+
+/*!
+ ***********************************************************************
+ * \brief
+ *    Inverse 4x4 transform, add and clip (SSE4.1)
+ ***********************************************************************
+ */
+static void itrans_add_4x4_sse41(imgpel **mb_rec, imgpel **mb_pred, int **cof, int pos_y, int pos_x, int max_imgpel_value)
+{
+  __m128i max = _mm_set1_epi16((short) max_imgpel_value);
+  __m128i r0  = load4_int(&cof[pos_y    ][pos_x]);
+  __m128i r1  = load4_int(&cof[pos_y + 1][pos_x]);
+  __m128i r2  = load4_int(&cof[pos_y + 2][pos_x]);
+  __m128i r3  = load4_int(&cof[pos_y + 3][pos_x]);
+  __m128i ac  = _mm_or_si128(_mm_or_si128(_mm_blend_epi16(r0, _mm_setzero_si128(), 0x03), r1), _mm_or_si128(r2, r3));
+  int j;
+
+  if (_mm_testz_si128(ac, ac))
+  {
+    __m128i dc = _mm_set1_epi32(rshift_rnd_sf(cof[pos_y][pos_x], DQ_BITS));
+    for (j = pos_y; j < pos_y + BLOCK_SIZE; ++j)
+      dc_add4(&mb_rec[j][pos_x], &mb_pred[j][pos_x], dc, max);
+    return;
+  }
+
+  // horizontal
+  transpose4_epi32(&r0, &r1, &r2, &r3);
+  ibutterfly4(&r0, &r1, &r2, &r3);
+  // vertical
+  transpose4_epi32(&r0, &r1, &r2, &r3);
+  ibutterfly4(&r0, &r1, &r2, &r3);
+
+  {
+    __m128i rnd = _mm_set1_epi32(1 << (DQ_BITS - 1));
+    recon4(&mb_rec[pos_y    ][pos_x], &mb_pred[pos_y    ][pos_x], r0, rnd, max);
+    recon4(&mb_rec[pos_y + 1][pos_x], &mb_pred[pos_y + 1][pos_x], r1, rnd, max);
+    recon4(&mb_rec[pos_y + 2][pos_x], &mb_pred[pos_y + 2][pos_x], r2, rnd, max);
+    recon4(&mb_rec[pos_y + 3][pos_x], &mb_pred[pos_y + 3][pos_x], r3, rnd, max);
+  }
+}
+
+/*
+ ************************************************************************
+ * 8x8 inverse transform. The SSE4.1 version keeps each row in two
+ * vectors (columns 0-3 and 4-7); the AVX2 version in one.
+ ************************************************************************
+ */
+#define IBUTTERFLY8(T, add, sub, srai, p) \
+{ \
+  T a0 = add(p[0], p[4]); \
+  T a1 = sub(p[0], p[4]); \
+  T a2 = sub(p[6], srai(p[2], 1)); \
+  T a3 = add(p[2], srai(p[6], 1)); \
+  T b0 = add(a0, a3); \
+  T b2 = sub(a1, a2); \
+  T b4 = add(a1, a2); \
+  T b6 = sub(a0, a3); \
+  T b1, b3, b5, b7; \
+  a0 = sub(sub(sub(p[5], p[3]), p[7]), srai(p[7], 1)); \
+  a1 = sub(sub(add(p[1], p[7]), p[3]), srai(p[3], 1)); \
+  a2 = add(add(sub(p[7], p[1]), p[5]), srai(p[5], 1)); \
+  a3 = add(add(add(p[3], p[5]), p[1]), srai(p[1], 1)); \
+  b1 = add(a0, srai(a3, 2)); \
+  b3 = add(a1, srai(a2, 2)); \
+  b5 = sub(a2, srai(a1, 2)); \
+  b7 = sub(a3, srai(a0, 2)); \
+  p[0] = add(b0, b7); \
+  p[1] = sub(b2, b5); \
+  p[2] = add(b4, b3); \
+  p[3] = add(b6, b1); \
+  p[4] = sub(b6, b1); \
+  p[5] = sub(b4, b3); \
+  p[6] = add(b2, b5); \
+  p[7] = sub(b0, b7); \
+}
+
+static inline void ibutterfly8_sse41(__m128i *p)
+{
+  IBUTTERFLY8(__m128i, _mm_add_epi32, _mm_sub_epi32, _mm_srai_epi32, p)
+}
+
+//! transposes an 8x8 matrix held as lo[8] (columns 0-3) and hi[8] (columns 4-7)
+static inline void transpose8_epi32_sse41(__m128i *lo, __m128i *hi)
+{
+  __m128i t;
+  int k;
+
+  transpose4_epi32(&lo[0], &lo[1], &lo[2], &lo[3]);
+  transpose4_epi32(&hi[4], &hi[5], &hi[6], &hi[7]);
+  transpose4_epi32(&hi[0], &hi[1], &hi[2], &hi[3]);
+  transpose4_epi32(&lo[4], &lo[5], &lo[6], &lo[7]);
+  for (k = 0; k < 4; ++k)
+  {
+    t = hi[k];
+    hi[k] = lo[k + 4];
+    lo[k + 4] = t;
+  }
+}
+
+/*!
+ ***********************************************************************
+ * \brief
+ *    Inverse 8x8 transform, add and clip (SSE4.1)
+ ***********************************************************************
+ */
+static void itrans_add_8x8_sse41(imgpel **mb_rec, imgpel **mb_pred, int **cof, int pos_y, int pos_x, int max_imgpel_value)
+{
+  __m128i max = _mm_set1_epi16((short) max_imgpel_value);
+  __m128i lo[8], hi[8];
+  __m128i ac;
+  int j;
+
+  for (j = 0; j < BLOCK_SIZE_8x8; ++j)
+  {
+    lo[j] = load4_int(&cof[pos_y + j][pos_x    ]);
+    hi[j] = load4_int(&cof[pos_y + j][pos_x + 4]);
+  }
+
+  ac = _mm_or_si128(_mm_blend_epi16(lo[0], _mm_setzero_si128(), 0x03), hi[0]);
+  for (j = 1; j < BLOCK_SIZE_8x8; ++j)
+    ac = _mm_or_si128(ac, _mm_or_si128(lo[j], hi[j]));
+
+  if (_mm_testz_si128(ac, ac))
+  {
+    __m128i dc = _mm_set1_epi32(rshift_rnd_sf(cof[pos_y][pos_x], DQ_BITS_8));
+    for (j = pos_y; j < pos_y + BLOCK_SIZE_8x8; ++j)
+    {
+      dc_add4(&mb_rec[j][pos_x    ], &mb_pred[j][pos_x    ], dc, max);
+      dc_add4(&mb_rec[j][pos_x + 4], &mb_pred[j][pos_x + 4], dc, max);
+    }
+    return;
+  }
+
+  // horizontal: after transposing, lo[k]/hi[k] hold coefficient k of rows 0-3/4-7
+  transpose8_epi32_sse41(lo, hi);
+  ibutterfly8_sse41(lo);
+  ibutterfly8_sse41(hi);
+  // vertical
+  transpose8_epi32_sse41(lo, hi);
+  ibutterfly8_sse41(lo);
+  ibutterfly8_sse41(hi);
+
+  {
+    __m128i rnd = _mm_set1_epi32(1 << (DQ_BITS_8 - 1));
+    for (j = 0; j < BLOCK_SIZE_8x8; ++j)
+    {
+      recon4(&mb_rec[pos_y + j][pos_x    ], &mb_pred[pos_y + j][pos_x    ], lo[j], rnd, max);
+      recon4(&mb_rec[pos_y + j][pos_x + 4], &mb_pred[pos_y + j][pos_x + 4], hi[j], rnd, max);
+    }
+  }
+}
+
+static TARGET_AVX2 inline void ibutterfly8_avx2(__m256i *p)
+{
+  IBUTTERFLY8(__m256i, _mm256_add_epi32, _mm256_sub_epi32, _mm256_srai_epi32, p)
+}
+
+static TARGET_AVX2 inline void transpose8_epi32_avx2(__m256i *r)
+{
+  __m256i t[8], u[8];
+  int k;
+
+  for (k = 0; k < 8; k += 2)
+  {
+    t[k    ] = _mm256_unpacklo_epi32(r[k], r[k + 1]);
+    t[k + 1] = _mm256_unpackhi_epi32(r[k], r[k + 1]);
+  }
+  for (k = 0; k < 8; k += 4)
+  {
+    u[k    ] = _mm256_unpacklo_epi64(t[k    ], t[k + 2]);
+    u[k + 1] = _mm256_unpackhi_epi64(t[k    ], t[k + 2]);
+    u[k + 2] = _mm256_unpacklo_epi64(t[k + 1], t[k + 3]);
+    u[k + 3] = _mm256_unpackhi_epi64(t[k + 1], t[k + 3]);
+  }
+  for (k = 0; k < 4; ++k)
+  {
+    r[k    ] = _mm256_permute2x128_si256(u[k], u[k + 4], 0x20);
+    r[k + 4] = _mm256_permute2x128_si256(u[k], u[k + 4], 0x31);
+  }
+}
+
+/*!
+ ***********************************************************************
+ * \brief
+ *    Inverse 8x8 transform, add and clip (AVX2)
+ ***********************************************************************
+ */
+static TARGET_AVX2 void itrans_add_8x8_avx2(imgpel **mb_rec, imgpel **mb_pred, int **cof, int pos_y, int pos_x, int max_imgpel_value)
+{
+  __m128i max = _mm_set1_epi16((short) max_imgpel_value);
+  __m256i r[8];
+  __m256i ac, add;
+  int j;
+
+  for (j = 0; j < BLOCK_SIZE_8x8; ++j)
+    r[j] = _mm256_loadu_si256((const __m256i *) &cof[pos_y + j][pos_x]);
+
+  ac = _mm256_blend_epi32(r[0], _mm256_setzero_si256(), 0x01);
+  for (j = 1; j < BLOCK_SIZE_8x8; ++j)
+    ac = _mm256_or_si256(ac, r[j]);
+
+  if (_mm256_testz_si256(ac, ac))
+  {
+    add = _mm256_set1_epi32(rshift_rnd_sf(cof[pos_y][pos_x], DQ_BITS_8));
+    for (j = 0; j < BLOCK_SIZE_8x8; ++j)
+      r[j] = add;
+  }
+  else
+  {
+    transpose8_epi32_avx2(r);
+    ibutterfly8_avx2(r);
+    transpose8_epi32_avx2(r);
+    ibutterfly8_avx2(r);
+
+    add = _mm256_set1_epi32(1 << (DQ_BITS_8 - 1));
+    for (j = 0; j < BLOCK_SIZE_8x8; ++j)
+      r[j] = _mm256_srai_epi32(_mm256_add_epi32(r[j], add), DQ_BITS_8);
+  }
+
+  for (j = 0; j < BLOCK_SIZE_8x8; ++j)
+  {
+    __m256i v = _mm256_add_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) &mb_pred[pos_y + j][pos_x])), r[j]);
+    __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    _mm_storeu_si128((__m128i *) &mb_rec[pos_y + j][pos_x], _mm_min_epu16(packed, max));
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Installs the SSE4.1 kernels
+ ************************************************************************
+ */
+void init_itrans_kernels_sse41(ITransKernels *kernels)
+{
+  kernels->itrans_add_4x4 = itrans_add_4x4_sse41;
+  kernels->itrans_add_8x8 = itrans_add_8x8_sse41;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Installs the AVX2 kernels on top of the SSE4.1 ones
+ ************************************************************************
+ */
+void init_itrans_kernels_avx2(ITransKernels *kernels)
+{
+  kernels->itrans_add_8x8 = itrans_add_8x8_avx2;
+}
+
+#else
+
+void init_itrans_kernels_sse41(ITransKernels *kernels)
+{
+}
+
+void init_itrans_kernels_avx2(ITransKernels *kernels)
+{
+}
+
+#endif
@@ -79,9 +79,7 @@ MotionInfoContexts* create_contexts_MotionInfo(void)
 {
   MotionInfoContexts *deco_ctx;
 
-  deco_ctx = (MotionInfoContexts*) calloc(1, sizeof(MotionInfoContexts) );
-  if( deco_ctx == NULL )
-    no_mem_exit("create_contexts_MotionInfo: deco_ctx");
+  deco_ctx = (MotionInfoContexts*) mem_calloc(1, sizeof(MotionInfoContexts) );
 
   return deco_ctx;
 }
@@ -98,9 +96,7 @@ TextureInfoContexts* create_contexts_TextureInfo(void)
 {
   TextureInfoContexts *deco_ctx;
 
-  deco_ctx = (TextureInfoContexts*) calloc(1, sizeof(TextureInfoContexts) );
-  if( deco_ctx == NULL )
-    no_mem_exit("create_contexts_TextureInfo: deco_ctx");
+  deco_ctx = (TextureInfoContexts*) mem_calloc(1, sizeof(TextureInfoContexts) );
 
   return deco_ctx;
 }
@@ -118,7 +114,7 @@ void delete_contexts_MotionInfo(MotionInfoContexts *deco_ctx)
   if( deco_ctx == NULL )
     return;
 
-  free( deco_ctx );
+  mem_free( deco_ctx );
 }
 
 
@@ -134,7 +130,7 @@ void delete_contexts_TextureInfo(TextureInfoContexts *deco_ctx)
   if( deco_ctx == NULL )
     return;
 
-  free( deco_ctx );
+  mem_free( deco_ctx );
 }
 
 void readFieldModeInfo_CABAC(Macroblock *currMB,  
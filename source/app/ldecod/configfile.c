@@ -64,6 +64,8 @@
 #include "memalloc.h"
 #include "config_common.h"
 #include "configfile.h"
+#include "frame_hash.h"
+#include "se_trace.h"
 #define MAX_ITEMS_TO_PARSE  10000
 
 static void PatchInp                (InputParameters *p_Inp);
@@ -87,14 +89,30 @@ void JMDecHelpExit (void)
     "   -f :  read <curencM.cfg> for reseting selected encoder parameters.\n"
     "         Multiple files could be used that set different parameters\n"
     "   -p :  Set parameter <DecParamM> to <DecValueM>.\n"
-    "         See default decoder.cfg file for description of all parameters.\n\n"
+    "         See default decoder.cfg file for description of all parameters.\n"
+    "   -threads :  decode the slices or macroblock rows of a picture on <N> threads and deblock\n"
+    "               the previous picture in the background (same as -p Threads=<N>).\n"
+    "   -hash :  write an md5, crc or xxh digest of every output picture and of the sequence\n"
+    "            instead of the pictures (same as -p OutputHash=1, 2 or 3).\n"
+    "   -trace :  write a binary record of every macroblock layer syntax element to TraceFile\n"
+    "             (bin), see tracedump, or no trace (off). Same as -p TraceMode=1 or 0.\n"
+    "   -mbmeta <prefix> :  write the type, QP, cbp, PLNZ and extracted metadata bits of every\n"
+    "             macroblock to the column files <prefix>.<column>. Same as -p MBMetaFile=<prefix>.\n"
+    "   -sei :  interpret the SEI messages of all payload types (all), of none (none) or of the\n"
+    "           listed ones (e.g. 5,6), the others are skipped unparsed. Same as -p SEITypes=<types>.\n"
+#if (MVC_EXTENSION_ENABLE)
+    "   -views :  decode only the base view of an MVC stream and drop the NAL units of the\n"
+    "             other views unread (base), or decode all views (all). Same as -p DecodeAllLayers=0 or 1.\n"
+#endif
+    "\n"
 
     "## Examples of usage:\n"
     "   ldecod\n"
     "   ldecod  -h\n"
     "   ldecod  -d default.cfg\n"
     "   ldecod  -f curenc1.cfg\n"
-    "   ldecod  -f curenc1.cfg -p InputFile=\"e:\\data\\container_qcif_30.264\" -p OutputFile=\"dec.yuv\" -p RefFile=\"Rec.yuv\"\n");
+    "   ldecod  -f curenc1.cfg -p InputFile=\"e:\\data\\container_qcif_30.264\" -p OutputFile=\"dec.yuv\" -p RefFile=\"Rec.yuv\"\n"
+    "   ldecod  -p FileFormat=1 -p InputFile=\"udp://127.0.0.1:5004\" -p ExtractInfo=\"100,0,1,1,2\"  (live RTP input)\n");
 
   exit(-1);
 }
@@ -167,7 +185,7 @@ void ParseCommand(InputParameters *p_Inp, int ac, char *av[])
         filename=av[2];
       CLcount = 3;
     }
-    if (0 == strncmp (av[1], "-h", 2))
+    if (0 == strncmp (av[1], "-h", 2) && 0 != strcmp (av[1], "-hash"))
     {
       JMDecHelpExit();
     }
@@ -186,9 +204,12 @@ void ParseCommand(InputParameters *p_Inp, int ac, char *av[])
   }
   // Parse the command line
 
+  // ParseContent() reloads p_Inp from cfgparams, so the options below that
+  // set a parameter directly store it in cfgparams too, or a later -f or -p
+  // would reset it.
   while (CLcount < ac)
   {
-    if (0 == strncmp (av[CLcount], "-h", 2))
+    if (0 == strncmp (av[CLcount], "-h", 2) && 0 != strcmp (av[CLcount], "-hash"))
     {
       JMDecHelpExit();
     }
@@ -231,11 +252,70 @@ void ParseCommand(InputParameters *p_Inp, int ac, char *av[])
       strncpy(p_Inp->outfile, av[CLcount+1], FILE_NAME_SIZE);
       CLcount += 2;
     } 
+    else if (0 == strcmp (av[CLcount], "-sei"))  // SEI payload types interpreted, tested before the -s prefix
+    {
+      if (CLcount + 1 >= ac)
+        JMDecHelpExit();
+      snprintf(p_Inp->sei_types, sizeof(p_Inp->sei_types), "%s", av[CLcount+1]);
+      snprintf(cfgparams.sei_types, sizeof(cfgparams.sei_types), "%s", p_Inp->sei_types);
+      CLcount += 2;
+    }
     else if (0 == strncmp (av[CLcount], "-s", 2) || 0 == strncmp (av[CLcount], "-S", 2))  // A file parameter?
     {
       p_Inp->silent = 1;
       CLcount += 1;
     }
+    else if (0 == strcmp (av[CLcount], "-threads"))  // number of decoding threads
+    {
+      if (CLcount + 1 >= ac)
+        JMDecHelpExit();
+      conf_read_check (sscanf(av[CLcount+1],"%d", &p_Inp->num_threads), 1);
+      p_Inp->num_threads = iClip3(1, 64, p_Inp->num_threads);
+      cfgparams.num_threads = p_Inp->num_threads;
+      CLcount += 2;
+    }
+    else if (0 == strcmp (av[CLcount], "-hash"))  // digests instead of the output pictures
+    {
+      static const char *hash_names[] = { "md5", "crc", "xxh" };
+      int i;
+
+      if (CLcount + 1 >= ac)
+        JMDecHelpExit();
+      for (i = 0; i < 3 && strcmp (av[CLcount+1], hash_names[i]); ++i)
+        ;
+      if (i == 3)
+      {
+        snprintf (errortext, ET_SIZE, "Unknown digest '%s' for -hash, expected md5, crc or xxh", av[CLcount+1]);
+        error (errortext, 300);
+      }
+      p_Inp->hash_type = HASH_MD5 + i;
+      cfgparams.hash_type = p_Inp->hash_type;
+      CLcount += 2;
+    }
+    else if (0 == strcmp (av[CLcount], "-trace"))  // binary syntax element trace
+    {
+      if (CLcount + 1 >= ac)
+        JMDecHelpExit();
+      if (0 == strcmp (av[CLcount+1], "bin"))
+        p_Inp->se_trace_mode = SE_TRACE_BIN;
+      else if (0 == strcmp (av[CLcount+1], "off"))
+        p_Inp->se_trace_mode = SE_TRACE_OFF;
+      else
+      {
+        snprintf (errortext, ET_SIZE, "Unknown value '%s' for -trace, expected bin or off", av[CLcount+1]);
+        error (errortext, 300);
+      }
+      cfgparams.se_trace_mode = p_Inp->se_trace_mode;
+      CLcount += 2;
+    }
+    else if (0 == strcmp (av[CLcount], "-mbmeta"))  // per macroblock metadata columns
+    {
+      if (CLcount + 1 >= ac)
+        JMDecHelpExit();
+      snprintf(p_Inp->mb_meta_file, sizeof(p_Inp->mb_meta_file), "%s", av[CLcount+1]);
+      snprintf(cfgparams.mb_meta_file, sizeof(cfgparams.mb_meta_file), "%s", p_Inp->mb_meta_file);
+      CLcount += 2;
+    }
     else if (0 == strncmp (av[CLcount], "-n", 2) || 0 == strncmp (av[CLcount], "-N", 2))  // A file parameter?
     {
       conf_read_check (sscanf(av[CLcount+1],"%d", &p_Inp->iDecFrmNum), 1);
@@ -247,6 +327,22 @@ void ParseCommand(InputParameters *p_Inp, int ac, char *av[])
       conf_read_check (sscanf(av[CLcount+1],"%d", &p_Inp->DecodeAllLayers), 1);
       CLcount += 2;
     } 
+    else if (0 == strcmp (av[CLcount], "-views"))  // base view only or all views
+    {
+      if (CLcount + 1 >= ac)
+        JMDecHelpExit();
+      if (0 == strcmp (av[CLcount+1], "base"))
+        p_Inp->DecodeAllLayers = 0;
+      else if (0 == strcmp (av[CLcount+1], "all"))
+        p_Inp->DecodeAllLayers = 1;
+      else
+      {
+        snprintf (errortext, ET_SIZE, "Unknown value '%s' for -views, expected base or all", av[CLcount+1]);
+        error (errortext, 300);
+      }
+      cfgparams.DecodeAllLayers = p_Inp->DecodeAllLayers;
+      CLcount += 2;
+    }
 #endif
     else if (0 == strncmp (av[CLcount], "-p", 2) || 0 == strncmp (av[CLcount], "-P", 2))  // A config change?
     {
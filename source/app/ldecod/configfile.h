@@ -32,6 +32,9 @@ Mapping Map[] = {
     {"RefFile",                  &cfgparams.reffile,                      1,   0.0,                       0,  0.0,              0.0,             FILE_NAME_SIZE, },
     {"WriteUV",                  &cfgparams.write_uv,                     0,   1.0,                       1,  0.0,              1.0,                             },
     {"FileFormat",               &cfgparams.FileFormat,                   0,   0.0,                       1,  0.0,              1.0,                             },
+    {"RTPReorderPackets",        &cfgparams.rtp_reorder_packets,          0,   64.0,                      1,  1.0,              256.0,                           },
+    {"RTPJitterMs",              &cfgparams.rtp_jitter_ms,                0,   100.0,                     1,  0.0,              10000.0,                         },
+    {"RTPTimeoutMs",             &cfgparams.rtp_timeout_ms,               0,   2000.0,                    1,  0.0,              3600000.0,                       },
     {"RefOffset",                &cfgparams.ref_offset,                   0,   0.0,                       1,  0.0,              256.0,                             },
     {"POCScale",                 &cfgparams.poc_scale,                    0,   2.0,                       1,  1.0,              10.0,                            },
 #ifdef _LEAKYBUCKET_
@@ -52,6 +55,19 @@ Mapping Map[] = {
 #endif
     {"DPBPLUS0",                 &cfgparams.dpb_plus[0],                  0,   1.0,                       1,  -16.0,            16.0,                             },
     {"DPBPLUS1",                 &cfgparams.dpb_plus[1],                  0,   0.0,                       1,  -16.0,            16.0,                             },
+    {"SIMDLevel",                &cfgparams.simd_level,                   0,   2.0,                       1,  0.0,              2.0,                             },
+    {"Threads",                  &cfgparams.num_threads,                  0,   1.0,                       1,  1.0,              64.0,                            },
+    {"DeblockRows",              &cfgparams.deblock_rows,                 0,   0.0,                       1,  0.0,              1.0,                             },
+    {"OutputBuffers",            &cfgparams.output_buffers,               0,   3.0,                       1,  0.0,              16.0,                            },
+    {"OutputDirect",             &cfgparams.output_direct,                0,   0.0,                       1,  0.0,              1.0,                             },
+    {"OutputHash",               &cfgparams.hash_type,                    0,   0.0,                       1,  0.0,              3.0,                             },
+    {"MemoryStatsFile",          &cfgparams.mem_stats_file,               1,   0.0,                       0,  0.0,              0.0,             FILE_NAME_SIZE, },
+    {"TraceMode",                &cfgparams.se_trace_mode,                0,   0.0,                       1,  0.0,              1.0,                             },
+    {"TraceFile",                &cfgparams.se_trace_file,                1,   0.0,                       0,  0.0,              0.0,             FILE_NAME_SIZE, },
+    {"MBMetaFile",               &cfgparams.mb_meta_file,                 1,   0.0,                       0,  0.0,              0.0,             FILE_NAME_SIZE, },
+    {"SEITypes",                 &cfgparams.sei_types,                    1,   0.0,                       0,  0.0,              0.0,             FILE_NAME_SIZE, },
+    {"SEIUserDataFile",          &cfgparams.sei_user_data_file,           1,   0.0,                       0,  0.0,              0.0,             FILE_NAME_SIZE, },
+    {"ExtractInfo",              &cfgparams.extract_info,                 1,   0.0,                       0,  0.0,              0.0,             FILE_NAME_SIZE, },
     {NULL,                       NULL,                                   -1,   0.0,                       0,  0.0,              0.0,                             },
 };
 #endif
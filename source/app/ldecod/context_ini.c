@@ -18,6 +18,8 @@
 #include "defines.h"
 #include "global.h"
 #include "biaridecod.h"
+#include "context_ini.h"
+#include "memalloc.h"
 #include "ctx_tables.h"
 
 
@@ -59,18 +61,20 @@
   } \
 }
 
-void init_contexts (Slice *currSlice)
+/*!
+ ************************************************************************
+ * \brief
+ *    Computes all context models of one slice class from the m/n tables
+ ************************************************************************
+ */
+static void init_context_set (CabacContextSet *ctx_set, int intra, int model_number, int qp)
 {
-  MotionInfoContexts*  mc = currSlice->mot_ctx;
-  TextureInfoContexts* tc = currSlice->tex_ctx;
+  MotionInfoContexts*  mc = &ctx_set->mot_ctx;
+  TextureInfoContexts* tc = &ctx_set->tex_ctx;
   int i, j;
-  int qp = imax(0, currSlice->qp); //p_Vid->qp);
-  int model_number = currSlice->model_number;
-
-  //printf("%d -", p_Vid->currentSlice->model_number);
 
   //--- motion coding contexts ---
-  if ((currSlice->slice_type == I_SLICE)||(currSlice->slice_type == SI_SLICE))
+  if (intra)
   {
     IBIARI_CTX_INIT2 (3, NUM_MB_TYPE_CTX,   mc->mb_type_contexts,     INIT_MB_TYPE,    model_number, qp);
     IBIARI_CTX_INIT2 (2, NUM_B8_TYPE_CTX,   mc->b8_type_contexts,     INIT_B8_TYPE,    model_number, qp);
@@ -120,3 +124,59 @@ void init_contexts (Slice *currSlice)
   }
 }
 
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Initializes the context models of a slice. Fully initialized sets
+ *    are computed once per (slice type, cabac_init_idc, SliceQP) and
+ *    copied into the slice afterwards.
+ ************************************************************************
+ */
+void init_contexts (Slice *currSlice)
+{
+  VideoParameters *p_Vid = currSlice->p_Vid;
+  int qp = imax(0, currSlice->qp); //p_Vid->qp);
+  int intra = (currSlice->slice_type == I_SLICE) || (currSlice->slice_type == SI_SLICE);
+  int model = intra ? 0 : currSlice->model_number + 1;
+  CabacContextSet *ctx_set;
+
+  //printf("%d -", p_Vid->currentSlice->model_number);
+
+  ctx_set = p_Vid->ctx_init_cache[model][qp];
+  if (ctx_set == NULL)
+  {
+    MemTag prev_tag = mem_set_tag(MEM_CABAC);
+
+    ctx_set = (CabacContextSet *) mem_malloc(sizeof(CabacContextSet));
+    mem_set_tag(prev_tag);
+    init_context_set(ctx_set, intra, currSlice->model_number, qp);
+    p_Vid->ctx_init_cache[model][qp] = ctx_set;
+  }
+
+  memcpy(currSlice->mot_ctx, &ctx_set->mot_ctx, sizeof(MotionInfoContexts));
+  memcpy(currSlice->tex_ctx, &ctx_set->tex_ctx, sizeof(TextureInfoContexts));
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Releases the cached context initializations
+ ************************************************************************
+ */
+void free_context_cache (VideoParameters *p_Vid)
+{
+  int model, qp;
+
+  for (model = 0; model < NUM_CTX_INIT_MODELS; ++model)
+  {
+    for (qp = 0; qp <= MAX_QP; ++qp)
+    {
+      if (p_Vid->ctx_init_cache[model][qp] != NULL)
+      {
+        mem_free(p_Vid->ctx_init_cache[model][qp]);
+        p_Vid->ctx_init_cache[model][qp] = NULL;
+      }
+    }
+  }
+}
@@ -18,6 +18,7 @@
 #define _CONTEXT_INI_
 
 extern void  init_contexts  (Slice *currslice);
+extern void  free_context_cache (VideoParameters *p_Vid);
 
 #endif
 
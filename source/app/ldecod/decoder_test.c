@@ -70,6 +70,41 @@ static void Configure(InputParameters *p_Inp, int ac, char *av[])
   
 }
 
+/*********************************************************
+writes the uuid, the size and the data of a
+user_data_unregistered SEI message to SEIUserDataFile
+*********************************************************/
+static void WriteSEIUserData(void *opaque, const byte *uuid, const byte *data, int size)
+{
+  FILE *f = (FILE *) opaque;
+  uint32 data_size = (uint32) size;
+
+  if (fwrite(uuid, 1, 16, f) != 16 || fwrite(&data_size, sizeof(data_size), 1, f) != 1
+    || fwrite(data, 1, size, f) != (size_t) size)
+    error ("WriteSEIUserData: error writing the SEI user data", 500);
+}
+
+/*********************************************************
+writes a plane with a single write() when its rows are 
+contiguous, row by row otherwise
+*********************************************************/
+static void WritePlane(int hFileOutput, byte *pbBuf, int iWidth, int iHeight, int iStride)
+{
+  int i;
+
+  if(iStride == iWidth)
+  {
+    if((long) write(hFileOutput, pbBuf, (size_t) iWidth*iHeight) != (long) iWidth*iHeight)
+      error ("error writing to output file.", 600);
+    return;
+  }
+  for(i=0; i<iHeight; i++)
+  {
+    if(write(hFileOutput, pbBuf+i*iStride, iWidth) != iWidth)
+      error ("error writing to output file.", 600);
+  }
+}
+
 /*********************************************************
 if bOutputAllFrames is 1, then output all valid frames to file onetime; 
 else output the first valid frame and move the buffer to the end of list;
@@ -81,10 +116,9 @@ static int WriteOneFrame(DecodedPicList *pDecPic, int hFileOutput0, int hFileOut
 
   if(pPic && (((pPic->iYUVStorageFormat==2) && pPic->bValid==3) || ((pPic->iYUVStorageFormat!=2) && pPic->bValid==1)) )
   {
-    int i, iWidth, iHeight, iStride, iWidthUV, iHeightUV, iStrideUV;
+    int iWidth, iHeight, iStride, iWidthUV, iHeightUV, iStrideUV;
     byte *pbBuf;    
     int hFileOutput;
-    int res;
 
     iWidth = pPic->iWidth*((pPic->iBitDepth+7)>>3);
     iHeight = pPic->iHeight;
@@ -110,37 +144,16 @@ static int WriteOneFrame(DecodedPicList *pDecPic, int hFileOutput0, int hFileOut
       {
         //Y;
         pbBuf = pPic->pY;
-        for(i=0; i<iHeight; i++)
-        {
-          res = write(hFileOutput, pbBuf+i*iStride, iWidth);
-          if (-1==res)
-          {
-            error ("error writing to output file.", 600);
-          }
-        }
+        WritePlane(hFileOutput, pbBuf, iWidth, iHeight, iStride);
 
         if(pPic->iYUVFormat != YUV400)
         {
          //U;
          pbBuf = pPic->pU;
-         for(i=0; i<iHeightUV; i++)
-         {
-           res = write(hFileOutput, pbBuf+i*iStrideUV, iWidthUV);
-           if (-1==res)
-           {
-             error ("error writing to output file.", 600);
-           }
-}
+         WritePlane(hFileOutput, pbBuf, iWidthUV, iHeightUV, iStrideUV);
          //V;
          pbBuf = pPic->pV;
-         for(i=0; i<iHeightUV; i++)
-         {
-           res = write(hFileOutput, pbBuf+i*iStrideUV, iWidthUV);
-           if (-1==res)
-           {
-             error ("error writing to output file.", 600);
-           }
-         }
+         WritePlane(hFileOutput, pbBuf, iWidthUV, iHeightUV, iStrideUV);
         }
 
         iOutputFrame++;
@@ -154,38 +167,17 @@ static int WriteOneFrame(DecodedPicList *pDecPic, int hFileOutput0, int hFileOut
           int iPicSize =iHeight*iStride;
           //Y;
           pbBuf = pPic->pY+iPicSize;
-          for(i=0; i<iHeight; i++)
-          {
-            res = write(hFileOutput, pbBuf+i*iStride, iWidth);
-            if (-1==res)
-            {
-              error ("error writing to output file.", 600);
-            }
-          }
+          WritePlane(hFileOutput, pbBuf, iWidth, iHeight, iStride);
 
           if(pPic->iYUVFormat != YUV400)
           {
            iPicSize = iHeightUV*iStrideUV;
            //U;
            pbBuf = pPic->pU+iPicSize;
-           for(i=0; i<iHeightUV; i++)
-           {
-             res = write(hFileOutput, pbBuf+i*iStrideUV, iWidthUV);
-             if (-1==res)
-             {
-               error ("error writing to output file.", 600);
-             }
-           }
+           WritePlane(hFileOutput, pbBuf, iWidthUV, iHeightUV, iStrideUV);
            //V;
            pbBuf = pPic->pV+iPicSize;
-           for(i=0; i<iHeightUV; i++)
-           {
-             res = write(hFileOutput, pbBuf+i*iStrideUV, iWidthUV);
-             if (-1==res)
-             {
-               error ("error writing to output file.", 600);
-             }
-           }
+           WritePlane(hFileOutput, pbBuf, iWidthUV, iHeightUV, iStrideUV);
           }
 
           iOutputFrame++;
@@ -207,37 +199,18 @@ static int WriteOneFrame(DecodedPicList *pDecPic, int hFileOutput0, int hFileOut
   return iOutputFrame;
 }
 
-/*!
- ***********************************************************************
- * \brief
- *    main function for JM decoder
- ***********************************************************************
- */
-int main(int argc, char **argv)
+/*********************************************************
+reads endInfo from the trailer NAL unit at the end of 
+the input file, returns 0 if there is none
+*********************************************************/
+static int ReadEndInfo(char *infile)
 {
-  int iRet;
-  DecodedPicList *pDecPicList;
-  int hFileDecOutput0=-1, hFileDecOutput1=-1;
-  int iFramesOutput=0, iFramesDecoded=0;
-  InputParameters InputParams;
   unsigned char fileN[256];
   unsigned char sizeH = 0;
   int OffsetEnd = 5, BitOffsetEnd = 8;
 
-#if DECOUTPUT_TEST
-  hFileDecOutput0 = open(DECOUTPUT_VIEW0_FILENAME, OPENFLAGS_WRITE, OPEN_PERMISSIONS);
-  fprintf(stdout, "Decoder output view0: %s\n", DECOUTPUT_VIEW0_FILENAME);
-  hFileDecOutput1 = open(DECOUTPUT_VIEW1_FILENAME, OPENFLAGS_WRITE, OPEN_PERMISSIONS);
-  fprintf(stdout, "Decoder output view1: %s\n", DECOUTPUT_VIEW1_FILENAME);
-#endif
-
-  init_time();
-
-  //get input parameters;
-  Configure(&InputParams, argc, argv);
-  //open decoder;
-  iRet = OpenDecoder(&InputParams);
-  Input_File = fopen(InputParams.infile, "rb");
+  if ((Input_File = fopen(infile, "rb")) == NULL)
+    return 0;
   InsertingSlice = Find_Slice_type(Input_File, fileN);
   fseek(Input_File, -1, SEEK_END);
   fread(&sizeH, 1, 1, Input_File);
@@ -260,8 +233,51 @@ int main(int argc, char **argv)
 	  endInfo.Threshold = ReadExpGlomb(fileN, &OffsetEnd, &BitOffsetEnd);
 	  endInfo.MetaDataNum = ReadExpGlomb(fileN, &OffsetEnd, &BitOffsetEnd);
 	  endInfo.FrameType = ReadExpGlomb(fileN, &OffsetEnd, &BitOffsetEnd);
+	  return 1;
   }
-  else
+  return 0;
+}
+
+/*!
+ ***********************************************************************
+ * \brief
+ *    main function for JM decoder
+ ***********************************************************************
+ */
+int main(int argc, char **argv)
+{
+  int iRet;
+  DecodedPicList *pDecPicList;
+  int hFileDecOutput0=-1, hFileDecOutput1=-1;
+  int iFramesOutput=0, iFramesDecoded=0;
+  InputParameters InputParams;
+  FILE *pSEIUserData = NULL;
+
+#if DECOUTPUT_TEST
+  hFileDecOutput0 = open(DECOUTPUT_VIEW0_FILENAME, OPENFLAGS_WRITE, OPEN_PERMISSIONS);
+  fprintf(stdout, "Decoder output view0: %s\n", DECOUTPUT_VIEW0_FILENAME);
+  hFileDecOutput1 = open(DECOUTPUT_VIEW1_FILENAME, OPENFLAGS_WRITE, OPEN_PERMISSIONS);
+  fprintf(stdout, "Decoder output view1: %s\n", DECOUTPUT_VIEW1_FILENAME);
+#endif
+
+  init_time();
+
+  //get input parameters;
+  Configure(&InputParams, argc, argv);
+  if (InputParams.extract_info[0] != '\0')
+  {
+    //extraction parameters given instead of the trailer, which live input has not got;
+    int Threshold;
+
+    if (sscanf(InputParams.extract_info, "%u,%d,%d,%u,%d", &endInfo.FrameNum, &endInfo.SliceMbNum,
+               &Threshold, &endInfo.MetaDataNum, &endInfo.FrameType) != 5)
+    {
+      fprintf(stderr, "Invalid ExtractInfo '%s', expected FrameNum,SliceMbNum,Threshold,MetaDataNum,FrameType\n", InputParams.extract_info);
+      return -1;
+    }
+    endInfo.Threshold = (unsigned char) Threshold;
+  }
+  else if (!ReadEndInfo(InputParams.infile))
   {
 	  fprintf(stderr, "NMI\n");
 	  return 0;
@@ -296,6 +312,16 @@ int main(int argc, char **argv)
   Output_MD = fopen(G_File_MDIn, "wb");
   BitBuffer = 0;
 
+  if (InputParams.sei_user_data_file[0] != '\0')
+  {
+    if ((pSEIUserData = fopen(InputParams.sei_user_data_file, "wb")) == NULL)
+    {
+      fprintf(stderr, "Cannot open %s for the SEI user data\n", InputParams.sei_user_data_file);
+      return -1;
+    }
+    SetSEIUserDataCallback(WriteSEIUserData, pSEIUserData);
+  }
+
   if(iRet != DEC_OPEN_NOERR)
   {
     fprintf(stderr, "Open encoder failed: 0x%x!\n", iRet);
@@ -332,6 +358,8 @@ int main(int argc, char **argv)
   iFramesOutput += WriteOneFrame(pDecPicList, hFileDecOutput0, hFileDecOutput1 , 1);
   iRet = CloseDecoder();
   fclose(Output_MD);
+  if (pSEIUserData != NULL)
+    fclose(pSEIUserData);
 
   //quit;
   if(hFileDecOutput0>=0)
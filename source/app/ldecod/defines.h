@@ -43,7 +43,6 @@
 #define ENABLE_OUTPUT_TONEMAPPING 1    //!< enable tone map the output if tone mapping SEI present
 #define JCOST_CALC_SCALEUP        1    //!< 1: J = (D<<LAMBDA_ACCURACY_BITS)+Lambda*R; 0: J = D + ((Lambda*R+Rounding)>>LAMBDA_ACCURACY_BITS)
 #define DISABLE_ERC               0    //!< Disable any error concealment processes
-#define JM_PARALLEL_DEBLOCK       0    //!< Enables Parallel Deblocking
 #define SIMULCAST_ENABLE          0    //!< to test the decoder
 
 #define MVC_EXTENSION_ENABLE      1    //!< enable support for the Multiview High Profile
@@ -63,11 +62,9 @@
 #define MAX_CODED_FRAME_SIZE 8000000         //!< bytes for one frame
 #define MAX_NUM_DECSLICES  16
 #define MAX_DEC_THREADS    16                  //16 core deocoding;
-#define MCBUF_LUMA_PAD_X        32
-#define MCBUF_LUMA_PAD_Y        12
-#define MCBUF_CHROMA_PAD_X      16
-#define MCBUF_CHROMA_PAD_Y      8
 #define MAX_NUM_DPB_LAYERS      2
+#define SEI_TYPE_COUNT     256                 //!< SEI payload types SEITypes can list, the larger ones are reserved
+#define SEI_TYPE_WORDS     (SEI_TYPE_COUNT / 64 + 1) //!< words of the SEITypes mask, the last bit is for all reserved types
 
 //AVC Profile IDC definitions
 typedef enum {
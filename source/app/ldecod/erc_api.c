@@ -23,22 +23,53 @@
 /*!
  ************************************************************************
  * \brief
- *    Initinize the error concealment module
+ *    Initinize the error concealment module. The buffers for the
+ *    macroblock modes and states are only allocated by ercStartPicture()
+ *    for the first picture with lost macroblocks.
  ************************************************************************
  */
-void ercInit(VideoParameters *p_Vid, int pic_sizex, int pic_sizey, int flag)
+void ercInit(VideoParameters *p_Vid, int flag)
 {
+  MemTag prev_tag;
+
   ercClose(p_Vid, p_Vid->erc_errorVar);
-  p_Vid->erc_object_list = (objectBuffer_t *) calloc((pic_sizex * pic_sizey) >> 6, sizeof(objectBuffer_t));
-  if (p_Vid->erc_object_list == NULL) no_mem_exit("ercInit: erc_object_list");
+  prev_tag = mem_set_tag(MEM_ERC);
 
   // the error concealment instance is allocated
   p_Vid->erc_errorVar = ercOpen();
+  mem_set_tag(prev_tag);
 
   // set error concealment ON
   ercSetErrorConcealment(p_Vid->erc_errorVar, flag);
 }
 
+/*!
+ ************************************************************************
+ * \brief
+ *      Prepares the concealment of the current picture, allocating the
+ *      macroblock mode buffer on first use. Only called for pictures
+ *      with lost macroblocks, so error free streams never set up any
+ *      concealment state.
+ * \param p_Vid
+ *      VideoParameters variable
+ * \param nOfMBs
+ *      Number of macroblocks in the picture
+ * \param picSizeX
+ *      Width of the picture in pixels.
+ ************************************************************************
+ */
+void ercStartPicture( VideoParameters *p_Vid, int nOfMBs, int picSizeX )
+{
+  if (p_Vid->erc_object_list == NULL)
+  {
+    MemTag prev_tag = mem_set_tag(MEM_ERC);
+    p_Vid->erc_object_list = (objectBuffer_t *) mem_calloc((p_Vid->width * p_Vid->height) >> 6, sizeof(objectBuffer_t));
+    mem_set_tag(prev_tag);
+  }
+
+  ercReset(p_Vid->erc_errorVar, nOfMBs, nOfMBs, picSizeX);
+}
+
 /*!
  ************************************************************************
  * \brief
@@ -51,8 +82,7 @@ ercVariables_t *ercOpen( void )
 {
   ercVariables_t *errorVar = NULL;
 
-  errorVar = (ercVariables_t *)malloc( sizeof(ercVariables_t));
-  if ( errorVar == NULL ) no_mem_exit("ercOpen: errorVar");
+  errorVar = (ercVariables_t *)mem_malloc( sizeof(ercVariables_t));
 
   errorVar->nOfMBs = 0;
   errorVar->segments = NULL;
@@ -89,38 +119,34 @@ void ercReset( ercVariables_t *errorVar, int nOfMBs, int numOfSegments, int picS
 
   if ( errorVar && errorVar->concealment )
   {
+    MemTag prev_tag = mem_set_tag(MEM_ERC);
     ercSegment_t *segments = NULL;
     // If frame size has been changed
     if ( nOfMBs != errorVar->nOfMBs && errorVar->yCondition != NULL )
     {
-      free( errorVar->yCondition );
+      mem_free( errorVar->yCondition );
       errorVar->yCondition = NULL;
-      free( errorVar->prevFrameYCondition );
+      mem_free( errorVar->prevFrameYCondition );
       errorVar->prevFrameYCondition = NULL;
-      free( errorVar->uCondition );
+      mem_free( errorVar->uCondition );
       errorVar->uCondition = NULL;
-      free( errorVar->vCondition );
+      mem_free( errorVar->vCondition );
       errorVar->vCondition = NULL;
-      free( errorVar->segments );
+      mem_free( errorVar->segments );
       errorVar->segments = NULL;
     }
 
     // If the structures are uninitialized (first frame, or frame size is changed)
     if ( errorVar->yCondition == NULL )
     {
-      errorVar->segments = (ercSegment_t *)malloc( numOfSegments*sizeof(ercSegment_t) );
-      if ( errorVar->segments == NULL ) no_mem_exit("ercReset: errorVar->segments");
+      errorVar->segments = (ercSegment_t *)mem_malloc( numOfSegments*sizeof(ercSegment_t) );
       fast_memset( errorVar->segments, 0, numOfSegments*sizeof(ercSegment_t));
       errorVar->nOfSegments = numOfSegments;
 
-      errorVar->yCondition = (char *)malloc( 4*nOfMBs*sizeof(char) );
-      if ( errorVar->yCondition == NULL ) no_mem_exit("ercReset: errorVar->yCondition");
-      errorVar->prevFrameYCondition = (char *)malloc( 4*nOfMBs*sizeof(char) );
-      if ( errorVar->prevFrameYCondition == NULL ) no_mem_exit("ercReset: errorVar->prevFrameYCondition");
-      errorVar->uCondition = (char *)malloc( nOfMBs*sizeof(char) );
-      if ( errorVar->uCondition == NULL ) no_mem_exit("ercReset: errorVar->uCondition");
-      errorVar->vCondition = (char *)malloc( nOfMBs*sizeof(char) );
-      if ( errorVar->vCondition == NULL ) no_mem_exit("ercReset: errorVar->vCondition");
+      errorVar->yCondition = (char *)mem_malloc( 4*nOfMBs*sizeof(char) );
+      errorVar->prevFrameYCondition = (char *)mem_malloc( 4*nOfMBs*sizeof(char) );
+      errorVar->uCondition = (char *)mem_malloc( nOfMBs*sizeof(char) );
+      errorVar->vCondition = (char *)mem_malloc( nOfMBs*sizeof(char) );
       errorVar->nOfMBs = nOfMBs;
     }
     else
@@ -138,10 +164,9 @@ void ercReset( ercVariables_t *errorVar, int nOfMBs, int numOfSegments, int picS
 
     if (errorVar->nOfSegments != numOfSegments)
     {
-      free( errorVar->segments );
+      mem_free( errorVar->segments );
       errorVar->segments = NULL;
-      errorVar->segments = (ercSegment_t *)malloc( numOfSegments*sizeof(ercSegment_t) );
-      if ( errorVar->segments == NULL ) no_mem_exit("ercReset: errorVar->segments");
+      errorVar->segments = (ercSegment_t *)mem_malloc( numOfSegments*sizeof(ercSegment_t) );
       errorVar->nOfSegments = numOfSegments;
     }
 
@@ -157,6 +182,7 @@ void ercReset( ercVariables_t *errorVar, int nOfMBs, int numOfSegments, int picS
 
     errorVar->currSegment = 0;
     errorVar->nOfCorruptedSegments = 0;
+    mem_set_tag(prev_tag);
   }
 }
 
@@ -173,25 +199,28 @@ void ercReset( ercVariables_t *errorVar, int nOfMBs, int numOfSegments, int picS
  */
 void ercClose(VideoParameters *p_Vid,  ercVariables_t *errorVar )
 {
+  MemTag prev_tag = mem_set_tag(MEM_ERC);
+
   if ( errorVar != NULL )
   {
     if (errorVar->yCondition != NULL)
     {
-      free( errorVar->segments );
-      free( errorVar->yCondition );
-      free( errorVar->uCondition );
-      free( errorVar->vCondition );
-      free( errorVar->prevFrameYCondition );
+      mem_free( errorVar->segments );
+      mem_free( errorVar->yCondition );
+      mem_free( errorVar->uCondition );
+      mem_free( errorVar->vCondition );
+      mem_free( errorVar->prevFrameYCondition );
     }
-    free( errorVar );
+    mem_free( errorVar );
     errorVar = NULL;
   }
 
   if (p_Vid->erc_object_list)
   {
-    free(p_Vid->erc_object_list);
+    mem_free(p_Vid->erc_object_list);
     p_Vid->erc_object_list=NULL;
   }
+  mem_set_tag(prev_tag);
 }
 
 /*!
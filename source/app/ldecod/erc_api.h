@@ -111,8 +111,9 @@ typedef struct ercVariables_s
 * External function interface
 */
 
-void ercInit (VideoParameters *p_Vid, int pic_sizex, int pic_sizey, int flag);
+void ercInit (VideoParameters *p_Vid, int flag);
 ercVariables_t *ercOpen( void );
+void ercStartPicture( VideoParameters *p_Vid, int nOfMBs, int picSizeX );
 void ercReset( ercVariables_t *errorVar, int nOfMBs, int numOfSegments, int picSizeX );
 void ercClose( VideoParameters *p_Vid, ercVariables_t *errorVar );
 void ercSetErrorConcealment( ercVariables_t *errorVar, int value );
@@ -0,0 +1,546 @@
+
+/*!
+ *************************************************************************************
+ * \file frame_hash.c
+ *
+ * \brief
+ *    Digests of the output pictures written instead of the pictures
+ *
+ *    With -hash the output file receives one line per picture with the
+ *    digest of the bytes the picture would have added to the YUV file,
+ *    and a last line with the digest of the whole file. For MD5 that line
+ *    equals the md5sum of the YUV file written without -hash.
+ *
+ *************************************************************************************
+ */
+
+#include "global.h"
+#include "memalloc.h"
+#include "frame_hash.h"
+
+#define MAX_HASH_FILES  4    //!< output files hashed at the same time
+#define MAX_DIGEST_SIZE 16   //!< bytes of the longest digest (MD5)
+
+typedef struct md5_context
+{
+  uint32 state[4];
+  uint64 length;             //!< bytes hashed
+  byte   block[64];
+} Md5Context;
+
+typedef struct xxh64_context
+{
+  uint64 acc[4];
+  uint64 length;             //!< bytes hashed
+  byte   block[32];
+} Xxh64Context;
+
+typedef union hash_context
+{
+  Md5Context   md5;
+  uint32       crc;
+  Xxh64Context xxh;
+} HashContext;
+
+//! output file being hashed
+typedef struct hash_file
+{
+  int         fd;            //!< -1 for an unused entry
+  int         frames;        //!< pictures hashed
+  HashContext frame;         //!< digest of the current picture
+  HashContext sequence;      //!< digest of the whole file
+} HashFile;
+
+struct frame_hash
+{
+  int            type;
+  HashFile       files[MAX_HASH_FILES];
+  unsigned char *row;        //!< scratch buffer of get_hash_row()
+  size_t         row_size;
+};
+
+static uint32 crc_table[256];
+
+/*
+ * MD5 (RFC 1321)
+ */
+
+static const uint32 md5_k[64] =
+{
+  0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+  0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+  0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+  0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+  0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+  0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+  0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+  0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+static const byte md5_r[64] =
+{
+  7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+  5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
+  4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+  6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
+
+static inline uint32 rotl32(uint32 x, int n)
+{
+  return (x << n) | (x >> (32 - n));
+}
+
+static inline uint64 rotl64(uint64 x, int n)
+{
+  return (x << n) | (x >> (64 - n));
+}
+
+static inline uint32 read_le32(const byte *p)
+{
+  return (uint32) p[0] | ((uint32) p[1] << 8) | ((uint32) p[2] << 16) | ((uint32) p[3] << 24);
+}
+
+static inline uint64 read_le64(const byte *p)
+{
+  return (uint64) read_le32(p) | ((uint64) read_le32(p + 4) << 32);
+}
+
+static void md5_init(Md5Context *c)
+{
+  c->state[0] = 0x67452301;
+  c->state[1] = 0xefcdab89;
+  c->state[2] = 0x98badcfe;
+  c->state[3] = 0x10325476;
+  c->length = 0;
+}
+
+static void md5_block(Md5Context *c, const byte *data)
+{
+  uint32 m[16];
+  uint32 a = c->state[0], b = c->state[1], cc = c->state[2], d = c->state[3];
+  int i;
+
+  for (i = 0; i < 16; ++i)
+    m[i] = read_le32(data + 4 * i);
+
+  for (i = 0; i < 64; ++i)
+  {
+    uint32 f, tmp;
+    int g;
+
+    if (i < 16)
+    {
+      f = (b & cc) | (~b & d);
+      g = i;
+    }
+    else if (i < 32)
+    {
+      f = (d & b) | (~d & cc);
+      g = (5 * i + 1) & 15;
+    }
+    else if (i < 48)
+    {
+      f = b ^ cc ^ d;
+      g = (3 * i + 5) & 15;
+    }
+    else
+    {
+      f = cc ^ (b | ~d);
+      g = (7 * i) & 15;
+    }
+    tmp = d;
+    d   = cc;
+    cc  = b;
+    b  += rotl32(a + f + md5_k[i] + m[g], md5_r[i]);
+    a   = tmp;
+  }
+
+  c->state[0] += a;
+  c->state[1] += b;
+  c->state[2] += cc;
+  c->state[3] += d;
+}
+
+static void md5_update(Md5Context *c, const byte *data, size_t size)
+{
+  size_t fill = (size_t) (c->length & 63);
+
+  c->length += size;
+  if (fill > 0)
+  {
+    size_t n = (64 - fill < size) ? 64 - fill : size;
+
+    memcpy(c->block + fill, data, n);
+    data += n;
+    size -= n;
+    if (fill + n < 64)
+      return;
+    md5_block(c, c->block);
+  }
+  for (; size >= 64; data += 64, size -= 64)
+    md5_block(c, data);
+  memcpy(c->block, data, size);
+}
+
+static void md5_final(Md5Context *c, byte *digest)
+{
+  static const byte padding[64] = { 0x80 };
+  uint64 bits = c->length << 3;
+  byte length[8];
+  int i;
+
+  for (i = 0; i < 8; ++i)
+    length[i] = (byte) (bits >> (8 * i));
+  md5_update(c, padding, ((c->length & 63) < 56) ? (size_t) (56 - (c->length & 63)) : (size_t) (120 - (c->length & 63)));
+  md5_update(c, length, 8);
+
+  for (i = 0; i < 16; ++i)
+    digest[i] = (byte) (c->state[i >> 2] >> (8 * (i & 3)));
+}
+
+/*
+ * CRC-32 (ISO-HDLC, as used by zlib and gzip)
+ */
+
+static void init_crc_table(void)
+{
+  uint32 i, k;
+
+  for (i = 0; i < 256; ++i)
+  {
+    uint32 c = i;
+
+    for (k = 0; k < 8; ++k)
+      c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+    crc_table[i] = c;
+  }
+}
+
+static void crc_update(uint32 *crc, const byte *data, size_t size)
+{
+  uint32 c = ~*crc;
+
+  while (size-- > 0)
+    c = crc_table[(c ^ *data++) & 0xff] ^ (c >> 8);
+  *crc = ~c;
+}
+
+/*
+ * XXH64 with seed 0
+ */
+
+#define XXH_PRIME64_1  0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2  0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3  0x165667B19E3779F9ULL
+#define XXH_PRIME64_4  0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5  0x27D4EB2F165667C5ULL
+
+static inline uint64 xxh64_round(uint64 acc, uint64 input)
+{
+  acc += input * XXH_PRIME64_2;
+  return rotl64(acc, 31) * XXH_PRIME64_1;
+}
+
+static inline uint64 xxh64_merge_round(uint64 acc, uint64 val)
+{
+  acc ^= xxh64_round(0, val);
+  return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+static void xxh64_init(Xxh64Context *c)
+{
+  c->acc[0] = XXH_PRIME64_1 + XXH_PRIME64_2;
+  c->acc[1] = XXH_PRIME64_2;
+  c->acc[2] = 0;
+  c->acc[3] = 0 - XXH_PRIME64_1;
+  c->length = 0;
+}
+
+static void xxh64_stripe(Xxh64Context *c, const byte *data)
+{
+  c->acc[0] = xxh64_round(c->acc[0], read_le64(data));
+  c->acc[1] = xxh64_round(c->acc[1], read_le64(data + 8));
+  c->acc[2] = xxh64_round(c->acc[2], read_le64(data + 16));
+  c->acc[3] = xxh64_round(c->acc[3], read_le64(data + 24));
+}
+
+static void xxh64_update(Xxh64Context *c, const byte *data, size_t size)
+{
+  size_t fill = (size_t) (c->length & 31);
+
+  c->length += size;
+  if (fill > 0)
+  {
+    size_t n = (32 - fill < size) ? 32 - fill : size;
+
+    memcpy(c->block + fill, data, n);
+    data += n;
+    size -= n;
+    if (fill + n < 32)
+      return;
+    xxh64_stripe(c, c->block);
+  }
+  for (; size >= 32; data += 32, size -= 32)
+    xxh64_stripe(c, data);
+  memcpy(c->block, data, size);
+}
+
+static void xxh64_final(Xxh64Context *c, byte *digest)
+{
+  const byte *p   = c->block;
+  const byte *end = c->block + (c->length & 31);
+  uint64 h;
+  int i;
+
+  if (c->length >= 32)
+  {
+    h = rotl64(c->acc[0], 1) + rotl64(c->acc[1], 7) + rotl64(c->acc[2], 12) + rotl64(c->acc[3], 18);
+    for (i = 0; i < 4; ++i)
+      h = xxh64_merge_round(h, c->acc[i]);
+  }
+  else
+    h = XXH_PRIME64_5;
+  h += c->length;
+
+  for (; p + 8 <= end; p += 8)
+  {
+    h ^= xxh64_round(0, read_le64(p));
+    h  = rotl64(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+  }
+  if (p + 4 <= end)
+  {
+    h ^= (uint64) read_le32(p) * XXH_PRIME64_1;
+    h  = rotl64(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+    p += 4;
+  }
+  for (; p < end; ++p)
+  {
+    h ^= *p * XXH_PRIME64_5;
+    h  = rotl64(h, 11) * XXH_PRIME64_1;
+  }
+
+  h ^= h >> 33;
+  h *= XXH_PRIME64_2;
+  h ^= h >> 29;
+  h *= XXH_PRIME64_3;
+  h ^= h >> 32;
+
+  // canonical big endian representation, as printed by xxhsum
+  for (i = 0; i < 8; ++i)
+    digest[i] = (byte) (h >> (56 - 8 * i));
+}
+
+/*
+ * digest selection
+ */
+
+static void hash_init(int type, HashContext *c)
+{
+  switch (type)
+  {
+  case HASH_MD5:
+    md5_init(&c->md5);
+    break;
+  case HASH_CRC:
+    c->crc = 0;
+    break;
+  default:
+    xxh64_init(&c->xxh);
+    break;
+  }
+}
+
+static void hash_update(int type, HashContext *c, const byte *data, size_t size)
+{
+  switch (type)
+  {
+  case HASH_MD5:
+    md5_update(&c->md5, data, size);
+    break;
+  case HASH_CRC:
+    crc_update(&c->crc, data, size);
+    break;
+  default:
+    xxh64_update(&c->xxh, data, size);
+    break;
+  }
+}
+
+//! writes the digest of c as a hexadecimal string to text
+static void hash_final(int type, HashContext *c, char *text)
+{
+  byte digest[MAX_DIGEST_SIZE];
+  int size, i;
+
+  switch (type)
+  {
+  case HASH_MD5:
+    md5_final(&c->md5, digest);
+    size = 16;
+    break;
+  case HASH_CRC:
+    for (i = 0; i < 4; ++i)
+      digest[i] = (byte) (c->crc >> (24 - 8 * i));
+    size = 4;
+    break;
+  default:
+    xxh64_final(&c->xxh, digest);
+    size = 8;
+    break;
+  }
+
+  for (i = 0; i < size; ++i)
+    sprintf(text + 2 * i, "%02x", digest[i]);
+}
+
+static void write_line(int fd, const char *line)
+{
+  size_t size = strlen(line);
+
+  if ((long) write(fd, line, size) != (long) size)
+    error ("write_line: error writing to hash file", 500);
+}
+
+static HashFile *get_hash_file(FrameHash *h, int fd)
+{
+  HashFile *unused = NULL;
+  int i;
+
+  for (i = 0; i < MAX_HASH_FILES; ++i)
+  {
+    if (h->files[i].fd == fd)
+      return &h->files[i];
+    if (h->files[i].fd == -1 && unused == NULL)
+      unused = &h->files[i];
+  }
+  if (unused == NULL)
+    error ("get_hash_file: too many output files", 500);
+
+  unused->fd     = fd;
+  unused->frames = 0;
+  hash_init(h->type, &unused->frame);
+  hash_init(h->type, &unused->sequence);
+  return unused;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    creates the digest state for the given HashType
+ ************************************************************************
+ */
+FrameHash *create_frame_hash(int type)
+{
+  FrameHash *h = (FrameHash *) calloc(1, sizeof(FrameHash));
+  int i;
+
+  if (h == NULL)
+    no_mem_exit("create_frame_hash: h");
+  h->type = type;
+  for (i = 0; i < MAX_HASH_FILES; ++i)
+    h->files[i].fd = -1;
+  if (type == HASH_CRC && crc_table[1] == 0)
+    init_crc_table();
+
+  return h;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    writes the sequence digests of all files and frees the state
+ ************************************************************************
+ */
+void free_frame_hash(FrameHash *h)
+{
+  int i;
+
+  if (h == NULL)
+    return;
+
+  for (i = 0; i < MAX_HASH_FILES; ++i)
+  {
+    if (h->files[i].fd != -1)
+      finish_file_hash(h, h->files[i].fd);
+  }
+  free(h->row);
+  free(h);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    returns a scratch buffer of at least size bytes for converting a
+ *    row of samples
+ ************************************************************************
+ */
+unsigned char *get_hash_row(FrameHash *h, size_t size)
+{
+  if (h->row_size < size)
+  {
+    free(h->row);
+    if ((h->row = (unsigned char *) malloc(size)) == NULL)
+      no_mem_exit("get_hash_row: row");
+    h->row_size = size;
+  }
+  return h->row;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    adds bytes of the current picture of an output file
+ ************************************************************************
+ */
+void hash_frame_data(FrameHash *h, int fd, const unsigned char *data, size_t size)
+{
+  HashFile *f = get_hash_file(h, fd);
+
+  hash_update(h->type, &f->frame, data, size);
+  hash_update(h->type, &f->sequence, data, size);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    writes the digest of the current picture of an output file
+ ************************************************************************
+ */
+void finish_frame_hash(FrameHash *h, int fd)
+{
+  HashFile *f = get_hash_file(h, fd);
+  char line[2 * MAX_DIGEST_SIZE + 32];
+
+  hash_final(h->type, &f->frame, line);
+  sprintf(line + strlen(line), "  frame %d\n", f->frames++);
+  write_line(fd, line);
+  hash_init(h->type, &f->frame);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    writes the digest of everything written to an output file. Must be
+ *    called before fd is closed.
+ ************************************************************************
+ */
+void finish_file_hash(FrameHash *h, int fd)
+{
+  HashFile *f;
+  char line[2 * MAX_DIGEST_SIZE + 32];
+  int i;
+
+  if (h == NULL)
+    return;
+
+  for (i = 0; i < MAX_HASH_FILES && h->files[i].fd != fd; ++i)
+    ;
+  if (i == MAX_HASH_FILES)
+    return;
+
+  f = &h->files[i];
+  hash_final(h->type, &f->sequence, line);
+  strcat(line, "  sequence\n");
+  write_line(fd, line);
+  f->fd = -1;
+}
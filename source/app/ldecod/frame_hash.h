@@ -0,0 +1,34 @@
+
+/*!
+ *************************************************************************************
+ * \file frame_hash.h
+ *
+ * \brief
+ *    Digests of the output pictures written instead of the pictures
+ *
+ *************************************************************************************
+ */
+
+#ifndef _FRAME_HASH_H_
+#define _FRAME_HASH_H_
+
+#include "global.h"
+
+//! digest written by -hash
+typedef enum {
+  HASH_NONE = 0,
+  HASH_MD5  = 1,
+  HASH_CRC  = 2,       //!< CRC-32 as used by zlib
+  HASH_XXH  = 3        //!< XXH64 with seed 0
+} HashType;
+
+typedef struct frame_hash FrameHash;
+
+extern FrameHash     *create_frame_hash(int type);
+extern void           free_frame_hash  (FrameHash *h);
+extern unsigned char *get_hash_row     (FrameHash *h, size_t size);
+extern void           hash_frame_data  (FrameHash *h, int fd, const unsigned char *data, size_t size);
+extern void           finish_frame_hash(FrameHash *h, int fd);
+extern void           finish_file_hash (FrameHash *h, int fd);
+
+#endif
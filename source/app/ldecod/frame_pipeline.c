@@ -0,0 +1,342 @@
+
+/*!
+ *************************************************************************************
+ * \file frame_pipeline.c
+ *
+ * \brief
+ *    Deblocking of a picture in the background while the next picture is
+ *    decoded
+ *
+ *    exit_picture() hands a decoded frame to the pipeline thread and stores
+ *    it in the DPB right away. The thread deblocks the frame one
+ *    macroblock row after the other and advances the ready_rows counter of
+ *    the picture. Motion compensation, output and release of a picture wait
+ *    on that counter, so the next picture can start as soon as the rows its
+ *    motion vectors reach are done.
+ *
+ *    The thread finishes one picture at a time. The macroblock data of the
+ *    picture is swapped with a spare buffer and the slices it points to are
+ *    copied, so the decoder can go on with the next picture. Deblocking
+ *    reads the decoder parameters from a copy that is taken again after
+ *    every drain of the pipeline, which happens on every activation of a
+ *    sequence parameter set.
+ *
+ *************************************************************************************
+ */
+
+#include "global.h"
+#include "memalloc.h"
+#include "image.h"
+#include "loopfilter.h"
+#include "thread_pool.h"
+#include "frame_pipeline.h"
+
+struct frame_pipeline
+{
+  Thread           thread;
+  Mutex            lock;
+  CondVar          changed;        //!< signalled when a picture is handed over or finished, or on shutdown
+  int              shutdown;
+
+  StorablePicture *pending;        //!< picture being finished, NULL if the thread is idle
+  ThreadProgress   rows;           //!< ready_rows of the pending picture
+
+  VideoParameters *vid;            //!< decoder parameters the deblocking reads
+  seq_parameter_set_rbsp_t sps;    //!< active sps of vid
+  int              vid_stale;      //!< vid has to be copied again before the next picture
+
+  Macroblock      *mb_data;        //!< macroblocks of the pending picture, spare buffer when idle
+  int              mb_data_size;
+  Slice           *slice_copy;     //!< copies of the slices of the pending picture
+  Slice          **slice_orig;     //!< slices the copies were taken from
+  int              num_slices;     //!< slices of the pending picture
+  int              max_slices;
+};
+
+/*!
+ ************************************************************************
+ * \brief
+ *    publishes the number of ready macroblock rows of the pending picture
+ ************************************************************************
+ */
+static void set_ready_rows(FramePipeline *pl, StorablePicture *p, int rows)
+{
+  atomic_store_int(&p->ready_rows, rows);
+  set_thread_progress(&pl->rows, rows);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    deblocks the pending picture. A row is final once the row below is
+ *    deblocked.
+ ************************************************************************
+ */
+static void finish_pending_picture(FramePipeline *pl)
+{
+  StorablePicture *p = pl->pending;
+  int num_rows = p->size_y >> 4;
+  int row;
+
+  for (row = 0; row < num_rows; ++row)
+  {
+    DeblockMbRows(pl->vid, p, row, 1);
+    if (row > 0)
+      set_ready_rows(pl, p, row);
+  }
+  set_ready_rows(pl, p, PICTURE_READY);
+}
+
+static void pipeline_main(void *param)
+{
+  FramePipeline *pl = (FramePipeline *) param;
+
+  lock_mutex(&pl->lock);
+  for (;;)
+  {
+    while (!pl->shutdown && pl->pending == NULL)
+      wait_cond(&pl->changed, &pl->lock);
+    if (pl->shutdown)
+      break;
+
+    unlock_mutex(&pl->lock);
+    finish_pending_picture(pl);
+    lock_mutex(&pl->lock);
+
+    pl->pending = NULL;
+    broadcast_cond(&pl->changed);
+  }
+  unlock_mutex(&pl->lock);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    creates the pipeline and its thread
+ *
+ * \return
+ *    the pipeline or NULL if no thread could be started
+ ************************************************************************
+ */
+FramePipeline *create_frame_pipeline(void)
+{
+  FramePipeline *pl = (FramePipeline *) calloc(1, sizeof(FramePipeline));
+
+  if (pl == NULL)
+    no_mem_exit("create_frame_pipeline: pl");
+  if ((pl->vid = (VideoParameters *) malloc(sizeof(VideoParameters))) == NULL)
+    no_mem_exit("create_frame_pipeline: vid");
+
+  init_mutex(&pl->lock);
+  init_cond(&pl->changed);
+  init_thread_progress(&pl->rows, PICTURE_READY);
+  pl->vid_stale = 1;
+
+  if (create_thread(&pl->thread, pipeline_main, pl) != 0)
+  {
+    free_thread_progress(&pl->rows);
+    free_cond(&pl->changed);
+    free_mutex(&pl->lock);
+    free(pl->vid);
+    free(pl);
+    return NULL;
+  }
+
+  return pl;
+}
+
+void free_frame_pipeline(FramePipeline *pl)
+{
+  if (pl == NULL)
+    return;
+
+  lock_mutex(&pl->lock);
+  while (pl->pending != NULL)
+    wait_cond(&pl->changed, &pl->lock);
+  pl->shutdown = 1;
+  broadcast_cond(&pl->changed);
+  unlock_mutex(&pl->lock);
+  join_thread(pl->thread);
+
+  free_thread_progress(&pl->rows);
+  free_cond(&pl->changed);
+  free_mutex(&pl->lock);
+  free(pl->slice_orig);
+  free(pl->slice_copy);
+  free(pl->mb_data);
+  free(pl->vid);
+  free(pl);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    waits until the pending picture is finished and points the
+ *    macroblocks of the spare buffer back to the slices of the decoder
+ ************************************************************************
+ */
+static void wait_pipeline_idle(FramePipeline *pl)
+{
+  Slice *last = pl->slice_copy + pl->num_slices;
+  int i;
+
+  lock_mutex(&pl->lock);
+  while (pl->pending != NULL)
+    wait_cond(&pl->changed, &pl->lock);
+  unlock_mutex(&pl->lock);
+
+  for (i = 0; i < pl->mb_data_size && pl->num_slices > 0; ++i)
+  {
+    Macroblock *currMB = &pl->mb_data[i];
+    if (currMB->p_Slice >= pl->slice_copy && currMB->p_Slice < last)
+      currMB->p_Slice = pl->slice_orig[currMB->p_Slice - pl->slice_copy];
+  }
+  pl->num_slices = 0;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    returns whether the picture can be finished in the background:
+ *    a progressive frame of a single layer decoded without
+ *    concealment
+ ************************************************************************
+ */
+int frame_pipeline_accepts(VideoParameters *p_Vid, StorablePicture *p)
+{
+  InputParameters *p_Inp = p_Vid->p_Inp;
+
+  return p_Vid->frame_pipeline != NULL
+    && p->structure == FRAME && p->frame_mbs_only_flag && !p->mb_aff_frame_flag
+    && p_Vid->separate_colour_plane_flag == 0
+#if (MVC_EXTENSION_ENABLE)
+    && p_Inp->DecodeAllLayers == 0 && p->layer_id == 0
+#endif
+    && p_Inp->conceal_mode == 0
+    && p_Vid->mb_data == p_Vid->p_EncodePar[0]->mb_data;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    copies the slices of the picture and points its macroblocks to the
+ *    copies
+ ************************************************************************
+ */
+static void copy_picture_slices(FramePipeline *pl, VideoParameters *p_Vid, Macroblock *mb_data, int num_mbs)
+{
+  int num_slices = p_Vid->iSliceNumOfCurrPic;
+  int i, k = 0;
+
+  if (num_slices > pl->max_slices)
+  {
+    free(pl->slice_orig);
+    free(pl->slice_copy);
+    pl->slice_copy = (Slice *) malloc(num_slices * sizeof(Slice));
+    pl->slice_orig = (Slice **) malloc(num_slices * sizeof(Slice *));
+    if (pl->slice_copy == NULL || pl->slice_orig == NULL)
+      no_mem_exit("copy_picture_slices: slice_copy");
+    pl->max_slices = num_slices;
+  }
+
+  for (i = 0; i < num_slices; ++i)
+  {
+    pl->slice_copy[i] = *p_Vid->ppSliceList[i];
+    pl->slice_orig[i] = p_Vid->ppSliceList[i];
+  }
+  pl->num_slices = num_slices;
+
+  // consecutive macroblocks mostly belong to the same slice
+  for (i = 0; i < num_mbs; ++i)
+  {
+    Macroblock *currMB = &mb_data[i];
+    int j;
+
+    if (currMB->p_Slice != pl->slice_orig[k])
+    {
+      for (j = 0; j < num_slices && currMB->p_Slice != pl->slice_orig[j]; ++j)
+        ;
+      k = (j < num_slices) ? j : 0;
+    }
+    currMB->p_Slice = &pl->slice_copy[k];
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    hands a decoded frame to the pipeline thread for deblocking. The
+ *    decoder continues with the spare macroblock buffer.
+ ************************************************************************
+ */
+void finish_picture_in_background(VideoParameters *p_Vid, StorablePicture *p)
+{
+  FramePipeline *pl = p_Vid->frame_pipeline;
+  CodingParameters *cps = p_Vid->p_EncodePar[0];
+  Macroblock *mb_data = p_Vid->mb_data;
+  int num_mbs = p_Vid->FrameSizeInMbs;
+
+  wait_pipeline_idle(pl);
+
+  if (pl->mb_data_size != num_mbs)
+  {
+    free(pl->mb_data);
+    if ((pl->mb_data = (Macroblock *) calloc(num_mbs, sizeof(Macroblock))) == NULL)
+      no_mem_exit("finish_picture_in_background: mb_data");
+    pl->mb_data_size = num_mbs;
+  }
+  // the spare buffer gets its neighbours in init_Deblock() of the next picture
+  p_Vid->mb_data = cps->mb_data = pl->mb_data;
+  pl->mb_data = mb_data;
+
+  if (pl->vid_stale)
+  {
+    memcpy(pl->vid, p_Vid, sizeof(VideoParameters));
+    pl->sps = *p_Vid->active_sps;
+    pl->vid->active_sps = &pl->sps;
+    pl->vid_stale = 0;
+  }
+  pl->vid->mb_data = mb_data;
+  copy_picture_slices(pl, p_Vid, mb_data, p->PicSizeInMbs);
+
+  p->ready_rows = 0;
+  p->ready_progress = &pl->rows;
+  set_thread_progress(&pl->rows, 0);
+
+  lock_mutex(&pl->lock);
+  pl->pending = p;
+  broadcast_cond(&pl->changed);
+  unlock_mutex(&pl->lock);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    waits until the pipeline has finished its picture. The decoder
+ *    parameters are copied again for the next picture.
+ ************************************************************************
+ */
+void drain_frame_pipeline(VideoParameters *p_Vid)
+{
+  FramePipeline *pl = p_Vid->frame_pipeline;
+
+  if (pl == NULL)
+    return;
+
+  wait_pipeline_idle(pl);
+  pl->vid_stale = 1;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    waits until the given number of macroblock rows of a picture, or
+ *    the whole picture for PICTURE_READY, is deblocked.
+ *    Only the picture handed to the pipeline last can be unfinished.
+ ************************************************************************
+ */
+void wait_picture_rows(StorablePicture *p, int rows)
+{
+  if (atomic_load_int(&p->ready_rows) < rows)
+    wait_thread_progress(p->ready_progress, rows);
+}
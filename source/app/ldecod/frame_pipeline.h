@@ -0,0 +1,55 @@
+
+/*!
+ *************************************************************************************
+ * \file frame_pipeline.h
+ *
+ * \brief
+ *    Deblocking of a picture in the background while the next picture is
+ *    decoded
+ *
+ *************************************************************************************
+ */
+
+#ifndef _FRAME_PIPELINE_H_
+#define _FRAME_PIPELINE_H_
+
+#include <limits.h>
+
+#include "global.h"
+#include "mbuffer.h"
+#include "threading.h"
+
+#define PICTURE_READY  INT_MAX   //!< ready_rows of a picture that is completely deblocked
+
+typedef struct frame_pipeline FramePipeline;
+
+extern FramePipeline *create_frame_pipeline(void);
+extern void free_frame_pipeline   (FramePipeline *pl);
+extern int  frame_pipeline_accepts(VideoParameters *p_Vid, StorablePicture *p);
+extern void finish_picture_in_background(VideoParameters *p_Vid, StorablePicture *p);
+extern void drain_frame_pipeline  (VideoParameters *p_Vid);
+extern void wait_picture_rows     (StorablePicture *p, int rows);
+
+/*!
+ ************************************************************************
+ * \brief
+ *    waits until the samples of a picture are final up to the given
+ *    line
+ *
+ * \param p
+ *    picture
+ * \param last_line
+ *    last line read, relative to the picture
+ * \param height
+ *    lines of the plane
+ * \param lines_per_row
+ *    lines of one macroblock row of the plane
+ ************************************************************************
+ */
+static inline void wait_picture_lines(StorablePicture *p, int last_line, int height, int lines_per_row)
+{
+  if (atomic_load_int(&p->ready_rows) != PICTURE_READY)
+    wait_picture_rows(p, (last_line < height) ? imax(last_line, 0) / lines_per_row + 1 : PICTURE_READY);
+}
+
+#endif
@@ -78,6 +78,24 @@ typedef struct infos
 }INFOs;
 INFOs endInfo;
 
+//! Metadata extraction step recorded while a slice is parsed, see Data_Extractor.c
+typedef struct md_event
+{
+  int   mb_addr;                   //!< macroblock the step belongs to
+  short kind;                      //!< MD_EVENT_FINISH, MD_EVENT_GATE or an MD_EVENT_BIT* kind
+  short value;                     //!< PLNZ of the block, or the sign bit for MD_EVENT_BIT16
+  short block;                     //!< luma 4x4 block of an MD_EVENT_BIT* step in raster order
+} MDEvent;
+
+//! Extraction steps of one slice, replayed in slice order once the picture is decoded
+typedef struct md_log
+{
+  MDEvent *event;
+  int      count;
+  int      size;
+  int      finish_logged;          //!< MD_EVENT_FINISH already recorded for this slice
+} MDLog;
+
 /***********************************************************************
  * T y p e    d e f i n i t i o n s    f o r    J M
  ***********************************************************************
@@ -198,6 +216,15 @@ typedef struct
   BiContextType  abs_contexts [NUM_BLOCK_TYPES][NUM_ABS_CTX];
 } TextureInfoContexts;
 
+#define NUM_CTX_INIT_MODELS 4   //!< I/SI tables plus the three P/B cabac_init_idc tables
+
+//! fully initialized context models for one (slice type, cabac_init_idc, SliceQP) triple
+typedef struct
+{
+  MotionInfoContexts  mot_ctx;
+  TextureInfoContexts tex_ctx;
+} CabacContextSet;
+
 
 //*********************** end of data type definition for CABAC *******************
 
@@ -460,6 +487,7 @@ typedef struct slice
   byte                bottom_field_flag;
   PictureStructure    structure;     //!< Identify picture structure type
   int                 start_mb_nr;   //!< MUST be set by NAL even in case of ei_flag == 1
+  int                 decoded_in_parallel; //!< neighbours are available from the first macroblock of the slice on, their slice_nr is not read
   int                 end_mb_nr_plus1;
   int                 max_part_nr;
   int                 dp_mode;       //!< data partitioning mode
@@ -538,6 +566,9 @@ typedef struct slice
 
   // Cabac
   int  coeff[64]; // one more for EOB
+  int  cabac_coeff[64];            //!< levels of the current 8x8 luma block for metadata extraction
+  MDLog md_log;                    //!< metadata extraction steps of this slice
+  struct se_trace_buffer *se_trace_buf; //!< syntax element records not written yet, NULL without -trace bin
   int  coeff_ctr;
   int  pos;  
 
@@ -569,12 +600,12 @@ typedef struct slice
   int max_mb_vmv_r;                          //!< maximum vertical motion vector range in luma quarter pixel units for the current level_idc
   int ref_flag[17];                //!< 0: i-th previous frame is incorrect
 
-  int erc_mvperMB;
   Macroblock *mb_data;
   struct storable_picture *dec_picture;
   int **siblock;
   byte **ipredmode;
   char  *intra_block;
+  byte ****nz_coeff;
   char  chroma_vector_adjustment[6][32];
   void (*read_CBP_and_coeffs_from_NAL) (Macroblock *currMB);
   int  (*decode_one_component     )    (Macroblock *currMB, ColorPlane curr_plane, imgpel **currImg, struct storable_picture *dec_picture);
@@ -684,6 +715,7 @@ typedef struct coding_par
   byte **ipredmode;                  //!< prediction type [90][74]
   byte **ipredmode_JV[MAX_PLANE];
   byte ****nz_coeff;
+  byte ****nz_coeff_JV[MAX_PLANE];  //!< nz_coeff of each colour plane, parts of nz_coeff
   int **siblock;
   int **siblock_JV[MAX_PLANE];
   int *qp_per_matrix;
@@ -699,6 +731,18 @@ typedef struct layer_par
   struct decoded_picture_buffer *p_Dpb;
 }LayerParameters;
 
+//! deblocking of the current picture one macroblock row behind the reconstruction
+typedef struct row_deblock
+{
+  int active;                //!< rows of the current picture are finished while it is reconstructed
+  int deblock;               //!< deblock the current picture
+  int next_mb;               //!< macroblocks reconstructed in raster order so far, -1 once out of order
+  int rows_deblocked;        //!< macroblock rows deblocked so far
+} RowDeblock;
+
+//! receives the payload of a user_data_unregistered SEI message, which is only valid during the call
+typedef void (*SEIUserDataCallback)(void *opaque, const byte *uuid, const byte *data, int size);
+
 // video parameters
 typedef struct video_par
 {
@@ -743,6 +787,7 @@ typedef struct video_par
   byte **ipredmode;                  //!< prediction type [90][74]
   byte **ipredmode_JV[MAX_PLANE];
   byte ****nz_coeff;
+  byte ****nz_coeff_JV[MAX_PLANE];  //!< nz_coeff of each colour plane, parts of nz_coeff
   int **siblock;
   int **siblock_JV[MAX_PLANE];
   BlockPos *PicPos;
@@ -861,12 +906,15 @@ typedef struct video_par
   int *qp_per_matrix;
   int *qp_rem_matrix;
 
+  CabacContextSet *ctx_init_cache[NUM_CTX_INIT_MODELS][MAX_QP + 1]; //!< lazily filled CABAC context initializations
+
   struct frame_store *last_out_fs;
   int pocs_in_dpb[100];
 
   struct storable_picture *dec_picture;
   struct storable_picture *dec_picture_JV[MAX_PLANE];  //!< dec_picture to be used during 4:4:4 independent mode decoding
   struct storable_picture *no_reference_picture; //!< dummy storable picture for recovery point
+  struct picture_pool     *pic_pool;             //!< released pictures kept for reuse
 
   // Error parameters
   struct object_buffer  *erc_object_list;
@@ -877,6 +925,7 @@ typedef struct video_par
   int ec_flag[SE_MAX_ELEMENTS];        //!< array to set errorconcealment
 
   struct annex_b_struct *annex_b;
+  struct rtp_reader     *rtp;
 
   struct frame_store *out_buffer;
 
@@ -884,8 +933,6 @@ typedef struct video_par
   int    pending_output_state;
   int    recovery_flag;
 
-  int BitStreamFile;
-
   // report
   char cslice_type[9];  
   // FMO
@@ -902,7 +949,7 @@ typedef struct video_par
   void (*get_mb_block_pos) (BlockPos *PicPos, int mb_addr, short *x, short *y);
   void (*GetStrengthVer)   (Macroblock *MbQ, int edge, int mvlimit, struct storable_picture *p);
   void (*GetStrengthHor)   (Macroblock *MbQ, int edge, int mvlimit, struct storable_picture *p);
-  void (*EdgeLoopLumaVer)  (ColorPlane pl, imgpel** Img, byte *Strength, Macroblock *MbQ, int edge);
+  void (*EdgeLoopLumaVer)  (ColorPlane pl, imgpel** Img, byte *Strength, Macroblock *MbQ, int edge, struct storable_picture *p);
   void (*EdgeLoopLumaHor)  (ColorPlane pl, imgpel** Img, byte *Strength, Macroblock *MbQ, int edge, struct storable_picture *p);
   void (*EdgeLoopChromaVer)(imgpel** Img, byte *Strength, Macroblock *MbQ, int edge, int uv, struct storable_picture *p);
   void (*EdgeLoopChromaHor)(imgpel** Img, byte *Strength, Macroblock *MbQ, int edge, int uv, struct storable_picture *p);
@@ -978,6 +1025,18 @@ typedef struct video_par
 /******************* end deprecative variables; ***************************************/
 
   struct dec_stat_parameters *dec_stats;
+  struct thread_pool *thread_pool;           //!< workers for slice parallel decoding, NULL when single threaded
+  struct mb_wavefront *mb_wavefront;         //!< buffers for macroblock row parallel decoding, allocated on first use
+  struct frame_pipeline *frame_pipeline;     //!< thread finishing the previous picture, NULL when single threaded
+  struct deblock_wavefront *deblock_wavefront; //!< row progress of parallel deblocking, allocated on first use
+  struct yuv_writer *yuv_writer;             //!< thread writing the output files, NULL when they are written directly
+  struct frame_hash *frame_hash;             //!< digests written instead of the output pictures, NULL without -hash
+  struct se_trace *se_trace;                 //!< binary syntax element trace, NULL without -trace bin
+  struct mb_meta *mb_meta;                   //!< per macroblock metadata columns, NULL without -mbmeta
+  uint64 sei_types[SEI_TYPE_WORDS];          //!< SEI payload types interpreted, see parse_sei_types()
+  SEIUserDataCallback sei_user_data_callback; //!< set with SetSEIUserDataCallback(), NULL if none
+  void  *sei_user_data_opaque;
+  RowDeblock row_deblock;                    //!< deblocking behind the reconstruction (DeblockRows)
 } VideoParameters;
 
 
@@ -1000,6 +1059,9 @@ typedef struct inp_par
   char reffile[FILE_NAME_SIZE];                      //!< Optional YUV 4:2:0 reference file for SNR measurement
 
   int FileFormat;                         //!< File format of the Input file, PAR_OF_ANNEXB or PAR_OF_RTP
+  int rtp_reorder_packets;                //!< packets the reorder buffer of live RTP input holds
+  int rtp_jitter_ms;                      //!< time a missing live RTP packet is waited for
+  int rtp_timeout_ms;                     //!< time without live RTP packets that ends the stream, 0: none
   int ref_offset;
   int poc_scale;
   int write_uv;
@@ -1044,6 +1106,19 @@ typedef struct inp_par
 
   int bDisplayDecParams;
   int dpb_plus[2];
+  int simd_level;                       //!< highest SIMD kernel set to use (0: C only, 1: SSE4.1, 2: AVX2)
+  int num_threads;                      //!< number of decoding threads, 1 decodes single threaded
+  int deblock_rows;                     //!< deblock every macroblock row one row behind the reconstruction
+  int output_buffers;                   //!< pictures queued for the output writer thread, 0 writes on the decoding thread
+  int output_direct;                    //!< write the output files with O_DIRECT
+  int hash_type;                        //!< digest written instead of the output pictures, see HashType
+  char mem_stats_file[FILE_NAME_SIZE];  //!< JSON file the memory usage is written to at exit, none if empty
+  int se_trace_mode;                    //!< syntax element trace written while decoding, see SETraceMode
+  char se_trace_file[FILE_NAME_SIZE];   //!< file of the binary syntax element trace
+  char mb_meta_file[FILE_NAME_SIZE];    //!< prefix of the per macroblock metadata columns, none if empty
+  char sei_types[FILE_NAME_SIZE];       //!< SEI payload types interpreted: all, none or a list of types
+  char sei_user_data_file[FILE_NAME_SIZE]; //!< file the user_data_unregistered SEI payloads are written to, none if empty
+  char extract_info[FILE_NAME_SIZE];    //!< FrameNum,SliceMbNum,Threshold,MetaDataNum,FrameType of the extraction, from the trailer of the input file if empty
 } InputParameters;
 
 typedef struct old_slice_par
@@ -1091,6 +1166,7 @@ extern int EBSPtoRBSP(byte *streamBuffer, int end_bytepos, int begin_bytepos);
 
 extern void FreePartition (DataPartition *dp, int n);
 extern DataPartition *AllocPartition(int n);
+extern void AllocPartitionBuffers(DataPartition *partArr, int n);
 
 extern void tracebits (const char *trace_str, int len, int info, int value1);
 extern void tracebits2(const char *trace_str, int len, int info);
@@ -47,6 +47,7 @@ int DecodeOneFrame(DecodedPicList **ppDecPic);
 int FinitDecoder(DecodedPicList **ppDecPicList);
 int CloseDecoder();
 int SetOptsDecoder(DecSet_t *pDecOpts);
+int SetSEIUserDataCallback(SEIUserDataCallback callback, void *opaque);
 
 #ifdef __cplusplus
 }
@@ -261,6 +261,8 @@ int RestOfSliceHeader(Slice *currSlice)
   if (p_Vid->active_pps->entropy_coding_mode_flag && currSlice->slice_type != I_SLICE && currSlice->slice_type != SI_SLICE)
   {
     currSlice->model_number = read_ue_v("SH: cabac_init_idc", currStream, &p_Dec->UsedBits);
+    if (currSlice->model_number > 2)
+      error ("cabac_init_idc out of range", 500);
   }
   else
   {
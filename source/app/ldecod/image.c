@@ -60,8 +60,18 @@
 #include "fast_memory.h"
 
 #include "mc_prediction.h"
+#include "thread_pool.h"
+#include "mb_wavefront.h"
+#include "frame_pipeline.h"
+#include "se_trace.h"
+#include "mb_meta.h"
+#include "Data_Extractor.h"
+
 extern int testEndian(void);
 void reorder_lists(Slice *currSlice);
+static void init_slice_mb_decoding  (Slice *currSlice);
+static void decode_slice_macroblocks(Slice *currSlice);
+static void ercWriteMBMODEandMV     (Macroblock *currMB, StorablePicture *dec_picture);
 
 static inline void reset_mbs(Macroblock *currMB)
 {
@@ -87,6 +97,7 @@ static void setup_buffers(VideoParameters *p_Vid, int layer_id)
        p_Vid->intra_block_JV[i] = cps->intra_block_JV[i];
        p_Vid->ipredmode_JV[i] = cps->ipredmode_JV[i];
        p_Vid->siblock_JV[i] = cps->siblock_JV[i];
+       p_Vid->nz_coeff_JV[i] = cps->nz_coeff_JV[i];
      }
      p_Vid->mb_data = NULL;
      p_Vid->intra_block = NULL;
@@ -263,7 +274,10 @@ static void init_picture(VideoParameters *p_Vid, Slice *currSlice, InputParamete
     gettime (&(p_Vid->start_time));             // start time
   }
 
-  dec_picture = p_Vid->dec_picture = alloc_storable_picture (p_Vid, currSlice->structure, p_Vid->width, p_Vid->height, p_Vid->width_cr, p_Vid->height_cr, 1);
+  if (currSlice->structure == FRAME)
+    dec_picture = p_Vid->dec_picture = alloc_storable_picture_noclear (p_Vid, FRAME, p_Vid->width, p_Vid->height, p_Vid->width_cr, p_Vid->height_cr, 1);
+  else
+    dec_picture = p_Vid->dec_picture = alloc_field_picture (p_Vid, currSlice->p_Dpb, currSlice->structure, currSlice->frame_num);
   dec_picture->top_poc=currSlice->toppoc;
   dec_picture->bottom_poc=currSlice->bottompoc;
   dec_picture->frame_poc=currSlice->framepoc;
@@ -284,14 +298,6 @@ static void init_picture(VideoParameters *p_Vid, Slice *currSlice, InputParamete
   }
 #endif
 
-  // reset all variables of the error concealment instance before decoding of every frame.
-  // here the third parameter should, if perfectly, be equal to the number of slices per frame.
-  // using little value is ok, the code will allocate more memory if the slice number is larger
-#if (DISABLE_ERC == 0)
-  ercReset(p_Vid->erc_errorVar, p_Vid->PicSizeInMbs, p_Vid->PicSizeInMbs, dec_picture->size_x);
-#endif
-  p_Vid->erc_mvperMB = 0;
-
   switch (currSlice->structure )
   {
   case TOP_FIELD:
@@ -326,7 +332,9 @@ static void init_picture(VideoParameters *p_Vid, Slice *currSlice, InputParamete
   // CAVLC init
   if (p_Vid->active_pps->entropy_coding_mode_flag == (Boolean) CAVLC)
   {
-    memset(p_Vid->nz_coeff[0][0][0], -1, p_Vid->PicSizeInMbs * 48 *sizeof(byte)); // 3 * 4 * 4
+    int nplanes = (p_Vid->separate_colour_plane_flag != 0) ? MAX_PLANE : 1;
+    for( nplane=0; nplane<nplanes; ++nplane )
+      memset(p_Vid->nz_coeff[nplane * p_Vid->FrameSizeInMbs][0][0], -1, p_Vid->PicSizeInMbs * 48 *sizeof(byte)); // 3 * 4 * 4
   }
 
   // Set the slice_nr member of each MB to -1, to ensure correct when packet loss occurs
@@ -372,6 +380,9 @@ static void init_picture(VideoParameters *p_Vid, Slice *currSlice, InputParamete
     fast_memset(p_Vid->ipredmode[0], DC_PRED, 16 * p_Vid->FrameHeightInMbs * p_Vid->PicWidthInMbs * sizeof(char));
   }  
 
+  if (p_Vid->mb_meta != NULL)
+    start_mb_meta_picture(p_Vid->mb_meta, p_Vid->PicSizeInMbs);
+
   dec_picture->slice_type = p_Vid->type;
   dec_picture->used_for_reference = (currSlice->nal_reference_idc != 0);
   dec_picture->idr_flag = currSlice->idr_flag;
@@ -431,10 +442,9 @@ static void init_picture(VideoParameters *p_Vid, Slice *currSlice, InputParamete
   if( (p_Vid->separate_colour_plane_flag != 0) )
   {
     p_Vid->dec_picture_JV[0] = p_Vid->dec_picture;
-    p_Vid->dec_picture_JV[1] = alloc_storable_picture (p_Vid, (PictureStructure) currSlice->structure, p_Vid->width, p_Vid->height, p_Vid->width_cr, p_Vid->height_cr, 1);
-    copy_dec_picture_JV( p_Vid, p_Vid->dec_picture_JV[1], p_Vid->dec_picture_JV[0] );
-    p_Vid->dec_picture_JV[2] = alloc_storable_picture (p_Vid, (PictureStructure) currSlice->structure, p_Vid->width, p_Vid->height, p_Vid->width_cr, p_Vid->height_cr, 1);
-    copy_dec_picture_JV( p_Vid, p_Vid->dec_picture_JV[2], p_Vid->dec_picture_JV[0] );
+    // the colour planes are decoded straight into the chroma planes of the frame
+    p_Vid->dec_picture_JV[1] = alloc_colour_plane_picture (dec_picture, PLANE_U);
+    p_Vid->dec_picture_JV[2] = alloc_colour_plane_picture (dec_picture, PLANE_V);
   }
 }
 
@@ -668,6 +678,79 @@ static void init_picture_decoding(VideoParameters *p_Vid)
 #endif
   }
   p_Vid->iDeblockMode = iDeblockMode;
+  p_Vid->row_deblock.active = FALSE;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    enables deblocking behind the reconstruction for the
+ *    current picture if it is a frame that is reconstructed row by row
+ *    in raster order
+ ************************************************************************
+ */
+static void init_row_deblocking(VideoParameters *p_Vid)
+{
+  RowDeblock *rd = &p_Vid->row_deblock;
+  StorablePicture *p = p_Vid->dec_picture;
+
+  rd->deblock = !p_Vid->iDeblockMode && (p_Vid->bDeblockEnable & (1 << p->used_for_reference));
+  rd->next_mb = 0;
+  rd->rows_deblocked = 0;
+  rd->active = p_Vid->p_Inp->deblock_rows && rd->deblock
+    && p->structure == FRAME && !p->mb_aff_frame_flag
+    && p_Vid->separate_colour_plane_flag == 0
+    && p_Vid->active_pps->num_slice_groups_minus1 == 0;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    deblocks the macroblock rows above the last of the first rows
+ *    reconstructed rows. The last row has to stay unfiltered for the
+ *    intra prediction of the next row.
+ ************************************************************************
+ */
+void deblock_reconstructed_rows(VideoParameters *p_Vid, int rows)
+{
+  RowDeblock *rd = &p_Vid->row_deblock;
+  StorablePicture *p = p_Vid->dec_picture;
+
+  for (; rd->rows_deblocked < rows - 1; ++rd->rows_deblocked)
+    DeblockMbRows(p_Vid, p, rd->rows_deblocked, 1);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    counts a reconstructed macroblock and finishes the rows behind
+ *    once a row is complete. Rows are only counted while the
+ *    macroblocks come in raster order.
+ ************************************************************************
+ */
+static void row_deblock_mb_done(VideoParameters *p_Vid, int mb_nr)
+{
+  RowDeblock *rd = &p_Vid->row_deblock;
+
+  if (mb_nr != rd->next_mb)
+    rd->next_mb = -1;
+  else if (++rd->next_mb % p_Vid->PicWidthInMbs == 0)
+    deblock_reconstructed_rows(p_Vid, rd->next_mb / p_Vid->PicWidthInMbs);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    deblocks the rows of the current picture left after
+ *    the reconstruction and error concealment
+ ************************************************************************
+ */
+static void finish_row_deblocking(VideoParameters *p_Vid)
+{
+  int num_rows = p_Vid->dec_picture->PicSizeInMbs / p_Vid->dec_picture->PicWidthInMbs;
+
+  deblock_reconstructed_rows(p_Vid, num_rows + 1);
+  p_Vid->row_deblock.active = FALSE;
 }
 
 void init_slice(VideoParameters *p_Vid, Slice *currSlice)
@@ -728,7 +811,13 @@ void init_slice(VideoParameters *p_Vid, Slice *currSlice)
   }
 }
 
-void decode_slice(Slice *currSlice, int current_header)
+/*!
+ ************************************************************************
+ * \brief
+ *    initializes the entropy decoder and weighted prediction of a slice
+ ************************************************************************
+ */
+static void init_slice_decoding(Slice *currSlice)
 {
   if (currSlice->active_pps->entropy_coding_mode_flag)
   {
@@ -739,11 +828,26 @@ void decode_slice(Slice *currSlice, int current_header)
   if ( (currSlice->active_pps->weighted_bipred_idc > 0  && (currSlice->slice_type == B_SLICE)) || (currSlice->active_pps->weighted_pred_flag && currSlice->slice_type !=I_SLICE))
     fill_wp_params(currSlice);
 
+  if (currSlice->p_Vid->se_trace != NULL)
+    start_se_trace(currSlice);
+}
+
+static inline int slice_has_macroblocks(Slice *currSlice, int current_header)
+{
+  return (current_header == SOP || current_header == SOS) && currSlice->ei_flag == 0;
+}
+
+void decode_slice(Slice *currSlice, int current_header)
+{
+  init_slice_decoding(currSlice);
+
   //printf("frame picture %d %d %d\n",currSlice->structure,currSlice->ThisPOC,currSlice->direct_spatial_mv_pred_flag);
 
   // decode main slice information
-  if ((current_header == SOP || current_header == SOS) && currSlice->ei_flag == 0)
+  if (slice_has_macroblocks(currSlice, current_header))
     decode_one_slice(currSlice);
+  if (currSlice->p_Vid->se_trace != NULL)
+    end_se_trace_slice(currSlice);
 
   // setMB-Nr in case this slice was lost
   // if(currSlice->ei_flag)
@@ -751,6 +855,128 @@ void decode_slice(Slice *currSlice, int current_header)
 
 }
 
+/*!
+ ************************************************************************
+ * \brief
+ *    returns whether the slices of the current picture can be decoded
+ *    concurrently.
+ *
+ *    Macroblocks only reference neighbours of their own slice, but the
+ *    macroblock layer reads the active PPS and the macroblock array
+ *    through p_Vid, so all slices have to share them. Without slice
+ *    groups every slice covers the macroblocks from its first one up to
+ *    the first one of the next slice, which lets a slice tell its
+ *    neighbours apart without reading the slice_nr other slices write.
+ *
+ *    The colour planes of a 4:4:4 independent picture are decoded into
+ *    buffers of their own, reached through the slice. The MBAFF neighbour
+ *    derivation still reads p_Vid->mb_data, which is only valid for one
+ *    plane at a time, so MBAFF pictures are decoded plane after plane.
+ ************************************************************************
+ */
+static int slices_decodable_in_parallel(VideoParameters *p_Vid)
+{
+  Slice **ppSliceList = p_Vid->ppSliceList;
+  int iSliceNo;
+
+  if (p_Vid->thread_pool == NULL || p_Vid->iSliceNumOfCurrPic < 2)
+    return FALSE;
+  if (ppSliceList[0]->active_pps->num_slice_groups_minus1 != 0)
+    return FALSE;
+
+  for (iSliceNo = 0; iSliceNo < p_Vid->iSliceNumOfCurrPic; iSliceNo++)
+  {
+    if (ppSliceList[iSliceNo]->active_pps != ppSliceList[0]->active_pps)
+      return FALSE;
+    if (p_Vid->separate_colour_plane_flag != 0 && ppSliceList[iSliceNo]->mb_aff_frame_flag)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+static void decode_slice_job(void *arg, int job)
+{
+  Slice *currSlice = ((VideoParameters *) arg)->ppSliceList[job];
+
+  if (slice_has_macroblocks(currSlice, currSlice->current_header))
+    decode_slice_macroblocks(currSlice);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    decodes the slices of the current picture on the thread pool.
+ *
+ *    Everything that touches state shared between the slices (reference
+ *    lists, reference picture planes, the CABAC context cache) is set up
+ *    for all slices first, the jobs only parse and reconstruct the
+ *    macroblocks. The jobs test the availability of neighbours against the
+ *    first macroblock of their slice, as the slice_nr of a neighbour may be
+ *    written by another job at the same time.
+ ************************************************************************
+ */
+static void decode_slices_parallel(VideoParameters *p_Vid)
+{
+  int iSliceNo;
+
+  for (iSliceNo = 0; iSliceNo < p_Vid->iSliceNumOfCurrPic; iSliceNo++)
+  {
+    Slice *currSlice = p_Vid->ppSliceList[iSliceNo];
+
+    assert(currSlice->current_header != EOS);
+    assert(currSlice->current_slice_nr == iSliceNo);
+
+    init_slice(p_Vid, currSlice);
+    init_slice_decoding(currSlice);
+    if (slice_has_macroblocks(currSlice, currSlice->current_header))
+      init_slice_mb_decoding(currSlice);
+    currSlice->decoded_in_parallel = TRUE;
+  }
+
+  run_thread_jobs(p_Vid->thread_pool, decode_slice_job, p_Vid, p_Vid->iSliceNumOfCurrPic);
+
+  for (iSliceNo = 0; iSliceNo < p_Vid->iSliceNumOfCurrPic; iSliceNo++)
+    p_Vid->ppSliceList[iSliceNo]->decoded_in_parallel = FALSE;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    returns whether the macroblock rows of a picture coded as one slice
+ *    can be reconstructed concurrently.
+ *
+ *    The wavefront walks the picture in raster order, which rules out
+ *    MBAFF macroblock pairs and slice groups.
+ ************************************************************************
+ */
+static int slice_decodable_in_wavefront(VideoParameters *p_Vid)
+{
+  Slice *currSlice = p_Vid->ppSliceList[0];
+
+  return thread_pool_size(p_Vid->thread_pool) > 1
+    && p_Vid->iSliceNumOfCurrPic == 1
+    && slice_has_macroblocks(currSlice, currSlice->current_header)
+    && currSlice->start_mb_nr == 0
+    && currSlice->mb_aff_frame_flag == 0
+    && p_Vid->separate_colour_plane_flag == 0
+    && p_Vid->active_pps->num_slice_groups_minus1 == 0
+    && p_Vid->PicSizeInMbs > p_Vid->PicWidthInMbs;
+}
+
+static void decode_slice_rows_parallel(VideoParameters *p_Vid)
+{
+  Slice *currSlice = p_Vid->ppSliceList[0];
+
+  assert(currSlice->current_header != EOS);
+
+  init_slice(p_Vid, currSlice);
+  init_slice_decoding(currSlice);
+  init_slice_mb_decoding(currSlice);
+  decode_slice_wavefront(currSlice);
+  if (p_Vid->se_trace != NULL)
+    end_se_trace_slice(currSlice);
+}
+
 
 /*!
  ************************************************************************
@@ -927,7 +1153,18 @@ int decode_one_frame(DecoderParams *pDecoder)
   iRet = current_header;
   init_picture_decoding(p_Vid);
 
+  if (slices_decodable_in_parallel(p_Vid))
   {
+    decode_slices_parallel(p_Vid);
+  }
+  else if (slice_decodable_in_wavefront(p_Vid))
+  {
+    init_row_deblocking(p_Vid);
+    decode_slice_rows_parallel(p_Vid);
+  }
+  else
+  {
+    init_row_deblocking(p_Vid);
     for(iSliceNo=0; iSliceNo<p_Vid->iSliceNumOfCurrPic; iSliceNo++)
     {
       currSlice = ppSliceList[iSliceNo];
@@ -939,12 +1176,24 @@ int decode_one_frame(DecoderParams *pDecoder)
 
       init_slice(p_Vid, currSlice);
       decode_slice(currSlice, current_header);
-
-      p_Vid->iNumOfSlicesDecoded++;
-      p_Vid->num_dec_mb += currSlice->num_dec_mb;
-      p_Vid->erc_mvperMB += currSlice->erc_mvperMB;
     }
   }
+
+  for(iSliceNo=0; iSliceNo<p_Vid->iSliceNumOfCurrPic; iSliceNo++)
+  {
+    currSlice = ppSliceList[iSliceNo];
+
+    if (p_Vid->mb_meta != NULL && currSlice->colour_plane_id == PLANE_Y)
+      ReplayExtractLog(&currSlice->md_log, p_Vid->mb_meta->payload_mask, p_Vid->mb_meta->payload_bits);
+    else
+      ReplayExtractLog(&currSlice->md_log, NULL, NULL);
+    p_Vid->iNumOfSlicesDecoded++;
+    p_Vid->num_dec_mb += currSlice->num_dec_mb;
+  }
+  if (p_Vid->se_trace != NULL)
+    end_se_trace_picture(p_Vid);
+  if (p_Vid->mb_meta != NULL)
+    end_mb_meta_picture(p_Vid);
 #if MVC_EXTENSION_ENABLE
   p_Vid->last_dec_view_id = p_Vid->dec_picture->view_id;
 #endif
@@ -1151,6 +1400,8 @@ void find_snr(VideoParameters *p_Vid,
   // picture error concealment
   char yuv_types[4][6]= {"4:0:0","4:2:0","4:2:2","4:4:4"};
 
+  wait_picture_rows(p, PICTURE_READY);
+
   max_pix_value_sqd[0] = iabs2(p_Vid->max_pel_value_comp[0]);
   max_pix_value_sqd[1] = iabs2(p_Vid->max_pel_value_comp[1]);
   max_pix_value_sqd[2] = iabs2(p_Vid->max_pel_value_comp[2]);
@@ -1570,6 +1821,7 @@ process_nalu:
       currSlice->dp_mode     = PAR_DP_3;
       currSlice->max_part_nr = 3;
       currSlice->ei_flag     = 0;
+      AllocPartitionBuffers(currSlice->partArr, 3);
 #if MVC_EXTENSION_ENABLE
       currSlice->p_Dpb = p_Vid->p_Dpb_layer[0];
 #endif
@@ -1787,83 +2039,73 @@ process_nalu:
   }
 }
 
-void pad_buf(imgpel *pImgBuf, int iWidth, int iHeight, int iStride, int iPadX, int iPadY)
+/*!
+ ************************************************************************
+ * \brief
+ *    sets the samples of the macroblocks no slice was decoded for to 0,
+ *    as in a newly allocated picture. A picture taken from the pool
+ *    still holds the samples of its previous use there, which neither
+ *    the concealment of MBAFF pictures nor that of single colour planes
+ *    overwrites.
+ ************************************************************************
+ */
+static void clear_undecoded_mbs(VideoParameters *p_Vid, StorablePicture *p, Macroblock *mb_data, int chroma)
 {
-  int j;
-  imgpel *pLine0 = pImgBuf - iPadX, *pLine;
-#if (IMGTYPE==0)
-  int pad_width = iPadX + iWidth;
-  fast_memset(pImgBuf - iPadX, *pImgBuf, iPadX * sizeof(imgpel));
-  fast_memset(pImgBuf + iWidth, *(pImgBuf + iWidth - 1), iPadX * sizeof(imgpel));
-
-  pLine = pLine0 - iPadY * iStride;
-  
-  for(j = -iPadY; j < 0; j++)
-  {
-    fast_memcpy(pLine, pLine0, iStride * sizeof(imgpel));
-    pLine += iStride;
-  }
+  int mb_cr_w = p_Vid->mb_cr_size_x;
+  int mb_cr_h = p_Vid->mb_cr_size_y;
+  int i, j, k;
 
-  for(j = 1; j < iHeight; j++)
+  for (i = 0; i < (int) p->PicSizeInMbs; ++i)
   {
-    pLine += iStride;
-    fast_memset(pLine, *(pLine + iPadX), iPadX * sizeof(imgpel));
-    fast_memset(pLine + pad_width, *(pLine + pad_width - 1), iPadX * sizeof(imgpel));
-  }
+    int x, y;
 
-  pLine0 = pLine + iStride;
-    
-  for(j = iHeight; j < iHeight + iPadY; j++)
-  {
-    fast_memcpy(pLine0,  pLine, iStride * sizeof(imgpel));
-    pLine0 += iStride;
+    if (mb_data[i].slice_nr >= 0)
+      continue;
+
+    if (p->mb_aff_frame_flag)
+    {
+      x = p_Vid->PicPos[i >> 1].x;
+      y = 2 * p_Vid->PicPos[i >> 1].y + (i & 1);
+    }
+    else
+    {
+      x = p_Vid->PicPos[i].x;
+      y = p_Vid->PicPos[i].y;
+    }
+
+    for (j = 0; j < MB_BLOCK_SIZE; ++j)
+      memset(&p->imgY[y * MB_BLOCK_SIZE + j][x * MB_BLOCK_SIZE], 0, MB_BLOCK_SIZE * sizeof(imgpel));
+    if (chroma)
+    {
+      for (k = 0; k < 2; ++k)
+      {
+        for (j = 0; j < mb_cr_h; ++j)
+          memset(&p->imgUV[k][y * mb_cr_h + j][x * mb_cr_w], 0, mb_cr_w * sizeof(imgpel));
+      }
+    }
   }
-#else
-  int i;
-  for(i=-iPadX; i<0; i++)
-    pImgBuf[i] = *pImgBuf;
-  for(i=0; i<iPadX; i++)
-    pImgBuf[i+iWidth] = *(pImgBuf+iWidth-1);
-
-  for(j=-iPadY; j<0; j++)
-    memcpy(pLine0+j*iStride, pLine0, iStride*sizeof(imgpel));
-  for(j=1; j<iHeight; j++)
-  {
-    pLine = pLine0 + j*iStride;
-    for(i=0; i<iPadX; i++)
-      pLine[i] = pLine[iPadX];
-    pLine += iPadX+iWidth-1;
-    for(i=1; i<iPadX+1; i++)
-      pLine[i] = *pLine;
-  }
-  pLine = pLine0 + (iHeight-1)*iStride;
-  for(j=iHeight; j<iHeight+iPadY; j++)
-    memcpy(pLine0+j*iStride,  pLine, iStride*sizeof(imgpel));
-#endif
 }
 
-void pad_dec_picture(VideoParameters *p_Vid, StorablePicture *dec_picture)
+#if (DISABLE_ERC == 0)
+/*!
+ ************************************************************************
+ * \brief
+ *    returns whether any macroblock of the picture was lost or decoded
+ *    from corrupted data
+ ************************************************************************
+ */
+static int has_lost_mbs(VideoParameters *p_Vid, unsigned int num_mbs)
 {
-  int iPadX = p_Vid->iLumaPadX;
-  int iPadY = p_Vid->iLumaPadY;
-  int iWidth = dec_picture->size_x;
-  int iHeight = dec_picture->size_y;
-  int iStride = dec_picture->iLumaStride;
-
-  pad_buf(*dec_picture->imgY, iWidth, iHeight, iStride, iPadX, iPadY);
+  unsigned int i;
 
-  if(dec_picture->chroma_format_idc != YUV400) 
+  for (i = 0; i < num_mbs; ++i)
   {
-    iPadX = p_Vid->iChromaPadX;
-    iPadY = p_Vid->iChromaPadY;
-    iWidth = dec_picture->size_x_cr;
-    iHeight = dec_picture->size_y_cr;
-    iStride = dec_picture->iChromaStride;
-    pad_buf(*dec_picture->imgUV[0], iWidth, iHeight, iStride, iPadX, iPadY);
-    pad_buf(*dec_picture->imgUV[1], iWidth, iHeight, iStride, iPadX, iPadY);
+    if (p_Vid->mb_data[i].ei_flag)
+      return 1;
   }
+  return 0;
 }
-
+#endif
 
 /*!
  ************************************************************************
@@ -1883,6 +2125,9 @@ void exit_picture(VideoParameters *p_Vid, StorablePicture **dec_picture)
   frame recfr;
 #endif
   int structure, frame_poc, slice_type, refpic, qp, pic_num, chroma_format_idc, is_idr;
+  int deblock, in_background;
+  int concealed = 0;
+  int rows_finished = p_Vid->row_deblock.active;
 
   int64 tmp_time;                   // time used by decoding the last frame
   char   yuvFormat[10];
@@ -1893,23 +2138,50 @@ void exit_picture(VideoParameters *p_Vid, StorablePicture **dec_picture)
     return;
   }
 
-#if (DISABLE_ERC == 0)
-  recfr.p_Vid = p_Vid;
-  recfr.yptr = &(*dec_picture)->imgY[0][0];
-  if ((*dec_picture)->chroma_format_idc != YUV400)
+  if (p_Vid->separate_colour_plane_flag != 0)
   {
-    recfr.uptr = &(*dec_picture)->imgUV[0][0][0];
-    recfr.vptr = &(*dec_picture)->imgUV[1][0][0];
+    int nplane;
+
+    for (nplane = 0; nplane < MAX_PLANE; ++nplane)
+      clear_undecoded_mbs(p_Vid, p_Vid->dec_picture_JV[nplane], p_Vid->mb_data_JV[nplane], 0);
   }
+  else
+    clear_undecoded_mbs(p_Vid, *dec_picture, p_Vid->mb_data, (*dec_picture)->chroma_format_idc != YUV400);
 
-  //! this is always true at the beginning of a picture
-  //ercStartMB = 0;
-  ercSegment = 0;
+  // 4:4:4 independent pictures are concealed as a whole, with the
+  // macroblock map of colour plane 0
+  if (p_Vid->separate_colour_plane_flag != 0)
+    change_plane_JV(p_Vid, PLANE_Y, NULL);
 
-  //! mark the start of the first segment
-  if (!(*dec_picture)->mb_aff_frame_flag)
+#if (DISABLE_ERC == 0)
+  // the concealment state is only set up once a picture has lost macroblocks
+  if (!(*dec_picture)->mb_aff_frame_flag && has_lost_mbs(p_Vid, (*dec_picture)->PicSizeInMbs))
   {
     int i;
+
+    recfr.p_Vid = p_Vid;
+    recfr.yptr = &(*dec_picture)->imgY[0][0];
+    if ((*dec_picture)->chroma_format_idc != YUV400)
+    {
+      recfr.uptr = &(*dec_picture)->imgUV[0][0][0];
+      recfr.vptr = &(*dec_picture)->imgUV[1][0][0];
+    }
+
+    ercStartPicture(p_Vid, (*dec_picture)->PicSizeInMbs, (*dec_picture)->size_x);
+
+    //! modes and motion vectors of the macroblocks that were decoded
+    p_Vid->erc_mvperMB = 0;
+    for(i = 0; i < (int) (*dec_picture)->PicSizeInMbs; ++i)
+    {
+      if (p_Vid->mb_data[i].slice_nr >= 0)
+        ercWriteMBMODEandMV(&p_Vid->mb_data[i], *dec_picture);
+    }
+
+    //! this is always true at the beginning of a picture
+    //ercStartMB = 0;
+    ercSegment = 0;
+
+    //! mark the start of the first segment
     ercStartSegment(0, ercSegment, 0 , p_Vid->erc_errorVar);
     //! generate the segments according to the macroblock map
     for(i = 1; i < (int) (*dec_picture)->PicSizeInMbs; ++i)
@@ -1941,6 +2213,11 @@ void exit_picture(VideoParameters *p_Vid, StorablePicture **dec_picture)
 
     p_Vid->erc_img = p_Vid;
 
+    // the concealment copies from reference pictures the frame pipeline may still be finishing
+    concealed = p_Vid->erc_errorVar != NULL && p_Vid->erc_errorVar->nOfCorruptedSegments != 0;
+    if (concealed)
+      drain_frame_pipeline(p_Vid);
+
     if((*dec_picture)->slice_type == I_SLICE || (*dec_picture)->slice_type == SI_SLICE) // I-frame
       ercConcealIntraFrame(p_Vid, &recfr, (*dec_picture)->size_x, (*dec_picture)->size_y, p_Vid->erc_errorVar);
     else
@@ -1948,7 +2225,18 @@ void exit_picture(VideoParameters *p_Vid, StorablePicture **dec_picture)
   }
 #endif
 
-  if(!p_Vid->iDeblockMode && (p_Vid->bDeblockEnable & (1<<(*dec_picture)->used_for_reference)))
+  deblock = !p_Vid->iDeblockMode && (p_Vid->bDeblockEnable & (1<<(*dec_picture)->used_for_reference));
+  in_background = deblock && !concealed && !rows_finished && frame_pipeline_accepts(p_Vid, *dec_picture);
+
+  if (in_background)
+  {
+    finish_picture_in_background(p_Vid, *dec_picture);
+  }
+  else if (rows_finished)
+  {
+    finish_row_deblocking(p_Vid);
+  }
+  else if(deblock)
   {
     //deblocking for frame or field
     if( (p_Vid->separate_colour_plane_flag != 0) )
@@ -1984,13 +2272,7 @@ void exit_picture(VideoParameters *p_Vid, StorablePicture **dec_picture)
     frame_postprocessing(p_Vid);
   else
     field_postprocessing(p_Vid);   // reset all interlaced variables
-#if (MVC_EXTENSION_ENABLE)
-  if((*dec_picture)->used_for_reference || ((*dec_picture)->inter_view_flag == 1))
-    pad_dec_picture(p_Vid, *dec_picture);
-#else
-  if((*dec_picture)->used_for_reference)
-    pad_dec_picture(p_Vid, *dec_picture);
-#endif
+
   structure  = (*dec_picture)->structure;
   slice_type = (*dec_picture)->slice_type;
   frame_poc  = (*dec_picture)->frame_poc;  
@@ -2104,15 +2386,14 @@ void exit_picture(VideoParameters *p_Vid, StorablePicture **dec_picture)
 /*!
  ************************************************************************
  * \brief
- *    write the encoding mode and motion vectors of current
+ *    write the encoding mode and motion vectors of a decoded
  *    MB to the buffer of the error concealment module.
  ************************************************************************
  */
-void ercWriteMBMODEandMV(Macroblock *currMB)
+static void ercWriteMBMODEandMV(Macroblock *currMB, StorablePicture *dec_picture)
 {
   VideoParameters *p_Vid = currMB->p_Vid;
   int i, ii, jj, currMBNum = currMB->mbAddrX; //p_Vid->currentSlice->current_mb_nr;
-  StorablePicture *dec_picture = p_Vid->dec_picture;
   int mbx = xPosMB(currMBNum, dec_picture->size_x), mby = yPosMB(currMBNum, dec_picture->size_x);
   objectBuffer_t *currRegion, *pRegion;
 
@@ -2149,7 +2430,7 @@ void ercWriteMBMODEandMV(Macroblock *currMB)
           //          pRegion->mv[0]  = dec_picture->motion.mv[LIST_0][4*mby+(i/2)*2][4*mbx+(i%2)*2+BLOCK_SIZE][0];
           //          pRegion->mv[1]  = dec_picture->motion.mv[LIST_0][4*mby+(i/2)*2][4*mbx+(i%2)*2+BLOCK_SIZE][1];
         }
-        currMB->p_Slice->erc_mvperMB      += iabs(pRegion->mv[0]) + iabs(pRegion->mv[1]);
+        p_Vid->erc_mvperMB += iabs(pRegion->mv[0]) + iabs(pRegion->mv[1]);
         pRegion->mv[2]    = dec_picture->mv_info[jj][ii].ref_idx[LIST_0];
       }
     }
@@ -2182,7 +2463,7 @@ void ercWriteMBMODEandMV(Macroblock *currMB)
           dec_picture->mv_info[jj][ii+1].mv[idx].mv_y + 
           dec_picture->mv_info[jj+1][ii].mv[idx].mv_y + 
           dec_picture->mv_info[jj+1][ii+1].mv[idx].mv_y + 2)/4;
-        currMB->p_Slice->erc_mvperMB      += iabs(pRegion->mv[0]) + iabs(pRegion->mv[1]);
+        p_Vid->erc_mvperMB += iabs(pRegion->mv[0]) + iabs(pRegion->mv[1]);
 
         pRegion->mv[2]  = (dec_picture->mv_info[jj][ii].ref_idx[idx]);
         /*
@@ -2351,72 +2632,6 @@ void field_postprocessing(VideoParameters *p_Vid)
 
 
 
-/*!
- ************************************************************************
- * \brief
- *    copy StorablePicture *src -> StorablePicture *dst
- *    for 4:4:4 Independent mode
- ************************************************************************
- */
-void copy_dec_picture_JV( VideoParameters *p_Vid, StorablePicture *dst, StorablePicture *src )
-{
-  dst->top_poc              = src->top_poc;
-  dst->bottom_poc           = src->bottom_poc;
-  dst->frame_poc            = src->frame_poc;
-  dst->qp                   = src->qp;
-  dst->slice_qp_delta       = src->slice_qp_delta;
-  dst->chroma_qp_offset[0]  = src->chroma_qp_offset[0];
-  dst->chroma_qp_offset[1]  = src->chroma_qp_offset[1];
-
-  dst->poc                  = src->poc;
-
-  dst->slice_type           = src->slice_type;
-  dst->used_for_reference   = src->used_for_reference;
-  dst->idr_flag             = src->idr_flag;
-  dst->no_output_of_prior_pics_flag = src->no_output_of_prior_pics_flag;
-  dst->long_term_reference_flag = src->long_term_reference_flag;
-  dst->adaptive_ref_pic_buffering_flag = src->adaptive_ref_pic_buffering_flag;
-
-  dst->dec_ref_pic_marking_buffer = src->dec_ref_pic_marking_buffer;
-
-  dst->mb_aff_frame_flag    = src->mb_aff_frame_flag;
-  dst->PicWidthInMbs        = src->PicWidthInMbs;
-  dst->pic_num              = src->pic_num;
-  dst->frame_num            = src->frame_num;
-  dst->recovery_frame       = src->recovery_frame;
-  dst->coded_frame          = src->coded_frame;
-
-  dst->chroma_format_idc    = src->chroma_format_idc;
-
-  dst->frame_mbs_only_flag  = src->frame_mbs_only_flag;
-  dst->frame_cropping_flag  = src->frame_cropping_flag;
-
-  dst->frame_crop_left_offset   = src->frame_crop_left_offset;
-  dst->frame_crop_right_offset  = src->frame_crop_right_offset;
-  dst->frame_crop_top_offset    = src->frame_crop_top_offset;
-  dst->frame_crop_bottom_offset = src->frame_crop_bottom_offset;
-
-#if (ENABLE_OUTPUT_TONEMAPPING)
-  // store the necessary tone mapping sei into StorablePicture structure
-  dst->seiHasTone_mapping = src->seiHasTone_mapping;
-
-  dst->seiHasTone_mapping    = src->seiHasTone_mapping;
-  dst->tone_mapping_model_id = src->tone_mapping_model_id;
-  dst->tonemapped_bit_depth  = src->tonemapped_bit_depth;
-  if( src->tone_mapping_lut )
-  {
-    int coded_data_bit_max = (1 << p_Vid->seiToneMapping->coded_data_bit_depth);
-    dst->tone_mapping_lut      = malloc(sizeof(int) * coded_data_bit_max);
-    if (NULL == dst->tone_mapping_lut)
-    {
-      no_mem_exit("copy_dec_picture_JV: tone_mapping_lut");
-    }
-    memcpy(dst->tone_mapping_lut, src->tone_mapping_lut, sizeof(imgpel) * coded_data_bit_max);
-  }
-#endif
-}
-
-
 // this is intended to make get_block_luma faster by doing this at a more appropriate level
 // i.e. per slice rather than per MB
 static void init_cur_imgy(Slice *currSlice, VideoParameters *p_Vid)
@@ -2437,7 +2652,6 @@ static void init_cur_imgy(Slice *currSlice, VideoParameters *p_Vid)
           if (curr_ref) 
           {
             curr_ref->no_ref = noref && (curr_ref == vidref);
-            curr_ref->cur_imgY = curr_ref->imgY;
           }
         }
       }
@@ -2462,7 +2676,6 @@ static void init_cur_imgy(Slice *currSlice, VideoParameters *p_Vid)
         if (curr_ref) 
         {
           curr_ref->no_ref = noref && (curr_ref == vidref);
-          curr_ref->cur_imgY = curr_ref->imgY;
         }
       }
     }
@@ -2474,15 +2687,13 @@ static void init_cur_imgy(Slice *currSlice, VideoParameters *p_Vid)
 /*!
  ************************************************************************
  * \brief
- *    decodes one slice
+ *    points the slice to the picture buffers of its colour plane and
+ *    prepares the reference pictures for its macroblocks
  ************************************************************************
  */
-void decode_one_slice(Slice *currSlice)
+static void init_slice_mb_decoding(Slice *currSlice)
 {
   VideoParameters *p_Vid = currSlice->p_Vid;
-  Boolean end_of_slice = FALSE;
-  Macroblock *currMB = NULL;
-  currSlice->cod_counter=-1;
 
   if( (p_Vid->separate_colour_plane_flag != 0) )
   {
@@ -2495,6 +2706,7 @@ void decode_one_slice(Slice *currSlice)
     currSlice->siblock = p_Vid->siblock;
     currSlice->ipredmode = p_Vid->ipredmode;
     currSlice->intra_block = p_Vid->intra_block;
+    currSlice->nz_coeff = p_Vid->nz_coeff;
   }
 
   if (currSlice->slice_type == B_SLICE)
@@ -2504,6 +2716,20 @@ void decode_one_slice(Slice *currSlice)
 
   if (currSlice->slice_type != I_SLICE && currSlice->slice_type != SI_SLICE)
     init_cur_imgy(currSlice,p_Vid); 
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    parses and reconstructs the macroblocks of a slice
+ ************************************************************************
+ */
+static void decode_slice_macroblocks(Slice *currSlice)
+{
+  VideoParameters *p_Vid = currSlice->p_Vid;
+  Boolean end_of_slice = FALSE;
+  Macroblock *currMB = NULL;
+  currSlice->cod_counter=-1;
 
   //reset_ec_flags(p_Vid);
 
@@ -2519,6 +2745,8 @@ void decode_one_slice(Slice *currSlice)
     // Get the syntax elements from the NAL
     currSlice->read_one_macroblock(currMB);
     decode_one_macroblock(currMB, currSlice->dec_picture);
+    if (p_Vid->row_deblock.active)
+      row_deblock_mb_done(p_Vid, currMB->mbAddrX);
 
     if(currSlice->mb_aff_frame_flag && currMB->mb_field)
     {
@@ -2526,15 +2754,23 @@ void decode_one_slice(Slice *currSlice)
       currSlice->num_ref_idx_active[LIST_1] >>= 1;
     }
 
-#if (DISABLE_ERC == 0)
-    ercWriteMBMODEandMV(currMB);
-#endif
-
     end_of_slice = exit_macroblock(currSlice, (!currSlice->mb_aff_frame_flag|| currSlice->current_mb_nr%2));
   }
   //reset_ec_flags(p_Vid);
 }
 
+/*!
+ ************************************************************************
+ * \brief
+ *    decodes one slice
+ ************************************************************************
+ */
+void decode_one_slice(Slice *currSlice)
+{
+  init_slice_mb_decoding(currSlice);
+  decode_slice_macroblocks(currSlice);
+}
+
 #if (MVC_EXTENSION_ENABLE)
 int GetVOIdx(VideoParameters *p_Vid, int iViewId)
 {
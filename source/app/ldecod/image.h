@@ -21,12 +21,11 @@ extern int  picture_order     ( Slice *pSlice );
 extern void decode_one_slice  (Slice *currSlice);
 extern int  read_new_slice    (Slice *currSlice);
 extern void exit_picture      (VideoParameters *p_Vid, StorablePicture **dec_picture);
+extern void deblock_reconstructed_rows(VideoParameters *p_Vid, int rows);
 extern int  decode_one_frame  (DecoderParams *pDecoder);
 
 extern int  is_new_picture(StorablePicture *dec_picture, Slice *currSlice, OldSliceParams *p_old_slice);
 extern void init_old_slice(OldSliceParams *p_old_slice);
-// For 4:4:4 independent mode
-extern void copy_dec_picture_JV (VideoParameters *p_Vid, StorablePicture *dst, StorablePicture *src );
 
 extern void frame_postprocessing(VideoParameters *p_Vid);
 extern void field_postprocessing(VideoParameters *p_Vid);
@@ -14,6 +14,7 @@
  */
 #include "global.h"
 #include "intra16x16_pred.h"
+#include "intra_pred_common.h"
 #include "mb_access.h"
 #include "image.h"
 
@@ -243,7 +244,7 @@ static int intra16x16_plane_pred(Macroblock *currMB, ColorPlane pl)
   Slice *currSlice = currMB->p_Slice;
   VideoParameters *p_Vid = currMB->p_Vid;
   
-  int i,j;
+  int i;
 
   int ih = 0, iv = 0;
   int ib,ic,iaa;
@@ -294,18 +295,9 @@ static int intra16x16_plane_pred(Macroblock *currMB, ColorPlane pl)
   ic=(5 * iv + 32)>>6;
 
   iaa=16 * (mpr_line[8] + imgY[pos_y + 8][pos_x]);
-  for (j = 0;j < MB_BLOCK_SIZE; ++j)
-  {
-    int ibb = iaa + (j - 7) * ic + 16;
-    imgpel *prd = mb_pred[j];
-    for (i = 0;i < MB_BLOCK_SIZE; i += 4)
-    {
-      *prd++ = (imgpel) iClip1(max_imgpel_value, ((ibb + (i - 7) * ib) >> 5));
-      *prd++ = (imgpel) iClip1(max_imgpel_value, ((ibb + (i - 6) * ib) >> 5));
-      *prd++ = (imgpel) iClip1(max_imgpel_value, ((ibb + (i - 5) * ib) >> 5));
-      *prd++ = (imgpel) iClip1(max_imgpel_value, ((ibb + (i - 4) * ib) >> 5));
-    }
-  }// store plane prediction
+
+  // store plane prediction
+  intra_kernels.plane(mb_pred, MB_BLOCK_SIZE, MB_BLOCK_SIZE, iaa, ib, ic, max_imgpel_value);
 
   return DECODING_OK;
 }
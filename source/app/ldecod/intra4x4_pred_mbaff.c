@@ -786,8 +786,7 @@ int intra_pred_4x4_mbaff(Macroblock *currMB,    //!< current macroblock
                         int img_block_x,       //!< location of block X, multiples of 4
                         int img_block_y)       //!< location of block Y, multiples of 4
 {
-  VideoParameters *p_Vid = currMB->p_Vid;
-  byte predmode = p_Vid->ipredmode[img_block_y][img_block_x];
+  byte predmode = currMB->p_Slice->ipredmode[img_block_y][img_block_x];
   currMB->ipmode_DPCM = predmode; //For residual DPCM
 
   switch (predmode)
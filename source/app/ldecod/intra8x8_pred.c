@@ -16,6 +16,7 @@
  */
 #include "global.h"
 #include "intra8x8_pred.h"
+#include "intra_pred_common.h"
 #include "mb_access.h"
 #include "image.h"
 
@@ -34,1472 +35,6 @@
 //  X  a8 b8 c8 d8 e8 f8 g8 h8
 
 
-// Predictor array index definitions
-#define P_Z (PredPel[0])
-#define P_A (PredPel[1])
-#define P_B (PredPel[2])
-#define P_C (PredPel[3])
-#define P_D (PredPel[4])
-#define P_E (PredPel[5])
-#define P_F (PredPel[6])
-#define P_G (PredPel[7])
-#define P_H (PredPel[8])
-#define P_I (PredPel[9])
-#define P_J (PredPel[10])
-#define P_K (PredPel[11])
-#define P_L (PredPel[12])
-#define P_M (PredPel[13])
-#define P_N (PredPel[14])
-#define P_O (PredPel[15])
-#define P_P (PredPel[16])
-#define P_Q (PredPel[17])
-#define P_R (PredPel[18])
-#define P_S (PredPel[19])
-#define P_T (PredPel[20])
-#define P_U (PredPel[21])
-#define P_V (PredPel[22])
-#define P_W (PredPel[23])
-#define P_X (PredPel[24])
-
-/*!
- *************************************************************************************
- * \brief
- *    Prefiltering for Intra8x8 prediction
- *************************************************************************************
- */
-static inline void LowPassForIntra8x8Pred(imgpel *PredPel, int block_up_left, int block_up, int block_left)
-{
-  int i;
-  imgpel LoopArray[25];
-
-  memcpy(&LoopArray[0], &PredPel[0], 25 * sizeof(imgpel));
-
-  if(block_up_left)
-  {
-    if(block_up && block_left)
-    {
-      LoopArray[0] = (imgpel) ((P_Q + (P_Z<<1) + P_A + 2)>>2);
-    }
-    else
-    {
-      if(block_up)
-        LoopArray[0] = (imgpel) ((P_Z + (P_Z<<1) + P_A + 2)>>2);
-      else if (block_left)
-        LoopArray[0] = (imgpel) ((P_Z + (P_Z<<1) + P_Q + 2)>>2);
-    }
-  }
-  
-  if(block_up)
-  {    
-    if(block_up_left)
-    {
-      LoopArray[1] = (imgpel) ((PredPel[0] + (PredPel[1]<<1) + PredPel[2] + 2)>>2);
-    }
-    else
-      LoopArray[1] = (imgpel) ((PredPel[1] + (PredPel[1]<<1) + PredPel[2] + 2)>>2);
-
-
-    for(i = 2; i <16; i++)
-    {
-      LoopArray[i] = (imgpel) ((PredPel[i-1] + (PredPel[i]<<1) + PredPel[i+1] + 2)>>2);
-    }
-    LoopArray[16] = (imgpel) ((P_P + (P_P<<1) + P_O + 2)>>2);
-  }
-
-  if(block_left)
-  {
-    if(block_up_left)
-      LoopArray[17] = (imgpel) ((P_Z + (P_Q<<1) + P_R + 2)>>2);
-    else
-      LoopArray[17] = (imgpel) ((P_Q + (P_Q<<1) + P_R + 2)>>2);
-
-    for(i = 18; i <24; i++)
-    {
-      LoopArray[i] = (imgpel) ((PredPel[i-1] + (PredPel[i]<<1) + PredPel[i+1] + 2)>>2);
-    }
-    LoopArray[24] = (imgpel) ((P_W + (P_X<<1) + P_X + 2) >> 2);
-  }
-
-  memcpy(&PredPel[0], &LoopArray[0], 25 * sizeof(imgpel));
-}
-
-/*!
- *************************************************************************************
- * \brief
- *    Prefiltering for Intra8x8 prediction (Horizontal)
- *************************************************************************************
- */
-static inline void LowPassForIntra8x8PredHor(imgpel *PredPel, int block_up_left, int block_up, int block_left)
-{
-  int i;
-  imgpel LoopArray[25];
-
-  memcpy(&LoopArray[0], &PredPel[0], 25 * sizeof(imgpel));
-
-  if(block_up_left)
-  {
-    if(block_up && block_left)
-    {
-      LoopArray[0] = (imgpel) ((P_Q + (P_Z<<1) + P_A + 2)>>2);
-    }
-    else
-    {
-      if(block_up)
-        LoopArray[0] = (imgpel) ((P_Z + (P_Z<<1) + P_A + 2)>>2);
-      else if (block_left)
-        LoopArray[0] = (imgpel) ((P_Z + (P_Z<<1) + P_Q + 2)>>2);
-    }
-  }
-  
-  if(block_up)
-  {    
-    if(block_up_left)
-    {
-      LoopArray[1] = (imgpel) ((PredPel[0] + (PredPel[1]<<1) + PredPel[2] + 2)>>2);
-    }
-    else
-      LoopArray[1] = (imgpel) ((PredPel[1] + (PredPel[1]<<1) + PredPel[2] + 2)>>2);
-
-
-    for(i = 2; i <16; i++)
-    {
-      LoopArray[i] = (imgpel) ((PredPel[i-1] + (PredPel[i]<<1) + PredPel[i+1] + 2)>>2);
-    }
-    LoopArray[16] = (imgpel) ((P_P + (P_P<<1) + P_O + 2)>>2);
-  }
-
-
-  memcpy(&PredPel[0], &LoopArray[0], 17 * sizeof(imgpel));
-}
-
-/*!
- *************************************************************************************
- * \brief
- *    Prefiltering for Intra8x8 prediction (Vertical)
- *************************************************************************************
- */
-static inline void LowPassForIntra8x8PredVer(imgpel *PredPel, int block_up_left, int block_up, int block_left)
-{
-  // These functions need some cleanup and can be further optimized. 
-  // For convenience, let us copy all data for now. It is obvious that the filtering makes things a bit more "complex"
-  int i;
-  imgpel LoopArray[25];
-
-  memcpy(&LoopArray[0], &PredPel[0], 25 * sizeof(imgpel));
-
-  if(block_up_left)
-  {
-    if(block_up && block_left)
-    {
-      LoopArray[0] = (imgpel) ((P_Q + (P_Z<<1) + P_A + 2)>>2);
-    }
-    else
-    {
-      if(block_up)
-        LoopArray[0] = (imgpel) ((P_Z + (P_Z<<1) + P_A + 2)>>2);
-      else if (block_left)
-        LoopArray[0] = (imgpel) ((P_Z + (P_Z<<1) + P_Q + 2)>>2);
-    }
-  }
-  
-  if(block_left)
-  {
-    if(block_up_left)
-      LoopArray[17] = (imgpel) ((P_Z + (P_Q<<1) + P_R + 2)>>2);
-    else
-      LoopArray[17] = (imgpel) ((P_Q + (P_Q<<1) + P_R + 2)>>2);
-
-    for(i = 18; i <24; i++)
-    {
-      LoopArray[i] = (imgpel) ((PredPel[i-1] + (PredPel[i]<<1) + PredPel[i+1] + 2)>>2);
-    }
-    LoopArray[24] = (imgpel) ((P_W + (P_X<<1) + P_X + 2) >> 2);
-  }
-
-  memcpy(&PredPel[0], &LoopArray[0], 25 * sizeof(imgpel));
-}
-
-
-/*!
- ***********************************************************************
- * \brief
- *    makes and returns 8x8 DC prediction mode
- *
- * \return
- *    DECODING_OK   decoding of intra prediction mode was successful            \n
- *
- ***********************************************************************
- */
-static inline int intra8x8_dc_pred(Macroblock *currMB,    //!< current macroblock
-                                   ColorPlane pl,         //!< current image plane
-                                   int ioff,              //!< pixel offset X within MB
-                                   int joff)              //!< pixel offset Y within MB
-{
-  int i,j;
-  int s0 = 0;
-  imgpel PredPel[25];  // array of predictor pels
-  Slice *currSlice = currMB->p_Slice;
-  VideoParameters *p_Vid = currMB->p_Vid;
-
-  StorablePicture *dec_picture = currSlice->dec_picture;
-  imgpel **imgY = (pl) ? dec_picture->imgUV[pl - 1] : dec_picture->imgY; // For MB level frame/field coding tools -- set default to imgY
-
-  PixelPos pix_a;
-  PixelPos pix_b, pix_c, pix_d;
-
-  int block_available_up;
-  int block_available_left;
-  int block_available_up_left;
-  int block_available_up_right;
-  
-  imgpel **mpr = currSlice->mb_pred[pl];
-  int *mb_size = p_Vid->mb_size[IS_LUMA];
-
-  for (int i=0; i<25;i++) PredPel[i]=0;
-
-  getNonAffNeighbour(currMB, ioff - 1, joff, mb_size, &pix_a);
-  getNonAffNeighbour(currMB, ioff    , joff - 1, mb_size, &pix_b);
-  getNonAffNeighbour(currMB, ioff + 8, joff - 1, mb_size, &pix_c);
-  getNonAffNeighbour(currMB, ioff - 1, joff - 1, mb_size, &pix_d);
-
-  pix_c.available = pix_c.available &&!(ioff == 8 && joff == 8);
-
-  if (p_Vid->active_pps->constrained_intra_pred_flag)
-  {
-    block_available_left     = pix_a.available ? currSlice->intra_block [pix_a.mb_addr]: 0;
-    block_available_up       = pix_b.available ? currSlice->intra_block [pix_b.mb_addr] : 0;
-    block_available_up_right = pix_c.available ? currSlice->intra_block [pix_c.mb_addr] : 0;
-    block_available_up_left  = pix_d.available ? currSlice->intra_block [pix_d.mb_addr] : 0;
-  }
-  else
-  {
-    block_available_left     = pix_a.available;
-    block_available_up       = pix_b.available;
-    block_available_up_right = pix_c.available;
-    block_available_up_left  = pix_d.available;
-  }
-
-  // form predictor pels
-  if (block_available_up)
-  {
-    memcpy(&PredPel[1], &imgY[pix_b.pos_y][pix_b.pos_x], BLOCK_SIZE_8x8 * sizeof(imgpel));
-  }
-  else
-  {
-#if (IMGTYPE == 0)
-    memset(&PredPel[1], p_Vid->dc_pred_value_comp[pl], BLOCK_SIZE_8x8 * sizeof(imgpel));
-#else
-    P_A = P_B = P_C = P_D = P_E = P_F = P_G = P_H = (imgpel) p_Vid->dc_pred_value_comp[pl];
-#endif
-  }
-
-  if (block_available_up_right)
-  {
-    memcpy(&PredPel[9], &imgY[pix_c.pos_y][pix_c.pos_x], BLOCK_SIZE_8x8 * sizeof(imgpel));
-  }
-  else
-  {
-#if (IMGTYPE == 0)
-    memset(&PredPel[9], PredPel[8], BLOCK_SIZE_8x8 * sizeof(imgpel));
-#else
-    P_I = P_J = P_K = P_L = P_M = P_N = P_O = P_P = P_H;
-#endif
-  }
-
-  if (block_available_left)
-  {
-    imgpel **img_pred = &imgY[pix_a.pos_y];
-    int pos_x = pix_a.pos_x;
-    P_Q = *(*(img_pred ++) + pos_x);
-    P_R = *(*(img_pred ++) + pos_x);
-    P_S = *(*(img_pred ++) + pos_x);
-    P_T = *(*(img_pred ++) + pos_x);
-    P_U = *(*(img_pred ++) + pos_x);
-    P_V = *(*(img_pred ++) + pos_x);
-    P_W = *(*(img_pred ++) + pos_x);
-    P_X = *(*(img_pred   ) + pos_x);
-  }
-  else
-  {
-    P_Q = P_R = P_S = P_T = P_U = P_V = P_W = P_X = (imgpel) p_Vid->dc_pred_value_comp[pl];
-  }
-
-  if (block_available_up_left)
-  {
-    P_Z = imgY[pix_d.pos_y][pix_d.pos_x];
-  }
-  else
-  {
-    P_Z = (imgpel) p_Vid->dc_pred_value_comp[pl];
-  }
-
-  LowPassForIntra8x8Pred(PredPel, block_available_up_left, block_available_up, block_available_left);
-  
-  if (block_available_up && block_available_left)
-  {
-    // no edge
-    s0 = (P_A + P_B + P_C + P_D + P_E + P_F + P_G + P_H + P_Q + P_R + P_S + P_T + P_U + P_V + P_W + P_X + 8) >> 4;
-  }
-  else if (!block_available_up && block_available_left)
-  {
-    // upper edge
-    s0 = (P_Q + P_R + P_S + P_T + P_U + P_V + P_W + P_X + 4) >> 3;
-  }
-  else if (block_available_up && !block_available_left)
-  {
-    // left edge
-    s0 = (P_A + P_B + P_C + P_D + P_E + P_F + P_G + P_H + 4) >> 3;
-  }
-  else //if (!block_available_up && !block_available_left)
-  {
-    // top left corner, nothing to predict from
-    s0 = p_Vid->dc_pred_value_comp[pl];
-  }
-
-  for(i = ioff; i < ioff + BLOCK_SIZE_8x8; i++)
-    mpr[joff][i] = (imgpel) s0;
-
-  for(j = joff + 1; j < joff + BLOCK_SIZE_8x8; j++)
-    memcpy(&mpr[j][ioff], &mpr[j - 1][ioff], BLOCK_SIZE_8x8 * sizeof(imgpel));
-
-  return DECODING_OK;
-}
-
-/*!
- ***********************************************************************
- * \brief
- *    makes and returns 8x8 vertical prediction mode
- *
- * \return
- *    DECODING_OK   decoding of intra prediction mode was successful            \n
- *
- ***********************************************************************
- */
-static inline int intra8x8_vert_pred(Macroblock *currMB,    //!< current macroblock
-                                     ColorPlane pl,         //!< current image plane
-                                     int ioff,              //!< pixel offset X within MB
-                                     int joff)              //!< pixel offset Y within MB
-{
-  Slice *currSlice = currMB->p_Slice;
-  VideoParameters *p_Vid = currMB->p_Vid;
-  
-  int i;
-  imgpel PredPel[25];  // array of predictor pels  
-  imgpel **imgY = (pl) ? currSlice->dec_picture->imgUV[pl - 1] : currSlice->dec_picture->imgY; // For MB level frame/field coding tools -- set default to imgY
-
-  PixelPos pix_a;
-  PixelPos pix_b, pix_c, pix_d;
-
-  int block_available_up;
-  int block_available_left;
-  int block_available_up_left;
-  int block_available_up_right;
-
-  
-  imgpel **mpr = currSlice->mb_pred[pl];
-  int *mb_size = p_Vid->mb_size[IS_LUMA];
-  
-  for (int i=0; i<25;i++) PredPel[i]=0;
-
-  getNonAffNeighbour(currMB, ioff - 1, joff    , mb_size, &pix_a);
-  getNonAffNeighbour(currMB, ioff    , joff - 1, mb_size, &pix_b);
-  getNonAffNeighbour(currMB, ioff + 8, joff - 1, mb_size, &pix_c);
-  getNonAffNeighbour(currMB, ioff - 1, joff - 1, mb_size, &pix_d);
-
-  pix_c.available = pix_c.available &&!(ioff == 8 && joff == 8);
-
-  if (p_Vid->active_pps->constrained_intra_pred_flag)
-  {
-    block_available_left     = pix_a.available ? currSlice->intra_block [pix_a.mb_addr] : 0;
-    block_available_up       = pix_b.available ? currSlice->intra_block [pix_b.mb_addr] : 0;
-    block_available_up_right = pix_c.available ? currSlice->intra_block [pix_c.mb_addr] : 0;
-    block_available_up_left  = pix_d.available ? currSlice->intra_block [pix_d.mb_addr] : 0;
-  }
-  else
-  {
-    block_available_left     = pix_a.available;
-    block_available_up       = pix_b.available;
-    block_available_up_right = pix_c.available;
-    block_available_up_left  = pix_d.available;
-  }
-
-  if (!block_available_up)
-    printf ("warning: Intra_8x8_Vertical prediction mode not allowed at mb %d\n", (int) currSlice->current_mb_nr);
-
-  // form predictor pels
-  if (block_available_up)
-  {
-    memcpy(&PredPel[1], &imgY[pix_b.pos_y][pix_b.pos_x], BLOCK_SIZE_8x8 * sizeof(imgpel));
-  }
-  else
-  {
-#if (IMGTYPE == 0)
-    memset(&PredPel[1], p_Vid->dc_pred_value_comp[pl], BLOCK_SIZE_8x8 * sizeof(imgpel));
-#else
-    P_A = P_B = P_C = P_D = P_E = P_F = P_G = P_H = (imgpel) p_Vid->dc_pred_value_comp[pl];
-#endif
-  }
-
-  if (block_available_up_right)
-  {
-    memcpy(&PredPel[9], &imgY[pix_c.pos_y][pix_c.pos_x], BLOCK_SIZE_8x8 * sizeof(imgpel));
-  }
-  else
-  {
-#if (IMGTYPE == 0)
-    memset(&PredPel[9], PredPel[8], BLOCK_SIZE_8x8 * sizeof(imgpel));
-#else
-    P_I = P_J = P_K = P_L = P_M = P_N = P_O = P_P = P_H;
-#endif
-  }
-
-  if (block_available_up_left)
-  {
-    P_Z = imgY[pix_d.pos_y][pix_d.pos_x];
-  }
-  else
-  {
-    P_Z = (imgpel) p_Vid->dc_pred_value_comp[pl];
-  }
-
-  LowPassForIntra8x8PredHor(&(P_Z), block_available_up_left, block_available_up, block_available_left);
-  
-  for (i=joff; i < joff + BLOCK_SIZE_8x8; i++)
-  {
-    memcpy(&mpr[i][ioff], &PredPel[1], BLOCK_SIZE_8x8 * sizeof(imgpel));
-  }
-
-  return DECODING_OK;
-}
-
-/*!
- ***********************************************************************
- * \brief
- *    makes and returns 8x8 horizontal prediction mode
- *
- * \return
- *    DECODING_OK   decoding of intra prediction mode was successful            \n
- *
- ***********************************************************************
- */
-static inline int intra8x8_hor_pred(Macroblock *currMB,    //!< current macroblock
-                                    ColorPlane pl,         //!< current image plane
-                                    int ioff,              //!< pixel offset X within MB
-                                    int joff)              //!< pixel offset Y within MB
-{
-  Slice *currSlice = currMB->p_Slice;
-  VideoParameters *p_Vid = currMB->p_Vid;
-  
-
-  int j;
-  imgpel PredPel[25];  // array of predictor pels
-  imgpel **imgY = (pl) ? currSlice->dec_picture->imgUV[pl - 1] : currSlice->dec_picture->imgY; // For MB level frame/field coding tools -- set default to imgY
-
-  PixelPos pix_a;
-  PixelPos pix_b, pix_d;
-
-  int block_available_up;
-  int block_available_left;
-  int block_available_up_left;
-
-  for (int i=0; i<25;i++) PredPel[i]=0;
-
-#if (IMGTYPE != 0)
-  int ipos0 = ioff    , ipos1 = ioff + 1, ipos2 = ioff + 2, ipos3 = ioff + 3;
-  int ipos4 = ioff + 4, ipos5 = ioff + 5, ipos6 = ioff + 6, ipos7 = ioff + 7;
-#endif
-  int jpos;  
-  imgpel **mpr = currSlice->mb_pred[pl];
-  int *mb_size = p_Vid->mb_size[IS_LUMA];
-
-  getNonAffNeighbour(currMB, ioff - 1, joff    , mb_size, &pix_a);
-  getNonAffNeighbour(currMB, ioff    , joff - 1, mb_size, &pix_b);
-  getNonAffNeighbour(currMB, ioff - 1, joff - 1, mb_size, &pix_d);
-
-  if (p_Vid->active_pps->constrained_intra_pred_flag)
-  {
-    block_available_left     = pix_a.available ? currSlice->intra_block [pix_a.mb_addr]: 0;
-    block_available_up       = pix_b.available ? currSlice->intra_block [pix_b.mb_addr] : 0;
-    block_available_up_left  = pix_d.available ? currSlice->intra_block [pix_d.mb_addr] : 0;
-  }
-  else
-  {
-    block_available_left     = pix_a.available;
-    block_available_up       = pix_b.available;
-    block_available_up_left  = pix_d.available;
-  }
-
-  if (!block_available_left)
-    printf ("warning: Intra_8x8_Horizontal prediction mode not allowed at mb %d\n", (int) currSlice->current_mb_nr);
-
-  // form predictor pels
-  if (block_available_left)
-  {
-    imgpel **img_pred = &imgY[pix_a.pos_y];
-    int pos_x = pix_a.pos_x;
-    P_Q = *(*(img_pred ++) + pos_x);
-    P_R = *(*(img_pred ++) + pos_x);
-    P_S = *(*(img_pred ++) + pos_x);
-    P_T = *(*(img_pred ++) + pos_x);
-    P_U = *(*(img_pred ++) + pos_x);
-    P_V = *(*(img_pred ++) + pos_x);
-    P_W = *(*(img_pred ++) + pos_x);
-    P_X = *(*(img_pred   ) + pos_x);
-  }
-  else
-  {
-    P_Q = P_R = P_S = P_T = P_U = P_V = P_W = P_X = (imgpel) p_Vid->dc_pred_value_comp[pl];
-  }
-
-  if (block_available_up_left)
-  {
-    P_Z = imgY[pix_d.pos_y][pix_d.pos_x];
-  }
-  else
-  {
-    P_Z = (imgpel) p_Vid->dc_pred_value_comp[pl];
-  }
-
-  LowPassForIntra8x8PredVer(&(P_Z), block_available_up_left, block_available_up, block_available_left);
-
-  for (j=0; j < BLOCK_SIZE_8x8; j++)
-  {
-    jpos = j + joff;
-#if (IMGTYPE == 0)
-    memset(&mpr[jpos][ioff], (imgpel) (&P_Q)[j], 8 * sizeof(imgpel));
-#else
-    mpr[jpos][ipos0]  =
-      mpr[jpos][ipos1]  =
-      mpr[jpos][ipos2]  =
-      mpr[jpos][ipos3]  =
-      mpr[jpos][ipos4]  =
-      mpr[jpos][ipos5]  =
-      mpr[jpos][ipos6]  =
-      mpr[jpos][ipos7]  = (imgpel) (&P_Q)[j];
-#endif
-  }
- 
-  return DECODING_OK;
-}
-
-/*!
- ***********************************************************************
- * \brief
- *    makes and returns 8x8 diagonal down right prediction mode
- *
- * \return
- *    DECODING_OK   decoding of intra prediction mode was successful            \n
- *
- ***********************************************************************
- */
-static inline int intra8x8_diag_down_right_pred(Macroblock *currMB,    //!< current macroblock
-                                                ColorPlane pl,         //!< current image plane
-                                                int ioff,              //!< pixel offset X within MB
-                                                int joff)              //!< pixel offset Y within MB
-{
-  Slice *currSlice = currMB->p_Slice;
-  VideoParameters *p_Vid = currMB->p_Vid;
-  
-  imgpel PredPel[25];    // array of predictor pels
-  imgpel PredArray[16];  // array of final prediction values
-  imgpel **imgY = (pl) ? currSlice->dec_picture->imgUV[pl - 1] : currSlice->dec_picture->imgY; // For MB level frame/field coding tools -- set default to imgY
-
-  PixelPos pix_a;
-  PixelPos pix_b, pix_c, pix_d;
-
-  int block_available_up;
-  int block_available_left;
-  int block_available_up_left;
-  int block_available_up_right;
-
-  imgpel *pred_pels;
-  imgpel **mb_pred = &currSlice->mb_pred[pl][joff];
-  int *mb_size = p_Vid->mb_size[IS_LUMA];
-
-  for (int i=0; i<25;i++) PredPel[i]=0;
-
-  getNonAffNeighbour(currMB, ioff - 1, joff    , mb_size, &pix_a);
-  getNonAffNeighbour(currMB, ioff    , joff - 1, mb_size, &pix_b);
-  getNonAffNeighbour(currMB, ioff + 8, joff - 1, mb_size, &pix_c);
-  getNonAffNeighbour(currMB, ioff - 1, joff - 1, mb_size, &pix_d);
-
-  pix_c.available = pix_c.available &&!(ioff == 8 && joff == 8);
-
-  if (p_Vid->active_pps->constrained_intra_pred_flag)
-  {
-    block_available_left     = pix_a.available ? currSlice->intra_block [pix_a.mb_addr]: 0;
-    block_available_up       = pix_b.available ? currSlice->intra_block [pix_b.mb_addr] : 0;
-    block_available_up_right = pix_c.available ? currSlice->intra_block [pix_c.mb_addr] : 0;
-    block_available_up_left  = pix_d.available ? currSlice->intra_block [pix_d.mb_addr] : 0;
-  }
-  else
-  {
-    block_available_left     = pix_a.available;
-    block_available_up       = pix_b.available;
-    block_available_up_right = pix_c.available;
-    block_available_up_left  = pix_d.available;
-  }
-
-  if ((!block_available_up)||(!block_available_left)||(!block_available_up_left))
-    printf ("warning: Intra_8x8_Diagonal_Down_Right prediction mode not allowed at mb %d\n", (int) currSlice->current_mb_nr);
-
-  // form predictor pels
-  if (block_available_up)
-  {
-    memcpy(&PredPel[1], &imgY[pix_b.pos_y][pix_b.pos_x], BLOCK_SIZE_8x8 * sizeof(imgpel));
-  }
-  else
-  {
-#if (IMGTYPE == 0)
-    memset(&PredPel[1], p_Vid->dc_pred_value_comp[pl], BLOCK_SIZE_8x8 * sizeof(imgpel));
-#else
-    P_A = P_B = P_C = P_D = P_E = P_F = P_G = P_H = (imgpel) p_Vid->dc_pred_value_comp[pl];
-#endif
-  }
-
-  if (block_available_up_right)
-  {
-    memcpy(&PredPel[9], &imgY[pix_c.pos_y][pix_c.pos_x], BLOCK_SIZE_8x8 * sizeof(imgpel));
-  }
-  else
-  {
-#if (IMGTYPE == 0)
-    memset(&PredPel[9], PredPel[8], BLOCK_SIZE_8x8 * sizeof(imgpel));
-#else
-    P_I = P_J = P_K = P_L = P_M = P_N = P_O = P_P = P_H;
-#endif
-  }
-
-  if (block_available_left)
-  {
-    imgpel **img_pred = &imgY[pix_a.pos_y];
-    int pos_x = pix_a.pos_x;
-    P_Q = *(*(img_pred ++) + pos_x);
-    P_R = *(*(img_pred ++) + pos_x);
-    P_S = *(*(img_pred ++) + pos_x);
-    P_T = *(*(img_pred ++) + pos_x);
-    P_U = *(*(img_pred ++) + pos_x);
-    P_V = *(*(img_pred ++) + pos_x);
-    P_W = *(*(img_pred ++) + pos_x);
-    P_X = *(*(img_pred   ) + pos_x);
-  }
-  else
-  {
-    P_Q = P_R = P_S = P_T = P_U = P_V = P_W = P_X = (imgpel) p_Vid->dc_pred_value_comp[pl];
-  }
-
-  if (block_available_up_left)
-  {
-    P_Z = imgY[pix_d.pos_y][pix_d.pos_x];
-  }
-  else
-  {
-    P_Z = (imgpel) p_Vid->dc_pred_value_comp[pl];
-  }
-
-  LowPassForIntra8x8Pred(PredPel, block_available_up_left, block_available_up, block_available_left);
-
-  // Mode DIAG_DOWN_RIGHT_PRED
-  PredArray[ 0] = (imgpel) ((P_X + P_V + ((P_W) << 1) + 2) >> 2);
-  PredArray[ 1] = (imgpel) ((P_W + P_U + ((P_V) << 1) + 2) >> 2);
-  PredArray[ 2] = (imgpel) ((P_V + P_T + ((P_U) << 1) + 2) >> 2);
-  PredArray[ 3] = (imgpel) ((P_U + P_S + ((P_T) << 1) + 2) >> 2);
-  PredArray[ 4] = (imgpel) ((P_T + P_R + ((P_S) << 1) + 2) >> 2);
-  PredArray[ 5] = (imgpel) ((P_S + P_Q + ((P_R) << 1) + 2) >> 2);
-  PredArray[ 6] = (imgpel) ((P_R + P_Z + ((P_Q) << 1) + 2) >> 2);
-  PredArray[ 7] = (imgpel) ((P_Q + P_A + ((P_Z) << 1) + 2) >> 2);
-  PredArray[ 8] = (imgpel) ((P_Z + P_B + ((P_A) << 1) + 2) >> 2);
-  PredArray[ 9] = (imgpel) ((P_A + P_C + ((P_B) << 1) + 2) >> 2);
-  PredArray[10] = (imgpel) ((P_B + P_D + ((P_C) << 1) + 2) >> 2);
-  PredArray[11] = (imgpel) ((P_C + P_E + ((P_D) << 1) + 2) >> 2);
-  PredArray[12] = (imgpel) ((P_D + P_F + ((P_E) << 1) + 2) >> 2);
-  PredArray[13] = (imgpel) ((P_E + P_G + ((P_F) << 1) + 2) >> 2);
-  PredArray[14] = (imgpel) ((P_F + P_H + ((P_G) << 1) + 2) >> 2);
-
-  pred_pels = &PredArray[7];
-
-  memcpy((*mb_pred++) + ioff, pred_pels--, 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, pred_pels--, 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, pred_pels--, 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, pred_pels--, 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, pred_pels--, 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, pred_pels--, 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, pred_pels--, 8 * sizeof(imgpel));
-  memcpy((*mb_pred  ) + ioff, pred_pels  , 8 * sizeof(imgpel));
- 
-  return DECODING_OK;
-}
-
-/*!
- ***********************************************************************
- * \brief
- *    makes and returns 8x8 diagonal down left prediction mode
- *
- * \return
- *    DECODING_OK   decoding of intra prediction mode was successful            \n
- *
- ***********************************************************************
- */
-static inline int intra8x8_diag_down_left_pred(Macroblock *currMB,    //!< current macroblock
-                                               ColorPlane pl,         //!< current image plane
-                                               int ioff,              //!< pixel offset X within MB
-                                               int joff)              //!< pixel offset Y within MB
-{
-  Slice *currSlice = currMB->p_Slice;
-  VideoParameters *p_Vid = currMB->p_Vid;
-  
-  imgpel PredPel[25];    // array of predictor pels
-  imgpel PredArray[16];  // array of final prediction values
-  imgpel *Pred = &PredArray[0];
-  imgpel **imgY = (pl) ? currSlice->dec_picture->imgUV[pl - 1] : currSlice->dec_picture->imgY; // For MB level frame/field coding tools -- set default to imgY
-
-  PixelPos pix_a;
-  PixelPos pix_b, pix_c, pix_d;
-
-  int block_available_up;
-  int block_available_left;
-  int block_available_up_left;
-  int block_available_up_right;
-  
-  for (int i=0; i<25;i++) PredPel[i]=0;
-
-  imgpel **mb_pred = &currSlice->mb_pred[pl][joff];
-  int *mb_size = p_Vid->mb_size[IS_LUMA];
-
-  getNonAffNeighbour(currMB, ioff - 1, joff    , mb_size, &pix_a);
-  getNonAffNeighbour(currMB, ioff    , joff - 1, mb_size, &pix_b);
-  getNonAffNeighbour(currMB, ioff + 8, joff - 1, mb_size, &pix_c);
-  getNonAffNeighbour(currMB, ioff - 1, joff - 1, mb_size, &pix_d);
-
-  pix_c.available = pix_c.available &&!(ioff == 8 && joff == 8);
-
-  if (p_Vid->active_pps->constrained_intra_pred_flag)
-  {
-    block_available_left     = pix_a.available ? currSlice->intra_block [pix_a.mb_addr]: 0;
-    block_available_up       = pix_b.available ? currSlice->intra_block [pix_b.mb_addr] : 0;
-    block_available_up_right = pix_c.available ? currSlice->intra_block [pix_c.mb_addr] : 0;
-    block_available_up_left  = pix_d.available ? currSlice->intra_block [pix_d.mb_addr] : 0;
-  }
-  else
-  {
-    block_available_left     = pix_a.available;
-    block_available_up       = pix_b.available;
-    block_available_up_right = pix_c.available;
-    block_available_up_left  = pix_d.available;
-  }
-
-  if (!block_available_up)
-    printf ("warning: Intra_8x8_Diagonal_Down_Left prediction mode not allowed at mb %d\n", (int) currSlice->current_mb_nr);
-
-  // form predictor pels
-  if (block_available_up)
-  {
-    memcpy(&PredPel[1], &imgY[pix_b.pos_y][pix_b.pos_x], BLOCK_SIZE_8x8 * sizeof(imgpel));
-  }
-  else
-  {
-#if (IMGTYPE == 0)
-    memset(&PredPel[1], p_Vid->dc_pred_value_comp[pl], BLOCK_SIZE_8x8 * sizeof(imgpel));
-#else
-    P_A = P_B = P_C = P_D = P_E = P_F = P_G = P_H = (imgpel) p_Vid->dc_pred_value_comp[pl];
-#endif
-  }
-
-  if (block_available_up_right)
-  {
-    memcpy(&PredPel[9], &imgY[pix_c.pos_y][pix_c.pos_x], BLOCK_SIZE_8x8 * sizeof(imgpel));
-  }
-  else
-  {
-#if (IMGTYPE == 0)
-    memset(&PredPel[9], PredPel[8], BLOCK_SIZE_8x8 * sizeof(imgpel));
-#else
-    P_I = P_J = P_K = P_L = P_M = P_N = P_O = P_P = P_H;
-#endif
-  }
-
-  if (block_available_left)
-  {
-    imgpel **img_pred = &imgY[pix_a.pos_y];
-    int pos_x = pix_a.pos_x;
-    P_Q = *(*(img_pred ++) + pos_x);
-    P_R = *(*(img_pred ++) + pos_x);
-    P_S = *(*(img_pred ++) + pos_x);
-    P_T = *(*(img_pred ++) + pos_x);
-    P_U = *(*(img_pred ++) + pos_x);
-    P_V = *(*(img_pred ++) + pos_x);
-    P_W = *(*(img_pred ++) + pos_x);
-    P_X = *(*(img_pred   ) + pos_x);
-  }
-  else
-  {
-    P_Q = P_R = P_S = P_T = P_U = P_V = P_W = P_X = (imgpel) p_Vid->dc_pred_value_comp[pl];
-  }
-
-  if (block_available_up_left)
-  {
-    P_Z = imgY[pix_d.pos_y][pix_d.pos_x];
-  }
-  else
-  {
-    P_Z = (imgpel) p_Vid->dc_pred_value_comp[pl];
-  }
-
-  LowPassForIntra8x8Pred(PredPel, block_available_up_left, block_available_up, block_available_left);
-
-  // Mode DIAG_DOWN_LEFT_PRED
-  *Pred++ = (imgpel) ((P_A + P_C + ((P_B) << 1) + 2) >> 2);
-  *Pred++ = (imgpel) ((P_B + P_D + ((P_C) << 1) + 2) >> 2);
-  *Pred++ = (imgpel) ((P_C + P_E + ((P_D) << 1) + 2) >> 2);
-  *Pred++ = (imgpel) ((P_D + P_F + ((P_E) << 1) + 2) >> 2);
-  *Pred++ = (imgpel) ((P_E + P_G + ((P_F) << 1) + 2) >> 2);
-  *Pred++ = (imgpel) ((P_F + P_H + ((P_G) << 1) + 2) >> 2);
-  *Pred++ = (imgpel) ((P_G + P_I + ((P_H) << 1) + 2) >> 2);
-  *Pred++ = (imgpel) ((P_H + P_J + ((P_I) << 1) + 2) >> 2);
-  *Pred++ = (imgpel) ((P_I + P_K + ((P_J) << 1) + 2) >> 2);
-  *Pred++ = (imgpel) ((P_J + P_L + ((P_K) << 1) + 2) >> 2);
-  *Pred++ = (imgpel) ((P_K + P_M + ((P_L) << 1) + 2) >> 2);
-  *Pred++ = (imgpel) ((P_L + P_N + ((P_M) << 1) + 2) >> 2);
-  *Pred++ = (imgpel) ((P_M + P_O + ((P_N) << 1) + 2) >> 2);
-  *Pred++ = (imgpel) ((P_N + P_P + ((P_O) << 1) + 2) >> 2);
-  *Pred   = (imgpel) ((P_O + P_P + ((P_P) << 1) + 2) >> 2);
-
-  Pred = &PredArray[ 0];
-
-  memcpy((*mb_pred++) + ioff, Pred++, 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, Pred++, 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, Pred++, 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, Pred++, 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, Pred++, 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, Pred++, 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, Pred++, 8 * sizeof(imgpel));
-  memcpy((*mb_pred  ) + ioff, Pred  , 8 * sizeof(imgpel));
-
-  return DECODING_OK;
-}
-
-/*!
- ***********************************************************************
- * \brief
- *    makes and returns 8x8 vertical right prediction mode
- *
- * \return
- *    DECODING_OK   decoding of intra prediction mode was successful            \n
- *
- ***********************************************************************
- */
-static inline int intra8x8_vert_right_pred(Macroblock *currMB,    //!< current macroblock
-                                           ColorPlane pl,         //!< current image plane
-                                           int ioff,              //!< pixel offset X within MB
-                                           int joff)              //!< pixel offset Y within MB
-{
-  Slice *currSlice = currMB->p_Slice;
-  VideoParameters *p_Vid = currMB->p_Vid;
-  
-  imgpel PredPel[25];  // array of predictor pels
-  imgpel PredArray[22];  // array of final prediction values
-  imgpel **imgY = (pl) ? currSlice->dec_picture->imgUV[pl - 1] : currSlice->dec_picture->imgY; // For MB level frame/field coding tools -- set default to imgY
-
-  PixelPos pix_a;
-  PixelPos pix_b, pix_c, pix_d;
-
-  int block_available_up;
-  int block_available_left;
-  int block_available_up_left;
-  int block_available_up_right;
-
-  for (int i=0; i<25;i++) PredPel[i]=0;
-
-  imgpel *pred_pels;
-  imgpel **mb_pred = &currSlice->mb_pred[pl][joff];
-  int *mb_size = p_Vid->mb_size[IS_LUMA];
-
-  getNonAffNeighbour(currMB, ioff - 1, joff    , mb_size, &pix_a);
-  getNonAffNeighbour(currMB, ioff    , joff - 1, mb_size, &pix_b);
-  getNonAffNeighbour(currMB, ioff + 8, joff - 1, mb_size, &pix_c);
-  getNonAffNeighbour(currMB, ioff - 1, joff - 1, mb_size, &pix_d);
-
-  pix_c.available = pix_c.available &&!(ioff == 8 && joff == 8);
-
-  if (p_Vid->active_pps->constrained_intra_pred_flag)
-  {
-    block_available_left     = pix_a.available ? currSlice->intra_block [pix_a.mb_addr]: 0;
-    block_available_up       = pix_b.available ? currSlice->intra_block [pix_b.mb_addr] : 0;
-    block_available_up_right = pix_c.available ? currSlice->intra_block [pix_c.mb_addr] : 0;
-    block_available_up_left  = pix_d.available ? currSlice->intra_block [pix_d.mb_addr] : 0;
-  }
-  else
-  {
-    block_available_left     = pix_a.available;
-    block_available_up       = pix_b.available;
-    block_available_up_right = pix_c.available;
-    block_available_up_left  = pix_d.available;
-  }
-
-  if ((!block_available_up)||(!block_available_left)||(!block_available_up_left))
-    printf ("warning: Intra_8x8_Vertical_Right prediction mode not allowed at mb %d\n", (int) currSlice->current_mb_nr);
-
-  // form predictor pels
-  if (block_available_up)
-  {
-    memcpy(&PredPel[1], &imgY[pix_b.pos_y][pix_b.pos_x], BLOCK_SIZE_8x8 * sizeof(imgpel));
-  }
-  else
-  {
-#if (IMGTYPE == 0)
-    memset(&PredPel[1], p_Vid->dc_pred_value_comp[pl], BLOCK_SIZE_8x8 * sizeof(imgpel));
-#else
-    P_A = P_B = P_C = P_D = P_E = P_F = P_G = P_H = (imgpel) p_Vid->dc_pred_value_comp[pl];
-#endif
-  }
-
-  if (block_available_up_right)
-  {
-    memcpy(&PredPel[9], &imgY[pix_c.pos_y][pix_c.pos_x], BLOCK_SIZE_8x8 * sizeof(imgpel));
-  }
-  else
-  {
-#if (IMGTYPE == 0)
-    memset(&PredPel[9], PredPel[8], BLOCK_SIZE_8x8 * sizeof(imgpel));
-#else
-    P_I = P_J = P_K = P_L = P_M = P_N = P_O = P_P = P_H;
-#endif
-  }
-
-  if (block_available_left)
-  {
-    imgpel **img_pred = &imgY[pix_a.pos_y];
-    int pos_x = pix_a.pos_x;
-    P_Q = *(*(img_pred ++) + pos_x);
-    P_R = *(*(img_pred ++) + pos_x);
-    P_S = *(*(img_pred ++) + pos_x);
-    P_T = *(*(img_pred ++) + pos_x);
-    P_U = *(*(img_pred ++) + pos_x);
-    P_V = *(*(img_pred ++) + pos_x);
-    P_W = *(*(img_pred ++) + pos_x);
-    P_X = *(*(img_pred   ) + pos_x);
-  }
-  else
-  {
-    P_Q = P_R = P_S = P_T = P_U = P_V = P_W = P_X = (imgpel) p_Vid->dc_pred_value_comp[pl];
-  }
-
-  if (block_available_up_left)
-  {
-    P_Z = imgY[pix_d.pos_y][pix_d.pos_x];
-  }
-  else
-  {
-    P_Z = (imgpel) p_Vid->dc_pred_value_comp[pl];
-  }
-
-  LowPassForIntra8x8Pred(PredPel, block_available_up_left, block_available_up, block_available_left);
-
-  pred_pels = PredArray;
-  *pred_pels++ = (imgpel) ((P_V + P_T + ((P_U) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_T + P_R + ((P_S) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_R + P_Z + ((P_Q) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_Z + P_A + 1) >> 1);
-  *pred_pels++ = (imgpel) ((P_A + P_B + 1) >> 1);
-  *pred_pels++ = (imgpel) ((P_B + P_C + 1) >> 1);
-  *pred_pels++ = (imgpel) ((P_C + P_D + 1) >> 1);
-  *pred_pels++ = (imgpel) ((P_D + P_E + 1) >> 1);
-  *pred_pels++ = (imgpel) ((P_E + P_F + 1) >> 1);
-  *pred_pels++ = (imgpel) ((P_F + P_G + 1) >> 1);
-  *pred_pels++ = (imgpel) ((P_G + P_H + 1) >> 1);
-
-  *pred_pels++ = (imgpel) ((P_W + P_U + ((P_V) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_U + P_S + ((P_T) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_S + P_Q + ((P_R) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_Q + P_A + ((P_Z) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_Z + P_B + ((P_A) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_A + P_C + ((P_B) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_B + P_D + ((P_C) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_C + P_E + ((P_D) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_D + P_F + ((P_E) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_E + P_G + ((P_F) << 1) + 2) >> 2);
-  *pred_pels   = (imgpel) ((P_F + P_H + ((P_G) << 1) + 2) >> 2);
-
-  memcpy((*mb_pred++) + ioff, &PredArray[ 3], 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, &PredArray[14], 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, &PredArray[ 2], 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, &PredArray[13], 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, &PredArray[ 1], 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, &PredArray[12], 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, &PredArray[ 0], 8 * sizeof(imgpel));
-  memcpy((*mb_pred  ) + ioff, &PredArray[11], 8 * sizeof(imgpel));
-
-  return DECODING_OK;
-}
-
-
-/*!
- ***********************************************************************
- * \brief
- *    makes and returns 8x8 vertical left prediction mode
- *
- * \return
- *    DECODING_OK   decoding of intra prediction mode was successful            \n
- *
- ***********************************************************************
- */
-static inline int intra8x8_vert_left_pred(Macroblock *currMB,    //!< current macroblock
-                                          ColorPlane pl,         //!< current image plane
-                                          int ioff,              //!< pixel offset X within MB
-                                          int joff)              //!< pixel offset Y within MB
-{
-  Slice *currSlice = currMB->p_Slice;
-  VideoParameters *p_Vid = currMB->p_Vid;
-  
-  imgpel PredPel[25];  // array of predictor pels  
-  imgpel PredArray[22];  // array of final prediction values
-  imgpel *pred_pel = &PredArray[0];
-  imgpel **imgY = (pl) ? currSlice->dec_picture->imgUV[pl - 1] : currSlice->dec_picture->imgY; // For MB level frame/field coding tools -- set default to imgY
-
-  PixelPos pix_a;
-  PixelPos pix_b, pix_c, pix_d;
-
-  int block_available_up;
-  int block_available_left;
-  int block_available_up_left;
-  int block_available_up_right;
-
-  imgpel **mb_pred = &currSlice->mb_pred[pl][joff];
-  int *mb_size = p_Vid->mb_size[IS_LUMA];
-
-  for (int i=0; i<25;i++) PredPel[i]=0;
-
-  getNonAffNeighbour(currMB, ioff - 1, joff    , mb_size, &pix_a);
-  getNonAffNeighbour(currMB, ioff    , joff - 1, mb_size, &pix_b);
-  getNonAffNeighbour(currMB, ioff + 8, joff - 1, mb_size, &pix_c);
-  getNonAffNeighbour(currMB, ioff - 1, joff - 1, mb_size, &pix_d);
-
-  pix_c.available = pix_c.available &&!(ioff == 8 && joff == 8);
-
-  if (p_Vid->active_pps->constrained_intra_pred_flag)
-  {
-    block_available_left     = pix_a.available ? currSlice->intra_block [pix_a.mb_addr] : 0;
-    block_available_up       = pix_b.available ? currSlice->intra_block [pix_b.mb_addr] : 0;
-    block_available_up_right = pix_c.available ? currSlice->intra_block [pix_c.mb_addr] : 0;
-    block_available_up_left  = pix_d.available ? currSlice->intra_block [pix_d.mb_addr] : 0;
-  }
-  else
-  {
-    block_available_left     = pix_a.available;
-    block_available_up       = pix_b.available;
-    block_available_up_right = pix_c.available;
-    block_available_up_left  = pix_d.available;
-  }
-
-  if (!block_available_up)
-    printf ("warning: Intra_4x4_Vertical_Left prediction mode not allowed at mb %d\n", (int) currSlice->current_mb_nr);
-
-  // form predictor pels
-  if (block_available_up)
-  {
-    memcpy(&PredPel[1], &imgY[pix_b.pos_y][pix_b.pos_x], BLOCK_SIZE_8x8 * sizeof(imgpel));
-  }
-  else
-  {
-#if (IMGTYPE == 0)
-    memset(&PredPel[1], p_Vid->dc_pred_value_comp[pl], BLOCK_SIZE_8x8 * sizeof(imgpel));
-#else
-    P_A = P_B = P_C = P_D = P_E = P_F = P_G = P_H = (imgpel) p_Vid->dc_pred_value_comp[pl];
-#endif
-  }
-
-  if (block_available_up_right)
-  {
-    memcpy(&PredPel[9], &imgY[pix_c.pos_y][pix_c.pos_x], BLOCK_SIZE_8x8 * sizeof(imgpel));
-  }
-  else
-  {
-#if (IMGTYPE == 0)
-    memset(&PredPel[9], PredPel[8], BLOCK_SIZE_8x8 * sizeof(imgpel));
-#else
-    P_I = P_J = P_K = P_L = P_M = P_N = P_O = P_P = P_H;
-#endif
-  }
-
-  if (block_available_left)
-  {
-    imgpel **img_pred = &imgY[pix_a.pos_y];
-    int pos_x = pix_a.pos_x;
-    P_Q = *(*(img_pred ++) + pos_x);
-    P_R = *(*(img_pred ++) + pos_x);
-    P_S = *(*(img_pred ++) + pos_x);
-    P_T = *(*(img_pred ++) + pos_x);
-    P_U = *(*(img_pred ++) + pos_x);
-    P_V = *(*(img_pred ++) + pos_x);
-    P_W = *(*(img_pred ++) + pos_x);
-    P_X = *(*(img_pred   ) + pos_x);
-  }
-  else
-  {
-    P_Q = P_R = P_S = P_T = P_U = P_V = P_W = P_X = (imgpel) p_Vid->dc_pred_value_comp[pl];
-  }
-
-  if (block_available_up_left)
-  {
-    P_Z = imgY[pix_d.pos_y][pix_d.pos_x];
-  }
-  else
-  {
-    P_Z = (imgpel) p_Vid->dc_pred_value_comp[pl];
-  }
-
-  LowPassForIntra8x8Pred(PredPel, block_available_up_left, block_available_up, block_available_left);
-
-  *pred_pel++ = (imgpel) ((P_A + P_B + 1) >> 1);
-  *pred_pel++ = (imgpel) ((P_B + P_C + 1) >> 1);
-  *pred_pel++ = (imgpel) ((P_C + P_D + 1) >> 1);
-  *pred_pel++ = (imgpel) ((P_D + P_E + 1) >> 1);
-  *pred_pel++ = (imgpel) ((P_E + P_F + 1) >> 1);
-  *pred_pel++ = (imgpel) ((P_F + P_G + 1) >> 1);
-  *pred_pel++ = (imgpel) ((P_G + P_H + 1) >> 1);
-  *pred_pel++ = (imgpel) ((P_H + P_I + 1) >> 1);
-  *pred_pel++ = (imgpel) ((P_I + P_J + 1) >> 1);
-  *pred_pel++ = (imgpel) ((P_J + P_K + 1) >> 1);
-  *pred_pel++ = (imgpel) ((P_K + P_L + 1) >> 1);
-  *pred_pel++ = (imgpel) ((P_A + P_C + ((P_B) << 1) + 2) >> 2);
-  *pred_pel++ = (imgpel) ((P_B + P_D + ((P_C) << 1) + 2) >> 2);
-  *pred_pel++ = (imgpel) ((P_C + P_E + ((P_D) << 1) + 2) >> 2);
-  *pred_pel++ = (imgpel) ((P_D + P_F + ((P_E) << 1) + 2) >> 2);
-  *pred_pel++ = (imgpel) ((P_E + P_G + ((P_F) << 1) + 2) >> 2);
-  *pred_pel++ = (imgpel) ((P_F + P_H + ((P_G) << 1) + 2) >> 2);
-  *pred_pel++ = (imgpel) ((P_G + P_I + ((P_H) << 1) + 2) >> 2);
-  *pred_pel++ = (imgpel) ((P_H + P_J + ((P_I) << 1) + 2) >> 2);
-  *pred_pel++ = (imgpel) ((P_I + P_K + ((P_J) << 1) + 2) >> 2);
-  *pred_pel++ = (imgpel) ((P_J + P_L + ((P_K) << 1) + 2) >> 2);
-  *pred_pel   = (imgpel) ((P_K + P_M + ((P_L) << 1) + 2) >> 2);
-
-  memcpy((*mb_pred++) + ioff, &PredArray[ 0], 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, &PredArray[11], 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, &PredArray[ 1], 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, &PredArray[12], 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, &PredArray[ 2], 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, &PredArray[13], 8 * sizeof(imgpel));
-  memcpy((*mb_pred++) + ioff, &PredArray[ 3], 8 * sizeof(imgpel));
-  memcpy((*mb_pred  ) + ioff, &PredArray[14], 8 * sizeof(imgpel));
-
-  return DECODING_OK;
-}
-
-/*!
- ***********************************************************************
- * \brief
- *    makes and returns 8x8 horizontal up prediction mode
- *
- * \return
- *    DECODING_OK   decoding of intra prediction mode was successful            \n
- *
- ***********************************************************************
- */
-static inline int intra8x8_hor_up_pred(Macroblock *currMB,    //!< current macroblock
-                                       ColorPlane pl,         //!< current image plane
-                                       int ioff,              //!< pixel offset X within MB
-                                       int joff)              //!< pixel offset Y within MB
-{
-  Slice *currSlice = currMB->p_Slice;
-  VideoParameters *p_Vid = currMB->p_Vid;
-
-  imgpel PredPel[25];     // array of predictor pels
-  imgpel PredArray[22];   // array of final prediction values
-  imgpel **imgY = (pl) ? currSlice->dec_picture->imgUV[pl - 1] : currSlice->dec_picture->imgY; // For MB level frame/field coding tools -- set default to imgY
-
-  PixelPos pix_a;
-  PixelPos pix_b, pix_c, pix_d;
-
-  int block_available_up;
-  int block_available_left;
-  int block_available_up_left;
-  int block_available_up_right;
-  int jpos0 = joff    , jpos1 = joff + 1, jpos2 = joff + 2, jpos3 = joff + 3;
-  int jpos4 = joff + 4, jpos5 = joff + 5, jpos6 = joff + 6, jpos7 = joff + 7;
-
-  for (int i=0; i<25;i++) PredPel[i]=0;
-
-  imgpel **mpr = currSlice->mb_pred[pl];
-  int *mb_size = p_Vid->mb_size[IS_LUMA];
-
-  getNonAffNeighbour(currMB, ioff - 1, joff    , mb_size, &pix_a);
-  getNonAffNeighbour(currMB, ioff    , joff - 1, mb_size, &pix_b);
-  getNonAffNeighbour(currMB, ioff + 8, joff - 1, mb_size, &pix_c);
-  getNonAffNeighbour(currMB, ioff - 1, joff - 1, mb_size, &pix_d);
-  
-  pix_c.available = pix_c.available &&!(ioff == 8 && joff == 8);
-
-  if (p_Vid->active_pps->constrained_intra_pred_flag)
-  {
-    block_available_left     = pix_a.available ? currSlice->intra_block [pix_a.mb_addr] : 0;
-    block_available_up       = pix_b.available ? currSlice->intra_block [pix_b.mb_addr] : 0;
-    block_available_up_right = pix_c.available ? currSlice->intra_block [pix_c.mb_addr] : 0;
-    block_available_up_left  = pix_d.available ? currSlice->intra_block [pix_d.mb_addr] : 0;
-  }
-  else
-  {
-    block_available_left     = pix_a.available;
-    block_available_up       = pix_b.available;
-    block_available_up_right = pix_c.available;
-    block_available_up_left  = pix_d.available;
-  }
-
-  if (!block_available_left)
-    printf ("warning: Intra_8x8_Horizontal_Up prediction mode not allowed at mb %d\n", (int) currSlice->current_mb_nr);
-
-  // form predictor pels
-  if (block_available_up)
-  {
-    memcpy(&PredPel[1], &imgY[pix_b.pos_y][pix_b.pos_x], BLOCK_SIZE_8x8 * sizeof(imgpel));
-  }
-  else
-  {
-#if (IMGTYPE == 0)
-    memset(&PredPel[1], p_Vid->dc_pred_value_comp[pl], BLOCK_SIZE_8x8 * sizeof(imgpel));
-#else
-    P_A = P_B = P_C = P_D = P_E = P_F = P_G = P_H = (imgpel) p_Vid->dc_pred_value_comp[pl];
-#endif
-  }
-
-  if (block_available_up_right)
-  {
-    memcpy(&PredPel[9], &imgY[pix_c.pos_y][pix_c.pos_x], BLOCK_SIZE_8x8 * sizeof(imgpel));
-  }
-  else
-  {
-#if (IMGTYPE == 0)
-    memset(&PredPel[9], PredPel[8], BLOCK_SIZE_8x8 * sizeof(imgpel));
-#else
-    P_I = P_J = P_K = P_L = P_M = P_N = P_O = P_P = P_H;
-#endif
-  }
-
-  if (block_available_left)
-  {
-    imgpel **img_pred = &imgY[pix_a.pos_y];
-    int pos_x = pix_a.pos_x;
-    P_Q = *(*(img_pred ++) + pos_x);
-    P_R = *(*(img_pred ++) + pos_x);
-    P_S = *(*(img_pred ++) + pos_x);
-    P_T = *(*(img_pred ++) + pos_x);
-    P_U = *(*(img_pred ++) + pos_x);
-    P_V = *(*(img_pred ++) + pos_x);
-    P_W = *(*(img_pred ++) + pos_x);
-    P_X = *(*(img_pred   ) + pos_x);
-  }
-  else
-  {
-    P_Q = P_R = P_S = P_T = P_U = P_V = P_W = P_X = (imgpel) p_Vid->dc_pred_value_comp[pl];
-  }
-
-  if (block_available_up_left)
-  {
-    P_Z = imgY[pix_d.pos_y][pix_d.pos_x];
-  }
-  else
-  {
-    P_Z = (imgpel) p_Vid->dc_pred_value_comp[pl];
-  }
-
-  LowPassForIntra8x8Pred(PredPel, block_available_up_left, block_available_up, block_available_left);
-
-  PredArray[ 0] = (imgpel) ((P_Q + P_R + 1) >> 1);
-  PredArray[ 1] = (imgpel) ((P_S + P_Q + ((P_R) << 1) + 2) >> 2);
-  PredArray[ 2] = (imgpel) ((P_R + P_S + 1) >> 1);
-  PredArray[ 3] = (imgpel) ((P_T + P_R + ((P_S) << 1) + 2) >> 2);
-  PredArray[ 4] = (imgpel) ((P_S + P_T + 1) >> 1);
-  PredArray[ 5] = (imgpel) ((P_U + P_S + ((P_T) << 1) + 2) >> 2);
-  PredArray[ 6] = (imgpel) ((P_T + P_U + 1) >> 1);
-  PredArray[ 7] = (imgpel) ((P_V + P_T + ((P_U) << 1) + 2) >> 2);
-  PredArray[ 8] = (imgpel) ((P_U + P_V + 1) >> 1);
-  PredArray[ 9] = (imgpel) ((P_W + P_U + ((P_V) << 1) + 2) >> 2);
-  PredArray[10] = (imgpel) ((P_V + P_W + 1) >> 1);
-  PredArray[11] = (imgpel) ((P_X + P_V + ((P_W) << 1) + 2) >> 2);
-  PredArray[12] = (imgpel) ((P_W + P_X + 1) >> 1);
-  PredArray[13] = (imgpel) ((P_W + P_X + ((P_X) << 1) + 2) >> 2);
-  PredArray[14] = (imgpel) P_X;
-  PredArray[15] = (imgpel) P_X;
-  PredArray[16] = (imgpel) P_X;
-  PredArray[17] = (imgpel) P_X;
-  PredArray[18] = (imgpel) P_X;
-  PredArray[19] = (imgpel) P_X;
-  PredArray[20] = (imgpel) P_X;
-  PredArray[21] = (imgpel) P_X;
-
-  memcpy(&mpr[jpos0][ioff], &PredArray[0], 8 * sizeof(imgpel));
-  memcpy(&mpr[jpos1][ioff], &PredArray[2], 8 * sizeof(imgpel));
-  memcpy(&mpr[jpos2][ioff], &PredArray[4], 8 * sizeof(imgpel));
-  memcpy(&mpr[jpos3][ioff], &PredArray[6], 8 * sizeof(imgpel));
-  memcpy(&mpr[jpos4][ioff], &PredArray[8], 8 * sizeof(imgpel));
-  memcpy(&mpr[jpos5][ioff], &PredArray[10], 8 * sizeof(imgpel));
-  memcpy(&mpr[jpos6][ioff], &PredArray[12], 8 * sizeof(imgpel));
-  memcpy(&mpr[jpos7][ioff], &PredArray[14], 8 * sizeof(imgpel));
-
-  return DECODING_OK;
-}
-
-/*!
- ***********************************************************************
- * \brief
- *    makes and returns 8x8 horizontal down prediction mode
- *
- * \return
- *    DECODING_OK   decoding of intra prediction mode was successful            \n
- *
- ***********************************************************************
- */
-static inline int intra8x8_hor_down_pred(Macroblock *currMB,    //!< current macroblock
-                                         ColorPlane pl,         //!< current image plane
-                                         int ioff,              //!< pixel offset X within MB
-                                         int joff)              //!< pixel offset Y within MB
-{
-  Slice *currSlice = currMB->p_Slice;
-  VideoParameters *p_Vid = currMB->p_Vid;
-
-  imgpel PredPel[25];  // array of predictor pels
-  imgpel PredArray[22];   // array of final prediction values
-  imgpel **imgY = (pl) ? currSlice->dec_picture->imgUV[pl - 1] : currSlice->dec_picture->imgY; // For MB level frame/field coding tools -- set default to imgY
-
-  PixelPos pix_a;
-  PixelPos pix_b, pix_c, pix_d;
-
-  int block_available_up;
-  int block_available_left;
-  int block_available_up_left;
-  int block_available_up_right;
-  
-  imgpel *pred_pels;
-  imgpel **mb_pred = &currSlice->mb_pred[pl][joff];
-  int *mb_size = p_Vid->mb_size[IS_LUMA];
-
-  for (int i=0; i<25;i++) PredPel[i]=0;
-
-  getNonAffNeighbour(currMB, ioff - 1, joff    , mb_size, &pix_a);
-  getNonAffNeighbour(currMB, ioff    , joff - 1, mb_size, &pix_b);
-  getNonAffNeighbour(currMB, ioff + 8, joff - 1, mb_size, &pix_c);
-  getNonAffNeighbour(currMB, ioff - 1, joff - 1, mb_size, &pix_d);
-
-  pix_c.available = pix_c.available &&!(ioff == 8 && joff == 8);
-
-  if (p_Vid->active_pps->constrained_intra_pred_flag)
-  {
-    block_available_left     = pix_a.available ? currSlice->intra_block [pix_a.mb_addr] : 0;
-    block_available_up       = pix_b.available ? currSlice->intra_block [pix_b.mb_addr] : 0;
-    block_available_up_right = pix_c.available ? currSlice->intra_block [pix_c.mb_addr] : 0;
-    block_available_up_left  = pix_d.available ? currSlice->intra_block [pix_d.mb_addr] : 0;
-  }
-  else
-  {
-    block_available_left     = pix_a.available;
-    block_available_up       = pix_b.available;
-    block_available_up_right = pix_c.available;
-    block_available_up_left  = pix_d.available;
-  }
-
-  if ((!block_available_up)||(!block_available_left)||(!block_available_up_left))
-    printf ("warning: Intra_8x8_Horizontal_Down prediction mode not allowed at mb %d\n", (int) currSlice->current_mb_nr);
-
-  // form predictor pels
-  if (block_available_up)
-  {
-    memcpy(&PredPel[1], &imgY[pix_b.pos_y][pix_b.pos_x], BLOCK_SIZE_8x8 * sizeof(imgpel));
-  }
-  else
-  {
-#if (IMGTYPE == 0)
-    memset(&PredPel[1], p_Vid->dc_pred_value_comp[pl], BLOCK_SIZE_8x8 * sizeof(imgpel));
-#else
-    P_A = P_B = P_C = P_D = P_E = P_F = P_G = P_H = (imgpel) p_Vid->dc_pred_value_comp[pl];
-#endif
-  }
-
-  if (block_available_up_right)
-  {
-    memcpy(&PredPel[9], &imgY[pix_c.pos_y][pix_c.pos_x], BLOCK_SIZE_8x8 * sizeof(imgpel));
-  }
-  else
-  {
-#if (IMGTYPE == 0)
-    memset(&PredPel[9], PredPel[8], BLOCK_SIZE_8x8 * sizeof(imgpel));
-#else
-    P_I = P_J = P_K = P_L = P_M = P_N = P_O = P_P = P_H;
-#endif
-  }
-
-  if (block_available_left)
-  {
-    imgpel **img_pred = &imgY[pix_a.pos_y];
-    int pos_x = pix_a.pos_x;
-    P_Q = *(*(img_pred ++) + pos_x);
-    P_R = *(*(img_pred ++) + pos_x);
-    P_S = *(*(img_pred ++) + pos_x);
-    P_T = *(*(img_pred ++) + pos_x);
-    P_U = *(*(img_pred ++) + pos_x);
-    P_V = *(*(img_pred ++) + pos_x);
-    P_W = *(*(img_pred ++) + pos_x);
-    P_X = *(*(img_pred   ) + pos_x);
-  }
-  else
-  {
-    P_Q = P_R = P_S = P_T = P_U = P_V = P_W = P_X = (imgpel) p_Vid->dc_pred_value_comp[pl];
-  }
-
-  if (block_available_up_left)
-  {
-    P_Z = imgY[pix_d.pos_y][pix_d.pos_x];
-  }
-  else
-  {
-    P_Z = (imgpel) p_Vid->dc_pred_value_comp[pl];
-  }
-
-  LowPassForIntra8x8Pred(PredPel, block_available_up_left, block_available_up, block_available_left);
-
-  pred_pels = PredArray;
-
-  *pred_pels++ = (imgpel) ((P_X + P_W + 1) >> 1);
-  *pred_pels++ = (imgpel) ((P_V + P_X + (P_W << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_W + P_V + 1) >> 1);
-  *pred_pels++ = (imgpel) ((P_U + P_W + ((P_V) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_V + P_U + 1) >> 1);
-  *pred_pels++ = (imgpel) ((P_T + P_V + ((P_U) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_U + P_T + 1) >> 1);
-  *pred_pels++ = (imgpel) ((P_S + P_U + ((P_T) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_T + P_S + 1) >> 1);
-  *pred_pels++ = (imgpel) ((P_R + P_T + ((P_S) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_S + P_R + 1) >> 1);
-  *pred_pels++ = (imgpel) ((P_Q + P_S + ((P_R) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_R + P_Q + 1) >> 1);
-  *pred_pels++ = (imgpel) ((P_Z + P_R + ((P_Q) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_Q + P_Z + 1) >> 1);
-  *pred_pels++ = (imgpel) ((P_Q + P_A + ((P_Z) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_Z + P_B + ((P_A) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_A + P_C + ((P_B) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_B + P_D + ((P_C) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_C + P_E + ((P_D) << 1) + 2) >> 2);
-  *pred_pels++ = (imgpel) ((P_D + P_F + ((P_E) << 1) + 2) >> 2);
-  *pred_pels   = (imgpel) ((P_E + P_G + ((P_F) << 1) + 2) >> 2);
-
-  pred_pels = &PredArray[14];
-  memcpy((*mb_pred++) + ioff, pred_pels, 8 * sizeof(imgpel));
-  pred_pels -= 2;
-  memcpy((*mb_pred++) + ioff, pred_pels, 8 * sizeof(imgpel));
-  pred_pels -= 2;
-  memcpy((*mb_pred++) + ioff, pred_pels, 8 * sizeof(imgpel));
-  pred_pels -= 2;
-  memcpy((*mb_pred++) + ioff, pred_pels, 8 * sizeof(imgpel));
-  pred_pels -= 2;
-  memcpy((*mb_pred++) + ioff, pred_pels, 8 * sizeof(imgpel));
-  pred_pels -= 2;
-  memcpy((*mb_pred++) + ioff, pred_pels, 8 * sizeof(imgpel));
-  pred_pels -= 2;
-  memcpy((*mb_pred++) + ioff, pred_pels, 8 * sizeof(imgpel));
-  pred_pels -= 2;
-  memcpy((*mb_pred  ) + ioff, pred_pels, 8 * sizeof(imgpel));
-  
-  return DECODING_OK;
-}
-
 /*!
  ************************************************************************
  * \brief
@@ -1523,42 +58,33 @@ int intra_pred_8x8_normal(Macroblock *currMB,    //!< Current Macroblock
   int block_x = (currMB->block_x) + (ioff >> 2);
   int block_y = (currMB->block_y) + (joff >> 2);
   byte predmode = currMB->p_Slice->ipredmode[block_y][block_x];
+  ALIGNED(16) imgpel nb[NB_SIZE];  // neighbour sample vector
+
+  int block_available_left;
+  int block_available_up;
+  int block_available_up_left;
 
   currMB->ipmode_DPCM = predmode;  //For residual DPCM
 
-  switch (predmode)
+  if (predmode > HOR_UP_PRED)
   {
-  case DC_PRED:
-    return (intra8x8_dc_pred(currMB, pl, ioff, joff));
-    break;
-  case VERT_PRED:
-    return (intra8x8_vert_pred(currMB, pl, ioff, joff));
-    break;
-  case HOR_PRED:
-    return (intra8x8_hor_pred(currMB, pl, ioff, joff));
-    break;
-  case DIAG_DOWN_RIGHT_PRED:
-    return (intra8x8_diag_down_right_pred(currMB, pl, ioff, joff));
-    break;
-  case DIAG_DOWN_LEFT_PRED:
-    return (intra8x8_diag_down_left_pred(currMB, pl, ioff, joff));
-    break;
-  case VERT_RIGHT_PRED:
-    return (intra8x8_vert_right_pred(currMB, pl, ioff, joff));
-    break;
-  case VERT_LEFT_PRED:
-    return (intra8x8_vert_left_pred(currMB, pl, ioff, joff));
-    break;
-  case HOR_UP_PRED:
-    return (intra8x8_hor_up_pred(currMB, pl, ioff, joff));
-    break;
-  case HOR_DOWN_PRED:  
-    return (intra8x8_hor_down_pred(currMB, pl, ioff, joff));
-  default:
     printf("Error: illegal intra_8x8 prediction mode: %d\n", (int) predmode);
     return SEARCH_SYNC;
-    break;
   }
-}
 
+  get_block_neighbours(currMB, pl, ioff, joff, BLOCK_SIZE_8x8, nb, &block_available_left, &block_available_up, &block_available_up_left);
+
+  // the 8x8 modes still predict from the substituted samples after warning
+  if (!intra_block_mode_available(predmode, block_available_left, block_available_up, block_available_up_left))
+    printf ("warning: Intra_8x8_%s prediction mode not allowed at mb %d\n", intra_block_mode_name[predmode], (int) currMB->p_Slice->current_mb_nr);
+
+  intra_kernels.lowpass_8x8(nb, block_available_up_left, block_available_up, block_available_left);
+
+  if (predmode == DC_PRED)
+    set_dc_neighbours(nb, BLOCK_SIZE_8x8, block_available_left, block_available_up);
+
+  intra_kernels.pred_8x8[predmode](currMB->p_Slice->mb_pred[pl], ioff, joff, nb);
+
+  return DECODING_OK;
+}
 
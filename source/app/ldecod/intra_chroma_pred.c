@@ -14,6 +14,7 @@
  */
 #include "global.h"
 #include "block.h"
+#include "intra_pred_common.h"
 #include "mb_access.h"
 #include "image.h"
 
@@ -290,7 +291,7 @@ static void intrapred_chroma_plane(Macroblock *currMB)
     int cr_MB_y2 = (cr_MB_y >> 1);
     int cr_MB_x2 = (cr_MB_x >> 1);
 
-    int i,j;
+    int i;
     int ih, iv, ib, ic, iaa;
     int uv;
     for (uv = 0; uv < 2; uv++) 
@@ -321,13 +322,7 @@ static void intrapred_chroma_plane(Macroblock *currMB)
 
       iaa = ((imgUV[pos_y1][pos_x] + upPred[cr_MB_x-1]) << 4);
 
-      for (j = 0; j < cr_MB_y; ++j)
-      {
-        int plane = iaa + (j - cr_MB_y2 + 1) * ic + 16 - (cr_MB_x2 - 1) * ib;
-
-        for (i = 0; i < cr_MB_x; ++i)
-          mb_pred[j][i]=(imgpel) iClip1(max_imgpel_value, ((i * ib + plane) >> 5));
-      }
+      intra_kernels.plane(mb_pred, cr_MB_x, cr_MB_y, iaa, ib, ic, max_imgpel_value);
     }
   }
 }
@@ -16,8 +16,19 @@
 #include "intra4x4_pred.h"
 #include "intra8x8_pred.h"
 #include "intra16x16_pred.h"
+#include "intra_pred_common.h"
 #include "mb_access.h"
 #include "image.h"
+#include "cpu_features.h"
+
+IntraKernels intra_kernels;
+
+//! name of each 4x4 / 8x8 prediction mode, for the availability warnings
+const char *intra_block_mode_name[9] =
+{
+  "Vertical", "Horizontal", "DC", "Diagonal_Down_Left", "Diagonal_Down_Right",
+  "Vertical_Right", "Horizontal_Down", "Vertical_Left", "Horizontal_Up"
+};
 
 
 extern void intra_pred_chroma      (Macroblock *currMB);
@@ -41,3 +52,379 @@ void set_intra_prediction_modes(Slice *currSlice)
     currSlice->intra_pred_chroma = intra_pred_chroma;   
   }
 }
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Fills the neighbour vector of the n x n block at (ioff, joff) of a
+ *    non-MBAFF macroblock (see intra_pred_common.h) and returns the
+ *    availability of the left, above and above left neighbours. Missing
+ *    samples are replaced by the DC value, a missing above right part
+ *    repeats the last above sample.
+ ************************************************************************
+ */
+void get_block_neighbours(Macroblock *currMB, ColorPlane pl, int ioff, int joff, int n, imgpel *nb,
+                          int *block_available_left, int *block_available_up, int *block_available_up_left)
+{
+  Slice *currSlice = currMB->p_Slice;
+  VideoParameters *p_Vid = currMB->p_Vid;
+  PicPlane *plane = &currSlice->dec_picture->plane[pl];
+  imgpel *img = plane->data;
+  int stride = plane->stride;
+  imgpel dc_pred_value = (imgpel) p_Vid->dc_pred_value_comp[pl];
+  int *mb_size = p_Vid->mb_size[IS_LUMA];
+  int block_available_up_right;
+  int i;
+
+  PixelPos pix_a, pix_b, pix_c, pix_d;
+
+  getNonAffNeighbour(currMB, ioff - 1, joff    , mb_size, &pix_a);
+  getNonAffNeighbour(currMB, ioff    , joff - 1, mb_size, &pix_b);
+  getNonAffNeighbour(currMB, ioff + n, joff - 1, mb_size, &pix_c);
+  getNonAffNeighbour(currMB, ioff - 1, joff - 1, mb_size, &pix_d);
+
+  if (n == BLOCK_SIZE)
+    pix_c.available = pix_c.available && !((ioff == 4) && ((joff == 4) || (joff == 12)));
+  else
+    pix_c.available = pix_c.available && !((ioff == 8) && (joff == 8));
+
+  if (p_Vid->active_pps->constrained_intra_pred_flag)
+  {
+    *block_available_left    = pix_a.available ? currSlice->intra_block [pix_a.mb_addr] : 0;
+    *block_available_up      = pix_b.available ? currSlice->intra_block [pix_b.mb_addr] : 0;
+    block_available_up_right = pix_c.available ? currSlice->intra_block [pix_c.mb_addr] : 0;
+    *block_available_up_left = pix_d.available ? currSlice->intra_block [pix_d.mb_addr] : 0;
+  }
+  else
+  {
+    *block_available_left    = pix_a.available;
+    *block_available_up      = pix_b.available;
+    block_available_up_right = pix_c.available;
+    *block_available_up_left = pix_d.available;
+  }
+
+  if (*block_available_up)
+    memcpy(&nb[NB_TOP(n)], img + pix_b.pos_y * stride + pix_b.pos_x, n * sizeof(imgpel));
+  else
+  {
+    for (i = 0; i < n; ++i)
+      nb[NB_TOP(n) + i] = dc_pred_value;
+  }
+
+  if (block_available_up_right)
+    memcpy(&nb[NB_TOP(n) + n], img + pix_c.pos_y * stride + pix_c.pos_x, n * sizeof(imgpel));
+  else
+  {
+    for (i = n; i < 2 * n; ++i)
+      nb[NB_TOP(n) + i] = nb[NB_TOP(n) + n - 1];
+  }
+  nb[NB_TOP(n) + 2 * n    ] = nb[NB_TOP(n) + 2 * n - 1];
+  nb[NB_TOP(n) + 2 * n + 1] = nb[NB_TOP(n) + 2 * n - 1];
+
+  if (*block_available_left)
+  {
+    imgpel *img_pred = img + pix_a.pos_y * stride + pix_a.pos_x;
+    for (i = 0; i < n; ++i, img_pred += stride)
+      nb[NB_CORNER(n) - 1 - i] = *img_pred;
+  }
+  else
+  {
+    for (i = 0; i < n; ++i)
+      nb[NB_LEFT + i] = dc_pred_value;
+  }
+  nb[0] = nb[NB_LEFT];
+
+  nb[NB_CORNER(n)] = (*block_available_up_left) ? img[pix_d.pos_y * stride + pix_d.pos_x] : dc_pred_value;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Prepares a neighbour vector for pred_dc: if only one of the left
+ *    and above neighbours is available it is copied over the other, so
+ *    that the sum over both gives the mean of the available one.
+ ************************************************************************
+ */
+void set_dc_neighbours(imgpel *nb, int n, int block_available_left, int block_available_up)
+{
+  if (block_available_up && !block_available_left)
+    memcpy(&nb[NB_LEFT], &nb[NB_TOP(n)], n * sizeof(imgpel));
+  else if (block_available_left && !block_available_up)
+    memcpy(&nb[NB_TOP(n)], &nb[NB_LEFT], n * sizeof(imgpel));
+}
+
+//! 2 tap average of p[0] and p[1]
+static inline int avg2(const imgpel *p)
+{
+  return (p[0] + p[1] + 1) >> 1;
+}
+
+//! 3 tap filter centered on p[0]
+static inline int avg3(const imgpel *p)
+{
+  return (p[-1] + (p[0] << 1) + p[1] + 2) >> 2;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Directional and DC prediction of an n x n block from its neighbour
+ *    vector, written after the equations of the standard. x and y are the
+ *    sample position in the block; the left column, above row and above
+ *    left corner of the standard map to nb[C - 1 - y], nb[C + 1 + x] and
+ *    nb[C] with C = NB_CORNER(n).
+ ************************************************************************
+ */
+static void pred_vert(imgpel **mb_pred, int ioff, int joff, const imgpel *nb, int n)
+{
+  int j;
+
+  for (j = joff; j < joff + n; ++j)
+    memcpy(&mb_pred[j][ioff], &nb[NB_TOP(n)], n * sizeof(imgpel));
+}
+
+static void pred_hor(imgpel **mb_pred, int ioff, int joff, const imgpel *nb, int n)
+{
+  int i, j;
+
+  for (j = 0; j < n; ++j)
+  {
+    imgpel *prd = &mb_pred[joff + j][ioff];
+    imgpel val = nb[NB_CORNER(n) - 1 - j];
+
+    for (i = 0; i < n; ++i)
+      prd[i] = val;
+  }
+}
+
+//! expects a vector prepared by set_dc_neighbours()
+static void pred_dc(imgpel **mb_pred, int ioff, int joff, const imgpel *nb, int n)
+{
+  int i, j;
+  int s0 = n;
+  imgpel val;
+
+  for (i = 0; i < n; ++i)
+    s0 += nb[NB_LEFT + i] + nb[NB_TOP(n) + i];
+  val = (imgpel) (s0 >> (n == BLOCK_SIZE ? 3 : 4));
+
+  for (j = joff; j < joff + n; ++j)
+  {
+    imgpel *prd = &mb_pred[j][ioff];
+    for (i = 0; i < n; ++i)
+      prd[i] = val;
+  }
+}
+
+static void pred_diag_down_left(imgpel **mb_pred, int ioff, int joff, const imgpel *nb, int n)
+{
+  int i, j;
+
+  for (j = 0; j < n; ++j)
+  {
+    imgpel *prd = &mb_pred[joff + j][ioff];
+    for (i = 0; i < n; ++i)
+      prd[i] = (imgpel) avg3(&nb[NB_TOP(n) + 1 + i + j]);
+  }
+}
+
+static void pred_diag_down_right(imgpel **mb_pred, int ioff, int joff, const imgpel *nb, int n)
+{
+  int i, j;
+
+  for (j = 0; j < n; ++j)
+  {
+    imgpel *prd = &mb_pred[joff + j][ioff];
+    for (i = 0; i < n; ++i)
+      prd[i] = (imgpel) avg3(&nb[NB_CORNER(n) + i - j]);
+  }
+}
+
+static void pred_vert_right(imgpel **mb_pred, int ioff, int joff, const imgpel *nb, int n)
+{
+  int i, j;
+
+  for (j = 0; j < n; ++j)
+  {
+    imgpel *prd = &mb_pred[joff + j][ioff];
+    for (i = 0; i < n; ++i)
+    {
+      int zVR = 2 * i - j;
+
+      if (zVR >= 0)
+        prd[i] = (imgpel) ((zVR & 0x01) ? avg3(&nb[NB_CORNER(n) + i - (j >> 1)]) : avg2(&nb[NB_CORNER(n) + i - (j >> 1)]));
+      else
+        prd[i] = (imgpel) avg3(&nb[NB_CORNER(n) + 1 + zVR]);
+    }
+  }
+}
+
+static void pred_hor_down(imgpel **mb_pred, int ioff, int joff, const imgpel *nb, int n)
+{
+  int i, j;
+
+  for (j = 0; j < n; ++j)
+  {
+    imgpel *prd = &mb_pred[joff + j][ioff];
+    for (i = 0; i < n; ++i)
+    {
+      int zHD = 2 * j - i;
+
+      if (zHD >= 0)
+        prd[i] = (imgpel) ((zHD & 0x01) ? avg3(&nb[NB_CORNER(n) - j + (i >> 1)]) : avg2(&nb[NB_CORNER(n) - 1 - j + (i >> 1)]));
+      else
+        prd[i] = (imgpel) avg3(&nb[NB_CORNER(n) - 1 - zHD]);
+    }
+  }
+}
+
+static void pred_vert_left(imgpel **mb_pred, int ioff, int joff, const imgpel *nb, int n)
+{
+  int i, j;
+
+  for (j = 0; j < n; ++j)
+  {
+    imgpel *prd = &mb_pred[joff + j][ioff];
+    for (i = 0; i < n; ++i)
+      prd[i] = (imgpel) ((j & 0x01) ? avg3(&nb[NB_TOP(n) + 1 + i + (j >> 1)]) : avg2(&nb[NB_TOP(n) + i + (j >> 1)]));
+  }
+}
+
+static void pred_hor_up(imgpel **mb_pred, int ioff, int joff, const imgpel *nb, int n)
+{
+  int i, j;
+
+  for (j = 0; j < n; ++j)
+  {
+    imgpel *prd = &mb_pred[joff + j][ioff];
+    for (i = 0; i < n; ++i)
+    {
+      int zHU = i + 2 * j;
+
+      if (zHU > 2 * n - 3)
+        prd[i] = nb[NB_LEFT];
+      else
+        prd[i] = (imgpel) ((zHU & 0x01) ? avg3(&nb[NB_CORNER(n) - 2 - j - (i >> 1)]) : avg2(&nb[NB_CORNER(n) - 2 - j - (i >> 1)]));
+    }
+  }
+}
+
+#define BLOCK_PRED_KERNELS(name) \
+static void name##_4x4(imgpel **mb_pred, int ioff, int joff, const imgpel *nb) { name(mb_pred, ioff, joff, nb, BLOCK_SIZE); } \
+static void name##_8x8(imgpel **mb_pred, int ioff, int joff, const imgpel *nb) { name(mb_pred, ioff, joff, nb, BLOCK_SIZE_8x8); }
+
+BLOCK_PRED_KERNELS(pred_vert)
+BLOCK_PRED_KERNELS(pred_hor)
+BLOCK_PRED_KERNELS(pred_dc)
+BLOCK_PRED_KERNELS(pred_diag_down_left)
+BLOCK_PRED_KERNELS(pred_diag_down_right)
+BLOCK_PRED_KERNELS(pred_vert_right)
+BLOCK_PRED_KERNELS(pred_hor_down)
+BLOCK_PRED_KERNELS(pred_vert_left)
+BLOCK_PRED_KERNELS(pred_hor_up)
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Reference sample filtering for intra 8x8 prediction (8.3.2.2.1).
+ *    Unavailable parts of the vector are left as they are.
+ ************************************************************************
+ */
+static void lowpass_8x8(imgpel *nb, int block_up_left, int block_up, int block_left)
+{
+  const int C = NB_CORNER(BLOCK_SIZE_8x8);
+  const int T = NB_TOP(BLOCK_SIZE_8x8);
+  imgpel LoopArray[NB_SIZE];
+  int i;
+
+  memcpy(LoopArray, nb, NB_USED(BLOCK_SIZE_8x8) * sizeof(imgpel));
+
+  if (block_up_left)
+  {
+    if (block_up && block_left)
+      LoopArray[C] = (imgpel) avg3(&nb[C]);
+    else if (block_up)
+      LoopArray[C] = (imgpel) ((3 * nb[C] + nb[T] + 2) >> 2);
+    else if (block_left)
+      LoopArray[C] = (imgpel) ((3 * nb[C] + nb[C - 1] + 2) >> 2);
+  }
+
+  if (block_up)
+  {
+    LoopArray[T] = (imgpel) (block_up_left ? avg3(&nb[T]) : (3 * nb[T] + nb[T + 1] + 2) >> 2);
+    // the padding after the above right row repeats its last sample
+    for (i = T + 1; i < T + 2 * BLOCK_SIZE_8x8; ++i)
+      LoopArray[i] = (imgpel) avg3(&nb[i]);
+    for (; i < NB_USED(BLOCK_SIZE_8x8); ++i)
+      LoopArray[i] = LoopArray[T + 2 * BLOCK_SIZE_8x8 - 1];
+  }
+
+  if (block_left)
+  {
+    LoopArray[C - 1] = (imgpel) (block_up_left ? avg3(&nb[C - 1]) : (3 * nb[C - 1] + nb[C - 2] + 2) >> 2);
+    for (i = NB_LEFT; i < C - 1; ++i)
+      LoopArray[i] = (imgpel) avg3(&nb[i]);
+    LoopArray[0] = LoopArray[NB_LEFT];
+  }
+
+  memcpy(nb, LoopArray, NB_USED(BLOCK_SIZE_8x8) * sizeof(imgpel));
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Plane prediction for 16x16 luma and all chroma block sizes
+ ************************************************************************
+ */
+static void plane_pred(imgpel **mb_pred, int width, int height, int iaa, int ib, int ic, int max_imgpel_value)
+{
+  int i, j;
+  int xc = (width  >> 1) - 1;
+  int yc = (height >> 1) - 1;
+
+  for (j = 0; j < height; ++j)
+  {
+    int ibb = iaa + (j - yc) * ic + 16 - xc * ib;
+    imgpel *prd = mb_pred[j];
+
+    for (i = 0; i < width; ++i)
+      prd[i] = (imgpel) iClip1(max_imgpel_value, (ibb + i * ib) >> 5);
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Fills kernels with the intra prediction kernels. The C versions
+ *    are the reference; SIMD versions replace them up to the given
+ *    SimdLevel.
+ ************************************************************************
+ */
+void set_intra_kernels(IntraKernels *kernels, int simd_level)
+{
+  IntraBlockPredFunc pred_4x4[9] = { pred_vert_4x4, pred_hor_4x4, pred_dc_4x4, pred_diag_down_left_4x4, pred_diag_down_right_4x4,
+                                     pred_vert_right_4x4, pred_hor_down_4x4, pred_vert_left_4x4, pred_hor_up_4x4 };
+  IntraBlockPredFunc pred_8x8[9] = { pred_vert_8x8, pred_hor_8x8, pred_dc_8x8, pred_diag_down_left_8x8, pred_diag_down_right_8x8,
+                                     pred_vert_right_8x8, pred_hor_down_8x8, pred_vert_left_8x8, pred_hor_up_8x8 };
+
+  memcpy(kernels->pred_4x4, pred_4x4, sizeof(pred_4x4));
+  memcpy(kernels->pred_8x8, pred_8x8, sizeof(pred_8x8));
+  kernels->lowpass_8x8 = lowpass_8x8;
+  kernels->plane       = plane_pred;
+
+  if (simd_level >= SIMD_SSE41)
+    init_intra_kernels_sse41(kernels);
+  if (simd_level >= SIMD_AVX2)
+    init_intra_kernels_avx2(kernels);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Selects the intra prediction kernels used by the decoder
+ ************************************************************************
+ */
+void init_intra_kernels(int simd_level)
+{
+  set_intra_kernels(&intra_kernels, simd_level);
+}
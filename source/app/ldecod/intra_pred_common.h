@@ -0,0 +1,91 @@
+
+/*!
+ *************************************************************************************
+ * \file intra_pred_common.h
+ *
+ * \brief
+ *    Prediction kernels shared by the intra 4x4, 8x8, 16x16 and chroma modes
+ *
+ *************************************************************************************
+ */
+
+#ifndef _INTRA_PRED_COMMON_H_
+#define _INTRA_PRED_COMMON_H_
+
+#include "global.h"
+#include "cpu_features.h"
+
+// Neighbour sample vector of an n x n block (n = 4 or 8). The left column is
+// stored bottom-up, followed by the above left corner and the above and above
+// right row, so that every directional mode reads contiguous runs of it:
+//
+//   nb[0]                 copy of the bottom left sample
+//   nb[1 .. n]            left column, bottom to top
+//   nb[n + 1]             above left corner
+//   nb[n + 2 .. 3n + 1]   above and above right row
+//   nb[3n + 2], nb[3n + 3] copies of the last above right sample
+//
+// Unavailable neighbours are substituted as in the standard before the
+// kernels are called.
+#define NB_LEFT          1              //!< index of the bottom left sample
+#define NB_CORNER(n)     ((n) + 1)      //!< index of the above left sample
+#define NB_TOP(n)        ((n) + 2)      //!< index of the first above sample
+#define NB_USED(n)       (3 * (n) + 4)  //!< number of valid entries
+#define NB_SIZE          32             //!< array length, NB_USED(8) rounded up
+
+//! Predicts one 4x4 or 8x8 block at (ioff, joff) of mb_pred from a neighbour vector
+typedef void (*IntraBlockPredFunc)(imgpel **mb_pred, int ioff, int joff, const imgpel *nb);
+//! Reference sample filtering of an 8x8 neighbour vector
+typedef void (*IntraLowPassFunc)  (imgpel *nb, int block_up_left, int block_up, int block_left);
+//! Plane prediction of a width x height block: Clip1((iaa + (x - xc) * ib + (y - yc) * ic + 16) >> 5)
+//! with xc = width / 2 - 1 and yc = height / 2 - 1
+typedef void (*IntraPlanePredFunc)(imgpel **mb_pred, int width, int height, int iaa, int ib, int ic, int max_imgpel_value);
+
+typedef struct intra_kernels
+{
+  IntraBlockPredFunc pred_4x4[9];   //!< indexed by the intra 4x4 prediction mode
+  IntraBlockPredFunc pred_8x8[9];   //!< indexed by the intra 8x8 prediction mode
+  IntraLowPassFunc   lowpass_8x8;
+  IntraPlanePredFunc plane;         //!< 16x16 luma and chroma plane prediction
+} IntraKernels;
+
+extern IntraKernels intra_kernels;
+extern const char  *intra_block_mode_name[9];
+
+/*!
+ ***********************************************************************
+ * \brief
+ *    returns whether the neighbours a 4x4 or 8x8 prediction mode
+ *    depends on are available
+ ***********************************************************************
+ */
+static inline int intra_block_mode_available(byte predmode, int block_available_left, int block_available_up, int block_available_up_left)
+{
+  switch (predmode)
+  {
+  case VERT_PRED:
+  case DIAG_DOWN_LEFT_PRED:
+  case VERT_LEFT_PRED:
+    return block_available_up;
+  case HOR_PRED:
+  case HOR_UP_PRED:
+    return block_available_left;
+  case DIAG_DOWN_RIGHT_PRED:
+  case VERT_RIGHT_PRED:
+  case HOR_DOWN_PRED:
+    return block_available_up && block_available_left && block_available_up_left;
+  default:
+    return 1;
+  }
+}
+
+extern void get_block_neighbours(Macroblock *currMB, ColorPlane pl, int ioff, int joff, int n, imgpel *nb,
+                                 int *block_available_left, int *block_available_up, int *block_available_up_left);
+extern void set_dc_neighbours   (imgpel *nb, int n, int block_available_left, int block_available_up);
+
+extern void init_intra_kernels      (int simd_level);
+extern void set_intra_kernels       (IntraKernels *kernels, int simd_level);
+extern void init_intra_kernels_sse41(IntraKernels *kernels);
+extern void init_intra_kernels_avx2 (IntraKernels *kernels);
+
+#endif
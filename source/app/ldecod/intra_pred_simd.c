@@ -0,0 +1,370 @@
+
+/*!
+ *************************************************************************************
+ * \file intra_pred_simd.c
+ *
+ * \brief
+ *    SSE4.1 and AVX2 versions of the intra prediction kernels of intra_pred_common.c
+ *
+ *    The directional 4x4 and 8x8 modes first filter the whole neighbour vector
+ *    once (2 and 3 tap), after which every predicted row is one contiguous load
+ *    from the filtered vector or from an interleave of both filters. DC, vertical
+ *    and horizontal prediction stay with the C kernels. The 3 tap sums are kept in
+ *    16 bit lanes, which is exact for all bit depths up to 14 bit.
+ *
+ *************************************************************************************
+ */
+#include "global.h"
+#include "intra_pred_common.h"
+
+#if HAVE_X86_SIMD && (IMGTYPE == 1)
+
+#include <immintrin.h>
+
+static IntraKernels sse41_fallback;   //!< kernels replaced by init_intra_kernels_sse41()
+static IntraKernels avx2_fallback;    //!< kernels replaced by init_intra_kernels_avx2()
+
+//! leading entries of the filtered vectors, so that reversed loads of a 4x4 vector stay in bounds
+#define FILT_PAD  8
+
+static inline __m128i avg2_epu16(__m128i a, __m128i b)
+{
+  return _mm_avg_epu16(a, b);
+}
+
+static inline __m128i avg3_epu16(__m128i l, __m128i c, __m128i r)
+{
+  __m128i sum = _mm_add_epi16(_mm_add_epi16(l, r), _mm_slli_epi16(c, 1));
+  return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+}
+
+static inline void store_row(imgpel *dst, __m128i v, int n)
+{
+  if (n == BLOCK_SIZE)
+    _mm_storel_epi64((__m128i *) dst, v);
+  else
+    _mm_storeu_si128((__m128i *) dst, v);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Fills f2[k] = avg2 of nb[k], nb[k + 1] and f3[k] = avg3 centred on
+ *    nb[k] for the used part of the neighbour vector. Only nb[0 ..
+ *    NB_USED(n) - 1] is read.
+ ************************************************************************
+ */
+static inline void filter_neighbours(const imgpel *nb, int n, imgpel *f2, imgpel *f3)
+{
+  int last = NB_USED(n) - 2;   // last index of either vector that is needed
+  int k = 0;
+
+  for (;;)
+  {
+    __m128i l = _mm_loadu_si128((const __m128i *) &nb[k]);
+    __m128i c = _mm_loadu_si128((const __m128i *) &nb[k + 1]);
+    __m128i r = _mm_loadu_si128((const __m128i *) &nb[k + 2]);
+
+    _mm_storeu_si128((__m128i *) &f2[k    ], avg2_epu16(l, c));
+    _mm_storeu_si128((__m128i *) &f3[k + 1], avg3_epu16(l, c, r));
+    if (k + 8 >= last)
+      break;
+    k = imin(k + 8, last - 8);
+  }
+  f2[last] = (imgpel) ((nb[last] + nb[last + 1] + 1) >> 1);
+}
+
+static inline void pred_diag_down_left_sse41(imgpel **mb_pred, int ioff, int joff, const imgpel *nb, int n)
+{
+  ALIGNED(16) imgpel f2[FILT_PAD + NB_SIZE];
+  ALIGNED(16) imgpel f3[FILT_PAD + NB_SIZE];
+  const imgpel *t3 = &f3[FILT_PAD + NB_TOP(n) + 1];
+  int j;
+
+  filter_neighbours(nb, n, &f2[FILT_PAD], &f3[FILT_PAD]);
+  for (j = 0; j < n; ++j)
+    store_row(&mb_pred[joff + j][ioff], _mm_loadu_si128((const __m128i *) &t3[j]), n);
+}
+
+static inline void pred_diag_down_right_sse41(imgpel **mb_pred, int ioff, int joff, const imgpel *nb, int n)
+{
+  ALIGNED(16) imgpel f2[FILT_PAD + NB_SIZE];
+  ALIGNED(16) imgpel f3[FILT_PAD + NB_SIZE];
+  const imgpel *c3 = &f3[FILT_PAD + NB_CORNER(n)];
+  int j;
+
+  filter_neighbours(nb, n, &f2[FILT_PAD], &f3[FILT_PAD]);
+  for (j = 0; j < n; ++j)
+    store_row(&mb_pred[joff + j][ioff], _mm_loadu_si128((const __m128i *) &c3[-j]), n);
+}
+
+static inline void pred_vert_left_sse41(imgpel **mb_pred, int ioff, int joff, const imgpel *nb, int n)
+{
+  ALIGNED(16) imgpel f2[FILT_PAD + NB_SIZE];
+  ALIGNED(16) imgpel f3[FILT_PAD + NB_SIZE];
+  const imgpel *t2 = &f2[FILT_PAD + NB_TOP(n)];
+  const imgpel *t3 = &f3[FILT_PAD + NB_TOP(n) + 1];
+  int j;
+
+  filter_neighbours(nb, n, &f2[FILT_PAD], &f3[FILT_PAD]);
+  for (j = 0; j < n; j += 2)
+  {
+    store_row(&mb_pred[joff + j    ][ioff], _mm_loadu_si128((const __m128i *) &t2[j >> 1]), n);
+    store_row(&mb_pred[joff + j + 1][ioff], _mm_loadu_si128((const __m128i *) &t3[j >> 1]), n);
+  }
+}
+
+//! row j + 2 is row j moved one sample to the right, with the 3 tap value of the left column entering
+static inline void pred_vert_right_sse41(imgpel **mb_pred, int ioff, int joff, const imgpel *nb, int n)
+{
+  ALIGNED(16) imgpel f2[FILT_PAD + NB_SIZE];
+  ALIGNED(16) imgpel f3[FILT_PAD + NB_SIZE];
+  const imgpel *c3 = &f3[FILT_PAD + NB_CORNER(n)];
+  __m128i even, odd;
+  int j;
+
+  filter_neighbours(nb, n, &f2[FILT_PAD], &f3[FILT_PAD]);
+  even = _mm_loadu_si128((const __m128i *) &f2[FILT_PAD + NB_CORNER(n)]);
+  odd  = _mm_loadu_si128((const __m128i *) c3);
+  store_row(&mb_pred[joff    ][ioff], even, n);
+  store_row(&mb_pred[joff + 1][ioff], odd, n);
+
+  for (j = 2; j < n; j += 2)
+  {
+    even = _mm_insert_epi16(_mm_slli_si128(even, 2), c3[1 - j], 0);
+    odd  = _mm_insert_epi16(_mm_slli_si128(odd , 2), c3[   -j], 0);
+    store_row(&mb_pred[joff + j    ][ioff], even, n);
+    store_row(&mb_pred[joff + j + 1][ioff], odd, n);
+  }
+}
+
+//! the sample at (x, y) only depends on 2y - x; row y starts 2 entries before row y - 1
+static inline void pred_hor_down_sse41(imgpel **mb_pred, int ioff, int joff, const imgpel *nb, int n)
+{
+  ALIGNED(16) imgpel f2[FILT_PAD + NB_SIZE];
+  ALIGNED(16) imgpel f3[FILT_PAD + NB_SIZE];
+  ALIGNED(16) imgpel zhd[24];
+  __m128i l2, l3;
+  int j;
+
+  filter_neighbours(nb, n, &f2[FILT_PAD], &f3[FILT_PAD]);
+  l2 = _mm_loadu_si128((const __m128i *) &f2[FILT_PAD + NB_LEFT]);
+  l3 = _mm_loadu_si128((const __m128i *) &f3[FILT_PAD + NB_LEFT + 1]);
+  _mm_store_si128((__m128i *) &zhd[0], _mm_unpacklo_epi16(l2, l3));
+  _mm_store_si128((__m128i *) &zhd[8], _mm_unpackhi_epi16(l2, l3));
+  _mm_storeu_si128((__m128i *) &zhd[2 * n], _mm_loadu_si128((const __m128i *) &f3[FILT_PAD + NB_CORNER(n) + 1]));
+
+  for (j = 0; j < n; ++j)
+    store_row(&mb_pred[joff + j][ioff], _mm_loadu_si128((const __m128i *) &zhd[2 * (n - 1 - j)]), n);
+}
+
+//! the sample at (x, y) only depends on x + 2y; row y starts 2 entries after row y - 1
+static inline void pred_hor_up_sse41(imgpel **mb_pred, int ioff, int joff, const imgpel *nb, int n)
+{
+  ALIGNED(16) imgpel f2[FILT_PAD + NB_SIZE];
+  ALIGNED(16) imgpel f3[FILT_PAD + NB_SIZE];
+  ALIGNED(16) imgpel zhu[24];
+  const __m128i reverse = _mm_setr_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1);
+  __m128i l2, l3;
+  int j, z;
+
+  filter_neighbours(nb, n, &f2[FILT_PAD], &f3[FILT_PAD]);
+  // left column top down, so that lane m holds the values centred on nb[C - 2 - m]
+  l2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) &f2[FILT_PAD + n - 8]), reverse);
+  l3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) &f3[FILT_PAD + n - 8]), reverse);
+  _mm_store_si128((__m128i *) &zhu[0], _mm_unpacklo_epi16(l2, l3));
+  _mm_store_si128((__m128i *) &zhu[8], _mm_unpackhi_epi16(l2, l3));
+  for (z = 2 * n - 2; z < 3 * n - 2; ++z)
+    zhu[z] = nb[NB_LEFT];
+
+  for (j = 0; j < n; ++j)
+    store_row(&mb_pred[joff + j][ioff], _mm_loadu_si128((const __m128i *) &zhu[2 * j]), n);
+}
+
+#define BLOCK_PRED_KERNELS_SSE41(name) \
+static void name##_4x4_sse41(imgpel **mb_pred, int ioff, int joff, const imgpel *nb) { name##_sse41(mb_pred, ioff, joff, nb, BLOCK_SIZE); } \
+static void name##_8x8_sse41(imgpel **mb_pred, int ioff, int joff, const imgpel *nb) { name##_sse41(mb_pred, ioff, joff, nb, BLOCK_SIZE_8x8); }
+
+BLOCK_PRED_KERNELS_SSE41(pred_diag_down_left)
+BLOCK_PRED_KERNELS_SSE41(pred_diag_down_right)
+BLOCK_PRED_KERNELS_SSE41(pred_vert_right)
+BLOCK_PRED_KERNELS_SSE41(pred_hor_down)
+BLOCK_PRED_KERNELS_SSE41(pred_vert_left)
+BLOCK_PRED_KERNELS_SSE41(pred_hor_up)
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Reference sample filtering for intra 8x8 prediction; the interior
+ *    samples are the 3 tap vector, the ends are fixed up afterwards.
+ ************************************************************************
+ */
+static void lowpass_8x8_sse41(imgpel *nb, int block_up_left, int block_up, int block_left)
+{
+  const int C = NB_CORNER(BLOCK_SIZE_8x8);
+  const int T = NB_TOP(BLOCK_SIZE_8x8);
+  ALIGNED(16) imgpel f2[NB_SIZE];
+  ALIGNED(16) imgpel f3[NB_SIZE];
+  imgpel corner = nb[C];
+  imgpel top    = nb[T];
+  imgpel left   = nb[C - 1];
+
+  filter_neighbours(nb, BLOCK_SIZE_8x8, f2, f3);
+
+  if (block_up_left)
+  {
+    if (block_up && block_left)
+      corner = f3[C];
+    else if (block_up)
+      corner = (imgpel) ((3 * nb[C] + nb[T] + 2) >> 2);
+    else if (block_left)
+      corner = (imgpel) ((3 * nb[C] + nb[C - 1] + 2) >> 2);
+  }
+  if (block_up)
+    top  = block_up_left ? f3[T] : (imgpel) ((3 * nb[T] + nb[T + 1] + 2) >> 2);
+  if (block_left)
+    left = block_up_left ? f3[C - 1] : (imgpel) ((3 * nb[C - 1] + nb[C - 2] + 2) >> 2);
+
+  if (block_up)
+  {
+    _mm_storeu_si128((__m128i *) &nb[T + 1], _mm_loadu_si128((const __m128i *) &f3[T + 1]));
+    _mm_storeu_si128((__m128i *) &nb[T + 9], _mm_loadu_si128((const __m128i *) &f3[T + 9]));
+    // the padding after the above right row repeats its last sample
+    nb[T + 2 * BLOCK_SIZE_8x8] = nb[T + 2 * BLOCK_SIZE_8x8 + 1] = nb[T + 2 * BLOCK_SIZE_8x8 - 1];
+    nb[T] = top;
+  }
+  if (block_left)
+  {
+    _mm_storeu_si128((__m128i *) &nb[NB_LEFT], _mm_loadu_si128((const __m128i *) &f3[NB_LEFT]));
+    nb[0] = nb[NB_LEFT];
+    nb[C - 1] = left;
+  }
+  nb[C] = corner;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Plane prediction, eight samples per step in 32 bit lanes
+ ************************************************************************
+ */
+static void plane_pred_sse41(imgpel **mb_pred, int width, int height, int iaa, int ib, int ic, int max_imgpel_value)
+{
+  int xc = (width  >> 1) - 1;
+  int yc = (height >> 1) - 1;
+  __m128i max  = _mm_set1_epi16((short) max_imgpel_value);
+  __m128i ramp = _mm_mullo_epi32(_mm_set1_epi32(ib), _mm_setr_epi32(0, 1, 2, 3));
+  __m128i ib4  = _mm_set1_epi32(4 * ib);
+  int i, j;
+
+  if (width & 0x07)
+  {
+    sse41_fallback.plane(mb_pred, width, height, iaa, ib, ic, max_imgpel_value);
+    return;
+  }
+
+  for (j = 0; j < height; ++j)
+  {
+    imgpel *prd = mb_pred[j];
+    __m128i v = _mm_add_epi32(_mm_set1_epi32(iaa + (j - yc) * ic + 16 - xc * ib), ramp);
+
+    for (i = 0; i < width; i += 8)
+    {
+      __m128i lo = _mm_srai_epi32(v, 5);
+      __m128i hi = _mm_srai_epi32(_mm_add_epi32(v, ib4), 5);
+
+      _mm_storeu_si128((__m128i *) &prd[i], _mm_min_epu16(_mm_packus_epi32(lo, hi), max));
+      v = _mm_add_epi32(v, _mm_add_epi32(ib4, ib4));
+    }
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Plane prediction, eight samples per 256 bit step
+ ************************************************************************
+ */
+static TARGET_AVX2 void plane_pred_avx2(imgpel **mb_pred, int width, int height, int iaa, int ib, int ic, int max_imgpel_value)
+{
+  int xc = (width  >> 1) - 1;
+  int yc = (height >> 1) - 1;
+  __m128i max  = _mm_set1_epi16((short) max_imgpel_value);
+  __m256i ramp = _mm256_mullo_epi32(_mm256_set1_epi32(ib), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+  __m256i ib8  = _mm256_set1_epi32(8 * ib);
+  int i, j;
+
+  if (width & 0x07)
+  {
+    avx2_fallback.plane(mb_pred, width, height, iaa, ib, ic, max_imgpel_value);
+    return;
+  }
+
+  for (j = 0; j < height; ++j)
+  {
+    imgpel *prd = mb_pred[j];
+    __m256i v = _mm256_add_epi32(_mm256_set1_epi32(iaa + (j - yc) * ic + 16 - xc * ib), ramp);
+
+    for (i = 0; i < width; i += 8)
+    {
+      __m256i s = _mm256_srai_epi32(v, 5);
+      __m128i p = _mm_packus_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+
+      _mm_storeu_si128((__m128i *) &prd[i], _mm_min_epu16(p, max));
+      v = _mm256_add_epi32(v, ib8);
+    }
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Installs the SSE4.1 intra prediction kernels
+ ************************************************************************
+ */
+void init_intra_kernels_sse41(IntraKernels *kernels)
+{
+  sse41_fallback = *kernels;
+
+  kernels->pred_4x4[DIAG_DOWN_LEFT_PRED ] = pred_diag_down_left_4x4_sse41;
+  kernels->pred_4x4[DIAG_DOWN_RIGHT_PRED] = pred_diag_down_right_4x4_sse41;
+  kernels->pred_4x4[VERT_RIGHT_PRED     ] = pred_vert_right_4x4_sse41;
+  kernels->pred_4x4[HOR_DOWN_PRED       ] = pred_hor_down_4x4_sse41;
+  kernels->pred_4x4[VERT_LEFT_PRED      ] = pred_vert_left_4x4_sse41;
+  kernels->pred_4x4[HOR_UP_PRED         ] = pred_hor_up_4x4_sse41;
+
+  kernels->pred_8x8[DIAG_DOWN_LEFT_PRED ] = pred_diag_down_left_8x8_sse41;
+  kernels->pred_8x8[DIAG_DOWN_RIGHT_PRED] = pred_diag_down_right_8x8_sse41;
+  kernels->pred_8x8[VERT_RIGHT_PRED     ] = pred_vert_right_8x8_sse41;
+  kernels->pred_8x8[HOR_DOWN_PRED       ] = pred_hor_down_8x8_sse41;
+  kernels->pred_8x8[VERT_LEFT_PRED      ] = pred_vert_left_8x8_sse41;
+  kernels->pred_8x8[HOR_UP_PRED         ] = pred_hor_up_8x8_sse41;
+
+  kernels->lowpass_8x8 = lowpass_8x8_sse41;
+  kernels->plane       = plane_pred_sse41;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Installs the AVX2 kernels on top of the SSE4.1 ones
+ ************************************************************************
+ */
+void init_intra_kernels_avx2(IntraKernels *kernels)
+{
+  avx2_fallback = *kernels;
+
+  kernels->plane = plane_pred_avx2;
+}
+
+#else
+
+void init_intra_kernels_sse41(IntraKernels *kernels)
+{
+}
+
+void init_intra_kernels_avx2(IntraKernels *kernels)
+{
+}
+
+#endif
@@ -56,6 +56,7 @@
 #include "fmo.h"
 #include "output.h"
 #include "cabac.h"
+#include "context_ini.h"
 #include "parset.h"
 #include "sei.h"
 #include "erc_api.h"
@@ -64,15 +65,25 @@
 #include "nalu.h"
 #include "img_io.h"
 #include "loopfilter.h"
+#include "intra_pred_common.h"
 #include "rtp.h"
 #include "input.h"
 #include "output.h"
 #include "h264decoder.h"
 #include "dec_statistics.h"
+#include "thread_pool.h"
+#include "mb_wavefront.h"
+#include "frame_pipeline.h"
+#include "yuv_writer.h"
+#include "frame_hash.h"
+#include "se_trace.h"
+#include "mb_meta.h"
+#include "Data_Extractor.h"
 
 #define LOGFILE     "log.dec"
 #define DATADECFILE "dataDec.txt"
 #define TRACEFILE   "trace_dec.txt"
+#define SETRACEFILE "trace_dec.bin"
 
 // Decoder definition. This should be the only global variable in the entire
 // software. Global variables should be avoided.
@@ -227,6 +238,25 @@ static void free_img( VideoParameters *p_Vid)
     {
       free_annex_b (&p_Vid->annex_b);
     }
+    if (p_Vid->thread_pool != NULL)
+    {
+      free_thread_pool(p_Vid->thread_pool);
+      p_Vid->thread_pool = NULL;
+    }
+    free_mb_wavefront(p_Vid->mb_wavefront);
+    p_Vid->mb_wavefront = NULL;
+    free_frame_pipeline(p_Vid->frame_pipeline);
+    p_Vid->frame_pipeline = NULL;
+    free_deblock_wavefront(p_Vid->deblock_wavefront);
+    p_Vid->deblock_wavefront = NULL;
+    free_yuv_writer(p_Vid->yuv_writer);
+    p_Vid->yuv_writer = NULL;
+    free_frame_hash(p_Vid->frame_hash);
+    p_Vid->frame_hash = NULL;
+    close_se_trace(p_Vid->se_trace);
+    p_Vid->se_trace = NULL;
+    close_mb_meta(p_Vid->mb_meta);
+    p_Vid->mb_meta = NULL;
 #if (ENABLE_OUTPUT_TONEMAPPING)  
     if (p_Vid->seiToneMapping != NULL)
     {
@@ -291,6 +321,9 @@ static void free_img( VideoParameters *p_Vid)
       p_Vid->pNextPPS = NULL;
     }
 
+    free_context_cache(p_Vid);
+    free_picture_pool(p_Vid);
+
     // clear decoder statistics
 #if ENABLE_DEC_STATS
     delete_dec_stats(p_Vid->dec_stats);
@@ -309,7 +342,10 @@ void FreeDecPicList(DecodedPicList *pDecPicList)
     DecodedPicList *pPicNext = pDecPicList->pNext;
     if(pDecPicList->pY)
     {
-      free(pDecPicList->pY);
+      MemTag prev_tag = mem_set_tag(MEM_OUTPUT);
+
+      mem_free(pDecPicList->pY);
+      mem_set_tag(prev_tag);
       pDecPicList->pY = NULL;
       pDecPicList->pU = NULL;
       pDecPicList->pV = NULL;
@@ -329,6 +365,7 @@ static void init(VideoParameters *p_Vid)  //!< video parameters
 {
   //int i;
   InputParameters *p_Inp = p_Vid->p_Inp;
+  int simd_level = imin(p_Inp->simd_level, get_cpu_simd_level());
   p_Vid->oldFrameSizeInMbs = (unsigned int) -1;
 
   p_Vid->imgY_ref  = NULL;
@@ -386,16 +423,31 @@ static void init(VideoParameters *p_Vid)  //!< video parameters
   p_Vid->newframe = 0;
   p_Vid->previous_frame_num = 0;
 
-  p_Vid->iLumaPadX = MCBUF_LUMA_PAD_X;
-  p_Vid->iLumaPadY = MCBUF_LUMA_PAD_Y;
-  p_Vid->iChromaPadX = MCBUF_CHROMA_PAD_X;
-  p_Vid->iChromaPadY = MCBUF_CHROMA_PAD_Y;
+  // motion compensation extends the reference borders itself, pictures are not padded
+  p_Vid->iLumaPadX = 0;
+  p_Vid->iLumaPadY = 0;
+  p_Vid->iChromaPadX = 0;
+  p_Vid->iChromaPadY = 0;
 
   p_Vid->iPostProcess = 0;
   p_Vid->bDeblockEnable = 0x3;
   p_Vid->last_dec_view_id = -1;
   p_Vid->last_dec_layer_id = -1;
 
+  init_mc_kernels     (simd_level);
+  init_itrans_kernels (simd_level);
+  init_deblock_kernels(simd_level);
+  init_intra_kernels  (simd_level);
+  init_output_kernels (simd_level);
+
+  p_Vid->thread_pool = (p_Inp->num_threads > 1) ? create_thread_pool(p_Inp->num_threads) : NULL;
+  p_Vid->frame_pipeline = (p_Inp->num_threads > 1) ? create_frame_pipeline() : NULL;
+  p_Vid->frame_hash = (p_Inp->hash_type != HASH_NONE) ? create_frame_hash(p_Inp->hash_type) : NULL;
+  p_Vid->yuv_writer = (p_Inp->output_buffers > 0 && p_Vid->frame_hash == NULL) ? create_yuv_writer(p_Inp->output_buffers, p_Inp->output_direct) : NULL;
+  p_Vid->se_trace = (p_Inp->se_trace_mode == SE_TRACE_BIN) ? open_se_trace(p_Inp->se_trace_file[0] != '\0' ? p_Inp->se_trace_file : SETRACEFILE) : NULL;
+  p_Vid->mb_meta  = (p_Inp->mb_meta_file[0] != '\0') ? open_mb_meta(p_Inp->mb_meta_file) : NULL;
+  parse_sei_types(p_Vid->sei_types, p_Inp->sei_types);
+
 #if ENABLE_DEC_STATS
   if ((p_Vid->dec_stats = (DecStatParameters *) malloc (sizeof (DecStatParameters)))== NULL)
     no_mem_exit ("init: p_Vid->dec_stats");
@@ -469,6 +521,31 @@ void init_frext(VideoParameters *p_Vid)  //!< video parameters
   p_Vid->mb_size_shift[1][1] = p_Vid->mb_size_shift[2][1] = CeilLog2_sf (p_Vid->mb_size[1][1]);
 }
 
+/*!
+ ************************************************************************
+ * \brief
+ *    Reports the memory usage once the decoder is torn down, so that
+ *    the current bytes of a tag are the ones never freed
+ ************************************************************************
+ */
+static void report_memory(InputParameters *p_Inp)
+{
+  FILE *p_log;
+
+  if (p_Inp->mem_stats_file[0] != '\0')
+  {
+    if ((p_log = fopen(p_Inp->mem_stats_file, "w")) == NULL)
+    {
+      snprintf(errortext, ET_SIZE, "Error open file %s for writing the memory usage", p_Inp->mem_stats_file);
+      error(errortext, 500);
+    }
+    write_mem_usage_json(p_log);
+    fclose(p_log);
+  }
+
+  report_mem_usage(stdout);
+}
+
 /*!
  ************************************************************************
  * \brief
@@ -643,6 +720,9 @@ static void Report(VideoParameters *p_Vid)
  *    Allocates a stand-alone partition structure.  Structure should
  *    be freed by FreePartition();
  *    data structures
+ *    Only the first partition gets a stream buffer, the buffers of the
+ *    others are allocated by AllocPartitionBuffers() when the first data
+ *    partitioned slice is read.
  *
  * \par Input:
  *    n: number of partitions in the array
@@ -656,32 +736,37 @@ DataPartition *AllocPartition(int n)
   DataPartition *partArr, *dataPart;
   int i;
 
-  partArr = (DataPartition *) calloc(n, sizeof(DataPartition));
-  if (partArr == NULL)
-  {
-    snprintf(errortext, ET_SIZE, "AllocPartition: Memory allocation for Data Partition failed");
-    error(errortext, 100);
-  }
+  partArr = (DataPartition *) mem_calloc(n, sizeof(DataPartition));
 
   for (i = 0; i < n; ++i) // loop over all data partitions
   {
     dataPart = &(partArr[i]);
-    dataPart->bitstream = (Bitstream *) calloc(1, sizeof(Bitstream));
-    if (dataPart->bitstream == NULL)
-    {
-      snprintf(errortext, ET_SIZE, "AllocPartition: Memory allocation for Bitstream failed");
-      error(errortext, 100);
-    }
-    dataPart->bitstream->streamBuffer = (byte *) calloc(MAX_CODED_FRAME_SIZE, sizeof(byte));
-    if (dataPart->bitstream->streamBuffer == NULL)
-    {
-      snprintf(errortext, ET_SIZE, "AllocPartition: Memory allocation for streamBuffer failed");
-      error(errortext, 100);
-    }
+    dataPart->bitstream = (Bitstream *) mem_calloc(1, sizeof(Bitstream));
   }
+  partArr[0].bitstream->streamBuffer = (byte *) mem_calloc(MAX_CODED_FRAME_SIZE, sizeof(byte));
   return partArr;
 }
 
+/*!
+ ************************************************************************
+ * \brief
+ *    Allocates the stream buffers of the first n partitions of a slice
+ *    that do not have one yet.
+ ************************************************************************
+ */
+void AllocPartitionBuffers(DataPartition *partArr, int n)
+{
+  MemTag prev_tag = mem_set_tag(MEM_SLICE);
+  int i;
+
+  for (i = 0; i < n; ++i)
+  {
+    if (partArr[i].bitstream->streamBuffer == NULL)
+      partArr[i].bitstream->streamBuffer = (byte *) mem_calloc(MAX_CODED_FRAME_SIZE, sizeof(byte));
+  }
+  mem_set_tag(prev_tag);
+}
+
 
 
 
@@ -709,10 +794,10 @@ void FreePartition (DataPartition *dp, int n)
   assert (dp->bitstream->streamBuffer != NULL);
   for (i=0; i<n; ++i)
   {
-    free (dp[i].bitstream->streamBuffer);
-    free (dp[i].bitstream);
+    mem_free (dp[i].bitstream->streamBuffer);
+    mem_free (dp[i].bitstream);
   }
-  free (dp);
+  mem_free (dp);
 }
 
 
@@ -729,20 +814,18 @@ void FreePartition (DataPartition *dp, int n)
 Slice *malloc_slice(InputParameters *p_Inp, VideoParameters *p_Vid)
 {
   int i, j, memory_size = 0;
+  MemTag prev_tag = mem_set_tag(MEM_SLICE);
   Slice *currSlice;
 
-  currSlice = (Slice *) calloc(1, sizeof(Slice));
-  if ( currSlice  == NULL)
-  {
-    snprintf(errortext, ET_SIZE, "Memory allocation for Slice datastruct in NAL-mode %d failed", p_Inp->FileFormat);
-    error(errortext,100);
-  }
+  currSlice = (Slice *) mem_calloc(1, sizeof(Slice));
 
   // create all context models
+  mem_set_tag(MEM_CABAC);
   currSlice->mot_ctx = create_contexts_MotionInfo();
   currSlice->tex_ctx = create_contexts_TextureInfo();
+  mem_set_tag(MEM_SLICE);
 
-  currSlice->max_part_nr = 3;  //! assume data partitioning (worst case) for the following mallocs()
+  currSlice->max_part_nr = 3;  //! the buffers of partitions B and C are allocated with the first partition A
   currSlice->partArr = AllocPartition(currSlice->max_part_nr);
 
   memory_size += get_mem2Dwp (&(currSlice->wp_params), 2, MAX_REFERENCE_PICTURES);
@@ -769,9 +852,7 @@ Slice *malloc_slice(InputParameters *p_Inp, VideoParameters *p_Vid)
   }
   for (i = 0; i < 6; i++)
   {
-    currSlice->listX[i] = calloc(MAX_LIST_SIZE, sizeof (StorablePicture*)); // +1 for reordering
-    if (NULL==currSlice->listX[i])
-      no_mem_exit("malloc_slice: currSlice->listX[i]");
+    currSlice->listX[i] = mem_calloc(MAX_LIST_SIZE, sizeof (StorablePicture*)); // +1 for reordering
   }
   for (j = 0; j < 6; j++)
   {
@@ -781,6 +862,7 @@ Slice *malloc_slice(InputParameters *p_Inp, VideoParameters *p_Vid)
     }
     currSlice->listXsize[j]=0;
   }
+  mem_set_tag(prev_tag);
 
   return currSlice;
 }
@@ -798,11 +880,14 @@ Slice *malloc_slice(InputParameters *p_Inp, VideoParameters *p_Vid)
  */
 static void free_slice(Slice *currSlice)
 {
+  MemTag prev_tag = mem_set_tag(MEM_SLICE);
   int i;
 
   if (currSlice->slice_type != I_SLICE && currSlice->slice_type != SI_SLICE)
   free_ref_pic_list_reordering_buffer(currSlice);
   free_pred_mem(currSlice);
+  FreeExtractLog(&currSlice->md_log);
+  free_se_trace_buffer(currSlice->se_trace_buf);
   free_mem3Dint(currSlice->cof    );
   free_mem3Dint(currSlice->mb_rres);
   free_mem3Dpel(currSlice->mb_rec );
@@ -818,15 +903,17 @@ static void free_slice(Slice *currSlice)
   //if (1)
   {
     // delete all context models
+    mem_set_tag(MEM_CABAC);
     delete_contexts_MotionInfo (currSlice->mot_ctx);
     delete_contexts_TextureInfo(currSlice->tex_ctx);
+    mem_set_tag(MEM_SLICE);
   }
 
   for (i=0; i<6; i++)
   {
     if (currSlice->listX[i])
     {
-      free (currSlice->listX[i]);
+      mem_free (currSlice->listX[i]);
       currSlice->listX[i] = NULL;
     }
   }
@@ -837,8 +924,9 @@ static void free_slice(Slice *currSlice)
     free (tmp_drpm);
   }
 
-  free(currSlice);
+  mem_free(currSlice);
   currSlice = NULL;
+  mem_set_tag(prev_tag);
 }
 
 /*!
@@ -867,14 +955,21 @@ int init_global_buffers(VideoParameters *p_Vid, int layer_id)
     free_layer_buffers(p_Vid, layer_id);
   }
 
-  // allocate memory for reference frame in find_snr
-  memory_size += get_mem2Dpel(&cps->imgY_ref, cps->height, cps->width);
-  if (cps->yuv_format != YUV400)
+  // allocate memory for reference frame in find_snr, which is only
+  // called with a reference file and without -s
+  if (p_Vid->p_ref != -1 && !p_Vid->p_Inp->silent)
   {
-    memory_size += get_mem3Dpel(&cps->imgUV_ref, 2, cps->height_cr, cps->width_cr);
+    memory_size += get_mem2Dpel(&cps->imgY_ref, cps->height, cps->width);
+    if (cps->yuv_format != YUV400)
+      memory_size += get_mem3Dpel(&cps->imgUV_ref, 2, cps->height_cr, cps->width_cr);
+    else
+      cps->imgUV_ref = NULL;
   }
   else
+  {
+    cps->imgY_ref  = NULL;
     cps->imgUV_ref = NULL;
+  }
 
   // allocate memory in structure p_Vid
   if( (cps->separate_colour_plane_flag != 0) )
@@ -930,7 +1025,16 @@ int init_global_buffers(VideoParameters *p_Vid, int layer_id)
    memory_size += get_mem2D(&(cps->ipredmode), 4*cps->FrameHeightInMbs, 4*cps->PicWidthInMbs);
 
   // CAVLC mem
-  memory_size += get_mem4D(&(cps->nz_coeff), cps->FrameSizeInMbs, 3, BLOCK_SIZE, BLOCK_SIZE);
+  if( (cps->separate_colour_plane_flag != 0) )
+  {
+    // the colour planes are parsed independently and need their own contexts
+    memory_size += get_mem4D(&(cps->nz_coeff), MAX_PLANE * cps->FrameSizeInMbs, 3, BLOCK_SIZE, BLOCK_SIZE);
+    for( i=0; i<MAX_PLANE; ++i )
+      cps->nz_coeff_JV[i] = cps->nz_coeff + i * cps->FrameSizeInMbs;
+  }
+  else
+    memory_size += get_mem4D(&(cps->nz_coeff), cps->FrameSizeInMbs, 3, BLOCK_SIZE, BLOCK_SIZE);
+
   if( (cps->separate_colour_plane_flag != 0) )
   {
     for( i=0; i<MAX_PLANE; ++i )
@@ -979,6 +1083,9 @@ void free_layer_buffers(VideoParameters *p_Vid, int layer_id)
   if(!p_Vid->global_init_done[layer_id])
     return;
 
+  // the pipeline may still use the macroblock data
+  drain_frame_pipeline(p_Vid);
+
   if (cps->imgY_ref)
   {
     free_mem2Dpel (cps->imgY_ref);
@@ -1010,6 +1117,7 @@ void free_layer_buffers(VideoParameters *p_Vid, int layer_id)
       cps->ipredmode_JV[i] = NULL;
       free (cps->intra_block_JV[i]);
       cps->intra_block_JV[i] = NULL;
+      cps->nz_coeff_JV[i] = NULL;
     }   
   }
   else
@@ -1211,7 +1319,7 @@ int OpenDecoder(InputParameters *p_Inp)
     open_annex_b(pDecoder->p_Inp->infile, pDecoder->p_Vid->annex_b);
     break;
   case PAR_OF_RTP:
-    OpenRTPFile(pDecoder->p_Inp->infile, &pDecoder->p_Vid->BitStreamFile);
+    pDecoder->p_Vid->rtp = OpenRTPFile(pDecoder->p_Inp->infile, pDecoder->p_Inp);
     break;   
   }
   
@@ -1294,6 +1402,25 @@ int FinitDecoder(DecodedPicList **ppDecPicList)
   return DEC_GEN_NOERR;
 }
 
+/************************************
+Interface: SetSEIUserDataCallback
+  callback receives the uuid and the data of every user_data_unregistered
+  SEI message that SEITypes lets through, pointing into the NAL unit
+  without copying, or nothing if it is NULL. Call after OpenDecoder.
+Return: 
+       0: NOERROR;
+       DEC_INVALID_PARAM: no open decoder;
+************************************/
+int SetSEIUserDataCallback(SEIUserDataCallback callback, void *opaque)
+{
+  DecoderParams *pDecoder = p_Dec;
+  if(!pDecoder)
+    return DEC_INVALID_PARAM;
+  pDecoder->p_Vid->sei_user_data_callback = callback;
+  pDecoder->p_Vid->sei_user_data_opaque   = opaque;
+  return DEC_GEN_NOERR;
+}
+
 int CloseDecoder()
 {
   int i;
@@ -1314,10 +1441,21 @@ int CloseDecoder()
     close_annex_b(pDecoder->p_Vid->annex_b);
     break;
   case PAR_OF_RTP:
-    CloseRTPFile(&pDecoder->p_Vid->BitStreamFile);
+    CloseRTPFile(pDecoder->p_Vid->rtp);
+    pDecoder->p_Vid->rtp = NULL;
     break;   
   }
 
+  // the output files are complete once the writer has stopped
+  free_yuv_writer(pDecoder->p_Vid->yuv_writer);
+  pDecoder->p_Vid->yuv_writer = NULL;
+  free_frame_hash(pDecoder->p_Vid->frame_hash);
+  pDecoder->p_Vid->frame_hash = NULL;
+  close_se_trace(pDecoder->p_Vid->se_trace);
+  pDecoder->p_Vid->se_trace = NULL;
+  close_mb_meta(pDecoder->p_Vid->mb_meta);
+  pDecoder->p_Vid->mb_meta = NULL;
+
 #if (MVC_EXTENSION_ENABLE)
   for(i=0;i<MAX_VIEW_NUM;i++)
   {
@@ -1363,6 +1501,7 @@ int CloseDecoder()
 #endif
 
   free_img (pDecoder->p_Vid);
+  report_memory(pDecoder->p_Inp);
   free (pDecoder->p_Inp);
   free(pDecoder);
 
@@ -1387,6 +1526,8 @@ void OpenOutputFiles(VideoParameters *p_Vid, int view0_id, int view1_id)
       sprintf(out_ViewFileName[1], "%s_ViewId%04d.yuv", chBuf, view1_id);
       if(p_Vid->p_out_mvc[0] >= 0)
       {
+        flush_yuv_file(p_Vid->yuv_writer, p_Vid->p_out_mvc[0]);
+        finish_file_hash(p_Vid->frame_hash, p_Vid->p_out_mvc[0]);
         close(p_Vid->p_out_mvc[0]);
         p_Vid->p_out_mvc[0] = -1;
       }
@@ -1399,6 +1540,8 @@ void OpenOutputFiles(VideoParameters *p_Vid, int view0_id, int view1_id)
       
       if(p_Vid->p_out_mvc[1] >= 0)
       {
+        flush_yuv_file(p_Vid->yuv_writer, p_Vid->p_out_mvc[1]);
+        finish_file_hash(p_Vid->frame_hash, p_Vid->p_out_mvc[1]);
         close(p_Vid->p_out_mvc[1]);
         p_Vid->p_out_mvc[1] = -1;
       }
@@ -1439,10 +1582,10 @@ void set_global_coding_par(VideoParameters *p_Vid, CodingParameters *cps)
 
     p_Vid->width = cps->width;
     p_Vid->height = cps->height;
-    p_Vid->iLumaPadX = MCBUF_LUMA_PAD_X;
-    p_Vid->iLumaPadY = MCBUF_LUMA_PAD_Y;
-    p_Vid->iChromaPadX = MCBUF_CHROMA_PAD_X;
-    p_Vid->iChromaPadY = MCBUF_CHROMA_PAD_Y;
+    p_Vid->iLumaPadX = cps->iLumaPadX;
+    p_Vid->iLumaPadY = cps->iLumaPadY;
+    p_Vid->iChromaPadX = cps->iChromaPadX;
+    p_Vid->iChromaPadY = cps->iChromaPadY;
     if (p_Vid->yuv_format == YUV420)
     {
       p_Vid->width_cr  = (p_Vid->width  >> 1);
@@ -1452,15 +1595,12 @@ void set_global_coding_par(VideoParameters *p_Vid, CodingParameters *cps)
     {
       p_Vid->width_cr  = (p_Vid->width >> 1);
       p_Vid->height_cr = p_Vid->height;
-      p_Vid->iChromaPadY = MCBUF_CHROMA_PAD_Y*2;
     }
     else if (p_Vid->yuv_format == YUV444)
     {
       //YUV444
       p_Vid->width_cr = p_Vid->width;
       p_Vid->height_cr = p_Vid->height;
-      p_Vid->iChromaPadX = p_Vid->iLumaPadX;
-      p_Vid->iChromaPadY = p_Vid->iLumaPadY;
     }
 
     init_frext(p_Vid);
@@ -25,6 +25,8 @@
 #include "mb_access.h"
 #include "loopfilter.h"
 #include "loop_filter.h"
+#include "memalloc.h"
+#include "thread_pool.h"
 
 static void DeblockMb      (VideoParameters *p_Vid, StorablePicture *p, int MbQAddr);
 static void perform_db     (VideoParameters *p_Vid, StorablePicture *p, int MbQAddr);
@@ -36,11 +38,91 @@ extern void deblock_normal(VideoParameters *p_Vid, StorablePicture *p);
 extern void get_strength_ver_MBAff     (byte *Strength, Macroblock *MbQ, int edge, int mvlimit, StorablePicture *p);
 extern void get_strength_hor_MBAff     (byte *Strength, Macroblock *MbQ, int edge, int mvlimit, StorablePicture *p);
 
-#if (JM_PARALLEL_DEBLOCK == 0)
+struct deblock_wavefront
+{
+  VideoParameters *p_Vid;
+  StorablePicture *p;
+  int              width;         //!< macroblocks per row
+  int              max_rows;      //!< rows the progress counters are allocated for
+  ThreadProgress  *row_done;      //!< number of filtered macroblocks of every row
+};
+
+/*!
+ *****************************************************************************************
+ * \brief
+ *    Filter one macroblock row, staying one macroblock behind the row above.
+ *    The top edge of a macroblock is filtered after the left edge of its upper
+ *    right neighbour, as in the serial order.
+ *****************************************************************************************
+ */
+static void deblock_row_job(void *arg, int row)
+{
+  DeblockWavefront *dw = (DeblockWavefront *) arg;
+  int width = dw->width;
+  int mb_nr = row * width;
+  int x;
+
+  for (x = 0; x < width; ++x, ++mb_nr)
+  {
+    if (row > 0)
+      wait_thread_progress(&dw->row_done[row - 1], imin(x + 2, width));
+    get_db_strength( dw->p_Vid, dw->p, mb_nr ) ;
+    perform_db( dw->p_Vid, dw->p, mb_nr ) ;
+    set_thread_progress(&dw->row_done[row], x + 1);
+  }
+}
+
+/*!
+ *****************************************************************************************
+ * \brief
+ *    Filter the macroblock rows of a picture that is not MBAFF on the thread pool
+ *****************************************************************************************
+ */
+static void DeblockPictureParallel(VideoParameters *p_Vid, StorablePicture *p)
+{
+  DeblockWavefront *dw = p_Vid->deblock_wavefront;
+  int num_rows = p->PicSizeInMbs / p->PicWidthInMbs;
+  int i;
+
+  if (dw == NULL || dw->max_rows < num_rows)
+  {
+    free_deblock_wavefront(dw);
+    if ((dw = p_Vid->deblock_wavefront = (DeblockWavefront *) calloc(1, sizeof(DeblockWavefront))) == NULL)
+      no_mem_exit("DeblockPictureParallel: dw");
+    if ((dw->row_done = (ThreadProgress *) calloc(num_rows, sizeof(ThreadProgress))) == NULL)
+      no_mem_exit("DeblockPictureParallel: row_done");
+    for (i = 0; i < num_rows; ++i)
+      init_thread_progress(&dw->row_done[i], 0);
+    dw->max_rows = num_rows;
+  }
+
+  dw->p_Vid = p_Vid;
+  dw->p     = p;
+  dw->width = p->PicWidthInMbs;
+  for (i = 0; i < num_rows; ++i)
+    set_thread_progress(&dw->row_done[i], 0);
+
+  run_thread_jobs(p_Vid->thread_pool, deblock_row_job, dw, num_rows);
+}
+
+void free_deblock_wavefront(DeblockWavefront *dw)
+{
+  int i;
+
+  if (dw == NULL)
+    return;
+
+  for (i = 0; i < dw->max_rows; ++i)
+    free_thread_progress(&dw->row_done[i]);
+  free(dw->row_done);
+  free(dw);
+}
+
 /*!
  *****************************************************************************************
  * \brief
- *    Filter all macroblocks in order of increasing macroblock address.
+ *    Filter all macroblocks in order of increasing macroblock address, or row
+ *    by row on the thread pool for pictures that are not MBAFF.
  *****************************************************************************************
  */
 void DeblockPicture(VideoParameters *p_Vid, StorablePicture *p)
@@ -53,6 +135,10 @@ void DeblockPicture(VideoParameters *p_Vid, StorablePicture *p)
       DeblockMb( p_Vid, p, i ) ;
     }
   }
+  else if (thread_pool_size(p_Vid->thread_pool) > 1 && p->PicSizeInMbs > p->PicWidthInMbs)
+  {
+    DeblockPictureParallel(p_Vid, p);
+  }
   else
   {
    // deblock_normal( p_Vid, p);
@@ -68,54 +154,30 @@ void DeblockPicture(VideoParameters *p_Vid, StorablePicture *p)
     
   }
 }
-#else
-static void DeblockParallel(VideoParameters *p_Vid, StorablePicture *p, unsigned int column, int block, int n_last)
-{
-  int i, j;
-  
-  for (j = 0; j < GROUP_SIZE; j++)
-  {
-    i = block++ * (p_Vid->PicWidthInMbs - 2) + column;
-
-    perform_db( p_Vid, p, i ) ;
-    if (block == n_last) break;
-  }
-}
 
 /*!
  *****************************************************************************************
  * \brief
- *    Filter all macroblocks in a diagonal manner to enable parallelization.
+ *    Filter the macroblocks of num_rows macroblock rows starting at first_row.
+ *    Filtering all rows of a frame that is not MBAFF in order gives the same
+ *    result as DeblockPicture(). The lines above first_row are modified too.
  *****************************************************************************************
  */
-void DeblockPicture(VideoParameters *p_Vid, StorablePicture *p)
+void DeblockMbRows(VideoParameters *p_Vid, StorablePicture *p, int first_row, int num_rows)
 {
-  int iheightMBs =(p_Vid->PicSizeInMbs/p_Vid->PicWidthInMbs);
-  unsigned int i, k = p->PicWidthInMbs + 2 * (iheightMBs - 1);
-
-#if defined(OPENMP)
-  int j;
-    #pragma omp parallel for
-#endif
-  for (j = 0; j < p->PicSizeInMbs; ++j)
+  unsigned i;
+  unsigned first = first_row * p->PicWidthInMbs;
+  unsigned last  = imin(first_row + num_rows, p->PicSizeInMbs / p->PicWidthInMbs) * p->PicWidthInMbs;
+
+  for (i = first; i < last; ++i)
   {
-    get_db_strength( p_Vid, p, j ) ;
+    get_db_strength( p_Vid, p, i ) ;
   }
- 
-  for (i = 0; i < k; i++)
+  for (i = first; i < last; ++i)
   {
-    int nn;    
-    int n_last = imin(iheightMBs, (i >> 1) + 1);
-    int n_start = (i < p->PicWidthInMbs) ? 0 : ((i - p->PicWidthInMbs) >> 1) + 1;
-
-#if defined(OPENMP)
-    #pragma omp parallel for
-#endif
-    for (nn = n_start; nn < n_last; nn += GROUP_SIZE)
-      DeblockParallel(p_Vid, p, i, nn, n_last);
+    perform_db( p_Vid, p, i ) ;
   }
 }
-#endif
 
 // likely already set - see testing via asserts
 static void init_neighbors(VideoParameters *p_Vid)
@@ -272,11 +334,11 @@ static void DeblockMb(VideoParameters *p_Vid, StorablePicture *p, int MbQAddr)
         {
           if (filterNon8x8LumaEdgesFlag[edge])
           {
-            p_Vid->EdgeLoopLumaVer( PLANE_Y, imgY, Strength, MbQ, edge << 2);
+            p_Vid->EdgeLoopLumaVer( PLANE_Y, imgY, Strength, MbQ, edge << 2, p);
             if(currSlice->chroma444_not_separate)
             {
-              p_Vid->EdgeLoopLumaVer(PLANE_U, imgUV[0], Strength, MbQ, edge << 2);
-              p_Vid->EdgeLoopLumaVer(PLANE_V, imgUV[1], Strength, MbQ, edge << 2);
+              p_Vid->EdgeLoopLumaVer(PLANE_U, imgUV[0], Strength, MbQ, edge << 2, p);
+              p_Vid->EdgeLoopLumaVer(PLANE_V, imgUV[1], Strength, MbQ, edge << 2, p);
             }
           }
           if (active_sps->chroma_format_idc==YUV420 || active_sps->chroma_format_idc==YUV422)
@@ -563,11 +625,11 @@ static void perform_db(VideoParameters *p_Vid, StorablePicture *p, int MbQAddr)
         {
           if (filterNon8x8LumaEdgesFlag[edge])
           {
-            p_Vid->EdgeLoopLumaVer( PLANE_Y, imgY, Strength, MbQ, edge << 2);
+            p_Vid->EdgeLoopLumaVer( PLANE_Y, imgY, Strength, MbQ, edge << 2, p);
             if(currSlice->chroma444_not_separate)
             {
-              p_Vid->EdgeLoopLumaVer(PLANE_U, imgUV[0], Strength, MbQ, edge << 2);
-              p_Vid->EdgeLoopLumaVer(PLANE_V, imgUV[1], Strength, MbQ, edge << 2);
+              p_Vid->EdgeLoopLumaVer(PLANE_U, imgUV[0], Strength, MbQ, edge << 2, p);
+              p_Vid->EdgeLoopLumaVer(PLANE_V, imgUV[1], Strength, MbQ, edge << 2, p);
             }
           }
           if (active_sps->chroma_format_idc==YUV420 || active_sps->chroma_format_idc==YUV422)
@@ -19,10 +19,9 @@
 #define _LOOP_FILTER_H_
 
 #include "global.h"
+#include "mbuffer.h"
 
 
-#define GROUP_SIZE  1
-
 /*********************************************************************************************************/
 
 // NOTE: In principle, the alpha and beta tables are calculated with the formulas below
@@ -65,4 +64,26 @@ static inline int compare_mvs(const MotionVector *mv0, const MotionVector *mv1,
   return ((iabs( mv0->mv_x - mv1->mv_x) >= 4) | (iabs( mv0->mv_y - mv1->mv_y) >= mvlimit));
 }
 
+//! Filters all lines of one vertical luma edge; imgP points to the P0 sample of the first line
+typedef void (*LumaEdgeVerFunc)  (imgpel *imgP, int width, const byte *Strength, int Alpha, int Beta, const byte *ClipTab, int bitdepth_scale, int max_imgpel_value);
+//! Filters all columns of one horizontal luma edge; imgP points to the first P0 sample
+typedef void (*LumaEdgeHorFunc)  (imgpel *imgP, int width, const byte *Strength, int Alpha, int Beta, const byte *ClipTab, int bitdepth_scale, int max_imgpel_value);
+//! Chroma versions of the above for PelNum lines/columns
+typedef void (*ChromaEdgeVerFunc)(imgpel *imgP, int width, int PelNum, const byte *Strength, int Alpha, int Beta, const byte *ClipTab, int bitdepth_scale, int max_imgpel_value);
+typedef void (*ChromaEdgeHorFunc)(imgpel *imgP, int width, int PelNum, const byte *Strength, int Alpha, int Beta, const byte *ClipTab, int bitdepth_scale, int max_imgpel_value);
+//! compare_mvs() for the four block pairs of an edge; bit i of straight/cross is set if pair i differs L0-L0/L1-L1 or L0-L1/L1-L0
+typedef void (*MvCompareFunc)    (PicMotionParams **mv_p, PicMotionParams **mv_q, int mvlimit, int *straight, int *cross);
+
+typedef struct deblock_kernels
+{
+  LumaEdgeVerFunc   luma_ver;
+  LumaEdgeHorFunc   luma_hor;
+  ChromaEdgeVerFunc chroma_ver;
+  ChromaEdgeHorFunc chroma_hor;
+  MvCompareFunc     mv_compare4;
+} DeblockKernels;
+
+extern void set_deblock_kernels       (DeblockKernels *kernels, int simd_level);
+extern void init_deblock_kernels_sse41(DeblockKernels *kernels);
+
 #endif
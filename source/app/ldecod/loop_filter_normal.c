@@ -25,15 +25,53 @@
 #include "mb_access.h"
 #include "loopfilter.h"
 #include "loop_filter.h"
+#include "cpu_features.h"
 
 static void get_strength_ver         (Macroblock *MbQ, int edge, int mvlimit, StorablePicture *p);
 static void get_strength_hor         (Macroblock *MbQ, int edge, int mvlimit, StorablePicture *p);
-static void edge_loop_luma_ver       (ColorPlane pl, imgpel** Img, byte *Strength, Macroblock *MbQ, int edge);
+static void edge_loop_luma_ver       (ColorPlane pl, imgpel** Img, byte *Strength, Macroblock *MbQ, int edge, StorablePicture *p);
 static void edge_loop_luma_hor       (ColorPlane pl, imgpel** Img, byte *Strength, Macroblock *MbQ, int edge, StorablePicture *p);
 static void edge_loop_chroma_ver     (imgpel** Img, byte *Strength, Macroblock *MbQ, int edge, int uv, StorablePicture *p);
 static void edge_loop_chroma_hor     (imgpel** Img, byte *Strength, Macroblock *MbQ, int edge, int uv, StorablePicture *p);
+static void luma_ver_edge            (imgpel *imgP, int width, const byte *Strength, int Alpha, int Beta, const byte *ClipTab, int bitdepth_scale, int max_imgpel_value);
+static void luma_hor_edge            (imgpel *imgP, int width, const byte *Strength, int Alpha, int Beta, const byte *ClipTab, int bitdepth_scale, int max_imgpel_value);
+static void chroma_ver_edge          (imgpel *imgP, int width, int PelNum, const byte *Strength, int Alpha, int Beta, const byte *ClipTab, int bitdepth_scale, int max_imgpel_value);
+static void chroma_hor_edge          (imgpel *imgP, int width, int PelNum, const byte *Strength, int Alpha, int Beta, const byte *ClipTab, int bitdepth_scale, int max_imgpel_value);
+static void mv_compare4              (PicMotionParams **mv_p, PicMotionParams **mv_q, int mvlimit, int *straight, int *cross);
 
 
+static DeblockKernels db_kernels;
+
+/*!
+ *****************************************************************************************
+ * \brief
+ *    Fills kernels with the edge filter and strength kernels. The C versions are the
+ *    reference; SIMD versions replace them up to the given SimdLevel.
+ *****************************************************************************************
+ */
+void set_deblock_kernels(DeblockKernels *kernels, int simd_level)
+{
+  kernels->luma_ver    = luma_ver_edge;
+  kernels->luma_hor    = luma_hor_edge;
+  kernels->chroma_ver  = chroma_ver_edge;
+  kernels->chroma_hor  = chroma_hor_edge;
+  kernels->mv_compare4 = mv_compare4;
+
+  if (simd_level >= SIMD_SSE41)
+    init_deblock_kernels_sse41(kernels);
+}
+
+/*!
+ *****************************************************************************************
+ * \brief
+ *    Selects the edge filter and strength kernels used by the decoder
+ *****************************************************************************************
+ */
+void init_deblock_kernels(int simd_level)
+{
+  set_deblock_kernels(&db_kernels, simd_level);
+}
+
 void set_loop_filter_functions_normal(VideoParameters *p_Vid)
 {
   p_Vid->GetStrengthVer    = get_strength_ver;
@@ -84,6 +122,67 @@ static Macroblock* get_non_aff_neighbor_chroma(Macroblock *mb, int xN, int yN, i
 #define get_pos_x_chroma(mb,x,max) (mb->pix_c_x + (x & max))
 #define get_pos_y_chroma(mb,y,max) (mb->pix_c_y + (y & max))
 
+/*!
+ *********************************************************************************************
+ * \brief
+ *    compare_mvs() for the four block pairs of an edge
+ *********************************************************************************************
+ */
+static void mv_compare4(PicMotionParams **mv_p, PicMotionParams **mv_q, int mvlimit, int *straight, int *cross)
+{
+  int i;
+
+  *straight = *cross = 0;
+  for (i = 0; i < BLOCK_SIZE; ++i)
+  {
+    *straight |= (compare_mvs(&mv_p[i]->mv[LIST_0], &mv_q[i]->mv[LIST_0], mvlimit) | compare_mvs(&mv_p[i]->mv[LIST_1], &mv_q[i]->mv[LIST_1], mvlimit)) << i;
+    *cross    |= (compare_mvs(&mv_p[i]->mv[LIST_0], &mv_q[i]->mv[LIST_1], mvlimit) | compare_mvs(&mv_p[i]->mv[LIST_1], &mv_q[i]->mv[LIST_0], mvlimit)) << i;
+  }
+}
+
+/*!
+ *********************************************************************************************
+ * \brief
+ *    Strength values of the four block pairs of an edge: 2 where either side has coefficients
+ *    (bit set in coded), otherwise 0 or 1 from the references and motion vectors
+ *********************************************************************************************
+ */
+static void get_strength_mv(byte *Strength, int coded, PicMotionParams **mv_info_p, PicMotionParams **mv_info_q, int mvlimit)
+{
+  int straight, cross, i;
+
+  db_kernels.mv_compare4(mv_info_p, mv_info_q, mvlimit, &straight, &cross);
+
+  for (i = 0; i < BLOCK_SIZE; ++i)
+  {
+    if ((coded >> i) & 0x01)
+      Strength[i] = 2;
+    else // for everything else, if no coefs, but vector difference >= 1 set Strength=1
+    {
+      StorablePicturePtr ref_p0 = mv_info_p[i]->ref_pic[LIST_0];
+      StorablePicturePtr ref_q0 = mv_info_q[i]->ref_pic[LIST_0];
+      StorablePicturePtr ref_p1 = mv_info_p[i]->ref_pic[LIST_1];
+      StorablePicturePtr ref_q1 = mv_info_q[i]->ref_pic[LIST_1];
+
+      if ( ((ref_p0==ref_q0) && (ref_p1==ref_q1)) || ((ref_p0==ref_q1) && (ref_p1==ref_q0)))
+      {
+        // L0 and L1 reference pictures of p0 are different; q0 as well
+        if (ref_p0 != ref_p1)
+        {
+          // compare MV for the same reference picture
+          Strength[i] = (byte) (((ref_p0 == ref_q0) ? straight : cross) >> i) & 0x01;
+        }
+        else
+        { // L0 and L1 reference pictures of p0 are the same; q0 as well
+          Strength[i] = (byte) ((straight & cross) >> i) & 0x01;
+        }
+      }
+      else
+        Strength[i] = 1;
+    }
+  }
+}
+
   /*!
  *********************************************************************************************
  * \brief
@@ -137,65 +236,26 @@ static void get_strength_ver(Macroblock *MbQ, int edge, int mvlimit, StorablePic
         else
         {
           int      blkP, blkQ, idx;
+          int      coded = 0;
+          PicMotionParams *mv_info_p[BLOCK_SIZE], *mv_info_q[BLOCK_SIZE];
           BlockPos mb = PicPos[ MbQ->mbAddrX ];
           mb.x <<= BLOCK_SHIFT;
           mb.y <<= BLOCK_SHIFT;
 
           for( idx = 0 ; idx < MB_BLOCK_SIZE ; idx += BLOCK_SIZE )
           {
+            int blk_y2 = (short)(get_pos_y_luma(neighbor,  0) + idx) >> 2;
+            int blk_x2 = (short)(get_pos_x_luma(neighbor, xQ)      ) >> 2;
+
             blkQ = idx  + (edge);
             blkP = idx  + (get_x_luma(xQ) >> 2);
             if (((MbQ->s_cbp[0].blk & i64_power2(blkQ)) != 0) || ((MbP->s_cbp[0].blk & i64_power2(blkP)) != 0))
-              StrValue = 2;
-            else // for everything else, if no coefs, but vector difference >= 1 set Strength=1
-            {
-              int blk_y  = mb.y + (blkQ >> 2);
-              int blk_x  = mb.x + (blkQ  & 3);
-              int blk_y2 = (short)(get_pos_y_luma(neighbor,  0) + idx) >> 2;
-              int blk_x2 = (short)(get_pos_x_luma(neighbor, xQ)      ) >> 2;
-              PicMotionParams *mv_info_p = &p->mv_info[blk_y ][blk_x ];            
-              PicMotionParams *mv_info_q = &p->mv_info[blk_y2][blk_x2];            
-              StorablePicturePtr ref_p0 = mv_info_p->ref_pic[LIST_0];
-              StorablePicturePtr ref_q0 = mv_info_q->ref_pic[LIST_0];            
-              StorablePicturePtr ref_p1 = mv_info_p->ref_pic[LIST_1];
-              StorablePicturePtr ref_q1 = mv_info_q->ref_pic[LIST_1];
-
-              if ( ((ref_p0==ref_q0) && (ref_p1==ref_q1)) || ((ref_p0==ref_q1) && (ref_p1==ref_q0)))
-              {
-                // L0 and L1 reference pictures of p0 are different; q0 as well
-                if (ref_p0 != ref_p1)
-                {
-                  // compare MV for the same reference picture
-                  if (ref_p0 == ref_q0)
-                  {
-                    StrValue = 
-                      compare_mvs(&mv_info_p->mv[LIST_0], &mv_info_q->mv[LIST_0], mvlimit) |
-                      compare_mvs(&mv_info_p->mv[LIST_1], &mv_info_q->mv[LIST_1], mvlimit);
-                  }
-                  else
-                  {
-                    StrValue = 
-                      compare_mvs(&mv_info_p->mv[LIST_0], &mv_info_q->mv[LIST_1], mvlimit) |
-                      compare_mvs(&mv_info_p->mv[LIST_1], &mv_info_q->mv[LIST_0], mvlimit);
-                  }
-                }
-                else
-                { // L0 and L1 reference pictures of p0 are the same; q0 as well
-                  StrValue = ((
-                    compare_mvs(&mv_info_p->mv[LIST_0], &mv_info_q->mv[LIST_0], mvlimit) |
-                    compare_mvs(&mv_info_p->mv[LIST_1], &mv_info_q->mv[LIST_1], mvlimit))
-                    && (
-                    compare_mvs(&mv_info_p->mv[LIST_0], &mv_info_q->mv[LIST_1], mvlimit) |
-                    compare_mvs(&mv_info_p->mv[LIST_1], &mv_info_q->mv[LIST_0], mvlimit)
-                    ));
-                }
-              }
-              else
-                StrValue = 1;
-            }
-            //*(int*)(Strength+(idx >> 2)) = StrValue; // * 0x01010101;
-            Strength[idx >> 2] = StrValue;
+              coded |= 1 << (idx >> 2);
+
+            mv_info_p[idx >> 2] = &p->mv_info[mb.y + (blkQ >> 2)][mb.x + (blkQ & 3)];
+            mv_info_q[idx >> 2] = &p->mv_info[blk_y2][blk_x2];
           }
+          get_strength_mv(Strength, coded, mv_info_p, mv_info_q, mvlimit);
         }
       }
       else
@@ -270,67 +330,27 @@ static void get_strength_hor(Macroblock *MbQ, int edge, int mvlimit, StorablePic
         else
         {
           int      blkP, blkQ, idx;
+          int      coded = 0;
+          PicMotionParams *mv_info_p[BLOCK_SIZE], *mv_info_q[BLOCK_SIZE];
           BlockPos mb = PicPos[ MbQ->mbAddrX ];
+          int blk_y2 = get_pos_y_luma(neighbor,yQ) >> 2;
           mb.x <<= 2;
           mb.y <<= 2;
 
           for( idx = 0 ; idx < BLOCK_SIZE ; idx ++)
           {
+            int blk_x2 = ((short)(get_pos_x_luma(neighbor,0)) >> 2) + idx;
+
             blkQ = (yQ + 1) + idx;
             blkP = (get_y_luma(yQ) & 0xFFFC) + idx;
 
             if (((MbQ->s_cbp[0].blk & i64_power2(blkQ)) != 0) || ((MbP->s_cbp[0].blk & i64_power2(blkP)) != 0))
-              StrValue = 2;
-            else // for everything else, if no coefs, but vector difference >= 1 set Strength=1
-            {
-              int blk_y  = mb.y + (blkQ >> 2);
-              int blk_x  = mb.x + (blkQ  & 3);
-              int blk_y2 = get_pos_y_luma(neighbor,yQ) >> 2;
-              int blk_x2 = ((short)(get_pos_x_luma(neighbor,0)) >> 2) + idx;
-
-              PicMotionParams *mv_info_p = &p->mv_info[blk_y ][blk_x ];
-              PicMotionParams *mv_info_q = &p->mv_info[blk_y2][blk_x2];
-
-              StorablePicturePtr ref_p0 = mv_info_p->ref_pic[LIST_0];
-              StorablePicturePtr ref_q0 = mv_info_q->ref_pic[LIST_0];
-              StorablePicturePtr ref_p1 = mv_info_p->ref_pic[LIST_1];
-              StorablePicturePtr ref_q1 = mv_info_q->ref_pic[LIST_1];            
+              coded |= 1 << idx;
 
-              if ( ((ref_p0==ref_q0) && (ref_p1==ref_q1)) || ((ref_p0==ref_q1) && (ref_p1==ref_q0)))
-              {
-                // L0 and L1 reference pictures of p0 are different; q0 as well
-                if (ref_p0 != ref_p1)
-                {
-                  // compare MV for the same reference picture
-                  if (ref_p0 == ref_q0)
-                  {
-                    StrValue = 
-                      compare_mvs(&mv_info_p->mv[LIST_0], &mv_info_q->mv[LIST_0], mvlimit) |
-                      compare_mvs(&mv_info_p->mv[LIST_1], &mv_info_q->mv[LIST_1], mvlimit);
-                  }
-                  else
-                  {
-                    StrValue = 
-                      compare_mvs(&mv_info_p->mv[LIST_0], &mv_info_q->mv[LIST_1], mvlimit) |
-                      compare_mvs(&mv_info_p->mv[LIST_1], &mv_info_q->mv[LIST_0], mvlimit);
-                  }
-                }
-                else
-                { // L0 and L1 reference pictures of p0 are the same; q0 as well
-                  StrValue = ((
-                    compare_mvs(&mv_info_p->mv[LIST_0], &mv_info_q->mv[LIST_0], mvlimit) |
-                    compare_mvs(&mv_info_p->mv[LIST_1], &mv_info_q->mv[LIST_1], mvlimit))
-                    && (
-                    compare_mvs(&mv_info_p->mv[LIST_0], &mv_info_q->mv[LIST_1], mvlimit) |
-                    compare_mvs(&mv_info_p->mv[LIST_1], &mv_info_q->mv[LIST_0], mvlimit)
-                    ));
-                }
-              }
-              else
-                StrValue = 1;
-            }
-            Strength[idx] = StrValue;
+            mv_info_p[idx] = &p->mv_info[mb.y + (blkQ >> 2)][mb.x + (blkQ & 3)];
+            mv_info_q[idx] = &p->mv_info[blk_y2][blk_x2];
           }
+          get_strength_mv(Strength, coded, mv_info_p, mv_info_q, mvlimit);
         }
       }
       else
@@ -355,12 +375,12 @@ static void get_strength_hor(Macroblock *MbQ, int edge, int mvlimit, StorablePic
  *    Vertical Deblocking with Strength = 4
  *****************************************************************************************
  */
-static void luma_ver_deblock_strong(imgpel **cur_img, int pos_x1, int Alpha, int Beta)
+static void luma_ver_deblock_strong(imgpel *imgP, int width, int Alpha, int Beta)
 {
   int i;
   for( i = 0 ; i < BLOCK_SIZE ; ++i )
   {
-    imgpel *SrcPtrP = *(cur_img++) + pos_x1;
+    imgpel *SrcPtrP = imgP + i * width;
     imgpel *SrcPtrQ = SrcPtrP + 1;
     imgpel  L0 = *SrcPtrP;
     imgpel  R0 = *SrcPtrQ;
@@ -417,7 +437,7 @@ static void luma_ver_deblock_strong(imgpel **cur_img, int pos_x1, int Alpha, int
  *    Vertical Deblocking with Normal Strength
  *****************************************************************************************
  */
-static void luma_ver_deblock_normal(imgpel **cur_img, int pos_x1, int Alpha, int Beta, int C0, int max_imgpel_value)
+static void luma_ver_deblock_normal(imgpel *imgP, int width, int Alpha, int Beta, int C0, int max_imgpel_value)
 {
   int i;
   imgpel *SrcPtrP, *SrcPtrQ;
@@ -427,7 +447,7 @@ static void luma_ver_deblock_normal(imgpel **cur_img, int pos_x1, int Alpha, int
   {
     for( i= 0 ; i < BLOCK_SIZE ; ++i )
     {             
-      SrcPtrP = *(cur_img++) + pos_x1;
+      SrcPtrP = imgP + i * width;
       SrcPtrQ = SrcPtrP + 1;
       edge_diff = *SrcPtrQ - *SrcPtrP;
 
@@ -460,7 +480,7 @@ static void luma_ver_deblock_normal(imgpel **cur_img, int pos_x1, int Alpha, int
   {
     for( i= 0 ; i < BLOCK_SIZE ; ++i )
     {             
-      SrcPtrP = *(cur_img++) + pos_x1;
+      SrcPtrP = imgP + i * width;
       SrcPtrQ = SrcPtrP + 1;
       edge_diff = *SrcPtrQ - *SrcPtrP;
 
@@ -498,13 +518,38 @@ static void luma_ver_deblock_normal(imgpel **cur_img, int pos_x1, int Alpha, int
   }
 }
 
+/*!
+ *****************************************************************************************
+ * \brief
+ *    Filters the 16 lines of a vertical luma edge
+ *****************************************************************************************
+ */
+static void luma_ver_edge(imgpel *imgP, int width, const byte *Strength, int Alpha, int Beta, const byte *ClipTab, int bitdepth_scale, int max_imgpel_value)
+{
+  int pel;
+
+  for( pel = 0 ; pel < MB_BLOCK_SIZE ; pel += 4 )
+  {
+    if(*Strength == 4 )    // INTRA strong filtering
+    {
+      luma_ver_deblock_strong(imgP, width, Alpha, Beta);
+    }
+    else if( *Strength != 0) // normal filtering
+    {
+      luma_ver_deblock_normal(imgP, width, Alpha, Beta, ClipTab[ *Strength ] * bitdepth_scale, max_imgpel_value);
+    }        
+    imgP += 4 * width;
+    Strength ++;
+  }
+}
+
 /*!
  *****************************************************************************************
  * \brief
  *    Filters 16 pel block edge of Frame or Field coded MBs 
  *****************************************************************************************
  */
-static void edge_loop_luma_ver(ColorPlane pl, imgpel** Img, byte *Strength, Macroblock *MbQ, int edge)
+static void edge_loop_luma_ver(ColorPlane pl, imgpel** Img, byte *Strength, Macroblock *MbQ, int edge, StorablePicture *p)
 {
   VideoParameters *p_Vid = MbQ->p_Vid;
 
@@ -527,24 +572,9 @@ static void edge_loop_luma_ver(ColorPlane pl, imgpel** Img, byte *Strength, Macr
     {
       const byte *ClipTab = CLIP_TAB[indexA];
       int max_imgpel_value = p_Vid->max_pel_value_comp[pl];      
+      int width = p->iLumaStride;
 
-      int pos_x1 = get_pos_x_luma(MbP, (edge - 1));
-      imgpel **cur_img = &Img[get_pos_y_luma(MbP, 0)];
-      int pel;
-
-      for( pel = 0 ; pel < MB_BLOCK_SIZE ; pel += 4 )
-      {
-        if(*Strength == 4 )    // INTRA strong filtering
-        {
-          luma_ver_deblock_strong(cur_img, pos_x1, Alpha, Beta);
-        }
-        else if( *Strength != 0) // normal filtering
-        {
-          luma_ver_deblock_normal(cur_img, pos_x1, Alpha, Beta, ClipTab[ *Strength ] * bitdepth_scale, max_imgpel_value);
-        }        
-        cur_img += 4;
-        Strength ++;
-      }
+      db_kernels.luma_ver(&Img[get_pos_y_luma(MbP, 0)][get_pos_x_luma(MbP, (edge - 1))], width, Strength, Alpha, Beta, ClipTab, bitdepth_scale, max_imgpel_value);
     }
   }
 }
@@ -701,6 +731,33 @@ static void luma_hor_deblock_normal(imgpel *imgP, imgpel *imgQ, int width, int A
   }
 }
 
+/*!
+ *****************************************************************************************
+ * \brief
+ *    Filters the 16 columns of a horizontal luma edge
+ *****************************************************************************************
+ */
+static void luma_hor_edge(imgpel *imgP, int width, const byte *Strength, int Alpha, int Beta, const byte *ClipTab, int bitdepth_scale, int max_imgpel_value)
+{
+  imgpel *imgQ = imgP + width;
+  int pel;
+
+  for( pel = 0 ; pel < BLOCK_SIZE ; pel++ )
+  {
+    if(*Strength == 4 )    // INTRA strong filtering
+    {
+      luma_hor_deblock_strong(imgP, imgQ, width, Alpha, Beta);
+    }
+    else if( *Strength != 0) // normal filtering
+    {
+      luma_hor_deblock_normal(imgP, imgQ, width, Alpha, Beta, ClipTab[ *Strength ] * bitdepth_scale, max_imgpel_value);
+    }        
+    imgP += 4;
+    imgQ += 4;
+    Strength ++;
+  }
+}
+
 /*!
  *****************************************************************************************
  * \brief
@@ -733,29 +790,64 @@ static void edge_loop_luma_hor(ColorPlane pl, imgpel** Img, byte *Strength, Macr
       int max_imgpel_value = p_Vid->max_pel_value_comp[pl];
       int width = p->iLumaStride; //p->size_x;
 
-      imgpel *imgP = &Img[get_pos_y_luma(MbP, ypos)][get_pos_x_luma(MbP, 0)];
-      imgpel *imgQ = imgP + width;
-      int pel;
+      db_kernels.luma_hor(&Img[get_pos_y_luma(MbP, ypos)][get_pos_x_luma(MbP, 0)], width, Strength, Alpha, Beta, ClipTab, bitdepth_scale, max_imgpel_value);
+    }
+  }
+}
+
 
-      for( pel = 0 ; pel < BLOCK_SIZE ; pel++ )
+/*!
+ *****************************************************************************************
+ * \brief
+ *    Filters the PelNum lines of a vertical chroma edge
+ *****************************************************************************************
+ */
+static void chroma_ver_edge(imgpel *imgP, int width, int PelNum, const byte *Strength, int Alpha, int Beta, const byte *ClipTab, int bitdepth_scale, int max_imgpel_value)
+{
+  int pel;
+
+  for( pel = 0 ; pel < PelNum ; ++pel )
+  {
+    int Strng = Strength[(PelNum == 8) ? (pel >> 1) : (pel >> 2)];
+
+    if( Strng != 0)
+    {
+      imgpel *SrcPtrP = imgP;
+      imgpel *SrcPtrQ = SrcPtrP + 1;
+      int edge_diff = *SrcPtrQ - *SrcPtrP;
+
+      if ( iabs( edge_diff ) < Alpha ) 
       {
-        if(*Strength == 4 )    // INTRA strong filtering
+        imgpel R1  = *(SrcPtrQ + 1);
+        if ( iabs(*SrcPtrQ - R1) < Beta )  
         {
-          luma_hor_deblock_strong(imgP, imgQ, width, Alpha, Beta);
+          imgpel L1  = *(SrcPtrP - 1);
+          if ( iabs(*SrcPtrP - L1) < Beta )
+          {
+            if( Strng == 4 )    // INTRA strong filtering
+            {
+              *SrcPtrP = (imgpel) ( ((L1 << 1) + *SrcPtrP + R1 + 2) >> 2 );
+              *SrcPtrQ = (imgpel) ( ((R1 << 1) + *SrcPtrQ + L1 + 2) >> 2 );
+            }
+            else
+            {
+              int tc0  = ClipTab[ Strng ] * bitdepth_scale + 1;
+              int dif = iClip3( -tc0, tc0, ( ((edge_diff) << 2) + (L1 - R1) + 4) >> 3 );
+
+              if (dif != 0)
+              {
+                *SrcPtrP = (imgpel) iClip1 ( max_imgpel_value, *SrcPtrP + dif );
+                *SrcPtrQ = (imgpel) iClip1 ( max_imgpel_value, *SrcPtrQ - dif );
+              }
+            }
+          }
         }
-        else if( *Strength != 0) // normal filtering
-        {
-          luma_hor_deblock_normal(imgP, imgQ, width, Alpha, Beta, ClipTab[ *Strength ] * bitdepth_scale, max_imgpel_value);
-        }        
-        imgP += 4;
-        imgQ += 4;
-        Strength ++;
       }
     }
-  }
+    imgP += width;
+  }     
 }
 
-
 /*!
  *****************************************************************************************
  * \brief
@@ -794,56 +886,68 @@ static void edge_loop_chroma_ver(imgpel** Img, byte *Strength, Macroblock *MbQ,
     {
       const int PelNum = pelnum_cr[0][p->chroma_format_idc];
       const     byte *ClipTab = CLIP_TAB[indexA];
+      int width = p->iChromaStride;
 
-      int pel;
-      int pos_x1 = get_pos_x_chroma(MbP, xQ, (block_width - 1));
-      imgpel **cur_img = &Img[get_pos_y_chroma(MbP,yQ, (block_height - 1))];
+      db_kernels.chroma_ver(&Img[get_pos_y_chroma(MbP,yQ, (block_height - 1))][get_pos_x_chroma(MbP, xQ, (block_width - 1))], width, PelNum, Strength, Alpha, Beta, ClipTab, bitdepth_scale, max_imgpel_value);
+    }
+  }
+}
 
-      for( pel = 0 ; pel < PelNum ; ++pel )
-      {
-        int Strng = Strength[(PelNum == 8) ? (pel >> 1) : (pel >> 2)];
 
-        if( Strng != 0)
-        {
-          imgpel *SrcPtrP = *cur_img + pos_x1;
-          imgpel *SrcPtrQ = SrcPtrP + 1;
-          int edge_diff = *SrcPtrQ - *SrcPtrP;
+/*!
+ *****************************************************************************************
+ * \brief
+ *    Filters the PelNum columns of a horizontal chroma edge
+ *****************************************************************************************
+ */
+static void chroma_hor_edge(imgpel *imgP, int width, int PelNum, const byte *Strength, int Alpha, int Beta, const byte *ClipTab, int bitdepth_scale, int max_imgpel_value)
+{
+  int pel;
+  imgpel *imgQ = imgP + width ;
 
-          if ( iabs( edge_diff ) < Alpha ) 
+  for( pel = 0 ; pel < PelNum ; ++pel )
+  {
+    int Strng = Strength[(PelNum == 8) ? (pel >> 1) : (pel >> 2)];
+
+    if( Strng != 0)
+    {
+      imgpel *SrcPtrP = imgP;
+      imgpel *SrcPtrQ = imgQ;
+      int edge_diff = *imgQ - *imgP;
+
+      if ( iabs( edge_diff ) < Alpha ) 
+      {
+        imgpel R1  = *(SrcPtrQ + width);
+        if ( iabs(*SrcPtrQ - R1) < Beta )  
+        {
+          imgpel L1  = *(SrcPtrP - width);
+          if ( iabs(*SrcPtrP - L1) < Beta )
           {
-            imgpel R1  = *(SrcPtrQ + 1);
-            if ( iabs(*SrcPtrQ - R1) < Beta )  
+            if( Strng == 4 )    // INTRA strong filtering
+            {
+              *SrcPtrP = (imgpel) ( ((L1 << 1) + *SrcPtrP + R1 + 2) >> 2 );
+              *SrcPtrQ = (imgpel) ( ((R1 << 1) + *SrcPtrQ + L1 + 2) >> 2 );
+            }
+            else
             {
-              imgpel L1  = *(SrcPtrP - 1);
-              if ( iabs(*SrcPtrP - L1) < Beta )
+              int tc0  = ClipTab[ Strng ] * bitdepth_scale + 1;
+              int dif = iClip3( -tc0, tc0, ( ((edge_diff) << 2) + (L1 - R1) + 4) >> 3 );
+
+              if (dif != 0)
               {
-                if( Strng == 4 )    // INTRA strong filtering
-                {
-                  *SrcPtrP = (imgpel) ( ((L1 << 1) + *SrcPtrP + R1 + 2) >> 2 );
-                  *SrcPtrQ = (imgpel) ( ((R1 << 1) + *SrcPtrQ + L1 + 2) >> 2 );
-                }
-                else
-                {
-                  int tc0  = ClipTab[ Strng ] * bitdepth_scale + 1;
-                  int dif = iClip3( -tc0, tc0, ( ((edge_diff) << 2) + (L1 - R1) + 4) >> 3 );
-
-                  if (dif != 0)
-                  {
-                    *SrcPtrP = (imgpel) iClip1 ( max_imgpel_value, *SrcPtrP + dif );
-                    *SrcPtrQ = (imgpel) iClip1 ( max_imgpel_value, *SrcPtrQ - dif );
-                  }
-                }
+                *SrcPtrP = (imgpel) iClip1 ( max_imgpel_value, *SrcPtrP + dif );
+                *SrcPtrQ = (imgpel) iClip1 ( max_imgpel_value, *SrcPtrQ - dif );
               }
             }
           }
         }
-        cur_img++;
-      }     
+      }
     }
+    imgP++;
+    imgQ++;
   }
 }
 
-
 /*!
  *****************************************************************************************
  * \brief
@@ -883,52 +987,7 @@ static void edge_loop_chroma_hor(imgpel** Img, byte *Strength, Macroblock *MbQ,
       const int PelNum = pelnum_cr[1][p->chroma_format_idc];
       const     byte *ClipTab = CLIP_TAB[indexA];
 
-      int pel;
-
-      imgpel *imgP = &Img[get_pos_y_chroma(MbP,yQ, (block_height-1))][get_pos_x_chroma(MbP,xQ, (block_width - 1))];
-      imgpel *imgQ = imgP + width ;
-
-      for( pel = 0 ; pel < PelNum ; ++pel )
-      {
-        int Strng = Strength[(PelNum == 8) ? (pel >> 1) : (pel >> 2)];
-
-        if( Strng != 0)
-        {
-          imgpel *SrcPtrP = imgP;
-          imgpel *SrcPtrQ = imgQ;
-          int edge_diff = *imgQ - *imgP;
-
-          if ( iabs( edge_diff ) < Alpha ) 
-          {
-            imgpel R1  = *(SrcPtrQ + width);
-            if ( iabs(*SrcPtrQ - R1) < Beta )  
-            {
-              imgpel L1  = *(SrcPtrP - width);
-              if ( iabs(*SrcPtrP - L1) < Beta )
-              {
-                if( Strng == 4 )    // INTRA strong filtering
-                {
-                  *SrcPtrP = (imgpel) ( ((L1 << 1) + *SrcPtrP + R1 + 2) >> 2 );
-                  *SrcPtrQ = (imgpel) ( ((R1 << 1) + *SrcPtrQ + L1 + 2) >> 2 );
-                }
-                else
-                {
-                  int tc0  = ClipTab[ Strng ] * bitdepth_scale + 1;
-                  int dif = iClip3( -tc0, tc0, ( ((edge_diff) << 2) + (L1 - R1) + 4) >> 3 );
-
-                  if (dif != 0)
-                  {
-                    *SrcPtrP = (imgpel) iClip1 ( max_imgpel_value, *SrcPtrP + dif );
-                    *SrcPtrQ = (imgpel) iClip1 ( max_imgpel_value, *SrcPtrQ - dif );
-                  }
-                }
-              }
-            }
-          }
-        }
-        imgP++;
-        imgQ++;
-      }
+      db_kernels.chroma_hor(&Img[get_pos_y_chroma(MbP,yQ, (block_height-1))][get_pos_x_chroma(MbP,xQ, (block_width - 1))], width, PelNum, Strength, Alpha, Beta, ClipTab, bitdepth_scale, max_imgpel_value);
     }
   }
 }
@@ -985,9 +1044,9 @@ static void perform_db_dep_normal(Macroblock   *MbQ, StorablePicture *p)
 
         if ( Strength[0] != 0 || Strength[1] != 0 || Strength[2] != 0 || Strength[3] != 0 ) // only if one of the first 4 Strength bytes is != 0
         {
-          edge_loop_luma_ver( PLANE_Y, imgY, Strength, MbQ, edge << 2);
-          edge_loop_luma_ver(PLANE_U, imgUV[0], Strength, MbQ, edge << 2);
-          edge_loop_luma_ver(PLANE_V, imgUV[1], Strength, MbQ, edge << 2);
+          edge_loop_luma_ver( PLANE_Y, imgY, Strength, MbQ, edge << 2, p);
+          edge_loop_luma_ver(PLANE_U, imgUV[0], Strength, MbQ, edge << 2, p);
+          edge_loop_luma_ver(PLANE_V, imgUV[1], Strength, MbQ, edge << 2, p);
         }
       }
     }//end edge
@@ -1041,9 +1100,9 @@ static void perform_db_dep_normal(Macroblock   *MbQ, StorablePicture *p)
 
         if ( Strength[0] != 0 || Strength[1] != 0 || Strength[2] != 0 || Strength[3] != 0 ) // only if one of the first 4 Strength bytes is != 0
         {              
-          edge_loop_luma_ver( PLANE_Y, imgY, Strength, MbQ, edge << 2);
-          edge_loop_luma_ver(PLANE_U, imgUV[0], Strength, MbQ, edge << 2);
-          edge_loop_luma_ver(PLANE_V, imgUV[1], Strength, MbQ, edge << 2);             
+          edge_loop_luma_ver( PLANE_Y, imgY, Strength, MbQ, edge << 2, p);
+          edge_loop_luma_ver(PLANE_U, imgUV[0], Strength, MbQ, edge << 2, p);
+          edge_loop_luma_ver(PLANE_V, imgUV[1], Strength, MbQ, edge << 2, p);             
         }
       }
     }//end edge
@@ -1119,7 +1178,7 @@ static void perform_db_ind_normal(Macroblock *MbQ, StorablePicture *p)
 
         if ( Strength[0] != 0 || Strength[1] != 0 || Strength[2] != 0 || Strength[3] != 0 ) // only if one of the first 4 Strength bytes is != 0
         {
-          edge_loop_luma_ver( PLANE_Y, imgY, Strength, MbQ, edge << 2);
+          edge_loop_luma_ver( PLANE_Y, imgY, Strength, MbQ, edge << 2, p);
 
           if (active_sps->chroma_format_idc==YUV420 || active_sps->chroma_format_idc==YUV422)
           {
@@ -1169,7 +1228,7 @@ static void perform_db_ind_normal(Macroblock *MbQ, StorablePicture *p)
 
         if ( Strength[0] != 0 || Strength[1] != 0 || Strength[2] != 0 || Strength[3] != 0 ) // only if one of the first 4 Strength bytes is != 0
         {
-          edge_loop_luma_ver( PLANE_Y, imgY, Strength, MbQ, 0);                
+          edge_loop_luma_ver( PLANE_Y, imgY, Strength, MbQ, 0, p);                
 
           if (active_sps->chroma_format_idc==YUV420 || active_sps->chroma_format_idc==YUV422)
           {
@@ -1213,7 +1272,7 @@ static void perform_db_ind_normal(Macroblock *MbQ, StorablePicture *p)
 
         if ( Strength[0] != 0 || Strength[1] != 0 || Strength[2] != 0 || Strength[3] != 0 ) // only if one of the first 4 Strength bytes is != 0
         {
-          edge_loop_luma_ver( PLANE_Y, imgY, Strength, MbQ, 0); 
+          edge_loop_luma_ver( PLANE_Y, imgY, Strength, MbQ, 0, p); 
 
           if (active_sps->chroma_format_idc==YUV420 || active_sps->chroma_format_idc==YUV422)
           {
@@ -1262,7 +1321,7 @@ static void perform_db_ind_normal(Macroblock *MbQ, StorablePicture *p)
 
           if ( Strength[0] != 0 || Strength[1] != 0 || Strength[2] != 0 || Strength[3] != 0 ) // only if one of the first 4 Strength bytes is != 0
           {
-            edge_loop_luma_ver( PLANE_Y, imgY, Strength, MbQ, edge << 2);                
+            edge_loop_luma_ver( PLANE_Y, imgY, Strength, MbQ, edge << 2, p);                
 
             if (active_sps->chroma_format_idc==YUV420 || active_sps->chroma_format_idc==YUV422)
             {
@@ -1309,7 +1368,7 @@ static void perform_db_ind_normal(Macroblock *MbQ, StorablePicture *p)
 
           if ( Strength[0] != 0 || Strength[1] != 0 || Strength[2] != 0 || Strength[3] != 0 ) // only if one of the first 4 Strength bytes is != 0
           {
-            edge_loop_luma_ver( PLANE_Y, imgY, Strength, MbQ, edge << 2);                
+            edge_loop_luma_ver( PLANE_Y, imgY, Strength, MbQ, edge << 2, p);                
 
             if (active_sps->chroma_format_idc==YUV420 || active_sps->chroma_format_idc==YUV422)
             {
@@ -1360,7 +1419,7 @@ static void perform_db_ind_normal(Macroblock *MbQ, StorablePicture *p)
 
           if ( Strength[0] != 0 || Strength[1] != 0 || Strength[2] != 0 || Strength[3] != 0 ) // only if one of the first 4 Strength bytes is != 0
           {
-            edge_loop_luma_ver( PLANE_Y, imgY, Strength, MbQ, edge << 2);                
+            edge_loop_luma_ver( PLANE_Y, imgY, Strength, MbQ, edge << 2, p);                
 
             if (active_sps->chroma_format_idc==YUV420 || active_sps->chroma_format_idc==YUV422)
             {
@@ -0,0 +1,416 @@
+
+/*!
+ *************************************************************************************
+ * \file loop_filter_simd.c
+ *
+ * \brief
+ *    SSE4.1 versions of the edge filter and boundary strength kernels of
+ *    loop_filter_normal.c
+ *
+ *    The edge filters work on eight lines (vertical edges) or eight columns
+ *    (horizontal edges) at a time in 16 bit lanes. Vertical edges are transposed
+ *    so that each register holds one sample position (P3 ... Q3) of all eight
+ *    lines. Every line gets its own bS and clipping value, and the filter
+ *    decisions are applied with masks instead of branches. 16 bit lanes are
+ *    exact for samples up to 12 bit; deeper pictures use the C kernels.
+ *
+ *************************************************************************************
+ */
+#include "global.h"
+#include "loop_filter.h"
+#include "cpu_features.h"
+
+#if HAVE_X86_SIMD && (IMGTYPE == 1)
+
+#include <immintrin.h>
+
+//! largest sample value the 16 bit filter arithmetic handles without overflow
+#define SIMD_MAX_PEL_VALUE  4095
+
+static DeblockKernels fallback;
+
+static inline __m128i absdiff_epi16(__m128i a, __m128i b)
+{
+  return _mm_abs_epi16(_mm_sub_epi16(a, b));
+}
+
+static inline __m128i clip3_epi16(__m128i low, __m128i high, __m128i x)
+{
+  return _mm_min_epi16(_mm_max_epi16(x, low), high);
+}
+
+static inline void transpose8_epi16(__m128i *r)
+{
+  __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+  __m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+  __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+  __m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+  __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+  __m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+  __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+  __m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+
+  __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+  __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+  __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+  __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+  __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+  __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+  __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+  __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+  r[0] = _mm_unpacklo_epi64(b0, b4);
+  r[1] = _mm_unpackhi_epi64(b0, b4);
+  r[2] = _mm_unpacklo_epi64(b1, b5);
+  r[3] = _mm_unpackhi_epi64(b1, b5);
+  r[4] = _mm_unpacklo_epi64(b2, b6);
+  r[5] = _mm_unpackhi_epi64(b2, b6);
+  r[6] = _mm_unpacklo_epi64(b3, b7);
+  r[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Luma filter for eight lines. v[0..7] hold P3, P2, P1, P0, Q0, Q1,
+ *    Q2, Q3; bs and c0 hold the strength and ClipTab value per line.
+ *    Returns 0 if no sample was changed.
+ ************************************************************************
+ */
+static inline int luma_filter8(__m128i *v, __m128i bs, __m128i c0, int Alpha, int Beta, __m128i max)
+{
+  __m128i p3 = v[0], p2 = v[1], p1 = v[2], p0 = v[3];
+  __m128i q0 = v[4], q1 = v[5], q2 = v[6], q3 = v[7];
+  __m128i zero  = _mm_setzero_si128();
+  __m128i beta  = _mm_set1_epi16((short) Beta);
+  __m128i adiff = absdiff_epi16(p0, q0);
+  __m128i mask, ap, aq, strong, small, sp, sq;
+  __m128i tc, dif, rl0, avg, np1, nq1;
+  __m128i two = _mm_set1_epi16(2), four = _mm_set1_epi16(4);
+  __m128i sp0, sp1, sp2, sq0, sq1, sq2, wp0, wq0;
+
+  mask = _mm_cmpgt_epi16(bs, zero);
+  mask = _mm_and_si128(mask, _mm_cmpgt_epi16(_mm_set1_epi16((short) Alpha), adiff));
+  mask = _mm_and_si128(mask, _mm_cmpgt_epi16(beta, absdiff_epi16(p1, p0)));
+  mask = _mm_and_si128(mask, _mm_cmpgt_epi16(beta, absdiff_epi16(q1, q0)));
+  if (_mm_testz_si128(mask, mask))
+    return 0;
+
+  ap = _mm_cmpgt_epi16(beta, absdiff_epi16(p2, p0));
+  aq = _mm_cmpgt_epi16(beta, absdiff_epi16(q2, q0));
+  strong = _mm_cmpeq_epi16(bs, four);
+
+  // normal filter (bS < 4); the masks are -1 so tc0 = C0 + ap + aq
+  tc  = _mm_sub_epi16(_mm_sub_epi16(c0, ap), aq);
+  dif = _mm_add_epi16(_mm_slli_epi16(_mm_sub_epi16(q0, p0), 2), _mm_sub_epi16(p1, q1));
+  dif = _mm_srai_epi16(_mm_add_epi16(dif, four), 3);
+  dif = clip3_epi16(_mm_sub_epi16(zero, tc), tc, dif);
+
+  avg = _mm_avg_epu16(p0, q0);
+  np1 = _mm_srai_epi16(_mm_sub_epi16(_mm_add_epi16(p2, avg), _mm_slli_epi16(p1, 1)), 1);
+  np1 = _mm_add_epi16(p1, _mm_and_si128(ap, clip3_epi16(_mm_sub_epi16(zero, c0), c0, np1)));
+  nq1 = _mm_srai_epi16(_mm_sub_epi16(_mm_add_epi16(q2, avg), _mm_slli_epi16(q1, 1)), 1);
+  nq1 = _mm_add_epi16(q1, _mm_and_si128(aq, clip3_epi16(_mm_sub_epi16(zero, c0), c0, nq1)));
+
+  // strong filter (bS == 4)
+  small = _mm_cmpgt_epi16(_mm_set1_epi16((short) ((Alpha >> 2) + 2)), adiff);
+  sp  = _mm_and_si128(small, ap);
+  sq  = _mm_and_si128(small, aq);
+  rl0 = _mm_add_epi16(p0, q0);
+
+  sp0 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(q1, _mm_slli_epi16(_mm_add_epi16(p1, rl0), 1)), _mm_add_epi16(p2, four)), 3);
+  sp1 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(p2, p1), _mm_add_epi16(rl0, two)), 2);
+  sp2 = _mm_add_epi16(_mm_slli_epi16(_mm_add_epi16(p3, p2), 1), _mm_add_epi16(p2, p1));
+  sp2 = _mm_srli_epi16(_mm_add_epi16(sp2, _mm_add_epi16(rl0, four)), 3);
+  wp0 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(p1, 1), p0), _mm_add_epi16(q1, two)), 2);
+
+  sq0 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(p1, _mm_slli_epi16(_mm_add_epi16(q1, rl0), 1)), _mm_add_epi16(q2, four)), 3);
+  sq1 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(q2, q1), _mm_add_epi16(rl0, two)), 2);
+  sq2 = _mm_add_epi16(_mm_slli_epi16(_mm_add_epi16(q3, q2), 1), _mm_add_epi16(q2, q1));
+  sq2 = _mm_srli_epi16(_mm_add_epi16(sq2, _mm_add_epi16(rl0, four)), 3);
+  wq0 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(q1, 1), q0), _mm_add_epi16(p1, two)), 2);
+
+  sp0 = _mm_blendv_epi8(wp0, sp0, sp);
+  sp1 = _mm_blendv_epi8(p1,  sp1, sp);
+  sp2 = _mm_blendv_epi8(p2,  sp2, sp);
+  sq0 = _mm_blendv_epi8(wq0, sq0, sq);
+  sq1 = _mm_blendv_epi8(q1,  sq1, sq);
+  sq2 = _mm_blendv_epi8(q2,  sq2, sq);
+
+  // pick strong or normal per line, then keep the lines that fail the edge test
+  v[1] = _mm_blendv_epi8(p2, _mm_blendv_epi8(p2, sp2, strong), mask);
+  v[2] = _mm_blendv_epi8(p1, _mm_blendv_epi8(np1, sp1, strong), mask);
+  v[3] = _mm_blendv_epi8(p0, _mm_blendv_epi8(clip3_epi16(zero, max, _mm_add_epi16(p0, dif)), sp0, strong), mask);
+  v[4] = _mm_blendv_epi8(q0, _mm_blendv_epi8(clip3_epi16(zero, max, _mm_sub_epi16(q0, dif)), sq0, strong), mask);
+  v[5] = _mm_blendv_epi8(q1, _mm_blendv_epi8(nq1, sq1, strong), mask);
+  v[6] = _mm_blendv_epi8(q2, _mm_blendv_epi8(q2, sq2, strong), mask);
+
+  return 1;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Chroma filter for eight lines. v[0..3] hold P1, P0, Q0, Q1; tc is
+ *    ClipTab value + 1 per line. Returns 0 if no sample was changed.
+ ************************************************************************
+ */
+static inline int chroma_filter8(__m128i *v, __m128i bs, __m128i tc, int Alpha, int Beta, __m128i max)
+{
+  __m128i p1 = v[0], p0 = v[1], q0 = v[2], q1 = v[3];
+  __m128i zero = _mm_setzero_si128();
+  __m128i beta = _mm_set1_epi16((short) Beta);
+  __m128i two  = _mm_set1_epi16(2);
+  __m128i mask, strong, dif, sp0, sq0;
+
+  mask = _mm_cmpgt_epi16(bs, zero);
+  mask = _mm_and_si128(mask, _mm_cmpgt_epi16(_mm_set1_epi16((short) Alpha), absdiff_epi16(p0, q0)));
+  mask = _mm_and_si128(mask, _mm_cmpgt_epi16(beta, absdiff_epi16(q0, q1)));
+  mask = _mm_and_si128(mask, _mm_cmpgt_epi16(beta, absdiff_epi16(p0, p1)));
+  if (_mm_testz_si128(mask, mask))
+    return 0;
+
+  strong = _mm_cmpeq_epi16(bs, _mm_set1_epi16(4));
+
+  dif = _mm_add_epi16(_mm_slli_epi16(_mm_sub_epi16(q0, p0), 2), _mm_sub_epi16(p1, q1));
+  dif = _mm_srai_epi16(_mm_add_epi16(dif, _mm_set1_epi16(4)), 3);
+  dif = clip3_epi16(_mm_sub_epi16(zero, tc), tc, dif);
+
+  sp0 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(p1, 1), p0), _mm_add_epi16(q1, two)), 2);
+  sq0 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(q1, 1), q0), _mm_add_epi16(p1, two)), 2);
+
+  v[1] = _mm_blendv_epi8(p0, _mm_blendv_epi8(clip3_epi16(zero, max, _mm_add_epi16(p0, dif)), sp0, strong), mask);
+  v[2] = _mm_blendv_epi8(q0, _mm_blendv_epi8(clip3_epi16(zero, max, _mm_sub_epi16(q0, dif)), sq0, strong), mask);
+
+  return 1;
+}
+
+//! bS and C0 lanes for eight luma lines covered by Strength[0] and Strength[1]
+static inline int luma_lanes(const byte *Strength, const byte *ClipTab, int bitdepth_scale, __m128i *bs, __m128i *c0)
+{
+  short s0 = Strength[0], s1 = Strength[1];
+  short c00 = (short) (ClipTab[s0] * bitdepth_scale), c01 = (short) (ClipTab[s1] * bitdepth_scale);
+
+  *bs = _mm_set_epi16(s1, s1, s1, s1, s0, s0, s0, s0);
+  *c0 = _mm_set_epi16(c01, c01, c01, c01, c00, c00, c00, c00);
+  return (s0 | s1);
+}
+
+//! bS and tc lanes for chroma lines pel ... pel + 7
+static inline int chroma_lanes(const byte *Strength, int PelNum, int pel, const byte *ClipTab, int bitdepth_scale, __m128i *bs, __m128i *tc)
+{
+  short s[8], c[8];
+  int i, any = 0;
+
+  for (i = 0; i < 8; ++i)
+  {
+    int Strng = Strength[(PelNum == 8) ? ((pel + i) >> 1) : ((pel + i) >> 2)];
+    s[i] = (short) Strng;
+    c[i] = (short) (ClipTab[Strng] * bitdepth_scale + 1);
+    any |= Strng;
+  }
+  *bs = _mm_loadu_si128((const __m128i *) s);
+  *tc = _mm_loadu_si128((const __m128i *) c);
+  return any;
+}
+
+static void luma_ver_edge_sse41(imgpel *imgP, int width, const byte *Strength, int Alpha, int Beta, const byte *ClipTab, int bitdepth_scale, int max_imgpel_value)
+{
+  __m128i max = _mm_set1_epi16((short) max_imgpel_value);
+  __m128i bs, c0, v[8];
+  int pel, i;
+
+  if (max_imgpel_value > SIMD_MAX_PEL_VALUE)
+  {
+    fallback.luma_ver(imgP, width, Strength, Alpha, Beta, ClipTab, bitdepth_scale, max_imgpel_value);
+    return;
+  }
+
+  for (pel = 0; pel < MB_BLOCK_SIZE; pel += 8, imgP += 8 * width, Strength += 2)
+  {
+    if (!luma_lanes(Strength, ClipTab, bitdepth_scale, &bs, &c0))
+      continue;
+
+    for (i = 0; i < 8; ++i)
+      v[i] = _mm_loadu_si128((const __m128i *) (imgP + i * width - 3));
+    transpose8_epi16(v);
+
+    if (luma_filter8(v, bs, c0, Alpha, Beta, max))
+    {
+      transpose8_epi16(v);
+      for (i = 0; i < 8; ++i)
+        _mm_storeu_si128((__m128i *) (imgP + i * width - 3), v[i]);
+    }
+  }
+}
+
+static void luma_hor_edge_sse41(imgpel *imgP, int width, const byte *Strength, int Alpha, int Beta, const byte *ClipTab, int bitdepth_scale, int max_imgpel_value)
+{
+  __m128i max = _mm_set1_epi16((short) max_imgpel_value);
+  __m128i bs, c0, v[8];
+  int pel, i;
+
+  if (max_imgpel_value > SIMD_MAX_PEL_VALUE)
+  {
+    fallback.luma_hor(imgP, width, Strength, Alpha, Beta, ClipTab, bitdepth_scale, max_imgpel_value);
+    return;
+  }
+
+  for (pel = 0; pel < MB_BLOCK_SIZE; pel += 8, imgP += 8, Strength += 2)
+  {
+    if (!luma_lanes(Strength, ClipTab, bitdepth_scale, &bs, &c0))
+      continue;
+
+    for (i = 0; i < 8; ++i)
+      v[i] = _mm_loadu_si128((const __m128i *) (imgP + (i - 3) * width));
+
+    if (luma_filter8(v, bs, c0, Alpha, Beta, max))
+    {
+      for (i = 1; i < 7; ++i)
+        _mm_storeu_si128((__m128i *) (imgP + (i - 3) * width), v[i]);
+    }
+  }
+}
+
+static void chroma_ver_edge_sse41(imgpel *imgP, int width, int PelNum, const byte *Strength, int Alpha, int Beta, const byte *ClipTab, int bitdepth_scale, int max_imgpel_value)
+{
+  __m128i max = _mm_set1_epi16((short) max_imgpel_value);
+  __m128i bs, tc, v[4];
+  int pel;
+
+  if (max_imgpel_value > SIMD_MAX_PEL_VALUE || (PelNum & 7))
+  {
+    fallback.chroma_ver(imgP, width, PelNum, Strength, Alpha, Beta, ClipTab, bitdepth_scale, max_imgpel_value);
+    return;
+  }
+
+  for (pel = 0; pel < PelNum; pel += 8, imgP += 8 * width)
+  {
+    __m128i t0, t1, t2, t3, u0, u1, u2, u3;
+
+    if (!chroma_lanes(Strength, PelNum, pel, ClipTab, bitdepth_scale, &bs, &tc))
+      continue;
+
+    // eight lines of P1 P0 Q0 Q1 -> four registers of eight lines
+    t0 = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *) (imgP - 1)), _mm_loadl_epi64((const __m128i *) (imgP + width - 1)));
+    t1 = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *) (imgP + 2 * width - 1)), _mm_loadl_epi64((const __m128i *) (imgP + 3 * width - 1)));
+    t2 = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *) (imgP + 4 * width - 1)), _mm_loadl_epi64((const __m128i *) (imgP + 5 * width - 1)));
+    t3 = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *) (imgP + 6 * width - 1)), _mm_loadl_epi64((const __m128i *) (imgP + 7 * width - 1)));
+    u0 = _mm_unpacklo_epi32(t0, t1);
+    u1 = _mm_unpackhi_epi32(t0, t1);
+    u2 = _mm_unpacklo_epi32(t2, t3);
+    u3 = _mm_unpackhi_epi32(t2, t3);
+    v[0] = _mm_unpacklo_epi64(u0, u2);
+    v[1] = _mm_unpackhi_epi64(u0, u2);
+    v[2] = _mm_unpacklo_epi64(u1, u3);
+    v[3] = _mm_unpackhi_epi64(u1, u3);
+
+    if (chroma_filter8(v, bs, tc, Alpha, Beta, max))
+    {
+      t0 = _mm_unpacklo_epi16(v[0], v[1]);
+      t1 = _mm_unpacklo_epi16(v[2], v[3]);
+      t2 = _mm_unpackhi_epi16(v[0], v[1]);
+      t3 = _mm_unpackhi_epi16(v[2], v[3]);
+      u0 = _mm_unpacklo_epi32(t0, t1);
+      u1 = _mm_unpackhi_epi32(t0, t1);
+      u2 = _mm_unpacklo_epi32(t2, t3);
+      u3 = _mm_unpackhi_epi32(t2, t3);
+      _mm_storel_epi64((__m128i *) (imgP - 1), u0);
+      _mm_storel_epi64((__m128i *) (imgP + width - 1), _mm_srli_si128(u0, 8));
+      _mm_storel_epi64((__m128i *) (imgP + 2 * width - 1), u1);
+      _mm_storel_epi64((__m128i *) (imgP + 3 * width - 1), _mm_srli_si128(u1, 8));
+      _mm_storel_epi64((__m128i *) (imgP + 4 * width - 1), u2);
+      _mm_storel_epi64((__m128i *) (imgP + 5 * width - 1), _mm_srli_si128(u2, 8));
+      _mm_storel_epi64((__m128i *) (imgP + 6 * width - 1), u3);
+      _mm_storel_epi64((__m128i *) (imgP + 7 * width - 1), _mm_srli_si128(u3, 8));
+    }
+  }
+}
+
+static void chroma_hor_edge_sse41(imgpel *imgP, int width, int PelNum, const byte *Strength, int Alpha, int Beta, const byte *ClipTab, int bitdepth_scale, int max_imgpel_value)
+{
+  __m128i max = _mm_set1_epi16((short) max_imgpel_value);
+  __m128i bs, tc, v[4];
+  int pel, i;
+
+  if (max_imgpel_value > SIMD_MAX_PEL_VALUE || (PelNum & 7))
+  {
+    fallback.chroma_hor(imgP, width, PelNum, Strength, Alpha, Beta, ClipTab, bitdepth_scale, max_imgpel_value);
+    return;
+  }
+
+  for (pel = 0; pel < PelNum; pel += 8, imgP += 8)
+  {
+    if (!chroma_lanes(Strength, PelNum, pel, ClipTab, bitdepth_scale, &bs, &tc))
+      continue;
+
+    for (i = 0; i < 4; ++i)
+      v[i] = _mm_loadu_si128((const __m128i *) (imgP + (i - 1) * width));
+
+    if (chroma_filter8(v, bs, tc, Alpha, Beta, max))
+    {
+      _mm_storeu_si128((__m128i *) imgP, v[1]);
+      _mm_storeu_si128((__m128i *) (imgP + width), v[2]);
+    }
+  }
+}
+
+//! per block bit mask of the lanes of cmp that are set, four 16 bit lanes per block
+static inline int block_bits(__m128i cmp01, __m128i cmp23)
+{
+  int bits = _mm_movemask_epi8(_mm_packs_epi16(cmp01, cmp23));
+  int i, res = 0;
+
+  for (i = 0; i < BLOCK_SIZE; ++i)
+    res |= ((bits >> (i << 2)) & 0x0F) ? (1 << i) : 0;
+  return res;
+}
+
+//! |a - b| >= thr per lane, for motion vector components
+static inline __m128i mv_differs(__m128i a, __m128i b, __m128i thr)
+{
+  __m128i d = _mm_abs_epi16(_mm_subs_epi16(a, b));
+  return _mm_cmpeq_epi16(_mm_max_epu16(d, thr), d);
+}
+
+static void mv_compare4_sse41(PicMotionParams **mv_p, PicMotionParams **mv_q, int mvlimit, int *straight, int *cross)
+{
+  __m128i thr = _mm_set_epi16((short) mvlimit, 4, (short) mvlimit, 4, (short) mvlimit, 4, (short) mvlimit, 4);
+  __m128i p01 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *) mv_p[0]->mv), _mm_loadl_epi64((const __m128i *) mv_p[1]->mv));
+  __m128i p23 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *) mv_p[2]->mv), _mm_loadl_epi64((const __m128i *) mv_p[3]->mv));
+  __m128i q01 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *) mv_q[0]->mv), _mm_loadl_epi64((const __m128i *) mv_q[1]->mv));
+  __m128i q23 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *) mv_q[2]->mv), _mm_loadl_epi64((const __m128i *) mv_q[3]->mv));
+
+  *straight = block_bits(mv_differs(p01, q01, thr), mv_differs(p23, q23, thr));
+
+  // swap the L0 and L1 vectors of q
+  q01 = _mm_shuffle_epi32(q01, _MM_SHUFFLE(2, 3, 0, 1));
+  q23 = _mm_shuffle_epi32(q23, _MM_SHUFFLE(2, 3, 0, 1));
+  *cross = block_bits(mv_differs(p01, q01, thr), mv_differs(p23, q23, thr));
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Installs the SSE4.1 kernels; the current ones are kept for the
+ *    cases the SIMD versions do not handle
+ ************************************************************************
+ */
+void init_deblock_kernels_sse41(DeblockKernels *kernels)
+{
+  fallback = *kernels;
+
+  kernels->luma_ver    = luma_ver_edge_sse41;
+  kernels->luma_hor    = luma_hor_edge_sse41;
+  kernels->chroma_ver  = chroma_ver_edge_sse41;
+  kernels->chroma_hor  = chroma_hor_edge_sse41;
+  kernels->mv_compare4 = mv_compare4_sse41;
+}
+
+#else
+
+void init_deblock_kernels_sse41(DeblockKernels *kernels)
+{
+}
+
+#endif
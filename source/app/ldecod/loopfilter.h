@@ -13,7 +13,12 @@
 #include "global.h"
 #include "mbuffer.h"
 
+typedef struct deblock_wavefront DeblockWavefront;
+
 extern void DeblockPicture(VideoParameters *p_Vid, StorablePicture *p) ;
+extern void DeblockMbRows (VideoParameters *p_Vid, StorablePicture *p, int first_row, int num_rows);
+extern void free_deblock_wavefront(DeblockWavefront *dw);
 
 void  init_Deblock(VideoParameters *p_Vid, int mb_aff_frame_flag);
+extern void init_deblock_kernels(int simd_level);
 #endif //_LOOPFILTER_H_
@@ -44,6 +44,8 @@
 #include "mb_prediction.h"
 #include "fast_memory.h"
 #include "filehandle.h"
+#include "se_trace.h"
+#include "mb_meta.h"
 
 
 #if TRACE
@@ -124,6 +126,7 @@ static char readRefPictureIdx_FLC(Macroblock *currMB, SyntaxElement *currSE, Dat
   currSE->len = 1;
   readSyntaxElement_FLC(currSE, dP->bitstream);
   currSE->value1 = 1 - currSE->value1;
+  trace_cavlc_se(currMB, currSE, dP);
 
   return (char) currSE->value1;
 }
@@ -657,6 +660,9 @@ Boolean exit_macroblock(Slice *currSlice, int eos_bit)
 // printf ("exit_macroblock: FmoGetLastMBOfPicture %d, p_Vid->current_mb_nr %d\n", FmoGetLastMBOfPicture(), p_Vid->current_mb_nr);
   ++(currSlice->num_dec_mb);
 
+  if (p_Vid->mb_meta != NULL)
+    put_mb_meta(currSlice, &currSlice->mb_data[currSlice->current_mb_nr]);
+
   if(currSlice->current_mb_nr == p_Vid->PicSizeInMbs - 1) //if (p_Vid->num_dec_mb == p_Vid->PicSizeInMbs)
   {
     return TRUE;
@@ -1197,11 +1203,11 @@ void check_dp_neighbors (Macroblock *currMB)
   {
     if (left.available)
     {
-      currMB->dpl_flag |= p_Vid->mb_data[left.mb_addr].dpl_flag;
+      currMB->dpl_flag |= currMB->p_Slice->mb_data[left.mb_addr].dpl_flag;
     }
     if (up.available)
     {
-      currMB->dpl_flag |= p_Vid->mb_data[up.mb_addr].dpl_flag;
+      currMB->dpl_flag |= currMB->p_Slice->mb_data[up.mb_addr].dpl_flag;
     }
   }
 }
@@ -1348,50 +1354,6 @@ static int decode_one_component_b_slice(Macroblock *currMB, ColorPlane curr_plan
  return 1;
 }
 
-// probably a better way (or place) to do this, but I'm not sure what (where) it is [CJV]
-// this is intended to make get_block_luma faster, but I'm still performing
-// this at the MB level, and it really should be done at the slice level
-static void init_cur_imgy(VideoParameters *p_Vid,Slice *currSlice,int pl)
-{
-  int i,j;
-  if (p_Vid->separate_colour_plane_flag == 0)
-  {
-    StorablePicture *vidref = p_Vid->no_reference_picture;
-    int noref = (currSlice->framepoc < p_Vid->recovery_poc);    
-    if (pl==PLANE_Y) 
-    {
-      for (j = 0; j < 6; j++)    // for (j = 0; j < (currSlice->slice_type==B_SLICE?2:1); j++) 
-      {
-        for (i = 0; i < currSlice->listXsize[j] ; i++) 
-        {
-          StorablePicture *curr_ref = currSlice->listX[j][i];
-          if (curr_ref) 
-          {
-            curr_ref->no_ref = noref && (curr_ref == vidref);
-            curr_ref->cur_imgY = curr_ref->imgY;
-          }
-        }
-      }
-    }
-    else 
-    {
-      for (j = 0; j < 6; j++)  //for (j = 0; j < (currSlice->slice_type==B_SLICE?2:1); j++)
-      {
-        for (i = 0; i < currSlice->listXsize[j]; i++) 
-        {
-          StorablePicture *curr_ref = currSlice->listX[j][i];
-          if (curr_ref) 
-          {
-            curr_ref->no_ref = noref && (curr_ref == vidref);
-            curr_ref->cur_imgY = curr_ref->imgUV[pl-1]; 
-          }
-        }
-      }
-    }
-  }
-}
-
-
 /*!
  ************************************************************************
  * \brief
@@ -1402,26 +1364,13 @@ static void init_cur_imgy(VideoParameters *p_Vid,Slice *currSlice,int pl)
 int decode_one_macroblock(Macroblock *currMB, StorablePicture *dec_picture)
 {
   Slice *currSlice = currMB->p_Slice;
-  VideoParameters *p_Vid = currMB->p_Vid;  
 
   // macroblock decoding **************************************************
   if (currSlice->chroma444_not_separate)  
   {
-    if (!currMB->is_intra_block)
-    {
-      init_cur_imgy(p_Vid, currSlice, PLANE_Y);
-      currSlice->decode_one_component(currMB, PLANE_Y, dec_picture->imgY, dec_picture);
-      init_cur_imgy(p_Vid, currSlice, PLANE_U);
-      currSlice->decode_one_component(currMB, PLANE_U, dec_picture->imgUV[0], dec_picture);
-      init_cur_imgy(p_Vid, currSlice, PLANE_V);
-      currSlice->decode_one_component(currMB, PLANE_V, dec_picture->imgUV[1], dec_picture);
-    }
-    else
-    {
-      currSlice->decode_one_component(currMB, PLANE_Y, dec_picture->imgY, dec_picture);
-      currSlice->decode_one_component(currMB, PLANE_U, dec_picture->imgUV[0], dec_picture);
-      currSlice->decode_one_component(currMB, PLANE_V, dec_picture->imgUV[1], dec_picture);      
-    }
+    currSlice->decode_one_component(currMB, PLANE_Y, dec_picture->imgY, dec_picture);
+    currSlice->decode_one_component(currMB, PLANE_U, dec_picture->imgUV[0], dec_picture);
+    currSlice->decode_one_component(currMB, PLANE_V, dec_picture->imgUV[1], dec_picture);
     currSlice->is_reset_coeff = FALSE;
     currSlice->is_reset_coeff_cr = FALSE;
   }
@@ -1455,6 +1404,7 @@ void change_plane_JV( VideoParameters *p_Vid, int nplane, Slice *pSlice)
     pSlice->mb_data = p_Vid->mb_data_JV[nplane];
     pSlice->dec_picture  = p_Vid->dec_picture_JV[nplane];
     pSlice->siblock = p_Vid->siblock_JV[nplane];
+    pSlice->nz_coeff = p_Vid->nz_coeff_JV[nplane];
     pSlice->ipredmode = p_Vid->ipredmode_JV[nplane];
     pSlice->intra_block = p_Vid->intra_block_JV[nplane];
   }
@@ -1469,27 +1419,22 @@ void change_plane_JV( VideoParameters *p_Vid, int nplane, Slice *pSlice)
  */
 void make_frame_picture_JV(VideoParameters *p_Vid)
 {
-  int uv, line;
+  int uv;
   int nsize;
   p_Vid->dec_picture = p_Vid->dec_picture_JV[0];
-  //copy;
+
+  // planes 1 and 2 were decoded into the frame (see alloc_colour_plane_picture),
+  // only the motion of plane 0 is kept separately
   if(p_Vid->dec_picture->used_for_reference) 
   {
     nsize = (p_Vid->dec_picture->size_y/BLOCK_SIZE)*(p_Vid->dec_picture->size_x/BLOCK_SIZE)*sizeof(PicMotionParams);
     memcpy( &(p_Vid->dec_picture->JVmv_info[PLANE_Y][0][0]), &(p_Vid->dec_picture_JV[PLANE_Y]->mv_info[0][0]), nsize);
-    memcpy( &(p_Vid->dec_picture->JVmv_info[PLANE_U][0][0]), &(p_Vid->dec_picture_JV[PLANE_U]->mv_info[0][0]), nsize);
-    memcpy( &(p_Vid->dec_picture->JVmv_info[PLANE_V][0][0]), &(p_Vid->dec_picture_JV[PLANE_V]->mv_info[0][0]), nsize);
   }
 
-  // This could be done with pointers and seems not necessary
   for( uv=0; uv<2; uv++ )
   {
-    for( line=0; line<p_Vid->height; line++ )
-    {
-      nsize = sizeof(imgpel) * p_Vid->width;
-      memcpy( p_Vid->dec_picture->imgUV[uv][line], p_Vid->dec_picture_JV[uv+1]->imgY[line], nsize );
-    }
-    free_storable_picture(p_Vid->dec_picture_JV[uv+1]);
+    free_colour_plane_picture(p_Vid->dec_picture_JV[uv+1]);
+    p_Vid->dec_picture_JV[uv+1] = NULL;
   }
 }
 
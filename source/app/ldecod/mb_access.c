@@ -31,6 +31,10 @@ Boolean mb_is_available(int mbAddr, Macroblock *currMB)
   // the following line checks both: slice number and if the mb has been decoded
   if (!currMB->DeblockCall)
   {
+    // slices decoded concurrently are contiguous, a neighbour belongs to the
+    // slice if it is not before its first macroblock
+    if (currSlice->decoded_in_parallel)
+      return (Boolean) (mbAddr >= (currSlice->start_mb_nr << currSlice->mb_aff_frame_flag));
     if (currSlice->mb_data[mbAddr].slice_nr != currMB->slice_nr)
       return FALSE;
   }
@@ -0,0 +1,193 @@
+
+/*!
+ *************************************************************************************
+ * \file mb_meta.c
+ *
+ * \brief
+ *    Per macroblock metadata written as column files (-mbmeta)
+ *
+ *    exit_macroblock() stores the fields of every parsed macroblock in the
+ *    columns of the current picture, the residual readers store the PLNZ
+ *    of its luma blocks and replaying the metadata extraction log marks
+ *    the blocks a bit was taken from. The columns are written once the
+ *    picture is decoded, one fwrite() per column and picture.
+ *
+ *************************************************************************************
+ */
+
+#include <stddef.h>
+
+#include "global.h"
+#include "memalloc.h"
+#include "mb_meta.h"
+
+typedef struct mb_meta_column
+{
+  const char *name;
+  int         value_size;
+  int         values_per_mb;
+  size_t      offset;              //!< of the column in MBMeta
+} MBMetaColumnInfo;
+
+static const MBMetaColumnInfo columns[MB_META_COLUMNS] =
+{
+  { "pic",          sizeof(uint32),  1, offsetof(MBMeta, pic)          },
+  { "frame_num",    sizeof(uint32),  1, offsetof(MBMeta, frame_num)    },
+  { "poc",          sizeof(int32),   1, offsetof(MBMeta, poc)          },
+  { "mb",           sizeof(uint32),  1, offsetof(MBMeta, mb)           },
+  { "slice",        sizeof(uint16),  1, offsetof(MBMeta, slice)        },
+  { "slice_type",   sizeof(byte),    1, offsetof(MBMeta, slice_type)   },
+  { "mb_type",      sizeof(byte),    1, offsetof(MBMeta, mb_type)      },
+  { "qp",           sizeof(char),    1, offsetof(MBMeta, qp)           },
+  { "cbp",          sizeof(byte),    1, offsetof(MBMeta, cbp)          },
+  { "transform8x8", sizeof(byte),    1, offsetof(MBMeta, transform8x8) },
+  { "plnz",         sizeof(byte),   16, offsetof(MBMeta, plnz)         },
+  { "payload_mask", sizeof(uint16),  1, offsetof(MBMeta, payload_mask) },
+  { "payload_bits", sizeof(uint16),  1, offsetof(MBMeta, payload_bits) }
+};
+
+static void **column_data(MBMeta *m, int c)
+{
+  return (void **) ((char *) m + columns[c].offset);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    creates the column files <prefix>.<column> and writes their headers
+ ************************************************************************
+ */
+MBMeta *open_mb_meta(const char *prefix)
+{
+  MBMeta *m = (MBMeta *) calloc(1, sizeof(MBMeta));
+  int c;
+
+  if (m == NULL)
+    no_mem_exit("open_mb_meta: m");
+
+  for (c = 0; c < MB_META_COLUMNS; ++c)
+  {
+    char filename[FILE_NAME_SIZE + 16];
+    MBMetaHeader header;
+
+    snprintf(filename, sizeof(filename), "%s.%s", prefix, columns[c].name);
+    if ((m->file[c] = fopen(filename, "wb")) == NULL)
+    {
+      snprintf(errortext, ET_SIZE, "Error open file %.*s for writing the macroblock metadata", ET_SIZE - 64, filename);
+      error(errortext, 500);
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MB_META_MAGIC, sizeof(header.magic));
+    header.value_size    = columns[c].value_size;
+    header.values_per_mb = columns[c].values_per_mb;
+    if (fwrite(&header, sizeof(header), 1, m->file[c]) != 1)
+      error ("open_mb_meta: error writing the macroblock metadata", 500);
+  }
+
+  return m;
+}
+
+void close_mb_meta(MBMeta *m)
+{
+  MemTag prev_tag = mem_set_tag(MEM_OUTPUT);
+  int c;
+
+  if (m != NULL)
+  {
+    for (c = 0; c < MB_META_COLUMNS; ++c)
+    {
+      fclose(m->file[c]);
+      mem_free(*column_data(m, c));
+    }
+    free(m);
+  }
+  mem_set_tag(prev_tag);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    clears the columns for a new picture of num_mbs macroblocks
+ ************************************************************************
+ */
+void start_mb_meta_picture(MBMeta *m, int num_mbs)
+{
+  int c, i;
+
+  if (num_mbs > m->size)
+  {
+    MemTag prev_tag = mem_set_tag(MEM_OUTPUT);
+
+    for (c = 0; c < MB_META_COLUMNS; ++c)
+    {
+      void **data = column_data(m, c);
+
+      mem_free(*data);
+      *data = mem_malloc(num_mbs * columns[c].value_size * columns[c].values_per_mb);
+    }
+    m->size = num_mbs;
+    mem_set_tag(prev_tag);
+  }
+  m->num_mbs = num_mbs;
+
+  for (c = MB_META_SLICE_TYPE; c < MB_META_COLUMNS; ++c)
+    memset(*column_data(m, c), 0, num_mbs * columns[c].value_size * columns[c].values_per_mb);
+  for (i = 0; i < num_mbs; ++i)
+  {
+    m->mb[i]    = i;
+    m->slice[i] = 0xFFFF;
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    stores the fields of a macroblock once it is parsed
+ ************************************************************************
+ */
+void put_mb_meta(Slice *currSlice, Macroblock *currMB)
+{
+  MBMeta *m = currSlice->p_Vid->mb_meta;
+  int mb = currMB->mbAddrX;
+
+  if (currSlice->colour_plane_id != PLANE_Y)
+    return;
+
+  m->slice[mb]        = (uint16) currSlice->current_slice_nr;
+  m->slice_type[mb]   = (byte) currSlice->slice_type;
+  m->mb_type[mb]      = (byte) currMB->mb_type;
+  m->qp[mb]           = (signed char) currMB->qp;
+  m->cbp[mb]          = (byte) currMB->cbp;
+  m->transform8x8[mb] = (byte) currMB->luma_transform_size_8x8_flag;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    writes the columns of the decoded picture, after the metadata
+ *    extraction log of its slices is replayed
+ ************************************************************************
+ */
+void end_mb_meta_picture(VideoParameters *p_Vid)
+{
+  MBMeta *m = p_Vid->mb_meta;
+  Slice *currSlice = p_Vid->ppSliceList[0];
+  int c, i;
+
+  for (i = 0; i < m->num_mbs; ++i)
+  {
+    m->pic[i]       = m->num_pics;
+    m->frame_num[i] = currSlice->frame_num;
+    m->poc[i]       = currSlice->ThisPOC;
+  }
+
+  for (c = 0; c < MB_META_COLUMNS; ++c)
+  {
+    size_t n = (size_t) m->num_mbs * columns[c].values_per_mb;
+
+    if (fwrite(*column_data(m, c), columns[c].value_size, n, m->file[c]) != n)
+      error ("end_mb_meta_picture: error writing the macroblock metadata", 500);
+  }
+  ++m->num_pics;
+}
@@ -0,0 +1,110 @@
+
+/*!
+ *************************************************************************************
+ * \file mb_meta.h
+ *
+ * \brief
+ *    Per macroblock metadata written as column files (-mbmeta)
+ *
+ *    Every column is a file <prefix>.<name> that starts with an
+ *    MBMetaHeader followed by the values of one macroblock after the other,
+ *    all macroblocks of a picture in address order and the pictures in
+ *    decoding order. The values are in the byte order of the decoding
+ *    machine, so the files can be mapped and used as arrays.
+ *
+ *    column        type      per macroblock
+ *    pic           uint32    picture in decoding order, counting from 0
+ *    frame_num     uint32    frame_num of the picture
+ *    poc           int32     POC of the picture (of the field for field pictures)
+ *    mb            uint32    macroblock address
+ *    slice         uint16    slice of the picture, 0xFFFF if the macroblock was not decoded
+ *    slice_type    uint8     P_SLICE ... SI_SLICE
+ *    mb_type       uint8     mb_type of ldecod (PSKIP ... IPCM, see defines.h)
+ *    qp            int8      QP luma
+ *    cbp           uint8     coded_block_pattern
+ *    transform8x8  uint8     transform_size_8x8_flag
+ *    plnz          16 uint8  position of the last nonzero coefficient of the luma 4x4 blocks in
+ *                            raster order, as used by the metadata extraction, 0 for 8x8 transform
+ *                            and lossless blocks
+ *    payload_mask  uint16    luma 4x4 blocks (bit 0: top left) a metadata bit was extracted from
+ *    payload_bits  uint16    values of these bits
+ *
+ *************************************************************************************
+ */
+
+#ifndef _MB_META_H_
+#define _MB_META_H_
+
+#include "global.h"
+
+#define MB_META_MAGIC  "JMMBCOL1"
+
+typedef enum {
+  MB_META_PIC = 0,
+  MB_META_FRAME_NUM,
+  MB_META_POC,
+  MB_META_MB,
+  MB_META_SLICE,
+  MB_META_SLICE_TYPE,
+  MB_META_MB_TYPE,
+  MB_META_QP,
+  MB_META_CBP,
+  MB_META_TRANSFORM8x8,
+  MB_META_PLNZ,
+  MB_META_PAYLOAD_MASK,
+  MB_META_PAYLOAD_BITS,
+  MB_META_COLUMNS
+} MBMetaColumn;
+
+typedef struct mb_meta_header
+{
+  char   magic[8];                 //!< MB_META_MAGIC without the terminating zero
+  uint32 value_size;               //!< bytes of a value
+  uint32 values_per_mb;            //!< 16 for plnz, 1 for the other columns
+} MBMetaHeader;
+
+//! columns of the current picture, written at its end
+typedef struct mb_meta
+{
+  FILE   *file[MB_META_COLUMNS];
+  uint32  num_pics;                //!< pictures written
+  int     size;                    //!< macroblocks the columns have room for
+  int     num_mbs;                 //!< macroblocks of the current picture
+  uint32 *pic;
+  uint32 *frame_num;
+  int32  *poc;
+  uint32 *mb;
+  uint16 *slice;
+  byte   *slice_type;
+  byte   *mb_type;
+  signed char *qp;
+  byte   *cbp;
+  byte   *transform8x8;
+  byte   *plnz;
+  uint16 *payload_mask;
+  uint16 *payload_bits;
+} MBMeta;
+
+extern MBMeta *open_mb_meta         (const char *prefix);
+extern void    close_mb_meta        (MBMeta *m);
+extern void    start_mb_meta_picture(MBMeta *m, int num_mbs);
+extern void    put_mb_meta          (Slice *currSlice, Macroblock *currMB);
+extern void    end_mb_meta_picture  (VideoParameters *p_Vid);
+
+/*!
+ ************************************************************************
+ * \brief
+ *    PLNZ of the luma 4x4 blocks of currMB to be filled while reading
+ *    its residual, NULL if they are not exported
+ ************************************************************************
+ */
+static inline byte *get_mb_meta_plnz(Macroblock *currMB, ColorPlane pl)
+{
+  MBMeta *m = currMB->p_Vid->mb_meta;
+
+  if (m == NULL || pl != PLANE_Y || currMB->p_Slice->colour_plane_id != PLANE_Y)
+    return NULL;
+  return &m->plnz[currMB->mbAddrX * 16];
+}
+
+#endif
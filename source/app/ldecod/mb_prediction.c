@@ -1264,18 +1264,6 @@ int mb_pred_ipcm(Macroblock *currMB)
   // for deblocking filter
   update_qp(currMB, 0);
 
-  // for CAVLC: Set the nz_coeff to 16.
-  // These parameters are to be used in CAVLC decoding of neighbour blocks  
-  memset(p_Vid->nz_coeff[currMB->mbAddrX][0][0], 16, 3 * BLOCK_PIXELS * sizeof(byte));
-
-  // for CABAC decoding of MB skip flag
-  currMB->skip_flag = 0;
-
-  //for deblocking filter CABAC
-  currMB->s_cbp[0].blk = 0xFFFF;
-
-  //For CABAC decoding of Dquant
-  currSlice->last_dquant = 0;
   currSlice->is_reset_coeff = FALSE;
   currSlice->is_reset_coeff_cr = FALSE;
   return 1;
@@ -44,6 +44,7 @@
 #include "mb_prediction.h"
 #include "fast_memory.h"
 #include "filehandle.h"
+#include "se_trace.h"
 
 #if TRACE
 #define TRACE_STRING(s) strncpy(currSE.tracestring, s, TRACESTRING_SIZE)
@@ -99,7 +100,10 @@ static void read_ipred_8x8_modes_mbaff(Macroblock *currMB)
     bi = currMB->block_x + bx;
     //get from stream
     if (p_Vid->active_pps->entropy_coding_mode_flag == (Boolean) CAVLC || dP->bitstream->ei_flag)
+    {
       readSyntaxElement_Intra4x4PredictionMode(&currSE, dP->bitstream);
+      trace_cavlc_se(currMB, &currSE, dP);
+    }
     else
     {
       currSE.context = (b8 << 2);
@@ -179,7 +183,10 @@ static void read_ipred_8x8_modes(Macroblock *currMB)
 
     //get from stream
     if (p_Vid->active_pps->entropy_coding_mode_flag == (Boolean) CAVLC || dP->bitstream->ei_flag)
+    {
       readSyntaxElement_Intra4x4PredictionMode(&currSE, dP->bitstream);
+      trace_cavlc_se(currMB, &currSE, dP);
+    }
     else
     {
       currSE.context = (b8 << 2);
@@ -258,7 +265,10 @@ static void read_ipred_4x4_modes_mbaff(Macroblock *currMB)
         bi = currMB->block_x + bx;
         //get from stream
         if (p_Vid->active_pps->entropy_coding_mode_flag == (Boolean) CAVLC || dP->bitstream->ei_flag)
+        {
           readSyntaxElement_Intra4x4PredictionMode(&currSE, dP->bitstream);
+          trace_cavlc_se(currMB, &currSE, dP);
+        }
         else
         {
           currSE.context=(b8<<2) + (j<<1) +i;
@@ -350,7 +360,10 @@ static void read_ipred_4x4_modes(Macroblock *currMB)
         bi = currMB->block_x + bx;
         //get from stream
         if (p_Vid->active_pps->entropy_coding_mode_flag == (Boolean) CAVLC || dP->bitstream->ei_flag)
+        {
           readSyntaxElement_Intra4x4PredictionMode(&currSE, dP->bitstream);
+          trace_cavlc_se(currMB, &currSE, dP);
+        }
         else
         {
           currSE.context=(b8<<2) + (j<<1) +i;
@@ -716,7 +729,7 @@ static inline void reset_coeffs(Macroblock *currMB)
 
   // CAVLC
   if (p_Vid->active_pps->entropy_coding_mode_flag == (Boolean) CAVLC)
-    fast_memset(p_Vid->nz_coeff[currMB->mbAddrX][0][0], 0, 3 * BLOCK_PIXELS * sizeof(byte));
+    fast_memset(currMB->p_Slice->nz_coeff[currMB->mbAddrX][0][0], 0, 3 * BLOCK_PIXELS * sizeof(byte));
 }
 
 static inline void field_flag_inference(Macroblock *currMB)
@@ -923,6 +936,7 @@ static void read_intra4x4_macroblock_cavlc(Macroblock *currMB, const byte *partM
     // read CAVLC transform_size_8x8_flag
     currSE.len = (int64) 1;
     readSyntaxElement_FLC(&currSE, dP->bitstream);
+    trace_cavlc_se(currMB, &currSE, dP);
 
     currMB->luma_transform_size_8x8_flag = (Boolean) currSE.value1;
 
@@ -1061,6 +1075,22 @@ static void read_i_pcm_macroblock(Macroblock *currMB, const byte *partMap)
     DataPartition *dP = &(currSlice->partArr[partMap[SE_LUM_DC_INTRA]]);
     read_IPCM_coeffs_from_NAL(currSlice, dP);
   }
+
+  // The syntax state of the following macroblocks is set here rather than
+  // in mb_pred_ipcm(), so that parsing does not depend on reconstruction
+
+  // for CAVLC: Set the nz_coeff to 16.
+  // These parameters are to be used in CAVLC decoding of neighbour blocks  
+  memset(currMB->p_Slice->nz_coeff[currMB->mbAddrX][0][0], 16, 3 * BLOCK_PIXELS * sizeof(byte));
+
+  // for CABAC decoding of MB skip flag
+  currMB->skip_flag = 0;
+
+  //for deblocking filter CABAC
+  currMB->s_cbp[0].blk = 0xFFFF;
+
+  //For CABAC decoding of Dquant
+  currSlice->last_dquant = 0;
 }
 
 /*!
@@ -1120,7 +1150,7 @@ static void read_one_macroblock_i_slice_cavlc(Macroblock *currMB)
   StorablePicture *dec_picture = currSlice->dec_picture; 
   PicMotionParamsOld *motion = &dec_picture->motion;
 
-  currMB->mb_field = ((mb_nr&0x01) == 0)? FALSE : currSlice->mb_data[mb_nr-1].mb_field; 
+  currMB->mb_field = ((mb_nr&0x01) == 0 || !currSlice->mb_aff_frame_flag)? FALSE : currSlice->mb_data[mb_nr-1].mb_field; 
 
   update_qp(currMB, currSlice->qp);
   currSE.type = SE_MBTYPE;
@@ -1136,6 +1166,7 @@ static void read_one_macroblock_i_slice_cavlc(Macroblock *currMB)
     TRACE_STRING("mb_field_decoding_flag");
     currSE.len = (int64) 1;
     readSyntaxElement_FLC(&currSE, dP->bitstream);
+    trace_cavlc_se(currMB, &currSE, dP);
     currMB->mb_field = (Boolean) currSE.value1;
   }
 
@@ -1191,7 +1222,7 @@ static void read_one_macroblock_i_slice_cabac(Macroblock *currMB)
   StorablePicture *dec_picture = currSlice->dec_picture; 
   PicMotionParamsOld *motion = &dec_picture->motion;
 
-  currMB->mb_field = ((mb_nr&0x01) == 0)? FALSE : currSlice->mb_data[mb_nr-1].mb_field; 
+  currMB->mb_field = ((mb_nr&0x01) == 0 || !currSlice->mb_aff_frame_flag)? FALSE : currSlice->mb_data[mb_nr-1].mb_field; 
 
   update_qp(currMB, currSlice->qp);
   currSE.type = SE_MBTYPE;
@@ -1409,6 +1440,7 @@ static void read_one_macroblock_p_slice_cavlc(Macroblock *currMB)
         TRACE_STRING("mb_field_decoding_flag");
         currSE.len = (int64) 1;
         readSyntaxElement_FLC(&currSE, dP->bitstream);
+        trace_cavlc_se(currMB, &currSE, dP);
         currMB->mb_field = (Boolean) currSE.value1;
       }
 
@@ -1806,6 +1838,7 @@ static void read_one_macroblock_b_slice_cavlc(Macroblock *currMB)
         TRACE_STRING("mb_field_decoding_flag");
         currSE.len = (int64) 1;
         readSyntaxElement_FLC(&currSE, dP->bitstream);
+        trace_cavlc_se(currMB, &currSE, dP);
         currMB->mb_field = (Boolean) currSE.value1;
       }
 
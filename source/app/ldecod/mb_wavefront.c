@@ -0,0 +1,336 @@
+
+/*!
+ *************************************************************************************
+ * \file mb_wavefront.c
+ *
+ * \brief
+ *    Reconstruction of the macroblock rows of a slice in a wavefront
+ *
+ *    The macroblocks of a slice are parsed in order by one job. The parsed
+ *    coefficients of each macroblock are kept in a ring of syntax slots
+ *    and every macroblock row is reconstructed by a job of its own, which
+ *    stays two macroblocks behind the row above. This satisfies the intra
+ *    prediction dependencies on the left, upper left, upper and upper right
+ *    neighbours.
+ *
+ *    B_Skip and B_Direct_16x16 macroblocks derive their motion vectors while
+ *    they are reconstructed and the following macroblocks predict their
+ *    motion vectors from them, so the parsing job reconstructs those itself.
+ *
+ *    With row deblocking the job of a row deblocks the row above once its
+ *    own row is complete, after the job of the row above has deblocked the
+ *    row before that.
+ *
+ *************************************************************************************
+ */
+
+#include <limits.h>
+
+#include "global.h"
+#include "memalloc.h"
+#include "image.h"
+#include "macroblock.h"
+#include "mc_prediction.h"
+#include "thread_pool.h"
+#include "mb_wavefront.h"
+
+#define PARSING_DONE INT_MAX   //!< value of the parsed counter after the last macroblock of the slice
+
+struct mb_wavefront
+{
+  int             width;          //!< macroblocks per row
+  int             height;         //!< macroblock rows per frame
+  int             num_slots;      //!< macroblocks whose syntax can be buffered
+  int          ****slot_cof;      //!< coefficients of the buffered macroblocks [slot][pl][y][x]
+  int          ****slot_rres;     //!< 8x8 residuals of the buffered macroblocks [slot][pl][y][x]
+  int            *slot_qp;        //!< slice qp after parsing the buffered macroblock
+  byte           *slot_done;      //!< buffered macroblock already reconstructed by the parsing job
+  int             num_row_slices;
+  Slice         **row_slice;      //!< prediction and reconstruction buffers of the row jobs
+  ThreadProgress  parsed;         //!< number of parsed macroblocks
+  ThreadProgress *row_done;       //!< number of reconstructed macroblocks of every row
+  ThreadProgress  rows_finished;  //!< rows whose job is done with the row deblocking
+
+  Slice          *currSlice;      //!< slice being decoded
+  int             num_rows;       //!< macroblock rows of the current picture
+  int             num_parsed;     //!< macroblocks of the slice, valid once parsing is done
+};
+
+static Slice *alloc_row_slice(void)
+{
+  Slice *rowSlice = (Slice *) mem_calloc(1, sizeof(Slice));
+
+  get_mem3Dpel(&rowSlice->mb_pred, MAX_PLANE, MB_BLOCK_SIZE, MB_BLOCK_SIZE);
+  get_mem3Dpel(&rowSlice->mb_rec , MAX_PLANE, MB_BLOCK_SIZE, MB_BLOCK_SIZE);
+  allocate_pred_mem(rowSlice);
+
+  return rowSlice;
+}
+
+static void free_row_slice(Slice *rowSlice)
+{
+  free_pred_mem(rowSlice);
+  free_mem3Dpel(rowSlice->mb_rec);
+  free_mem3Dpel(rowSlice->mb_pred);
+  mem_free(rowSlice);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    allocates the syntax slots and row buffers for pictures of the
+ *    given size
+ ************************************************************************
+ */
+static MBWavefront *create_mb_wavefront(int width, int height, int num_threads)
+{
+  MBWavefront *wf = (MBWavefront *) calloc(1, sizeof(MBWavefront));
+  MemTag prev_tag;
+  int i;
+
+  if (wf == NULL)
+    no_mem_exit("create_mb_wavefront: wf");
+  prev_tag = mem_set_tag(MEM_SLICE);
+
+  wf->width  = width;
+  wf->height = height;
+  // enough rows for every thread and one row of parsing lead
+  wf->num_slots = width * (num_threads + 1);
+
+  get_mem4Dint(&wf->slot_cof,  wf->num_slots, MAX_PLANE, MB_BLOCK_SIZE, MB_BLOCK_SIZE);
+  get_mem4Dint(&wf->slot_rres, wf->num_slots, MAX_PLANE, MB_BLOCK_SIZE, MB_BLOCK_SIZE);
+  if ((wf->slot_qp = (int *) calloc(wf->num_slots, sizeof(int))) == NULL)
+    no_mem_exit("create_mb_wavefront: slot_qp");
+  if ((wf->slot_done = (byte *) calloc(wf->num_slots, sizeof(byte))) == NULL)
+    no_mem_exit("create_mb_wavefront: slot_done");
+
+  wf->num_row_slices = num_threads;
+  if ((wf->row_slice = (Slice **) calloc(num_threads, sizeof(Slice *))) == NULL)
+    no_mem_exit("create_mb_wavefront: row_slice");
+  for (i = 0; i < num_threads; ++i)
+    wf->row_slice[i] = alloc_row_slice();
+
+  init_thread_progress(&wf->parsed, 0);
+  init_thread_progress(&wf->rows_finished, 0);
+  if ((wf->row_done = (ThreadProgress *) calloc(height, sizeof(ThreadProgress))) == NULL)
+    no_mem_exit("create_mb_wavefront: row_done");
+  for (i = 0; i < height; ++i)
+    init_thread_progress(&wf->row_done[i], 0);
+  mem_set_tag(prev_tag);
+
+  return wf;
+}
+
+void free_mb_wavefront(MBWavefront *wf)
+{
+  MemTag prev_tag;
+  int i;
+
+  if (wf == NULL)
+    return;
+
+  for (i = 0; i < wf->height; ++i)
+    free_thread_progress(&wf->row_done[i]);
+  free(wf->row_done);
+  free_thread_progress(&wf->rows_finished);
+  free_thread_progress(&wf->parsed);
+
+  prev_tag = mem_set_tag(MEM_SLICE);
+  for (i = 0; i < wf->num_row_slices; ++i)
+    free_row_slice(wf->row_slice[i]);
+  free(wf->row_slice);
+
+  free(wf->slot_done);
+  free(wf->slot_qp);
+  free_mem4Dint(wf->slot_rres);
+  free_mem4Dint(wf->slot_cof);
+  mem_set_tag(prev_tag);
+  free(wf);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    returns whether the macroblock has to be reconstructed before the
+ *    next one is parsed
+ ************************************************************************
+ */
+static int reconstructed_by_parser(Macroblock *currMB)
+{
+  return currMB->p_Slice->slice_type == B_SLICE && currMB->mb_type == BSKIP_DIRECT;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    parses the macroblocks of the slice into the syntax slots
+ ************************************************************************
+ */
+static void parse_slice_macroblocks(MBWavefront *wf)
+{
+  Slice *currSlice = wf->currSlice;
+  Boolean end_of_slice = FALSE;
+  Macroblock *currMB = NULL;
+  int num_parsed = 0;
+
+  currSlice->cod_counter = -1;
+
+  while (end_of_slice == FALSE)
+  {
+    int mb_nr = currSlice->current_mb_nr;
+    int slot  = mb_nr % wf->num_slots;
+
+    // the macroblock that used the slot before has to be reconstructed
+    if (mb_nr >= wf->num_slots)
+    {
+      int prev_nr = mb_nr - wf->num_slots;
+      wait_thread_progress(&wf->row_done[prev_nr / wf->width], prev_nr % wf->width + 1);
+    }
+
+#if TRACE
+    fprintf(p_Dec->p_trace,"\n*********** POC: %i (I/P) MB: %i Slice: %i Type %d **********\n", currSlice->ThisPOC, currSlice->current_mb_nr, currSlice->current_slice_nr, currSlice->slice_type);
+#endif
+
+    currSlice->cof     = wf->slot_cof[slot];
+    currSlice->mb_rres = wf->slot_rres[slot];
+    currSlice->is_reset_coeff    = FALSE;
+    currSlice->is_reset_coeff_cr = FALSE;
+
+    start_macroblock(currSlice, &currMB);
+    currSlice->read_one_macroblock(currMB);
+
+    wf->slot_qp[slot]   = currSlice->qp;
+    wf->slot_done[slot] = (byte) reconstructed_by_parser(currMB);
+    if (wf->slot_done[slot])
+      decode_one_macroblock(currMB, currSlice->dec_picture);
+
+    end_of_slice = exit_macroblock(currSlice, 1);
+    set_thread_progress(&wf->parsed, ++num_parsed);
+  }
+
+  wf->num_parsed = num_parsed;
+  set_thread_progress(&wf->parsed, PARSING_DONE);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    reconstructs one macroblock row from the syntax slots
+ ************************************************************************
+ */
+static void reconstruct_mb_row(MBWavefront *wf, int row)
+{
+  Slice *currSlice = wf->currSlice;
+  // rows finish in order, so the rows in flight never share a buffer
+  Slice *rowSlice  = wf->row_slice[row % wf->num_row_slices];
+  int width = wf->width;
+  int x;
+
+  for (x = 0; x < width; ++x)
+  {
+    int mb_nr = row * width + x;
+    int slot  = mb_nr % wf->num_slots;
+
+    if (wait_thread_progress(&wf->parsed, mb_nr + 1) == PARSING_DONE && mb_nr >= wf->num_parsed)
+      break;
+    if (row > 0)
+      wait_thread_progress(&wf->row_done[row - 1], imin(x + 2, width));
+
+    if (!wf->slot_done[slot])
+    {
+      Macroblock *currMB = &currSlice->mb_data[mb_nr];
+
+      rowSlice->cof           = wf->slot_cof[slot];
+      rowSlice->mb_rres       = wf->slot_rres[slot];
+      rowSlice->qp            = wf->slot_qp[slot];
+      rowSlice->current_mb_nr = mb_nr;
+
+      currMB->p_Slice = rowSlice;
+      decode_one_macroblock(currMB, rowSlice->dec_picture);
+      currMB->p_Slice = currSlice;
+    }
+    set_thread_progress(&wf->row_done[row], x + 1);
+  }
+
+  set_thread_progress(&wf->row_done[row], width);
+
+  // the rows below are incomplete too if this one is
+  if (x == width && currSlice->p_Vid->row_deblock.active)
+  {
+    wait_thread_progress(&wf->rows_finished, row);
+    deblock_reconstructed_rows(currSlice->p_Vid, row + 1);
+    set_thread_progress(&wf->rows_finished, row + 1);
+  }
+}
+
+static void wavefront_job(void *arg, int job)
+{
+  MBWavefront *wf = (MBWavefront *) arg;
+
+  if (job == 0)
+    parse_slice_macroblocks(wf);
+  else
+    reconstruct_mb_row(wf, job - 1);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    copies the slice into a row buffer, keeping the buffer's own
+ *    prediction and reconstruction memory
+ ************************************************************************
+ */
+static void init_row_slice(Slice *rowSlice, Slice *currSlice)
+{
+  Slice scratch = *rowSlice;
+
+  *rowSlice = *currSlice;
+  rowSlice->mb_pred      = scratch.mb_pred;
+  rowSlice->mb_rec       = scratch.mb_rec;
+  rowSlice->tmp_block_l0 = scratch.tmp_block_l0;
+  rowSlice->tmp_block_l1 = scratch.tmp_block_l1;
+  rowSlice->tmp_block_l2 = scratch.tmp_block_l2;
+  rowSlice->tmp_block_l3 = scratch.tmp_block_l3;
+  rowSlice->tmp_res      = scratch.tmp_res;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    parses a slice that starts the picture and reconstructs its
+ *    macroblock rows on the thread pool. The slice has to be set up for
+ *    macroblock decoding and must not be MBAFF or use slice groups.
+ ************************************************************************
+ */
+void decode_slice_wavefront(Slice *currSlice)
+{
+  VideoParameters *p_Vid = currSlice->p_Vid;
+  MBWavefront *wf = p_Vid->mb_wavefront;
+  int num_threads = thread_pool_size(p_Vid->thread_pool);
+  int ***cof     = currSlice->cof;
+  int ***mb_rres = currSlice->mb_rres;
+  int i;
+
+  if (wf == NULL || wf->width != (int) p_Vid->PicWidthInMbs || wf->height != (int) p_Vid->FrameHeightInMbs || wf->num_row_slices != num_threads)
+  {
+    free_mb_wavefront(wf);
+    wf = p_Vid->mb_wavefront = create_mb_wavefront(p_Vid->PicWidthInMbs, p_Vid->FrameHeightInMbs, num_threads);
+  }
+
+  wf->currSlice = currSlice;
+  wf->num_rows  = p_Vid->PicSizeInMbs / wf->width;
+  wf->num_parsed = 0;
+  set_thread_progress(&wf->parsed, 0);
+  set_thread_progress(&wf->rows_finished, 0);
+  for (i = 0; i < wf->num_rows; ++i)
+    set_thread_progress(&wf->row_done[i], 0);
+  for (i = 0; i < wf->num_row_slices; ++i)
+    init_row_slice(wf->row_slice[i], currSlice);
+
+  run_thread_jobs(p_Vid->thread_pool, wavefront_job, wf, wf->num_rows + 1);
+
+  currSlice->cof     = cof;
+  currSlice->mb_rres = mb_rres;
+  currSlice->is_reset_coeff    = FALSE;
+  currSlice->is_reset_coeff_cr = FALSE;
+}
@@ -0,0 +1,22 @@
+
+/*!
+ *************************************************************************************
+ * \file mb_wavefront.h
+ *
+ * \brief
+ *    Reconstruction of the macroblock rows of a slice in a wavefront
+ *
+ *************************************************************************************
+ */
+
+#ifndef _MB_WAVEFRONT_H_
+#define _MB_WAVEFRONT_H_
+
+#include "global.h"
+
+typedef struct mb_wavefront MBWavefront;
+
+extern void decode_slice_wavefront(Slice *currSlice);
+extern void free_mb_wavefront     (MBWavefront *wf);
+
+#endif
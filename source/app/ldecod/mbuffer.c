@@ -30,6 +30,7 @@
 #include "memalloc.h"
 #include "output.h"
 #include "mbuffer_mvc.h"
+#include "frame_pipeline.h"
 #include "fast_memory.h"
 #include "input.h"
 
@@ -500,65 +501,213 @@ FrameStore* alloc_frame_store(void)
 
 void alloc_pic_motion(PicMotionParamsOld *motion, int size_y, int size_x)
 {
-  motion->mb_field = calloc (size_y * size_x, sizeof(byte));
-  if (motion->mb_field == NULL)
-    no_mem_exit("alloc_storable_picture: motion->mb_field");
+  MemTag prev_tag = mem_set_tag(MEM_MOTION);
+
+  motion->mb_field = mem_calloc (size_y * size_x, sizeof(byte));
+  mem_set_tag(prev_tag);
 }
 
 /*!
  ************************************************************************
  * \brief
- *    Allocate memory for a stored picture.
- *
- * \param p_Vid
- *    VideoParameters
- * \param structure
- *    picture structure
- * \param size_x
- *    horizontal luma size
- * \param size_y
- *    vertical luma size
- * \param size_x_cr
- *    horizontal chroma size
- * \param size_y_cr
- *    vertical chroma size
+ *    Allocate the sample planes, motion arrays and field reference
+ *    lists of a new stored picture (size_y already halved for fields).
+ *    Field views (own_planes == 0) only get the row pointers of their
+ *    planes.
+ ************************************************************************
+ */
+static void alloc_picture_memory(VideoParameters *p_Vid, StorablePicture *s, PictureStructure structure, int size_x, int size_y, int size_x_cr, int size_y_cr, int own_planes)
+{
+  seq_parameter_set_rbsp_t *active_sps = p_Vid->active_sps;
+  MemTag prev_tag = mem_set_tag(MEM_DPB);
+  int   nplane;
+
+  if (own_planes)
+    get_pic_plane(&s->plane[0], size_y, size_x, p_Vid->iLumaPadY, p_Vid->iLumaPadX);
+  else
+    get_pic_plane_rows(&s->plane[0], size_y, p_Vid->iLumaPadY >> 1);
+  s->imgY = s->plane[0].rows;
+
+  if (active_sps->chroma_format_idc != YUV400)
+  {
+    for (nplane = PLANE_U; nplane <= PLANE_V; nplane++)
+    {
+      if (own_planes)
+        get_pic_plane(&s->plane[nplane], size_y_cr, size_x_cr, p_Vid->iChromaPadY, p_Vid->iChromaPadX);
+      else
+        get_pic_plane_rows(&s->plane[nplane], size_y_cr, p_Vid->iChromaPadY >> 1);
+    }
+    s->imgUV = (imgpel ***) mem_malloc(2 * sizeof(imgpel **));
+    s->imgUV[0] = s->plane[1].rows;
+    s->imgUV[1] = s->plane[2].rows;
+  }
+
+  mem_set_tag(MEM_MOTION);
+  get_mem2Dmp     ( &s->mv_info, (size_y >> BLOCK_SHIFT), (size_x >> BLOCK_SHIFT));
+  alloc_pic_motion( &s->motion , (size_y >> BLOCK_SHIFT), (size_x >> BLOCK_SHIFT));
+
+  if( (p_Vid->separate_colour_plane_flag != 0) )
+  {
+    for( nplane=0; nplane<MAX_PLANE; nplane++ )
+    {
+      get_mem2Dmp      (&s->JVmv_info[nplane], (size_y >> BLOCK_SHIFT), (size_x >> BLOCK_SHIFT));
+      alloc_pic_motion(&s->JVmotion[nplane] , (size_y >> BLOCK_SHIFT), (size_x >> BLOCK_SHIFT));
+    }
+  }
+  mem_set_tag(MEM_DPB);
+
+  if(!active_sps->frame_mbs_only_flag && structure != FRAME)
+  {
+    int i, j;
+    for(j = 0; j < MAX_NUM_SLICES; j++)
+    {
+      for (i = 0; i < 2; i++)
+      {
+        s->listX[j][i] = mem_calloc(MAX_LIST_SIZE, sizeof (StorablePicture*)); // +1 for reordering
+      }
+    }
+  }
+  mem_set_tag(prev_tag);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Returns whether a pooled picture was allocated with the layout
+ *    alloc_picture_memory() would give a new one.
+ ************************************************************************
+ */
+static int pooled_picture_fits(VideoParameters *p_Vid, StorablePicture *s, PictureStructure structure, int size_x, int size_y, int size_x_cr, int size_y_cr, int own_planes)
+{
+  seq_parameter_set_rbsp_t *active_sps = p_Vid->active_sps;
+
+  return ((s->plane[0].mem != NULL) == own_planes
+    && s->size_x == size_x && s->size_y == size_y && s->size_x_cr == size_x_cr && s->size_y_cr == size_y_cr
+    && s->iLumaPadX == p_Vid->iLumaPadX && s->iLumaPadY == p_Vid->iLumaPadY
+    && s->iChromaPadX == p_Vid->iChromaPadX && s->iChromaPadY == p_Vid->iChromaPadY
+    && s->separate_colour_plane_flag == p_Vid->separate_colour_plane_flag
+    && (s->imgUV != NULL) == (active_sps->chroma_format_idc != YUV400)
+    && (s->listX[0][0] != NULL) == (!active_sps->frame_mbs_only_flag && structure != FRAME));
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Takes the most recently released picture of matching layout out of
+ *    the pool and resets it to the state of a new allocation. The motion
+ *    arrays are zeroed; the sample planes only if clear_planes is set.
  *
  * \return
- *    the allocated StorablePicture structure
+ *    the recycled picture or NULL if the pool holds none that fits
  ************************************************************************
  */
-StorablePicture* alloc_storable_picture(VideoParameters *p_Vid, PictureStructure structure, int size_x, int size_y, int size_x_cr, int size_y_cr, int is_output)
+static StorablePicture* get_pooled_picture(VideoParameters *p_Vid, PictureStructure structure, int size_x, int size_y, int size_x_cr, int size_y_cr, int clear_planes, int own_planes)
 {
-  seq_parameter_set_rbsp_t *active_sps = p_Vid->active_sps;  
+  PicturePool *pool = p_Vid->pic_pool;
+  StorablePicture *s, keep;
+  int i, j, nplane;
+
+  for (i = pool->num_pics - 1; i >= 0; --i)
+  {
+    if (pooled_picture_fits(p_Vid, pool->pics[i], structure, size_x, size_y, size_x_cr, size_y_cr, own_planes))
+      break;
+  }
+  if (i < 0)
+    return NULL;
+
+  s = pool->pics[i];
+  memmove(&pool->pics[i], &pool->pics[i + 1], (pool->num_pics - i - 1) * sizeof(StorablePicture *));
+  --pool->num_pics;
+
+  keep = *s;
+  memset(s, 0, sizeof(StorablePicture));
+  memcpy(s->plane, keep.plane, sizeof(s->plane));
+  s->imgY    = keep.imgY;
+  s->imgUV   = keep.imgUV;
+  s->mv_info = keep.mv_info;
+  s->motion  = keep.motion;
+  memcpy(s->JVmv_info, keep.JVmv_info, sizeof(s->JVmv_info));
+  memcpy(s->JVmotion , keep.JVmotion , sizeof(s->JVmotion));
+  memcpy(s->listX    , keep.listX    , sizeof(s->listX));
+
+  memset(s->mv_info[0], 0, (size_y >> BLOCK_SHIFT) * (size_x >> BLOCK_SHIFT) * sizeof(PicMotionParams));
+  // the field flags are released when the picture stops being a reference
+  if (s->motion.mb_field == NULL)
+    alloc_pic_motion(&s->motion, (size_y >> BLOCK_SHIFT), (size_x >> BLOCK_SHIFT));
+  else
+    memset(s->motion.mb_field, 0, (size_y >> BLOCK_SHIFT) * (size_x >> BLOCK_SHIFT) * sizeof(byte));
+  if (p_Vid->separate_colour_plane_flag != 0)
+  {
+    for (nplane = 0; nplane < MAX_PLANE; nplane++)
+    {
+      memset(s->JVmv_info[nplane][0], 0, (size_y >> BLOCK_SHIFT) * (size_x >> BLOCK_SHIFT) * sizeof(PicMotionParams));
+      memset(s->JVmotion[nplane].mb_field, 0, (size_y >> BLOCK_SHIFT) * (size_x >> BLOCK_SHIFT) * sizeof(byte));
+    }
+  }
+  if (s->listX[0][0] != NULL)
+  {
+    for (j = 0; j < MAX_NUM_SLICES; j++)
+    {
+      for (i = 0; i < 2; i++)
+        memset(s->listX[j][i], 0, MAX_LIST_SIZE * sizeof(StorablePicture*));
+    }
+  }
+
+  if (clear_planes)
+  {
+    clear_pic_plane(&s->plane[0]);
+    if (s->imgUV != NULL)
+    {
+      clear_pic_plane(&s->plane[1]);
+      clear_pic_plane(&s->plane[2]);
+    }
+  }
 
+  return s;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Gets a stored picture from the picture pool, or allocates a new one
+ *    if none of the released pictures fits.
+ ************************************************************************
+ */
+static StorablePicture* get_storable_picture(VideoParameters *p_Vid, PictureStructure structure, int size_x, int size_y, int size_x_cr, int size_y_cr, int clear_planes, int own_planes)
+{
   StorablePicture *s;
-  int   nplane;
 
   //printf ("Allocating (%s) picture (x=%d, y=%d, x_cr=%d, y_cr=%d)\n", (type == FRAME)?"FRAME":(type == TOP_FIELD)?"TOP_FIELD":"BOTTOM_FIELD", size_x, size_y, size_x_cr, size_y_cr);
 
-  s = calloc (1, sizeof(StorablePicture));
-  if (NULL==s)
-    no_mem_exit("alloc_storable_picture: s");
-
   if (structure!=FRAME)
   {
     size_y    /= 2;
     size_y_cr /= 2;
   }
 
-  s->PicSizeInMbs = (size_x*size_y)/256;
-  s->imgUV = NULL;
-
-  get_mem2Dpel_pad (&(s->imgY), size_y, size_x, p_Vid->iLumaPadY, p_Vid->iLumaPadX);
-  s->iLumaStride = size_x+2*p_Vid->iLumaPadX;
-  s->iLumaExpandedHeight = size_y+2*p_Vid->iLumaPadY;
+  if (p_Vid->pic_pool == NULL)
+  {
+    p_Vid->pic_pool = calloc (1, sizeof(PicturePool));
+    if (NULL==p_Vid->pic_pool)
+      no_mem_exit("alloc_storable_picture: p_Vid->pic_pool");
+  }
 
-  if (active_sps->chroma_format_idc != YUV400)
+  s = get_pooled_picture(p_Vid, structure, size_x, size_y, size_x_cr, size_y_cr, clear_planes, own_planes);
+  if (NULL==s)
   {
-    get_mem3Dpel_pad(&(s->imgUV), 2, size_y_cr, size_x_cr, p_Vid->iChromaPadY, p_Vid->iChromaPadX);
+    s = calloc (1, sizeof(StorablePicture));
+    if (NULL==s)
+      no_mem_exit("alloc_storable_picture: s");
+
+    alloc_picture_memory(p_Vid, s, structure, size_x, size_y, size_x_cr, size_y_cr, own_planes);
   }
+  s->pool = p_Vid->pic_pool;
 
-  s->iChromaStride =size_x_cr + 2*p_Vid->iChromaPadX;
+  s->PicSizeInMbs = (size_x*size_y)/256;
+
+  s->iLumaStride = s->plane[0].stride;
+  s->iLumaExpandedHeight = size_y+2*p_Vid->iLumaPadY;
+  s->iChromaStride = (s->imgUV != NULL) ? s->plane[1].stride : size_x_cr + 2*p_Vid->iChromaPadX;
   s->iChromaExpandedHeight = size_y_cr + 2*p_Vid->iChromaPadY;
   s->iLumaPadY   = p_Vid->iLumaPadY;
   s->iLumaPadX   = p_Vid->iLumaPadX;
@@ -567,18 +716,6 @@ StorablePicture* alloc_storable_picture(VideoParameters *p_Vid, PictureStructure
 
   s->separate_colour_plane_flag = p_Vid->separate_colour_plane_flag;
 
-  get_mem2Dmp     ( &s->mv_info, (size_y >> BLOCK_SHIFT), (size_x >> BLOCK_SHIFT));
-  alloc_pic_motion( &s->motion , (size_y >> BLOCK_SHIFT), (size_x >> BLOCK_SHIFT));
-
-  if( (p_Vid->separate_colour_plane_flag != 0) )
-  {
-    for( nplane=0; nplane<MAX_PLANE; nplane++ )
-    {
-      get_mem2Dmp      (&s->JVmv_info[nplane], (size_y >> BLOCK_SHIFT), (size_x >> BLOCK_SHIFT));
-      alloc_pic_motion(&s->JVmotion[nplane] , (size_y >> BLOCK_SHIFT), (size_x >> BLOCK_SHIFT));
-    }
-  }
-
   s->pic_num   = 0;
   s->frame_num = 0;
   s->long_term_frame_idx = 0;
@@ -614,24 +751,184 @@ StorablePicture* alloc_storable_picture(VideoParameters *p_Vid, PictureStructure
 
   s->top_poc = s->bottom_poc = s->poc = 0;
   s->seiHasTone_mapping = 0;
+  s->ready_rows = PICTURE_READY;
 
-  if(!p_Vid->active_sps->frame_mbs_only_flag && structure != FRAME)
+  return s;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Allocate memory for a stored picture. Released pictures of the same
+ *    layout are recycled; their sample planes are cleared like a new
+ *    allocation.
+ *
+ * \param p_Vid
+ *    VideoParameters
+ * \param structure
+ *    picture structure
+ * \param size_x
+ *    horizontal luma size
+ * \param size_y
+ *    vertical luma size
+ * \param size_x_cr
+ *    horizontal chroma size
+ * \param size_y_cr
+ *    vertical chroma size
+ *
+ * \return
+ *    the allocated StorablePicture structure
+ ************************************************************************
+ */
+StorablePicture* alloc_storable_picture(VideoParameters *p_Vid, PictureStructure structure, int size_x, int size_y, int size_x_cr, int size_y_cr, int is_output)
+{
+  return get_storable_picture(p_Vid, structure, size_x, size_y, size_x_cr, size_y_cr, 1, 1);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Same as alloc_storable_picture(), but a recycled picture keeps the
+ *    samples of its previous use. For pictures whose samples (and, for
+ *    references, padding) are all written before they are read.
+ ************************************************************************
+ */
+StorablePicture* alloc_storable_picture_noclear(VideoParameters *p_Vid, PictureStructure structure, int size_x, int size_y, int size_x_cr, int size_y_cr, int is_output)
+{
+  return get_storable_picture(p_Vid, structure, size_x, size_y, size_x_cr, size_y_cr, 0, 1);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Allocates a field picture whose sample planes are a view of the rows
+ *    of one parity of frame. The frame is kept until the view is freed.
+ ************************************************************************
+ */
+static StorablePicture* alloc_field_view(VideoParameters *p_Vid, StorablePicture *frame, PictureStructure structure)
+{
+  StorablePicture *s = get_storable_picture(p_Vid, structure, frame->size_x, frame->size_y, frame->size_x_cr, frame->size_y_cr, 0, 0);
+  int bottom = (structure == BOTTOM_FIELD);
+
+  set_pic_plane_field(&s->plane[0], &frame->plane[0], bottom);
+  s->iLumaStride = s->plane[0].stride;
+  s->iChromaStride = 2 * frame->iChromaStride;
+  if (s->imgUV != NULL)
   {
-    int i, j;
-    for(j = 0; j < MAX_NUM_SLICES; j++)
-    {
-      for (i = 0; i < 2; i++)
-      {
-        s->listX[j][i] = calloc(MAX_LIST_SIZE, sizeof (StorablePicture*)); // +1 for reordering
-        if (NULL==s->listX[j][i])
-        no_mem_exit("alloc_storable_picture: s->listX[i]");
-      }
-    }
+    set_pic_plane_field(&s->plane[1], &frame->plane[1], bottom);
+    set_pic_plane_field(&s->plane[2], &frame->plane[2], bottom);
   }
 
+  s->view_of = frame;
+  ++frame->view_refs;
+
+  return s;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Returns the field stored last in the DPB (or waiting for output)
+ *    when the field pair of frame_num it starts has a free frame buffer
+ *    to be completed in.
+ ************************************************************************
+ */
+static StorablePicture* get_unpaired_field_view(VideoParameters *p_Vid, DecodedPictureBuffer *p_Dpb, PictureStructure structure, unsigned frame_num)
+{
+  int other = (structure == TOP_FIELD) ? 2 : 1;
+  FrameStore *fs = p_Dpb->last_picture;
+  StorablePicture *field;
+
+  if (fs == NULL || fs->is_used != other)
+    fs = p_Vid->out_buffer;
+  if (fs == NULL || fs->is_used != other)
+    return NULL;
+
+  field = (other == 1) ? fs->top_field : fs->bottom_field;
+  if (field->view_of == NULL || field->view_of->view_refs != 1 || field->frame_num != frame_num
+    || !pooled_picture_fits(p_Vid, field->view_of, FRAME, p_Vid->width, p_Vid->height, p_Vid->width_cr, p_Vid->height_cr, 1))
+    return NULL;
+
+  return field;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Allocates a field picture to be decoded. Its samples are the rows of
+ *    a frame buffer, the one of the first field if the picture is
+ *    likely its second field, so that dpb_combine_field() finds the
+ *    frame of the pair complete without copying.
+ ************************************************************************
+ */
+StorablePicture* alloc_field_picture(VideoParameters *p_Vid, DecodedPictureBuffer *p_Dpb, PictureStructure structure, unsigned frame_num)
+{
+  StorablePicture *first = get_unpaired_field_view(p_Vid, p_Dpb, structure, frame_num);
+  StorablePicture *frame;
+
+  if (first != NULL)
+    return alloc_field_view(p_Vid, first->view_of, structure);
+
+  // the samples are written by the fields before they are read
+  frame = alloc_storable_picture_noclear(p_Vid, FRAME, p_Vid->width, p_Vid->height, p_Vid->width_cr, p_Vid->height_cr, 1);
+  frame->released = 1;
+  return alloc_field_view(p_Vid, frame, structure);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Allocates the picture colour plane nplane (PLANE_U or PLANE_V) of a
+ *    separate_colour_plane_flag frame is decoded into. Its luma samples,
+ *    motion vectors and motion flags are plane nplane of the frame, so
+ *    nothing has to be copied into the frame once the plane is decoded.
+ *    Must be released with free_colour_plane_picture().
+ ************************************************************************
+ */
+StorablePicture* alloc_colour_plane_picture(StorablePicture *frame, int nplane)
+{
+  StorablePicture *s = malloc (sizeof(StorablePicture));
+
+  if (NULL==s)
+    no_mem_exit("alloc_colour_plane_picture: s");
+
+  *s = *frame;
+  s->pool = NULL;
+
+  memset(s->plane, 0, sizeof(s->plane));
+  s->plane[0] = frame->plane[nplane];
+  s->plane[0].mem = NULL;     // owned by the frame
+  s->imgY  = s->plane[0].rows;
+  s->imgUV = NULL;
+
+  s->iLumaStride = frame->iChromaStride;
+  s->iLumaExpandedHeight = frame->iChromaExpandedHeight;
+  s->iLumaPadX = frame->iChromaPadX;
+  s->iLumaPadY = frame->iChromaPadY;
+
+  s->mv_info = frame->JVmv_info[nplane];
+  s->motion  = frame->JVmotion[nplane];
+  memset(s->JVmv_info, 0, sizeof(s->JVmv_info));
+  memset(s->JVmotion , 0, sizeof(s->JVmotion));
+  memset(s->listX    , 0, sizeof(s->listX));
+
+  s->seiHasTone_mapping = 0;
+  s->tone_mapping_lut   = NULL;
+
   return s;
 }
 
+/*!
+ ************************************************************************
+ * \brief
+ *    Releases a picture allocated by alloc_colour_plane_picture().
+ ************************************************************************
+ */
+void free_colour_plane_picture(StorablePicture* p)
+{
+  free(p);
+}
+
 /*!
  ************************************************************************
  * \brief
@@ -671,8 +968,11 @@ void free_pic_motion(PicMotionParamsOld *motion)
 {
   if (motion->mb_field)
   {
-    free(motion->mb_field);
+    MemTag prev_tag = mem_set_tag(MEM_MOTION);
+
+    mem_free(motion->mb_field);
     motion->mb_field = NULL;
+    mem_set_tag(prev_tag);
   }
 }
 
@@ -680,18 +980,16 @@ void free_pic_motion(PicMotionParamsOld *motion)
 /*!
  ************************************************************************
  * \brief
- *    Free picture memory.
- *
- * \param p
- *    Picture to be freed
- *
+ *    Release the memory of a picture.
  ************************************************************************
  */
-void free_storable_picture(StorablePicture* p)
+static void destroy_storable_picture(StorablePicture* p)
 {
   int nplane;
   if (p)
   {
+    MemTag prev_tag = mem_set_tag(MEM_MOTION);
+
     if (p->mv_info)
     {
       free_mem2Dmp(p->mv_info);
@@ -712,22 +1010,18 @@ void free_storable_picture(StorablePicture* p)
       }
     }
 
-    if (p->imgY)
-    {
-      free_mem2Dpel_pad(p->imgY, p->iLumaPadY, p->iLumaPadX);
-      p->imgY = NULL;
-    }
+    mem_set_tag(MEM_DPB);
+    for (nplane = 0; nplane < MAX_PLANE; nplane++)
+      free_pic_plane(&p->plane[nplane]);
+    p->imgY = NULL;
 
     if (p->imgUV)
     {
-      free_mem3Dpel_pad(p->imgUV, 2, p->iChromaPadY, p->iChromaPadX);
+      mem_free(p->imgUV);
       p->imgUV=NULL;
     }
 
 
-    if (p->seiHasTone_mapping)
-      free(p->tone_mapping_lut);
-
     {
       int i, j;
       for(j = 0; j < MAX_NUM_SLICES; j++)
@@ -736,17 +1030,105 @@ void free_storable_picture(StorablePicture* p)
         {
           if(p->listX[j][i])
           {
-            free(p->listX[j][i]);
+            mem_free(p->listX[j][i]);
             p->listX[j][i] = NULL;
           }
         }
       }
     }
+    mem_set_tag(prev_tag);
     free(p);
     p = NULL;
   }
 }
 
+/*!
+ ************************************************************************
+ * \brief
+ *    Returns a picture to its pool, releasing the oldest pooled picture
+ *    if the pool is full, or releases it if it has no pool.
+ ************************************************************************
+ */
+static void recycle_storable_picture(StorablePicture* p)
+{
+  PicturePool *pool = p->pool;
+
+  if (pool == NULL)
+  {
+    destroy_storable_picture(p);
+    return;
+  }
+
+  if (pool->num_pics == PIC_POOL_SIZE)
+  {
+    destroy_storable_picture(pool->pics[0]);
+    memmove(&pool->pics[0], &pool->pics[1], (PIC_POOL_SIZE - 1) * sizeof(StorablePicture *));
+    --pool->num_pics;
+  }
+  pool->pics[pool->num_pics++] = p;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Free picture memory. The picture goes back to its pool for reuse;
+ *    if the pool is full its oldest entry is released instead. A frame
+ *    whose samples are still viewed by field pictures is kept until the
+ *    last of them is freed.
+ *
+ * \param p
+ *    Picture to be freed
+ *
+ ************************************************************************
+ */
+void free_storable_picture(StorablePicture* p)
+{
+  if (p)
+  {
+    StorablePicture *frame = p->view_of;
+
+    wait_picture_rows(p, PICTURE_READY);
+
+    if (p->seiHasTone_mapping)
+    {
+      free(p->tone_mapping_lut);
+      p->tone_mapping_lut = NULL;
+      p->seiHasTone_mapping = 0;
+    }
+
+    if (p->view_refs > 0)
+    {
+      p->released = 1;
+      return;
+    }
+
+    recycle_storable_picture(p);
+    if (frame != NULL && --frame->view_refs == 0 && frame->released)
+      recycle_storable_picture(frame);
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Releases all pooled pictures and the pool itself. Pictures still
+ *    in use must have been freed before.
+ ************************************************************************
+ */
+void free_picture_pool(VideoParameters *p_Vid)
+{
+  PicturePool *pool = p_Vid->pic_pool;
+
+  if (pool)
+  {
+    int i;
+    for (i = 0; i < pool->num_pics; ++i)
+      destroy_storable_picture(pool->pics[i]);
+    free(pool);
+    p_Vid->pic_pool = NULL;
+  }
+}
+
 /*!
  ************************************************************************
  * \brief
@@ -2281,7 +2663,7 @@ static void gen_field_ref_ids(VideoParameters *p_Vid, StorablePicture *p)
 /*!
  ************************************************************************
  * \brief
- *    Extract top field from a frame
+ *    Extract top and bottom field from a frame
  ************************************************************************
  */
 void dpb_split_field(VideoParameters *p_Vid, FrameStore *fs)
@@ -2297,30 +2679,9 @@ void dpb_split_field(VideoParameters *p_Vid, FrameStore *fs)
 
   if (!frame->frame_mbs_only_flag)
   {
-    fs_top = fs->top_field    = alloc_storable_picture(p_Vid, TOP_FIELD,    frame->size_x, frame->size_y, frame->size_x_cr, frame->size_y_cr, 1);
-    fs_btm = fs->bottom_field = alloc_storable_picture(p_Vid, BOTTOM_FIELD, frame->size_x, frame->size_y, frame->size_x_cr, frame->size_y_cr, 1);
-
-    for (i = 0; i < (frame->size_y >> 1); i++)
-    {
-      memcpy(fs_top->imgY[i], frame->imgY[i*2], frame->size_x*sizeof(imgpel));
-    }
-
-    for (i = 0; i< (frame->size_y_cr >> 1); i++)
-    {
-      memcpy(fs_top->imgUV[0][i], frame->imgUV[0][i*2], frame->size_x_cr*sizeof(imgpel));
-      memcpy(fs_top->imgUV[1][i], frame->imgUV[1][i*2], frame->size_x_cr*sizeof(imgpel));
-    }
-
-    for (i = 0; i < (frame->size_y>>1); i++)
-    {
-      memcpy(fs_btm->imgY[i], frame->imgY[i*2 + 1], frame->size_x*sizeof(imgpel));
-    }
-
-    for (i = 0; i < (frame->size_y_cr>>1); i++)
-    {
-      memcpy(fs_btm->imgUV[0][i], frame->imgUV[0][i*2 + 1], frame->size_x_cr*sizeof(imgpel));
-      memcpy(fs_btm->imgUV[1][i], frame->imgUV[1][i*2 + 1], frame->size_x_cr*sizeof(imgpel));
-    }
+    // the fields are views of the rows of the frame, no samples are copied
+    fs_top = fs->top_field    = alloc_field_view(p_Vid, frame, TOP_FIELD);
+    fs_btm = fs->bottom_field = alloc_field_view(p_Vid, frame, BOTTOM_FIELD);
 
     fs_top->poc = frame->top_poc;
     fs_btm->poc = frame->bottom_poc;
@@ -2366,11 +2727,6 @@ void dpb_split_field(VideoParameters *p_Vid, FrameStore *fs)
 
     fs_top->chroma_format_idc = fs_btm->chroma_format_idc = frame->chroma_format_idc;
     fs_top->iCodingType = fs_btm->iCodingType = frame->iCodingType;
-    if(frame->used_for_reference)
-    {
-      pad_dec_picture(p_Vid, fs_top);
-      pad_dec_picture(p_Vid, fs_btm);
-    }
   }
   else
   {
@@ -2478,33 +2834,60 @@ void dpb_split_field(VideoParameters *p_Vid, FrameStore *fs)
 /*!
  ************************************************************************
  * \brief
- *    Generate a frame from top and bottom fields,
- *    YUV components and display information only
+ *    Copies the samples of a field into the rows of its parity of frame
  ************************************************************************
  */
-void dpb_combine_field_yuv(VideoParameters *p_Vid, FrameStore *fs)
+static void copy_field_rows(StorablePicture *frame, StorablePicture *field, int bottom)
 {
   int i, j;
 
-  if (!fs->frame)
-  {
-    fs->frame = alloc_storable_picture(p_Vid, FRAME, fs->top_field->size_x, fs->top_field->size_y*2, fs->top_field->size_x_cr, fs->top_field->size_y_cr*2, 1);
-  }
+  for (i = 0; i < field->size_y; i++)
+    memcpy(frame->imgY[i*2 + bottom], field->imgY[i], field->size_x * sizeof(imgpel));
 
-  for (i=0; i<fs->top_field->size_y; i++)
+  if (frame->imgUV == NULL)
+    return;
+  for (j = 0; j < 2; j++)
   {
-    memcpy(fs->frame->imgY[i*2],     fs->top_field->imgY[i]   , fs->top_field->size_x * sizeof(imgpel));     // top field
-    memcpy(fs->frame->imgY[i*2 + 1], fs->bottom_field->imgY[i], fs->bottom_field->size_x * sizeof(imgpel)); // bottom field
+    for (i = 0; i < field->size_y_cr; i++)
+      memcpy(frame->imgUV[j][i*2 + bottom], field->imgUV[j][i], field->size_x_cr * sizeof(imgpel));
   }
+}
 
-  for (j = 0; j < 2; j++)
+/*!
+ ************************************************************************
+ * \brief
+ *    Generate a frame from top and bottom fields,
+ *    YUV components and display information only
+ *
+ *    Fields decoded as views of one frame buffer already form the frame,
+ *    which is then taken over without copying. Otherwise the rows of the
+ *    fields that are not views of the frame are copied into it.
+ ************************************************************************
+ */
+void dpb_combine_field_yuv(VideoParameters *p_Vid, FrameStore *fs)
+{
+  if (!fs->frame)
   {
-    for (i=0; i<fs->top_field->size_y_cr; i++)
+    StorablePicture *frame = fs->top_field->view_of ? fs->top_field->view_of : fs->bottom_field->view_of;
+
+    // the frame buffer of a single field view is free in the rows of the other parity
+    if (frame != NULL && frame->released
+      && (fs->top_field->view_of == fs->bottom_field->view_of || frame->view_refs == 1))
     {
-      memcpy(fs->frame->imgUV[j][i*2],     fs->top_field->imgUV[j][i],    fs->top_field->size_x_cr*sizeof(imgpel));
-      memcpy(fs->frame->imgUV[j][i*2 + 1], fs->bottom_field->imgUV[j][i], fs->bottom_field->size_x_cr*sizeof(imgpel));
+      frame->released = 0;
+      fs->frame = frame;
+    }
+    else
+    {
+      fs->frame = alloc_storable_picture(p_Vid, FRAME, fs->top_field->size_x, fs->top_field->size_y*2, fs->top_field->size_x_cr, fs->top_field->size_y_cr*2, 1);
     }
   }
+
+  if (fs->top_field->view_of != fs->frame)
+    copy_field_rows(fs->frame, fs->top_field, 0);
+  if (fs->bottom_field->view_of != fs->frame)
+    copy_field_rows(fs->frame, fs->bottom_field, 1);
+
   fs->poc=fs->frame->poc =fs->frame->frame_poc = imin (fs->top_field->poc, fs->bottom_field->poc);
 
   fs->bottom_field->frame_poc=fs->top_field->frame_poc=fs->frame->poc;
@@ -2539,11 +2922,6 @@ void dpb_combine_field_yuv(VideoParameters *p_Vid, FrameStore *fs)
   fs->top_field->bottom_field = fs->bottom_field;
   fs->bottom_field->top_field = fs->top_field;
   fs->bottom_field->bottom_field = fs->bottom_field;
-  if(fs->top_field->used_for_reference || fs->bottom_field->used_for_reference)
-  {
-    pad_dec_picture(p_Vid, fs->frame);
-  }
-
 }
 
 
@@ -3314,16 +3692,12 @@ StorablePicture * clone_storable_picture( VideoParameters *p_Vid, StorablePictur
 
   copy_img_data(&p_stored_pic->imgY[0][0], &img_in[0][0][0], ostride[0], istride[0], p_pic->size_y, p_pic->size_x * sizeof(imgpel)); 
 
-  pad_buf(*p_stored_pic->imgY, p_stored_pic->size_x, p_stored_pic->size_y, p_stored_pic->iLumaStride, p_Vid->iLumaPadX, p_Vid->iLumaPadY);
-
   if (p_Vid->active_sps->chroma_format_idc != YUV400)
   {    
     //memcpy((void *)p_stored_pic->imgUV[0][0], (void *)p_Vid->tempData3.frm_data[1][0], p_pic->size_x_cr * p_pic->size_y_cr * sizeof(imgpel));
     //memcpy((void *)p_stored_pic->imgUV[1][0], (void *)p_Vid->tempData3.frm_data[2][0], p_pic->size_x_cr * p_pic->size_y_cr * sizeof(imgpel));
     copy_img_data(&p_stored_pic->imgUV[0][0][0], &img_in[1][0][0], ostride[1], istride[1], p_pic->size_y_cr, p_pic->size_x_cr*sizeof(imgpel));
-    pad_buf(*p_stored_pic->imgUV[0], p_stored_pic->size_x_cr, p_stored_pic->size_y_cr, p_stored_pic->iChromaStride, p_Vid->iChromaPadX, p_Vid->iChromaPadY);
     copy_img_data(&p_stored_pic->imgUV[1][0][0], &img_in[2][0][0], ostride[1], istride[2], p_pic->size_y_cr, p_pic->size_x_cr*sizeof(imgpel));
-    pad_buf(*p_stored_pic->imgUV[1], p_stored_pic->size_x_cr, p_stored_pic->size_y_cr, p_stored_pic->iChromaStride, p_Vid->iChromaPadX, p_Vid->iChromaPadY);
   }
 
   for (j = 0; j < (p_pic->size_y >> BLOCK_SHIFT); j++)
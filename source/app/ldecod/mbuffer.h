@@ -74,8 +74,9 @@ typedef struct storable_picture
   int         iChromaPadY, iChromaPadX;
 
 
-  imgpel **     imgY;         //!< Y picture component
-  imgpel ***    imgUV;        //!< U and V picture components
+  PicPlane      plane[MAX_PLANE]; //!< sample planes, Y U V (Y Cb Cr for separate_colour_plane_flag)
+  imgpel **     imgY;         //!< Y picture component, row view of plane[0]
+  imgpel ***    imgUV;        //!< U and V picture components, row views of plane[1] and plane[2]
 
   struct pic_motion_params **mv_info;          //!< Motion info
   struct pic_motion_params **JVmv_info[MAX_PLANE];          //!< Motion info
@@ -124,13 +125,21 @@ typedef struct storable_picture
   int         iChromaStride;
   int         iLumaExpandedHeight;
   int         iChromaExpandedHeight;
-  imgpel **cur_imgY; // for more efficient get_block_luma
   int no_ref;
   int iCodingType;
   //
   char listXsize[MAX_NUM_SLICES][2];
   struct storable_picture **listX[MAX_NUM_SLICES][2];
   int         layer_id;
+
+  struct picture_pool *pool;   //!< pool the picture is returned to by free_storable_picture(), NULL if none
+
+  struct storable_picture *view_of;            //!< frame owning the samples of a field view, NULL if the samples are the picture's own
+  int         view_refs;                       //!< field views of the samples not freed yet
+  int         released;                        //!< freed while views of the samples were still in use
+
+  int         ready_rows;                      //!< macroblock rows deblocked and padded, PICTURE_READY once the picture is finished
+  struct thread_progress *ready_progress;      //!< progress to wait on while ready_rows is behind
 } StorablePicture;
 
 typedef StorablePicture *StorablePicturePtr;
@@ -169,6 +178,14 @@ typedef struct frame_store
 } FrameStore;
 
 
+//! Released pictures kept for reuse by alloc_storable_picture(), oldest first
+#define PIC_POOL_SIZE 16
+typedef struct picture_pool
+{
+  StorablePicture *pics[PIC_POOL_SIZE];
+  int              num_pics;
+} PicturePool;
+
 //! Decoded Picture Buffer
 typedef struct decoded_picture_buffer
 {
@@ -207,7 +224,12 @@ extern void              free_dpb(DecodedPictureBuffer *p_Dpb);
 extern FrameStore*       alloc_frame_store(void);
 extern void              free_frame_store (FrameStore* f);
 extern StorablePicture*  alloc_storable_picture(VideoParameters *p_Vid, PictureStructure type, int size_x, int size_y, int size_x_cr, int size_y_cr, int is_output);
+extern StorablePicture*  alloc_storable_picture_noclear(VideoParameters *p_Vid, PictureStructure type, int size_x, int size_y, int size_x_cr, int size_y_cr, int is_output);
+extern StorablePicture*  alloc_field_picture   (VideoParameters *p_Vid, DecodedPictureBuffer *p_Dpb, PictureStructure structure, unsigned frame_num);
 extern void              free_storable_picture (StorablePicture* p);
+extern StorablePicture*  alloc_colour_plane_picture(StorablePicture *frame, int nplane);
+extern void              free_colour_plane_picture (StorablePicture* p);
+extern void              free_picture_pool     (VideoParameters *p_Vid);
 extern void              store_picture_in_dpb(DecodedPictureBuffer *p_Dpb, StorablePicture* p);
 extern StorablePicture*  get_short_term_pic (Slice *currSlice, DecodedPictureBuffer *p_Dpb, int picNum);
 
@@ -248,8 +270,6 @@ extern void compute_colocated (Slice *currSlice, StorablePicture **listX[6]);
 
 extern int init_img_data(VideoParameters *p_Vid, ImageData *p_ImgData, seq_parameter_set_rbsp_t *sps);
 extern void free_img_data(VideoParameters *p_Vid, ImageData *p_ImgData);
-extern void pad_dec_picture(VideoParameters *p_Vid, StorablePicture *dec_picture);
-extern void pad_buf(imgpel *pImgBuf, int iWidth, int iHeight, int iStride, int iPadX, int iPadY);
 extern void process_picture_in_dpb_s(VideoParameters *p_Vid, StorablePicture *p_pic);
 extern StorablePicture * clone_storable_picture( VideoParameters *p_Vid, StorablePicture *p_pic );
 extern void store_proc_picture_in_dpb(DecodedPictureBuffer *p_Dpb, StorablePicture* p);
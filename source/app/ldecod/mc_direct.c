@@ -543,12 +543,11 @@ static void update_direct_mv_info_spatial_4x4(Macroblock *currMB)
 
   if (has_direct)
   {   
-    VideoParameters *p_Vid = currMB->p_Vid;
     Slice *currSlice = currMB->p_Slice;
     int i,j,k;
 
     int j4, i4;
-    StorablePicture *dec_picture = p_Vid->dec_picture;
+    StorablePicture *dec_picture = currSlice->dec_picture;
 
     int list_offset = currMB->list_offset; // ((currSlice->mb_aff_frame_flag)&&(currMB->mb_field))? (mb_nr&0x01) ? 4 : 2 : 0;
     StorablePicture **list0 = currSlice->listX[LIST_0 + list_offset];
@@ -22,6 +22,14 @@
 #include "macroblock.h"
 #include "memalloc.h"
 #include "dec_statistics.h"
+#include "frame_pipeline.h"
+
+static McKernels mc_kernels;        //!< kernels in use, see select_mc_kernels()
+static McKernels mc_kernels_any;    //!< kernels for every bit depth
+static McKernels mc_kernels_8bit;   //!< kernels for 8 bit samples
+
+#define EMU_LUMA_SIZE    (MB_BLOCK_SIZE + 5)   //!< lines and columns the 6-tap filter reads for a 16x16 block
+#define EMU_CHROMA_SIZE  (MB_BLOCK_SIZE + 1)   //!< lines and columns the bilinear filter reads for a 16x16 block
 
 int allocate_pred_mem(Slice *currSlice)
 {
@@ -165,23 +173,43 @@ static void weighted_bi_prediction(imgpel *mb_pred,
  *    Integer positions
  ************************************************************************
  */ 
-static void get_block_00(imgpel *block, imgpel *cur_img, int span, int block_size_y)
+static void get_block_00(imgpel *block, imgpel *cur_img, int span, int block_size_y, int block_size_x)
 {
-  // fastest to just move an entire block, since block is a temp block is a 256 byte block (16x16)
-  // writes 2 lines of 16 imgpel 1 to 8 times depending in block_size_y
+  // block is a 16x16 temp block; reference lines have no padding, so
+  // only block_size_x samples of a line may be read
   int j;
   
-  for (j = 0; j < block_size_y; j += 2)
+  for (j = 0; j < block_size_y; j++)
   { 
-    memcpy(block, cur_img, MB_BLOCK_SIZE * sizeof(imgpel));
-    block += MB_BLOCK_SIZE;
-    cur_img += span;
-    memcpy(block, cur_img, MB_BLOCK_SIZE * sizeof(imgpel));
+    memcpy(block, cur_img, block_size_x * sizeof(imgpel));
     block += MB_BLOCK_SIZE;
     cur_img += span;
   }
 }
 
+/*!
+ ************************************************************************
+ * \brief
+ *    Copies the samples x0 .. x0 + width - 1 of the lines y0 .. y0 + height - 1
+ *    of a reference plane to buf. Samples outside of the plane are replaced
+ *    by the nearest sample on its border, which is the reference sample
+ *    the standard defines for them.
+ ************************************************************************
+ */
+static void emulate_edge(imgpel *buf, int buf_stride, imgpel *data, int stride, int x0, int y0, int width, int height, int maxold_x, int maxold_y)
+{
+  int i, j;
+
+  for (j = 0; j < height; j++)
+  {
+    imgpel *line = data + iClip3(0, maxold_y, y0 + j) * stride;
+
+    for (i = 0; i < width; i++)
+      buf[i] = line[iClip3(0, maxold_x, x0 + i)];
+    buf += buf_stride;
+  }
+}
+
 
 /*!
  ************************************************************************
@@ -189,7 +217,7 @@ static void get_block_00(imgpel *block, imgpel *cur_img, int span, int block_siz
  *    Qpel (1,0) horizontal
  ************************************************************************
  */ 
-static void get_luma_10(imgpel **block, imgpel **cur_imgY, int block_size_y, int block_size_x, int x_pos , int max_imgpel_value)
+static void get_luma_10(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value)
 {
   imgpel *p0, *p1, *p2, *p3, *p4, *p5;
   imgpel *orig_line, *cur_line;
@@ -198,8 +226,8 @@ static void get_luma_10(imgpel **block, imgpel **cur_imgY, int block_size_y, int
   
   for (j = 0; j < block_size_y; j++)
   {
-    cur_line = &(cur_imgY[j][x_pos]);
-    p0 = &cur_imgY[j][x_pos - 2];
+    cur_line = cur_img + j * stride;
+    p0 = cur_img + j * stride - 2;
     p1 = p0 + 1;
     p2 = p1 + 1;
     p3 = p2 + 1;
@@ -224,7 +252,7 @@ static void get_luma_10(imgpel **block, imgpel **cur_imgY, int block_size_y, int
  *    Half horizontal
  ************************************************************************
  */ 
-static void get_luma_20(imgpel **block, imgpel **cur_imgY, int block_size_y, int block_size_x, int x_pos , int max_imgpel_value)
+static void get_luma_20(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value)
 {
   imgpel *p0, *p1, *p2, *p3, *p4, *p5;
   imgpel *orig_line;
@@ -232,7 +260,7 @@ static void get_luma_20(imgpel **block, imgpel **cur_imgY, int block_size_y, int
   int result;
   for (j = 0; j < block_size_y; j++)
   {
-    p0 = &cur_imgY[j][x_pos - 2];
+    p0 = cur_img + j * stride - 2;
     p1 = p0 + 1;
     p2 = p1 + 1;
     p3 = p2 + 1;
@@ -255,7 +283,7 @@ static void get_luma_20(imgpel **block, imgpel **cur_imgY, int block_size_y, int
  *    Qpel (3,0) horizontal
  ************************************************************************
  */ 
-static void get_luma_30(imgpel **block, imgpel **cur_imgY, int block_size_y, int block_size_x, int x_pos , int max_imgpel_value)
+static void get_luma_30(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value)
 {
   imgpel *p0, *p1, *p2, *p3, *p4, *p5;
   imgpel *orig_line, *cur_line;
@@ -264,8 +292,8 @@ static void get_luma_30(imgpel **block, imgpel **cur_imgY, int block_size_y, int
   
   for (j = 0; j < block_size_y; j++)
   {
-    cur_line = &(cur_imgY[j][x_pos + 1]);
-    p0 = &cur_imgY[j][x_pos - 2];
+    cur_line = cur_img + j * stride + 1;
+    p0 = cur_img + j * stride - 2;
     p1 = p0 + 1;
     p2 = p1 + 1;
     p3 = p2 + 1;
@@ -290,23 +318,23 @@ static void get_luma_30(imgpel **block, imgpel **cur_imgY, int block_size_y, int
  *    Qpel vertical (0, 1)
  ************************************************************************
  */ 
-static void get_luma_01(imgpel **block, imgpel **cur_imgY, int block_size_y, int block_size_x, int x_pos, int shift_x, int max_imgpel_value)
+static void get_luma_01(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value)
 {
   imgpel *p0, *p1, *p2, *p3, *p4, *p5;
   imgpel *orig_line, *cur_line;
   int i, j;
   int result;
   int jj = 0;
-  p0 = &(cur_imgY[ - 2][x_pos]);
+  p0 = cur_img - 2 * stride;
   for (j = 0; j < block_size_y; j++)
   {                  
-    p1 = p0 + shift_x;          
-    p2 = p1 + shift_x;
-    p3 = p2 + shift_x;
-    p4 = p3 + shift_x;
-    p5 = p4 + shift_x;
+    p1 = p0 + stride;          
+    p2 = p1 + stride;
+    p3 = p2 + stride;
+    p4 = p3 + stride;
+    p5 = p4 + stride;
     orig_line = block[j];
-    cur_line = &(cur_imgY[jj++][x_pos]);
+    cur_line = cur_img + (jj++) * stride;
 
     for (i = 0; i < block_size_x; i++)
     {
@@ -327,20 +355,20 @@ static void get_luma_01(imgpel **block, imgpel **cur_imgY, int block_size_y, int
  *    Half vertical
  ************************************************************************
  */ 
-static void get_luma_02(imgpel **block, imgpel **cur_imgY, int block_size_y, int block_size_x, int x_pos, int shift_x, int max_imgpel_value)
+static void get_luma_02(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value)
 {
   imgpel *p0, *p1, *p2, *p3, *p4, *p5;
   imgpel *orig_line;
   int i, j;
   int result;
-  p0 = &(cur_imgY[ - 2][x_pos]);
+  p0 = cur_img - 2 * stride;
   for (j = 0; j < block_size_y; j++)
   {                  
-    p1 = p0 + shift_x;          
-    p2 = p1 + shift_x;
-    p3 = p2 + shift_x;
-    p4 = p3 + shift_x;
-    p5 = p4 + shift_x;
+    p1 = p0 + stride;          
+    p2 = p1 + stride;
+    p3 = p2 + stride;
+    p4 = p3 + stride;
+    p5 = p4 + stride;
     orig_line = block[j];
 
     for (i = 0; i < block_size_x; i++)
@@ -360,7 +388,7 @@ static void get_luma_02(imgpel **block, imgpel **cur_imgY, int block_size_y, int
  *    Qpel vertical (0, 3)
  ************************************************************************
  */ 
-static void get_luma_03(imgpel **block, imgpel **cur_imgY, int block_size_y, int block_size_x, int x_pos, int shift_x, int max_imgpel_value)
+static void get_luma_03(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value)
 {
   imgpel *p0, *p1, *p2, *p3, *p4, *p5;
   imgpel *orig_line, *cur_line;
@@ -368,16 +396,16 @@ static void get_luma_03(imgpel **block, imgpel **cur_imgY, int block_size_y, int
   int result;
   int jj = 1;
 
-  p0 = &(cur_imgY[ -2][x_pos]);
+  p0 = cur_img - 2 * stride;
   for (j = 0; j < block_size_y; j++)
   {                  
-    p1 = p0 + shift_x;          
-    p2 = p1 + shift_x;
-    p3 = p2 + shift_x;
-    p4 = p3 + shift_x;
-    p5 = p4 + shift_x;
+    p1 = p0 + stride;          
+    p2 = p1 + stride;
+    p3 = p2 + stride;
+    p4 = p3 + stride;
+    p5 = p4 + stride;
     orig_line = block[j];
-    cur_line = &(cur_imgY[jj++][x_pos]);
+    cur_line = cur_img + (jj++) * stride;
 
     for (i = 0; i < block_size_x; i++)
     {
@@ -397,7 +425,7 @@ static void get_luma_03(imgpel **block, imgpel **cur_imgY, int block_size_y, int
  *    Hpel horizontal, Qpel vertical (2, 1)
  ************************************************************************
  */ 
-static void get_luma_21(imgpel **block, imgpel **cur_imgY, int **tmp_res, int block_size_y, int block_size_x, int x_pos, int max_imgpel_value)
+static void get_luma_21(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value)
 {
   int i, j;
   /* Vertical & horizontal interpolation */
@@ -411,7 +439,7 @@ static void get_luma_21(imgpel **block, imgpel **cur_imgY, int **tmp_res, int bl
 
   for (j = 0; j < block_size_y + 5; j++)
   {
-    p0 = &cur_imgY[jj++][x_pos - 2];
+    p0 = cur_img + (jj++) * stride - 2;
     p1 = p0 + 1;
     p2 = p1 + 1;
     p3 = p2 + 1;
@@ -454,7 +482,7 @@ static void get_luma_21(imgpel **block, imgpel **cur_imgY, int **tmp_res, int bl
  *    Hpel horizontal, Hpel vertical (2, 2)
  ************************************************************************
  */ 
-static void get_luma_22(imgpel **block, imgpel **cur_imgY, int **tmp_res, int block_size_y, int block_size_x, int x_pos, int max_imgpel_value)
+static void get_luma_22(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value)
 {
   int i, j;
   /* Vertical & horizontal interpolation */
@@ -468,7 +496,7 @@ static void get_luma_22(imgpel **block, imgpel **cur_imgY, int **tmp_res, int bl
 
   for (j = 0; j < block_size_y + 5; j++)
   {
-    p0 = &cur_imgY[jj++][x_pos - 2];
+    p0 = cur_img + (jj++) * stride - 2;
     p1 = p0 + 1;
     p2 = p1 + 1;
     p3 = p2 + 1;
@@ -507,7 +535,7 @@ static void get_luma_22(imgpel **block, imgpel **cur_imgY, int **tmp_res, int bl
  *    Hpel horizontal, Qpel vertical (2, 3)
  ************************************************************************
  */ 
-static void get_luma_23(imgpel **block, imgpel **cur_imgY, int **tmp_res, int block_size_y, int block_size_x, int x_pos, int max_imgpel_value)
+static void get_luma_23(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value)
 {
   int i, j;
   /* Vertical & horizontal interpolation */
@@ -521,7 +549,7 @@ static void get_luma_23(imgpel **block, imgpel **cur_imgY, int **tmp_res, int bl
 
   for (j = 0; j < block_size_y + 5; j++)
   {
-    p0 = &cur_imgY[jj++][x_pos - 2];
+    p0 = cur_img + (jj++) * stride - 2;
     p1 = p0 + 1;
     p2 = p1 + 1;
     p3 = p2 + 1;
@@ -564,7 +592,7 @@ static void get_luma_23(imgpel **block, imgpel **cur_imgY, int **tmp_res, int bl
  *    Qpel horizontal, Hpel vertical (1, 2)
  ************************************************************************
  */ 
-static void get_luma_12(imgpel **block, imgpel **cur_imgY, int **tmp_res, int block_size_y, int block_size_x, int x_pos, int shift_x, int max_imgpel_value)
+static void get_luma_12(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value)
 {
   int i, j;
   int *tmp_line;
@@ -573,14 +601,14 @@ static void get_luma_12(imgpel **block, imgpel **cur_imgY, int **tmp_res, int bl
   imgpel *orig_line;  
   int result;      
 
-  p0 = &(cur_imgY[ -2][x_pos - 2]);
+  p0 = cur_img - 2 * stride - 2;
   for (j = 0; j < block_size_y; j++)
   {                    
-    p1 = p0 + shift_x;
-    p2 = p1 + shift_x;
-    p3 = p2 + shift_x;
-    p4 = p3 + shift_x;
-    p5 = p4 + shift_x;
+    p1 = p0 + stride;
+    p2 = p1 + stride;
+    p3 = p2 + stride;
+    p4 = p3 + stride;
+    p5 = p4 + stride;
     tmp_line  = tmp_res[j];
 
     for (i = 0; i < block_size_x + 5; i++)
@@ -619,7 +647,7 @@ static void get_luma_12(imgpel **block, imgpel **cur_imgY, int **tmp_res, int bl
  *    Qpel horizontal, Hpel vertical (3, 2)
  ************************************************************************
  */ 
-static void get_luma_32(imgpel **block, imgpel **cur_imgY, int **tmp_res, int block_size_y, int block_size_x, int x_pos, int shift_x, int max_imgpel_value)
+static void get_luma_32(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value)
 {
   int i, j;
   int *tmp_line;
@@ -628,14 +656,14 @@ static void get_luma_32(imgpel **block, imgpel **cur_imgY, int **tmp_res, int bl
   imgpel *orig_line;  
   int result;      
 
-  p0 = &(cur_imgY[ -2][x_pos - 2]);
+  p0 = cur_img - 2 * stride - 2;
   for (j = 0; j < block_size_y; j++)
   {                    
-    p1 = p0 + shift_x;
-    p2 = p1 + shift_x;
-    p3 = p2 + shift_x;
-    p4 = p3 + shift_x;
-    p5 = p4 + shift_x;
+    p1 = p0 + stride;
+    p2 = p1 + stride;
+    p3 = p2 + stride;
+    p4 = p3 + stride;
+    p5 = p4 + stride;
     tmp_line  = tmp_res[j];
 
     for (i = 0; i < block_size_x + 5; i++)
@@ -673,7 +701,7 @@ static void get_luma_32(imgpel **block, imgpel **cur_imgY, int **tmp_res, int bl
  *    Qpel horizontal, Qpel vertical (3, 3)
  ************************************************************************
  */ 
-static void get_luma_33(imgpel **block, imgpel **cur_imgY, int block_size_y, int block_size_x, int x_pos, int shift_x, int max_imgpel_value)
+static void get_luma_33(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value)
 {
   int i, j;
   imgpel *p0, *p1, *p2, *p3, *p4, *p5;
@@ -684,7 +712,7 @@ static void get_luma_33(imgpel **block, imgpel **cur_imgY, int block_size_y, int
 
   for (j = 0; j < block_size_y; j++)
   {
-    p0 = &cur_imgY[jj++][x_pos - 2];
+    p0 = cur_img + (jj++) * stride - 2;
     p1 = p0 + 1;
     p2 = p1 + 1;
     p3 = p2 + 1;
@@ -701,14 +729,14 @@ static void get_luma_33(imgpel **block, imgpel **cur_imgY, int block_size_y, int
     }
   }
 
-  p0 = &(cur_imgY[-2][x_pos + 1]);
+  p0 = cur_img - 2 * stride + 1;
   for (j = 0; j < block_size_y; j++)
   {        
-    p1 = p0 + shift_x;
-    p2 = p1 + shift_x;
-    p3 = p2 + shift_x;
-    p4 = p3 + shift_x;
-    p5 = p4 + shift_x;
+    p1 = p0 + stride;
+    p2 = p1 + stride;
+    p3 = p2 + stride;
+    p4 = p3 + stride;
+    p5 = p4 + stride;
     orig_line = block[j];
 
     for (i = 0; i < block_size_x; i++)
@@ -730,7 +758,7 @@ static void get_luma_33(imgpel **block, imgpel **cur_imgY, int block_size_y, int
  *    Qpel horizontal, Qpel vertical (1, 1)
  ************************************************************************
  */ 
-static void get_luma_11(imgpel **block, imgpel **cur_imgY, int block_size_y, int block_size_x, int x_pos, int shift_x, int max_imgpel_value)
+static void get_luma_11(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value)
 {
   int i, j;
   imgpel *p0, *p1, *p2, *p3, *p4, *p5;
@@ -741,7 +769,7 @@ static void get_luma_11(imgpel **block, imgpel **cur_imgY, int block_size_y, int
 
   for (j = 0; j < block_size_y; j++)
   {
-    p0 = &cur_imgY[jj++][x_pos - 2];
+    p0 = cur_img + (jj++) * stride - 2;
     p1 = p0 + 1;
     p2 = p1 + 1;
     p3 = p2 + 1;
@@ -758,14 +786,14 @@ static void get_luma_11(imgpel **block, imgpel **cur_imgY, int block_size_y, int
     }
   }
 
-  p0 = &(cur_imgY[-2][x_pos]);
+  p0 = cur_img - 2 * stride;
   for (j = 0; j < block_size_y; j++)
   {        
-    p1 = p0 + shift_x;
-    p2 = p1 + shift_x;
-    p3 = p2 + shift_x;
-    p4 = p3 + shift_x;
-    p5 = p4 + shift_x;
+    p1 = p0 + stride;
+    p2 = p1 + stride;
+    p3 = p2 + stride;
+    p4 = p3 + stride;
+    p5 = p4 + stride;
     orig_line = block[j];
 
     for (i = 0; i < block_size_x; i++)
@@ -785,7 +813,7 @@ static void get_luma_11(imgpel **block, imgpel **cur_imgY, int block_size_y, int
  *    Qpel horizontal, Qpel vertical (1, 3)
  ************************************************************************
  */ 
-static void get_luma_13(imgpel **block, imgpel **cur_imgY, int block_size_y, int block_size_x, int x_pos, int shift_x, int max_imgpel_value)
+static void get_luma_13(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value)
 {
   /* Diagonal interpolation */
   int i, j;
@@ -797,7 +825,7 @@ static void get_luma_13(imgpel **block, imgpel **cur_imgY, int block_size_y, int
 
   for (j = 0; j < block_size_y; j++)
   {
-    p0 = &cur_imgY[jj++][x_pos - 2];
+    p0 = cur_img + (jj++) * stride - 2;
     p1 = p0 + 1;
     p2 = p1 + 1;
     p3 = p2 + 1;
@@ -814,14 +842,14 @@ static void get_luma_13(imgpel **block, imgpel **cur_imgY, int block_size_y, int
     }
   }
 
-  p0 = &(cur_imgY[-2][x_pos]);
+  p0 = cur_img - 2 * stride;
   for (j = 0; j < block_size_y; j++)
   {        
-    p1 = p0 + shift_x;
-    p2 = p1 + shift_x;
-    p3 = p2 + shift_x;
-    p4 = p3 + shift_x;
-    p5 = p4 + shift_x;
+    p1 = p0 + stride;
+    p2 = p1 + stride;
+    p3 = p2 + stride;
+    p4 = p3 + stride;
+    p5 = p4 + stride;
     orig_line = block[j];
 
     for (i = 0; i < block_size_x; i++)
@@ -841,7 +869,7 @@ static void get_luma_13(imgpel **block, imgpel **cur_imgY, int block_size_y, int
  *    Qpel horizontal, Qpel vertical (3, 1)
  ************************************************************************
  */ 
-static void get_luma_31(imgpel **block, imgpel **cur_imgY, int block_size_y, int block_size_x, int x_pos, int shift_x, int max_imgpel_value)
+static void get_luma_31(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value)
 {
   /* Diagonal interpolation */
   int i, j;
@@ -853,7 +881,7 @@ static void get_luma_31(imgpel **block, imgpel **cur_imgY, int block_size_y, int
 
   for (j = 0; j < block_size_y; j++)
   {
-    p0 = &cur_imgY[jj++][x_pos - 2];
+    p0 = cur_img + (jj++) * stride - 2;
     p1 = p0 + 1;
     p2 = p1 + 1;
     p3 = p2 + 1;
@@ -870,14 +898,14 @@ static void get_luma_31(imgpel **block, imgpel **cur_imgY, int block_size_y, int
     }
   }
 
-  p0 = &(cur_imgY[-2][x_pos + 1]);
+  p0 = cur_img - 2 * stride + 1;
   for (j = 0; j < block_size_y; j++)
   {        
-    p1 = p0 + shift_x;
-    p2 = p1 + shift_x;
-    p3 = p2 + shift_x;
-    p4 = p3 + shift_x;
-    p5 = p4 + shift_x;
+    p1 = p0 + stride;
+    p2 = p1 + stride;
+    p3 = p2 + stride;
+    p4 = p3 + stride;
+    p5 = p4 + stride;
     orig_line = block[j];
 
     for (i = 0; i < block_size_x; i++)
@@ -898,7 +926,7 @@ static void get_luma_31(imgpel **block, imgpel **cur_imgY, int block_size_y, int
  ************************************************************************
  */ 
 void get_block_luma(StorablePicture *curr_ref, int x_pos, int y_pos, int block_size_x, int block_size_y, imgpel **block,
-                    int shift_x, int maxold_x, int maxold_y, int **tmp_res, int max_imgpel_value, imgpel no_ref_value, Macroblock *currMB)
+                    int maxold_x, int maxold_y, int **tmp_res, int max_imgpel_value, imgpel no_ref_value, Macroblock *currMB, ColorPlane pl)
 {
   if (curr_ref->no_ref) {
     //printf("list[ref_frame] is equal to 'no reference picture' before RAP\n");
@@ -906,70 +934,31 @@ void get_block_luma(StorablePicture *curr_ref, int x_pos, int y_pos, int block_s
   }
   else
   {
-    imgpel **cur_imgY = (currMB->p_Vid->separate_colour_plane_flag && currMB->p_Slice->colour_plane_id>PLANE_Y)? curr_ref->imgUV[currMB->p_Slice->colour_plane_id-1] : curr_ref->cur_imgY;
+    PicPlane *plane = &curr_ref->plane[currMB->p_Vid->separate_colour_plane_flag ? currMB->p_Slice->colour_plane_id : pl];
+    imgpel emu[EMU_LUMA_SIZE * EMU_LUMA_SIZE];
+    imgpel *cur_img;
+    int stride = plane->stride;
     int dx = (x_pos & 3);
     int dy = (y_pos & 3);
     x_pos >>= 2;
     y_pos >>= 2;
-    x_pos = iClip3(-18, maxold_x+2, x_pos);
-    y_pos = iClip3(-10, maxold_y+2, y_pos);
+    // the 6-tap filter reads up to three lines below the block
+    wait_picture_lines(curr_ref, y_pos + block_size_y + 2, curr_ref->size_y, MB_BLOCK_SIZE);
+
+    if (x_pos < 2 || x_pos + block_size_x + 2 > maxold_x || y_pos < 2 || y_pos + block_size_y + 2 > maxold_y)
+    {
+      // the filter taps reach beyond the picture: interpolate from a copy with the border extended
+      emulate_edge(emu, EMU_LUMA_SIZE, plane->data, stride, x_pos - 2, y_pos - 2, block_size_x + 5, block_size_y + 5, maxold_x, maxold_y);
+      cur_img = emu + 2 * EMU_LUMA_SIZE + 2;
+      stride  = EMU_LUMA_SIZE;
+    }
+    else
+      cur_img = plane->data + y_pos * stride + x_pos;
 
     if (dx == 0 && dy == 0)
-      get_block_00(&block[0][0], &cur_imgY[y_pos][x_pos], curr_ref->iLumaStride, block_size_y);
+      get_block_00(&block[0][0], cur_img, stride, block_size_y, block_size_x);
     else
-    { /* other positions */
-      if (dy == 0) /* No vertical interpolation */
-      {         
-        if (dx == 1)
-          get_luma_10(block, &cur_imgY[ y_pos], block_size_y, block_size_x, x_pos, max_imgpel_value);
-        else if (dx == 2)
-          get_luma_20(block, &cur_imgY[ y_pos], block_size_y, block_size_x, x_pos, max_imgpel_value);
-        else
-          get_luma_30(block, &cur_imgY[ y_pos], block_size_y, block_size_x, x_pos, max_imgpel_value);
-      }
-      else if (dx == 0) /* No horizontal interpolation */        
-      {         
-        if (dy == 1)
-          get_luma_01(block, &cur_imgY[y_pos], block_size_y, block_size_x, x_pos, shift_x, max_imgpel_value);
-        else if (dy == 2)
-          get_luma_02(block, &cur_imgY[ y_pos], block_size_y, block_size_x, x_pos, shift_x, max_imgpel_value);
-        else
-          get_luma_03(block, &cur_imgY[ y_pos], block_size_y, block_size_x, x_pos, shift_x, max_imgpel_value);
-      }
-      else if (dx == 2)  /* Vertical & horizontal interpolation */
-      {  
-        if (dy == 1)
-          get_luma_21(block, &cur_imgY[ y_pos], tmp_res, block_size_y, block_size_x, x_pos, max_imgpel_value);
-        else if (dy == 2)
-          get_luma_22(block, &cur_imgY[ y_pos], tmp_res, block_size_y, block_size_x, x_pos, max_imgpel_value);
-        else
-          get_luma_23(block, &cur_imgY[ y_pos], tmp_res, block_size_y, block_size_x, x_pos, max_imgpel_value);
-      }
-      else if (dy == 2)
-      {
-        if (dx == 1)
-          get_luma_12(block, &cur_imgY[ y_pos], tmp_res, block_size_y, block_size_x, x_pos, shift_x, max_imgpel_value);
-        else
-          get_luma_32(block, &cur_imgY[ y_pos], tmp_res, block_size_y, block_size_x, x_pos, shift_x, max_imgpel_value);
-      }
-      else
-      {
-        if (dx == 1)
-        {
-          if (dy == 1)
-            get_luma_11(block, &cur_imgY[ y_pos], block_size_y, block_size_x, x_pos, shift_x, max_imgpel_value);
-          else
-            get_luma_13(block, &cur_imgY[ y_pos], block_size_y, block_size_x, x_pos, shift_x, max_imgpel_value);
-        }
-        else
-        {
-          if (dy == 1)
-            get_luma_31(block, &cur_imgY[ y_pos], block_size_y, block_size_x, x_pos, shift_x, max_imgpel_value);
-          else
-            get_luma_33(block, &cur_imgY[ y_pos], block_size_y, block_size_x, x_pos, shift_x, max_imgpel_value);
-        }
-      }
-    }
+      mc_kernels.get_luma[dy][dx](block, cur_img, stride, tmp_res, block_size_y, block_size_x, max_imgpel_value);
   }
 }
 
@@ -1073,11 +1062,88 @@ static void get_chroma_XY(imgpel *block, imgpel *cur_img, int span, int block_si
   }
 }
 
+/*!
+ ************************************************************************
+ * \brief
+ *    Fills kernels with the motion compensation kernels of the given
+ *    SimdLevel. The C versions are the reference; SIMD versions replace
+ *    them up to simd_level, and with samples_8bit set some of them are
+ *    further replaced by versions for 8 bit samples.
+ ************************************************************************
+ */
+void set_mc_kernels(McKernels *kernels, int simd_level, int samples_8bit)
+{
+  kernels->get_luma[0][0] = NULL;
+  kernels->get_luma[0][1] = get_luma_10;
+  kernels->get_luma[0][2] = get_luma_20;
+  kernels->get_luma[0][3] = get_luma_30;
+  kernels->get_luma[1][0] = get_luma_01;
+  kernels->get_luma[1][1] = get_luma_11;
+  kernels->get_luma[1][2] = get_luma_21;
+  kernels->get_luma[1][3] = get_luma_31;
+  kernels->get_luma[2][0] = get_luma_02;
+  kernels->get_luma[2][1] = get_luma_12;
+  kernels->get_luma[2][2] = get_luma_22;
+  kernels->get_luma[2][3] = get_luma_32;
+  kernels->get_luma[3][0] = get_luma_03;
+  kernels->get_luma[3][1] = get_luma_13;
+  kernels->get_luma[3][2] = get_luma_23;
+  kernels->get_luma[3][3] = get_luma_33;
+  kernels->get_chroma_0X = get_chroma_0X;
+  kernels->get_chroma_X0 = get_chroma_X0;
+  kernels->get_chroma_XY = get_chroma_XY;
+  kernels->weighted_mc_prediction = weighted_mc_prediction;
+  kernels->bi_prediction          = bi_prediction;
+  kernels->weighted_bi_prediction = weighted_bi_prediction;
+
+  if (simd_level >= SIMD_SSE41)
+    init_mc_kernels_sse41(kernels);
+  if (simd_level >= SIMD_AVX2)
+    init_mc_kernels_avx2(kernels);
+
+  if (samples_8bit)
+  {
+    if (simd_level >= SIMD_SSE41)
+      init_mc_kernels_8bit_sse41(kernels);
+    if (simd_level >= SIMD_AVX2)
+      init_mc_kernels_8bit_avx2(kernels);
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Builds the motion compensation kernels for every bit depth and the
+ *    set for 8 bit samples
+ ************************************************************************
+ */
+void init_mc_kernels(int simd_level)
+{
+  set_mc_kernels(&mc_kernels_any,  simd_level, 0);
+  set_mc_kernels(&mc_kernels_8bit, simd_level, 1);
+
+  mc_kernels = mc_kernels_any;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Switches to the kernels for the sample bit depths of the sequence
+ *    being activated. No slice may be decoded at the same time.
+ ************************************************************************
+ */
+void select_mc_kernels(int bitdepth_luma, int bitdepth_chroma)
+{
+  mc_kernels = (bitdepth_luma <= 8 && bitdepth_chroma <= 8) ? mc_kernels_8bit : mc_kernels_any;
+}
+
 static void get_block_chroma(StorablePicture *curr_ref, int x_pos, int y_pos, int subpel_x, int subpel_y, int maxold_x, int maxold_y,
                              int block_size_x, int vert_block_size, int shiftpel_x, int shiftpel_y,
                              imgpel *block1, imgpel *block2, int total_scale, imgpel no_ref_value, VideoParameters *p_Vid)
 {
   imgpel *img1,*img2;
+  imgpel emu1[EMU_CHROMA_SIZE * EMU_CHROMA_SIZE];
+  imgpel emu2[EMU_CHROMA_SIZE * EMU_CHROMA_SIZE];
   short dx,dy;
   int span = curr_ref->iChromaStride;
   if (curr_ref->no_ref) {
@@ -1091,17 +1157,27 @@ static void get_block_chroma(StorablePicture *curr_ref, int x_pos, int y_pos, in
     dy = (short) (y_pos & subpel_y);
     x_pos = x_pos >> shiftpel_x;
     y_pos = y_pos >> shiftpel_y;
-    //clip MV;
-    assert(vert_block_size <=p_Vid->iChromaPadY && block_size_x<=p_Vid->iChromaPadX);
-    x_pos = iClip3(-p_Vid->iChromaPadX, maxold_x, x_pos); //16
-    y_pos = iClip3(-p_Vid->iChromaPadY, maxold_y, y_pos); //8
-    img1 = &curr_ref->imgUV[0][y_pos][x_pos];
-    img2 = &curr_ref->imgUV[1][y_pos][x_pos];
+    wait_picture_lines(curr_ref, y_pos + vert_block_size, curr_ref->size_y_cr, p_Vid->mb_cr_size_y);
+
+    if (x_pos < 0 || x_pos + block_size_x > maxold_x || y_pos < 0 || y_pos + vert_block_size > maxold_y)
+    {
+      // the bilinear filter reaches beyond the picture: interpolate from copies with the border extended
+      emulate_edge(emu1, EMU_CHROMA_SIZE, curr_ref->imgUV[0][0], span, x_pos, y_pos, block_size_x + 1, vert_block_size + 1, maxold_x, maxold_y);
+      emulate_edge(emu2, EMU_CHROMA_SIZE, curr_ref->imgUV[1][0], span, x_pos, y_pos, block_size_x + 1, vert_block_size + 1, maxold_x, maxold_y);
+      img1 = emu1;
+      img2 = emu2;
+      span = EMU_CHROMA_SIZE;
+    }
+    else
+    {
+      img1 = &curr_ref->imgUV[0][y_pos][x_pos];
+      img2 = &curr_ref->imgUV[1][y_pos][x_pos];
+    }
 
     if (dx == 0 && dy == 0) 
     {
-      get_block_00(block1, img1, span, vert_block_size);
-      get_block_00(block2, img2, span, vert_block_size);
+      get_block_00(block1, img1, span, vert_block_size, block_size_x);
+      get_block_00(block2, img2, span, vert_block_size, block_size_x);
     }
     else 
     {
@@ -1111,22 +1187,22 @@ static void get_block_chroma(StorablePicture *curr_ref, int x_pos, int y_pos, in
       if (dx == 0)
       {
         short w01 = dxcur * dy;
-        get_chroma_0X(block1, img1, span, vert_block_size, block_size_x, w00, w01, total_scale);
-        get_chroma_0X(block2, img2, span, vert_block_size, block_size_x, w00, w01, total_scale);
+        mc_kernels.get_chroma_0X(block1, img1, span, vert_block_size, block_size_x, w00, w01, total_scale);
+        mc_kernels.get_chroma_0X(block2, img2, span, vert_block_size, block_size_x, w00, w01, total_scale);
       }
       else if (dy == 0)
       {
         short w10 = dx * dycur;
-        get_chroma_X0(block1, img1, span, vert_block_size, block_size_x, w00, w10, total_scale);
-        get_chroma_X0(block2, img2, span, vert_block_size, block_size_x, w00, w10, total_scale);
+        mc_kernels.get_chroma_X0(block1, img1, span, vert_block_size, block_size_x, w00, w10, total_scale);
+        mc_kernels.get_chroma_X0(block2, img2, span, vert_block_size, block_size_x, w00, w10, total_scale);
       }
       else
       {
         short w01 = dxcur * dy;
         short w10 = dx * dycur;
         short w11 = dx * dy;
-        get_chroma_XY(block1, img1, span, vert_block_size, block_size_x, w00, w01, w10, w11, total_scale);
-        get_chroma_XY(block2, img2, span, vert_block_size, block_size_x, w00, w01, w10, w11, total_scale);
+        mc_kernels.get_chroma_XY(block1, img1, span, vert_block_size, block_size_x, w00, w01, w10, w11, total_scale);
+        mc_kernels.get_chroma_XY(block2, img2, span, vert_block_size, block_size_x, w00, w01, w10, w11, total_scale);
       }
     }
   }
@@ -1331,15 +1407,6 @@ static void check_motion_vector_range(const MotionVector *mv, Slice *pSlice)
   }
 }
 
-static inline int check_vert_mv(int llimit, int vec1_y,int rlimit)
-{
-  int y_pos = vec1_y >> 2;
-  if(y_pos < llimit || y_pos > rlimit)
-    return 1;
-  else
-    return 0;
-}
-
 static void perform_mc_single_wp(Macroblock *currMB, ColorPlane pl, StorablePicture *dec_picture, int pred_dir, int i, int j, int block_size_x, int block_size_y)
 {
   VideoParameters *p_Vid = currMB->p_Vid;  
@@ -1365,7 +1432,6 @@ static void perform_mc_single_wp(Macroblock *currMB, ColorPlane pl, StorablePict
   // vars for get_block_luma
   int maxold_x = dec_picture->size_x_m1;
   int maxold_y = (currMB->mb_field) ? (dec_picture->size_y >> 1) - 1 : dec_picture->size_y_m1;   
-  int shift_x  = dec_picture->iLumaStride;
   int **tmp_res = currSlice->tmp_res;
   int max_imgpel_value = p_Vid->max_pel_value_comp[pl];
   imgpel no_ref_value = (imgpel) p_Vid->dc_pred_value_comp[pl];
@@ -1379,13 +1445,7 @@ static void perform_mc_single_wp(Macroblock *currMB, ColorPlane pl, StorablePict
   check_motion_vector_range(mv_array, currSlice);
   vec1_x = i4 * mv_mul + mv_array->mv_x;
   vec1_y = (currMB->block_y_aff + j) * mv_mul + mv_array->mv_y;
-  if(block_size_y > (p_Vid->iLumaPadY-4) && CheckVertMV(currMB, vec1_y, block_size_y))
-  {
-    get_block_luma(list, vec1_x, vec1_y, block_size_x, BLOCK_SIZE_8x8, tmp_block_l0, shift_x,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB);
-    get_block_luma(list, vec1_x, vec1_y+BLOCK_SIZE_8x8_SP, block_size_x, block_size_y-BLOCK_SIZE_8x8, tmp_block_l0+BLOCK_SIZE_8x8, shift_x,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB);
-  }
-  else
-    get_block_luma(list, vec1_x, vec1_y, block_size_x, block_size_y, tmp_block_l0,shift_x,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB);
+  get_block_luma(list, vec1_x, vec1_y, block_size_x, block_size_y, tmp_block_l0,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB, pl);
   
 
   {
@@ -1395,7 +1455,7 @@ static void perform_mc_single_wp(Macroblock *currMB, ColorPlane pl, StorablePict
     alpha_l0  = currSlice->wp_weight[pred_dir][ref_idx_wp][pl];
     wp_offset = currSlice->wp_offset[pred_dir][ref_idx_wp][pl];
     wp_denom  = pl > 0 ? currSlice->chroma_log2_weight_denom : currSlice->luma_log2_weight_denom;
-    weighted_mc_prediction(&currSlice->mb_pred[pl][joff], tmp_block_l0, block_size_y, block_size_x, ioff, alpha_l0, wp_offset, wp_denom, max_imgpel_value);
+    mc_kernels.weighted_mc_prediction(&currSlice->mb_pred[pl][joff], tmp_block_l0, block_size_y, block_size_x, ioff, alpha_l0, wp_offset, wp_denom, max_imgpel_value);
   }
 
   if ((chroma_format_idc != YUV400) && (chroma_format_idc != YUV444) ) 
@@ -1431,8 +1491,8 @@ static void perform_mc_single_wp(Macroblock *currMB, ColorPlane pl, StorablePict
       int *weight = currSlice->wp_weight[pred_dir][ref_idx_wp];
       int *offset = currSlice->wp_offset[pred_dir][ref_idx_wp];
       get_block_chroma(list,vec1_x,vec1_y_cr,p_Vid->subpel_x,p_Vid->subpel_y,maxold_x,maxold_y,block_size_x_cr,block_size_y_cr,p_Vid->shiftpel_x,p_Vid->shiftpel_y,&tmp_block_l0[0][0],&tmp_block_l1[0][0] ,total_scale,no_ref_value,p_Vid);
-      weighted_mc_prediction(&currSlice->mb_pred[1][joff_cr], tmp_block_l0, block_size_y_cr, block_size_x_cr, ioff_cr, weight[1], offset[1], chroma_log2_weight, p_Vid->max_pel_value_comp[1]);
-      weighted_mc_prediction(&currSlice->mb_pred[2][joff_cr], tmp_block_l1, block_size_y_cr, block_size_x_cr, ioff_cr, weight[2], offset[2], chroma_log2_weight, p_Vid->max_pel_value_comp[2]);
+      mc_kernels.weighted_mc_prediction(&currSlice->mb_pred[1][joff_cr], tmp_block_l0, block_size_y_cr, block_size_x_cr, ioff_cr, weight[1], offset[1], chroma_log2_weight, p_Vid->max_pel_value_comp[1]);
+      mc_kernels.weighted_mc_prediction(&currSlice->mb_pred[2][joff_cr], tmp_block_l1, block_size_y_cr, block_size_x_cr, ioff_cr, weight[2], offset[2], chroma_log2_weight, p_Vid->max_pel_value_comp[2]);
     }
   }
 }
@@ -1461,7 +1521,6 @@ static void perform_mc_single(Macroblock *currMB, ColorPlane pl, StorablePicture
   // vars for get_block_luma
   int maxold_x = dec_picture->size_x_m1;
   int maxold_y = (currMB->mb_field) ? (dec_picture->size_y >> 1) - 1 : dec_picture->size_y_m1;   
-  int shift_x  = dec_picture->iLumaStride;
   int **tmp_res = currSlice->tmp_res;
   int max_imgpel_value = p_Vid->max_pel_value_comp[pl];
   imgpel no_ref_value = (imgpel) p_Vid->dc_pred_value_comp[pl];
@@ -1478,13 +1537,7 @@ static void perform_mc_single(Macroblock *currMB, ColorPlane pl, StorablePicture
   vec1_x = i4 * mv_mul + mv_array->mv_x;
   vec1_y = (currMB->block_y_aff + j) * mv_mul + mv_array->mv_y;
   
-  if (block_size_y > (p_Vid->iLumaPadY-4) && CheckVertMV(currMB, vec1_y, block_size_y))
-  {
-    get_block_luma(list, vec1_x, vec1_y, block_size_x, BLOCK_SIZE_8x8, tmp_block_l0, shift_x,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB);
-    get_block_luma(list, vec1_x, vec1_y+BLOCK_SIZE_8x8_SP, block_size_x, block_size_y-BLOCK_SIZE_8x8, tmp_block_l0+BLOCK_SIZE_8x8, shift_x,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB);
-  }
-  else
-    get_block_luma(list, vec1_x, vec1_y, block_size_x, block_size_y, tmp_block_l0,shift_x,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB);
+  get_block_luma(list, vec1_x, vec1_y, block_size_x, block_size_y, tmp_block_l0,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB, pl);
 
   mc_prediction(&currSlice->mb_pred[pl][joff], tmp_block_l0, block_size_y, block_size_x, ioff); 
 
@@ -1553,10 +1606,6 @@ static void perform_mc_bi_wp(Macroblock *currMB, ColorPlane pl, StorablePicture
   int *offset0 = currSlice->wp_offset[LIST_0 + wt_list_offset][l0_ref_idx];
   int *offset1 = currSlice->wp_offset[LIST_1 + wt_list_offset][l1_ref_idx];
   int maxold_y = (currMB->mb_field) ? (dec_picture->size_y >> 1) - 1 : dec_picture->size_y_m1;   
-  int pady = p_Vid->iLumaPadY;
-  int rlimit = maxold_y + pady - block_size_y - 2;
-  int llimit = 2 - pady;
-  int big_blocky = block_size_y > (pady - 4);
   StorablePicture *list0 = currSlice->listX[LIST_0 + list_offset][l0_refframe];
   StorablePicture *list1 = currSlice->listX[LIST_1 + list_offset][l1_refframe];
   imgpel **tmp_block_l0 = currSlice->tmp_block_l0;
@@ -1572,7 +1621,6 @@ static void perform_mc_bi_wp(Macroblock *currMB, ColorPlane pl, StorablePicture
 
   // vars for get_block_luma
   int maxold_x = dec_picture->size_x_m1;
-  int shift_x  = dec_picture->iLumaStride;
   int **tmp_res = currSlice->tmp_res;
   int max_imgpel_value = p_Vid->max_pel_value_comp[pl];
   imgpel no_ref_value = (imgpel) p_Vid->dc_pred_value_comp[pl];
@@ -1584,25 +1632,13 @@ static void perform_mc_bi_wp(Macroblock *currMB, ColorPlane pl, StorablePicture
   vec1_y = (block_y_aff + j) * mv_mul + l0_mv_array->mv_y;
   vec2_y = (block_y_aff + j) * mv_mul + l1_mv_array->mv_y;
 
-  if (big_blocky && check_vert_mv(llimit, vec1_y, rlimit))
-  {
-    get_block_luma(list0, vec1_x, vec1_y, block_size_x, BLOCK_SIZE_8x8, tmp_block_l0, shift_x,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB);
-    get_block_luma(list0, vec1_x, vec1_y+BLOCK_SIZE_8x8_SP, block_size_x, block_size_y-BLOCK_SIZE_8x8, tmp_block_l0+BLOCK_SIZE_8x8, shift_x,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB);
-  }
-  else
-    get_block_luma(list0, vec1_x, vec1_y, block_size_x, block_size_y, tmp_block_l0,shift_x,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB);
-  if (big_blocky && check_vert_mv(llimit, vec2_y,rlimit))
-  {
-    get_block_luma(list1, vec2_x, vec2_y, block_size_x, BLOCK_SIZE_8x8, tmp_block_l1, shift_x,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB);
-    get_block_luma(list1, vec2_x, vec2_y+BLOCK_SIZE_8x8_SP, block_size_x, block_size_y-BLOCK_SIZE_8x8, tmp_block_l1 + BLOCK_SIZE_8x8, shift_x,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB);
-  }
-  else
-    get_block_luma(list1, vec2_x, vec2_y, block_size_x, block_size_y, tmp_block_l1,shift_x,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB);
+  get_block_luma(list0, vec1_x, vec1_y, block_size_x, block_size_y, tmp_block_l0,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB, pl);
+  get_block_luma(list1, vec2_x, vec2_y, block_size_x, block_size_y, tmp_block_l1,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB, pl);
 
 
   wp_offset = ((offset0[pl] + offset1[pl] + 1) >>1);
   wp_denom  = pl > 0 ? currSlice->chroma_log2_weight_denom : currSlice->luma_log2_weight_denom;
-  weighted_bi_prediction(&currSlice->mb_pred[pl][joff][ioff], block0, block1, block_size_y, block_size_x, weight0[pl], weight1[pl], wp_offset, wp_denom + 1, max_imgpel_value);
+  mc_kernels.weighted_bi_prediction(&currSlice->mb_pred[pl][joff][ioff], block0, block1, block_size_y, block_size_x, weight0[pl], weight1[pl], wp_offset, wp_denom + 1, max_imgpel_value);
 
   if ((chroma_format_idc != YUV400) && (chroma_format_idc != YUV444) ) 
   {
@@ -1652,9 +1688,9 @@ static void perform_mc_bi_wp(Macroblock *currMB, ColorPlane pl, StorablePicture
     wp_offset = ((offset0[1] + offset1[1] + 1) >>1);
     get_block_chroma(list0,vec1_x,vec1_y_cr,subpel_x,subpel_y,maxold_x,maxold_y,block_size_x_cr,block_size_y_cr,shiftpel_x,shiftpel_y,block0,block2 ,total_scale,no_ref_value,p_Vid);
     get_block_chroma(list1,vec2_x,vec2_y_cr,subpel_x,subpel_y,maxold_x,maxold_y,block_size_x_cr,block_size_y_cr,shiftpel_x,shiftpel_y,block1,block3 ,total_scale,no_ref_value,p_Vid);
-    weighted_bi_prediction(&currSlice->mb_pred[1][joff_cr][ioff_cr],block0,block1,block_size_y_cr,block_size_x_cr,weight0[1],weight1[1],wp_offset,chroma_log2,p_Vid->max_pel_value_comp[1]);
+    mc_kernels.weighted_bi_prediction(&currSlice->mb_pred[1][joff_cr][ioff_cr],block0,block1,block_size_y_cr,block_size_x_cr,weight0[1],weight1[1],wp_offset,chroma_log2,p_Vid->max_pel_value_comp[1]);
     wp_offset = ((offset0[2] + offset1[2] + 1) >>1);
-    weighted_bi_prediction(&currSlice->mb_pred[2][joff_cr][ioff_cr],block2,block3,block_size_y_cr,block_size_x_cr,weight0[2],weight1[2],wp_offset,chroma_log2,p_Vid->max_pel_value_comp[2]);
+    mc_kernels.weighted_bi_prediction(&currSlice->mb_pred[2][joff_cr][ioff_cr],block2,block3,block_size_y_cr,block_size_x_cr,weight0[2],weight1[2],wp_offset,chroma_log2,p_Vid->max_pel_value_comp[2]);
   }    
 }
 
@@ -1679,10 +1715,6 @@ static void perform_mc_bi(Macroblock *currMB, ColorPlane pl, StorablePicture *de
   int list_offset = currMB->list_offset;
 
   int maxold_y = (currMB->mb_field) ? (dec_picture->size_y >> 1) - 1 : dec_picture->size_y_m1;   
-  int pady = p_Vid->iLumaPadY;
-  int rlimit = maxold_y + pady - block_size_y - 2;
-  int llimit = 2 - pady;
-  int big_blocky = block_size_y > (pady - 4);
   StorablePicture *list0 = currSlice->listX[LIST_0 + list_offset][l0_refframe];
   StorablePicture *list1 = currSlice->listX[LIST_1 + list_offset][l1_refframe];
   imgpel **tmp_block_l0 = currSlice->tmp_block_l0;
@@ -1695,7 +1727,6 @@ static void perform_mc_bi(Macroblock *currMB, ColorPlane pl, StorablePicture *de
   imgpel *block3 = tmp_block_l3[0];
   // vars for get_block_luma
   int maxold_x = dec_picture->size_x_m1;
-  int shift_x  = dec_picture->iLumaStride;
   int **tmp_res = currSlice->tmp_res;
   int max_imgpel_value = p_Vid->max_pel_value_comp[pl];
   imgpel no_ref_value = (imgpel) p_Vid->dc_pred_value_comp[pl];
@@ -1705,21 +1736,9 @@ static void perform_mc_bi(Macroblock *currMB, ColorPlane pl, StorablePicture *de
   vec2_x = i4 * mv_mul + l1_mv_array->mv_x;
   vec1_y = (block_y_aff + j) * mv_mul + l0_mv_array->mv_y;
   vec2_y = (block_y_aff + j) * mv_mul + l1_mv_array->mv_y;
-  if (big_blocky && check_vert_mv(llimit, vec1_y, rlimit))
-  {
-    get_block_luma(list0, vec1_x, vec1_y, block_size_x, BLOCK_SIZE_8x8, tmp_block_l0, shift_x,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB);
-    get_block_luma(list0, vec1_x, vec1_y+BLOCK_SIZE_8x8_SP, block_size_x, block_size_y-BLOCK_SIZE_8x8, tmp_block_l0+BLOCK_SIZE_8x8, shift_x,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB);
-  }
-  else
-    get_block_luma(list0, vec1_x, vec1_y, block_size_x, block_size_y, tmp_block_l0,shift_x,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB);
-  if (big_blocky && check_vert_mv(llimit, vec2_y,rlimit))
-  {
-    get_block_luma(list1, vec2_x, vec2_y, block_size_x, BLOCK_SIZE_8x8, tmp_block_l1, shift_x,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB);
-    get_block_luma(list1, vec2_x, vec2_y+BLOCK_SIZE_8x8_SP, block_size_x, block_size_y-BLOCK_SIZE_8x8, tmp_block_l1 + BLOCK_SIZE_8x8, shift_x,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB);
-  }
-  else
-    get_block_luma(list1, vec2_x, vec2_y, block_size_x, block_size_y, tmp_block_l1,shift_x,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB);
-  bi_prediction(&currSlice->mb_pred[pl][joff],tmp_block_l0,tmp_block_l1, block_size_y, block_size_x, ioff); 
+  get_block_luma(list0, vec1_x, vec1_y, block_size_x, block_size_y, tmp_block_l0,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB, pl);
+  get_block_luma(list1, vec2_x, vec2_y, block_size_x, block_size_y, tmp_block_l1,maxold_x,maxold_y,tmp_res,max_imgpel_value,no_ref_value, currMB, pl);
+  mc_kernels.bi_prediction(&currSlice->mb_pred[pl][joff],tmp_block_l0,tmp_block_l1, block_size_y, block_size_x, ioff); 
 
   if ((chroma_format_idc != YUV400) && (chroma_format_idc != YUV444) ) 
   {
@@ -1765,8 +1784,8 @@ static void perform_mc_bi(Macroblock *currMB, ColorPlane pl, StorablePicture *de
     no_ref_value = (imgpel)p_Vid->dc_pred_value_comp[1];
     get_block_chroma(list0,vec1_x,vec1_y_cr,subpel_x,subpel_y,maxold_x,maxold_y,block_size_x_cr,block_size_y_cr,shiftpel_x,shiftpel_y,block0,block2 ,total_scale,no_ref_value,p_Vid);
     get_block_chroma(list1,vec2_x,vec2_y_cr,subpel_x,subpel_y,maxold_x,maxold_y,block_size_x_cr,block_size_y_cr,shiftpel_x,shiftpel_y,block1,block3 ,total_scale,no_ref_value,p_Vid);
-    bi_prediction(&currSlice->mb_pred[1][joff_cr],tmp_block_l0,tmp_block_l1, block_size_y_cr, block_size_x_cr, ioff_cr);
-    bi_prediction(&currSlice->mb_pred[2][joff_cr],tmp_block_l2,tmp_block_l3, block_size_y_cr, block_size_x_cr, ioff_cr);
+    mc_kernels.bi_prediction(&currSlice->mb_pred[1][joff_cr],tmp_block_l0,tmp_block_l1, block_size_y_cr, block_size_x_cr, ioff_cr);
+    mc_kernels.bi_prediction(&currSlice->mb_pred[2][joff_cr],tmp_block_l2,tmp_block_l3, block_size_y_cr, block_size_x_cr, ioff_cr);
   }
 }
 
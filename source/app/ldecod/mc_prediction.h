@@ -19,15 +19,39 @@
 
 #include "global.h"
 #include "mbuffer.h"
+#include "cpu_features.h"
+
+//! cur_img points at the integer sample position of the block in a plane of the given stride
+typedef void (*LumaPredFunc)(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value);
+
+//! motion compensation kernels, built at start-up by init_mc_kernels() and chosen per sequence by select_mc_kernels()
+typedef struct mc_kernels
+{
+  LumaPredFunc get_luma[4][4];     //!< quarter sample luma interpolation indexed by [dy][dx], [0][0] is unused
+  void (*get_chroma_0X)         (imgpel *block, imgpel *cur_img, int span, int block_size_y, int block_size_x, int w00, int w01, int total_scale);
+  void (*get_chroma_X0)         (imgpel *block, imgpel *cur_img, int span, int block_size_y, int block_size_x, int w00, int w10, int total_scale);
+  void (*get_chroma_XY)         (imgpel *block, imgpel *cur_img, int span, int block_size_y, int block_size_x, int w00, int w01, int w10, int w11, int total_scale);
+  void (*weighted_mc_prediction)(imgpel **mb_pred, imgpel **block, int block_size_y, int block_size_x, int ioff, int wp_scale, int wp_offset, int weight_denom, int color_clip);
+  void (*bi_prediction)         (imgpel **mb_pred, imgpel **block_l0, imgpel **block_l1, int block_size_y, int block_size_x, int ioff);
+  void (*weighted_bi_prediction)(imgpel *mb_pred, imgpel *block_l0, imgpel *block_l1, int block_size_y, int block_size_x, int wp_scale_l0, int wp_scale_l1, int wp_offset, int weight_denom, int color_clip);
+} McKernels;
 
 extern int  allocate_pred_mem(Slice *currSlice);
 extern void free_pred_mem    (Slice *currSlice);
 
 extern void get_block_luma(StorablePicture *curr_ref, int x_pos, int y_pos, int block_size_x, int block_size_y, imgpel **block,
-                           int shift_x,int maxold_x,int maxold_y,int **tmp_res,int max_imgpel_value,imgpel no_ref_value,Macroblock *currMB);
+                           int maxold_x,int maxold_y,int **tmp_res,int max_imgpel_value,imgpel no_ref_value,Macroblock *currMB,ColorPlane pl);
 
 extern void intra_cr_decoding    (Macroblock *currMB, int yuv);
 extern void prepare_direct_params(Macroblock *currMB, StorablePicture *dec_picture, MotionVector *pmvl0, MotionVector *pmvl1,char *l0_rFrame, char *l1_rFrame);
 extern void perform_mc           (Macroblock *currMB, ColorPlane pl, StorablePicture *dec_picture, int pred_dir, int i, int j, int block_size_x, int block_size_y);
+
+extern void init_mc_kernels      (int simd_level);
+extern void set_mc_kernels       (McKernels *kernels, int simd_level, int samples_8bit);
+extern void select_mc_kernels    (int bitdepth_luma, int bitdepth_chroma);
+extern void init_mc_kernels_sse41(McKernels *kernels);
+extern void init_mc_kernels_avx2 (McKernels *kernels);
+extern void init_mc_kernels_8bit_sse41(McKernels *kernels);
+extern void init_mc_kernels_8bit_avx2 (McKernels *kernels);
 #endif
 
@@ -0,0 +1,985 @@
+
+/*!
+ *************************************************************************************
+ * \file mc_prediction_simd.c
+ *
+ * \brief
+ *    SSE4.1 and AVX2 versions of the motion compensation kernels of mc_prediction.c
+ *
+ *    All kernels are bit exact with the C versions. Intermediate results are kept
+ *    in 32 bit lanes so that every supported sample bit depth is handled. Blocks
+ *    narrower than a vector fall back to the kernel they replace.
+ *
+ *    The 8 bit kernels are used while the active sequence has 8 bit samples.
+ *    Their interpolation sums fit in 16 bit lanes, so one vector filters twice
+ *    as many samples.
+ *
+ *************************************************************************************
+ */
+#include "global.h"
+#include "mc_prediction.h"
+
+#if HAVE_X86_SIMD && (IMGTYPE == 1)
+
+#include <immintrin.h>
+
+static McKernels sse41_fallback;   //!< kernels replaced by init_mc_kernels_sse41()
+static McKernels avx2_fallback;    //!< kernels replaced by init_mc_kernels_avx2()
+static McKernels sse41_8bit_fallback; //!< kernels replaced by init_mc_kernels_8bit_sse41()
+
+/*
+ ************************************************************************
+ * SSE4.1 helpers (four 32 bit lanes)
+ ************************************************************************
+ */
+static inline __m128i load4_epi32(const imgpel *p)
+{
+  return _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *) p));
+}
+
+//! (a + f) - 5 * (b + e) + 20 * (c + d)
+static inline __m128i tap6_epi32(__m128i a, __m128i b, __m128i c, __m128i d, __m128i e, __m128i f)
+{
+  __m128i cd = _mm_add_epi32(c, d);
+  __m128i be = _mm_add_epi32(b, e);
+  __m128i r  = _mm_add_epi32(a, f);
+
+  r = _mm_add_epi32(r, _mm_add_epi32(_mm_slli_epi32(cd, 4), _mm_slli_epi32(cd, 2)));
+  return _mm_sub_epi32(r, _mm_add_epi32(_mm_slli_epi32(be, 2), be));
+}
+
+static inline __m128i tap6_h4(const imgpel *p)
+{
+  return tap6_epi32(load4_epi32(p), load4_epi32(p + 1), load4_epi32(p + 2), load4_epi32(p + 3), load4_epi32(p + 4), load4_epi32(p + 5));
+}
+
+static inline __m128i tap6_v4(const imgpel *p, int stride)
+{
+  return tap6_epi32(load4_epi32(p - 2 * stride), load4_epi32(p - stride), load4_epi32(p),
+                    load4_epi32(p + stride), load4_epi32(p + 2 * stride), load4_epi32(p + 3 * stride));
+}
+
+static inline __m128i tap6_int4(int **rows, int x)
+{
+  return tap6_epi32(_mm_loadu_si128((const __m128i *) &rows[0][x]), _mm_loadu_si128((const __m128i *) &rows[1][x]),
+                    _mm_loadu_si128((const __m128i *) &rows[2][x]), _mm_loadu_si128((const __m128i *) &rows[3][x]),
+                    _mm_loadu_si128((const __m128i *) &rows[4][x]), _mm_loadu_si128((const __m128i *) &rows[5][x]));
+}
+
+static inline __m128i round_shift(__m128i v, int shift)
+{
+  return _mm_srai_epi32(_mm_add_epi32(v, _mm_set1_epi32(1 << (shift - 1))), shift);
+}
+
+//! stores four lanes clipped to [0, max]
+static inline void store4_clip(imgpel *dst, __m128i v, __m128i max)
+{
+  _mm_storel_epi64((__m128i *) dst, _mm_min_epu16(_mm_packus_epi32(v, v), max));
+}
+
+//! stores eight lanes clipped to [0, max]
+static inline void store8_clip(imgpel *dst, __m128i lo, __m128i hi, __m128i max)
+{
+  _mm_storeu_si128((__m128i *) dst, _mm_min_epu16(_mm_packus_epi32(lo, hi), max));
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Half sample horizontal filter of the block at src
+ ************************************************************************
+ */
+static void luma_filter_h_sse41(imgpel **dst, const imgpel *src, int stride, int block_size_y, int block_size_x, int max_imgpel_value)
+{
+  __m128i max = _mm_set1_epi16((short) max_imgpel_value);
+  int i, j;
+
+  for (j = 0; j < block_size_y; j++)
+  {
+    const imgpel *s = src + j * stride - 2;
+    imgpel *d = dst[j];
+
+    if (block_size_x == 4)
+      store4_clip(d, round_shift(tap6_h4(s), 5), max);
+    else
+    {
+      for (i = 0; i < block_size_x; i += 8)
+        store8_clip(d + i, round_shift(tap6_h4(s + i), 5), round_shift(tap6_h4(s + i + 4), 5), max);
+    }
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Half sample vertical filter of the block at src
+ ************************************************************************
+ */
+static void luma_filter_v_sse41(imgpel **dst, const imgpel *src, int stride, int block_size_y, int block_size_x, int max_imgpel_value)
+{
+  __m128i max = _mm_set1_epi16((short) max_imgpel_value);
+  int i, j;
+
+  for (j = 0; j < block_size_y; j++)
+  {
+    imgpel *d = dst[j];
+
+    if (block_size_x == 4)
+      store4_clip(d, round_shift(tap6_v4(src + j * stride, stride), 5), max);
+    else
+    {
+      for (i = 0; i < block_size_x; i += 8)
+        store8_clip(d + i, round_shift(tap6_v4(src + j * stride + i, stride), 5), round_shift(tap6_v4(src + j * stride + i + 4, stride), 5), max);
+    }
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Centre half sample position: unrounded horizontal pass into tmp_res,
+ *    vertical pass over tmp_res
+ ************************************************************************
+ */
+static void luma_filter_hv_sse41(imgpel **dst, const imgpel *src, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value)
+{
+  __m128i max = _mm_set1_epi16((short) max_imgpel_value);
+  int i, j;
+
+  for (j = 0; j < block_size_y + 5; j++)
+  {
+    const imgpel *s = src + (j - 2) * stride - 2;
+    for (i = 0; i < block_size_x; i += 4)
+      _mm_storeu_si128((__m128i *) &tmp_res[j][i], tap6_h4(s + i));
+  }
+
+  for (j = 0; j < block_size_y; j++)
+  {
+    imgpel *d = dst[j];
+
+    if (block_size_x == 4)
+      store4_clip(d, round_shift(tap6_int4(&tmp_res[j], 0), 10), max);
+    else
+    {
+      for (i = 0; i < block_size_x; i += 8)
+        store8_clip(d + i, round_shift(tap6_int4(&tmp_res[j], i), 10), round_shift(tap6_int4(&tmp_res[j], i + 4), 10), max);
+    }
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    dst = (dst + src + 1) >> 1 with src a block of the given stride
+ ************************************************************************
+ */
+static void luma_average_sse41(imgpel **dst, const imgpel *src, int stride, int block_size_y, int block_size_x)
+{
+  int i, j;
+
+  for (j = 0; j < block_size_y; j++)
+  {
+    const imgpel *s = src + j * stride;
+    imgpel *d = dst[j];
+
+    if (block_size_x == 4)
+      _mm_storel_epi64((__m128i *) d, _mm_avg_epu16(_mm_loadl_epi64((const __m128i *) d), _mm_loadl_epi64((const __m128i *) s)));
+    else
+    {
+      for (i = 0; i < block_size_x; i += 8)
+        _mm_storeu_si128((__m128i *) (d + i), _mm_avg_epu16(_mm_loadu_si128((const __m128i *) (d + i)), _mm_loadu_si128((const __m128i *) (s + i))));
+    }
+  }
+}
+
+/*
+ ************************************************************************
+ * AVX2 helpers (eight 32 bit lanes). Four sample wide blocks use the
+ * SSE4.1 filters.
+ ************************************************************************
+ */
+static TARGET_AVX2 inline __m256i load8_epi32_avx2(const imgpel *p)
+{
+  return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) p));
+}
+
+static TARGET_AVX2 inline __m256i tap6_epi32_avx2(__m256i a, __m256i b, __m256i c, __m256i d, __m256i e, __m256i f)
+{
+  __m256i cd = _mm256_add_epi32(c, d);
+  __m256i be = _mm256_add_epi32(b, e);
+  __m256i r  = _mm256_add_epi32(a, f);
+
+  r = _mm256_add_epi32(r, _mm256_add_epi32(_mm256_slli_epi32(cd, 4), _mm256_slli_epi32(cd, 2)));
+  return _mm256_sub_epi32(r, _mm256_add_epi32(_mm256_slli_epi32(be, 2), be));
+}
+
+static TARGET_AVX2 inline __m256i tap6_h8_avx2(const imgpel *p)
+{
+  return tap6_epi32_avx2(load8_epi32_avx2(p), load8_epi32_avx2(p + 1), load8_epi32_avx2(p + 2),
+                         load8_epi32_avx2(p + 3), load8_epi32_avx2(p + 4), load8_epi32_avx2(p + 5));
+}
+
+static TARGET_AVX2 inline __m256i tap6_v8_avx2(const imgpel *p, int stride)
+{
+  return tap6_epi32_avx2(load8_epi32_avx2(p - 2 * stride), load8_epi32_avx2(p - stride), load8_epi32_avx2(p),
+                         load8_epi32_avx2(p + stride), load8_epi32_avx2(p + 2 * stride), load8_epi32_avx2(p + 3 * stride));
+}
+
+static TARGET_AVX2 inline __m256i tap6_int8_avx2(int **rows, int x)
+{
+  return tap6_epi32_avx2(_mm256_loadu_si256((const __m256i *) &rows[0][x]), _mm256_loadu_si256((const __m256i *) &rows[1][x]),
+                         _mm256_loadu_si256((const __m256i *) &rows[2][x]), _mm256_loadu_si256((const __m256i *) &rows[3][x]),
+                         _mm256_loadu_si256((const __m256i *) &rows[4][x]), _mm256_loadu_si256((const __m256i *) &rows[5][x]));
+}
+
+static TARGET_AVX2 inline __m256i round_shift_avx2(__m256i v, int shift)
+{
+  return _mm256_srai_epi32(_mm256_add_epi32(v, _mm256_set1_epi32(1 << (shift - 1))), shift);
+}
+
+static TARGET_AVX2 inline void store8_clip_avx2(imgpel *dst, __m256i v, __m128i max)
+{
+  __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+  _mm_storeu_si128((__m128i *) dst, _mm_min_epu16(packed, max));
+}
+
+static TARGET_AVX2 void luma_filter_h_avx2(imgpel **dst, const imgpel *src, int stride, int block_size_y, int block_size_x, int max_imgpel_value)
+{
+  __m128i max = _mm_set1_epi16((short) max_imgpel_value);
+  int i, j;
+
+  if (block_size_x == 4)
+  {
+    luma_filter_h_sse41(dst, src, stride, block_size_y, block_size_x, max_imgpel_value);
+    return;
+  }
+
+  for (j = 0; j < block_size_y; j++)
+  {
+    const imgpel *s = src + j * stride - 2;
+    for (i = 0; i < block_size_x; i += 8)
+      store8_clip_avx2(dst[j] + i, round_shift_avx2(tap6_h8_avx2(s + i), 5), max);
+  }
+}
+
+static TARGET_AVX2 void luma_filter_v_avx2(imgpel **dst, const imgpel *src, int stride, int block_size_y, int block_size_x, int max_imgpel_value)
+{
+  __m128i max = _mm_set1_epi16((short) max_imgpel_value);
+  int i, j;
+
+  if (block_size_x == 4)
+  {
+    luma_filter_v_sse41(dst, src, stride, block_size_y, block_size_x, max_imgpel_value);
+    return;
+  }
+
+  for (j = 0; j < block_size_y; j++)
+  {
+    for (i = 0; i < block_size_x; i += 8)
+      store8_clip_avx2(dst[j] + i, round_shift_avx2(tap6_v8_avx2(src + j * stride + i, stride), 5), max);
+  }
+}
+
+static TARGET_AVX2 void luma_filter_hv_avx2(imgpel **dst, const imgpel *src, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value)
+{
+  __m128i max = _mm_set1_epi16((short) max_imgpel_value);
+  int i, j;
+
+  if (block_size_x == 4)
+  {
+    luma_filter_hv_sse41(dst, src, stride, tmp_res, block_size_y, block_size_x, max_imgpel_value);
+    return;
+  }
+
+  for (j = 0; j < block_size_y + 5; j++)
+  {
+    const imgpel *s = src + (j - 2) * stride - 2;
+    for (i = 0; i < block_size_x; i += 8)
+      _mm256_storeu_si256((__m256i *) &tmp_res[j][i], tap6_h8_avx2(s + i));
+  }
+
+  for (j = 0; j < block_size_y; j++)
+  {
+    for (i = 0; i < block_size_x; i += 8)
+      store8_clip_avx2(dst[j] + i, round_shift_avx2(tap6_int8_avx2(&tmp_res[j], i), 10), max);
+  }
+}
+
+static TARGET_AVX2 void luma_average_avx2(imgpel **dst, const imgpel *src, int stride, int block_size_y, int block_size_x)
+{
+  int j;
+
+  if (block_size_x != 16)
+  {
+    luma_average_sse41(dst, src, stride, block_size_y, block_size_x);
+    return;
+  }
+
+  for (j = 0; j < block_size_y; j++)
+  {
+    const imgpel *s = src + j * stride;
+    imgpel *d = dst[j];
+    _mm256_storeu_si256((__m256i *) d, _mm256_avg_epu16(_mm256_loadu_si256((const __m256i *) d), _mm256_loadu_si256((const __m256i *) s)));
+  }
+}
+
+/*
+ ************************************************************************
+ * Quarter sample positions, built from the half sample filters exactly
+ * as in mc_prediction.c: (a + b + 1) >> 1 of the two nearest integer or
+ * half sample positions
+ ************************************************************************
+ */
+#define TMP_BLOCK(name) \
+  imgpel name##_buf[MB_BLOCK_SIZE][MB_BLOCK_SIZE]; \
+  imgpel *name[MB_BLOCK_SIZE]; \
+  { int k; for (k = 0; k < MB_BLOCK_SIZE; k++) name[k] = name##_buf[k]; }
+
+#define DEFINE_LUMA_POSITIONS(isa) \
+static void get_luma_10_##isa(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value) \
+{ \
+  luma_filter_h_##isa(block, cur_img, stride, block_size_y, block_size_x, max_imgpel_value); \
+  luma_average_##isa(block, cur_img, stride, block_size_y, block_size_x); \
+} \
+static void get_luma_20_##isa(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value) \
+{ \
+  luma_filter_h_##isa(block, cur_img, stride, block_size_y, block_size_x, max_imgpel_value); \
+} \
+static void get_luma_30_##isa(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value) \
+{ \
+  luma_filter_h_##isa(block, cur_img, stride, block_size_y, block_size_x, max_imgpel_value); \
+  luma_average_##isa(block, cur_img + 1, stride, block_size_y, block_size_x); \
+} \
+static void get_luma_01_##isa(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value) \
+{ \
+  luma_filter_v_##isa(block, cur_img, stride, block_size_y, block_size_x, max_imgpel_value); \
+  luma_average_##isa(block, cur_img, stride, block_size_y, block_size_x); \
+} \
+static void get_luma_02_##isa(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value) \
+{ \
+  luma_filter_v_##isa(block, cur_img, stride, block_size_y, block_size_x, max_imgpel_value); \
+} \
+static void get_luma_03_##isa(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value) \
+{ \
+  luma_filter_v_##isa(block, cur_img, stride, block_size_y, block_size_x, max_imgpel_value); \
+  luma_average_##isa(block, cur_img + stride, stride, block_size_y, block_size_x); \
+} \
+static void get_luma_11_##isa(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value) \
+{ \
+  TMP_BLOCK(tmp) \
+  luma_filter_h_##isa(block, cur_img, stride, block_size_y, block_size_x, max_imgpel_value); \
+  luma_filter_v_##isa(tmp, cur_img, stride, block_size_y, block_size_x, max_imgpel_value); \
+  luma_average_##isa(block, tmp_buf[0], MB_BLOCK_SIZE, block_size_y, block_size_x); \
+} \
+static void get_luma_13_##isa(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value) \
+{ \
+  TMP_BLOCK(tmp) \
+  luma_filter_h_##isa(block, cur_img + stride, stride, block_size_y, block_size_x, max_imgpel_value); \
+  luma_filter_v_##isa(tmp, cur_img, stride, block_size_y, block_size_x, max_imgpel_value); \
+  luma_average_##isa(block, tmp_buf[0], MB_BLOCK_SIZE, block_size_y, block_size_x); \
+} \
+static void get_luma_31_##isa(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value) \
+{ \
+  TMP_BLOCK(tmp) \
+  luma_filter_h_##isa(block, cur_img, stride, block_size_y, block_size_x, max_imgpel_value); \
+  luma_filter_v_##isa(tmp, cur_img + 1, stride, block_size_y, block_size_x, max_imgpel_value); \
+  luma_average_##isa(block, tmp_buf[0], MB_BLOCK_SIZE, block_size_y, block_size_x); \
+} \
+static void get_luma_33_##isa(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value) \
+{ \
+  TMP_BLOCK(tmp) \
+  luma_filter_h_##isa(block, cur_img + stride, stride, block_size_y, block_size_x, max_imgpel_value); \
+  luma_filter_v_##isa(tmp, cur_img + 1, stride, block_size_y, block_size_x, max_imgpel_value); \
+  luma_average_##isa(block, tmp_buf[0], MB_BLOCK_SIZE, block_size_y, block_size_x); \
+} \
+static void get_luma_22_##isa(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value) \
+{ \
+  luma_filter_hv_##isa(block, cur_img, stride, tmp_res, block_size_y, block_size_x, max_imgpel_value); \
+} \
+static void get_luma_21_##isa(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value) \
+{ \
+  TMP_BLOCK(tmp) \
+  luma_filter_hv_##isa(block, cur_img, stride, tmp_res, block_size_y, block_size_x, max_imgpel_value); \
+  luma_filter_h_##isa(tmp, cur_img, stride, block_size_y, block_size_x, max_imgpel_value); \
+  luma_average_##isa(block, tmp_buf[0], MB_BLOCK_SIZE, block_size_y, block_size_x); \
+} \
+static void get_luma_23_##isa(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value) \
+{ \
+  TMP_BLOCK(tmp) \
+  luma_filter_hv_##isa(block, cur_img, stride, tmp_res, block_size_y, block_size_x, max_imgpel_value); \
+  luma_filter_h_##isa(tmp, cur_img + stride, stride, block_size_y, block_size_x, max_imgpel_value); \
+  luma_average_##isa(block, tmp_buf[0], MB_BLOCK_SIZE, block_size_y, block_size_x); \
+} \
+static void get_luma_12_##isa(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value) \
+{ \
+  TMP_BLOCK(tmp) \
+  luma_filter_hv_##isa(block, cur_img, stride, tmp_res, block_size_y, block_size_x, max_imgpel_value); \
+  luma_filter_v_##isa(tmp, cur_img, stride, block_size_y, block_size_x, max_imgpel_value); \
+  luma_average_##isa(block, tmp_buf[0], MB_BLOCK_SIZE, block_size_y, block_size_x); \
+} \
+static void get_luma_32_##isa(imgpel **block, imgpel *cur_img, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value) \
+{ \
+  TMP_BLOCK(tmp) \
+  luma_filter_hv_##isa(block, cur_img, stride, tmp_res, block_size_y, block_size_x, max_imgpel_value); \
+  luma_filter_v_##isa(tmp, cur_img + 1, stride, block_size_y, block_size_x, max_imgpel_value); \
+  luma_average_##isa(block, tmp_buf[0], MB_BLOCK_SIZE, block_size_y, block_size_x); \
+} \
+static void set_luma_positions_##isa(McKernels *kernels) \
+{ \
+  kernels->get_luma[0][1] = get_luma_10_##isa; \
+  kernels->get_luma[0][2] = get_luma_20_##isa; \
+  kernels->get_luma[0][3] = get_luma_30_##isa; \
+  kernels->get_luma[1][0] = get_luma_01_##isa; \
+  kernels->get_luma[1][1] = get_luma_11_##isa; \
+  kernels->get_luma[1][2] = get_luma_21_##isa; \
+  kernels->get_luma[1][3] = get_luma_31_##isa; \
+  kernels->get_luma[2][0] = get_luma_02_##isa; \
+  kernels->get_luma[2][1] = get_luma_12_##isa; \
+  kernels->get_luma[2][2] = get_luma_22_##isa; \
+  kernels->get_luma[2][3] = get_luma_32_##isa; \
+  kernels->get_luma[3][0] = get_luma_03_##isa; \
+  kernels->get_luma[3][1] = get_luma_13_##isa; \
+  kernels->get_luma[3][2] = get_luma_23_##isa; \
+  kernels->get_luma[3][3] = get_luma_33_##isa; \
+}
+
+DEFINE_LUMA_POSITIONS(sse41)
+DEFINE_LUMA_POSITIONS(avx2)
+
+/*
+ ************************************************************************
+ * 8 bit luma filters. A 6 tap sum of 8 bit samples lies in
+ * [-2550, 10710] and fits in 16 bit lanes. The vertical pass of the
+ * centre position multiplies such sums and uses _mm_madd_epi16.
+ ************************************************************************
+ */
+
+//! (a + f) - 5 * (b + e) + 20 * (c + d)
+static inline __m128i tap6_epi16(__m128i a, __m128i b, __m128i c, __m128i d, __m128i e, __m128i f)
+{
+  __m128i r = _mm_add_epi16(a, f);
+
+  r = _mm_add_epi16(r, _mm_mullo_epi16(_mm_add_epi16(c, d), _mm_set1_epi16(20)));
+  return _mm_sub_epi16(r, _mm_mullo_epi16(_mm_add_epi16(b, e), _mm_set1_epi16(5)));
+}
+
+static inline __m128i load_8bit(const imgpel *p, int block_size_x)
+{
+  return (block_size_x == 4) ? _mm_loadl_epi64((const __m128i *) p) : _mm_loadu_si128((const __m128i *) p);
+}
+
+static inline __m128i tap6_h_8bit(const imgpel *p, int block_size_x)
+{
+  return tap6_epi16(load_8bit(p, block_size_x), load_8bit(p + 1, block_size_x), load_8bit(p + 2, block_size_x),
+                    load_8bit(p + 3, block_size_x), load_8bit(p + 4, block_size_x), load_8bit(p + 5, block_size_x));
+}
+
+static inline __m128i tap6_v_8bit(const imgpel *p, int stride, int block_size_x)
+{
+  return tap6_epi16(load_8bit(p - 2 * stride, block_size_x), load_8bit(p - stride, block_size_x), load_8bit(p, block_size_x),
+                    load_8bit(p + stride, block_size_x), load_8bit(p + 2 * stride, block_size_x), load_8bit(p + 3 * stride, block_size_x));
+}
+
+//! stores (v + 16) >> 5 clipped to [0, max], four or eight lanes
+static inline void store_8bit(imgpel *dst, __m128i v, __m128i max, int block_size_x)
+{
+  v = _mm_srai_epi16(_mm_add_epi16(v, _mm_set1_epi16(16)), 5);
+  v = _mm_min_epi16(_mm_max_epi16(v, _mm_setzero_si128()), max);
+  if (block_size_x == 4)
+    _mm_storel_epi64((__m128i *) dst, v);
+  else
+    _mm_storeu_si128((__m128i *) dst, v);
+}
+
+static void luma_filter_h_8bit_sse41(imgpel **dst, const imgpel *src, int stride, int block_size_y, int block_size_x, int max_imgpel_value)
+{
+  __m128i max = _mm_set1_epi16((short) max_imgpel_value);
+  int i, j;
+
+  for (j = 0; j < block_size_y; j++)
+  {
+    const imgpel *s = src + j * stride - 2;
+    for (i = 0; i < block_size_x; i += 8)
+      store_8bit(dst[j] + i, tap6_h_8bit(s + i, block_size_x), max, block_size_x);
+  }
+}
+
+static void luma_filter_v_8bit_sse41(imgpel **dst, const imgpel *src, int stride, int block_size_y, int block_size_x, int max_imgpel_value)
+{
+  __m128i max = _mm_set1_epi16((short) max_imgpel_value);
+  int i, j;
+
+  for (j = 0; j < block_size_y; j++)
+  {
+    for (i = 0; i < block_size_x; i += 8)
+      store_8bit(dst[j] + i, tap6_v_8bit(src + j * stride + i, stride, block_size_x), max, block_size_x);
+  }
+}
+
+//! a - 5 * b + 20 * c + 20 * d - 5 * e + f of 16 bit lanes in 32 bit lanes, low or high half
+static inline __m128i tap6_madd(__m128i ab, __m128i cd, __m128i ef)
+{
+  __m128i r = _mm_madd_epi16(ab, _mm_set1_epi32((int) 0xFFFB0001));   // ( 1, -5)
+
+  r = _mm_add_epi32(r, _mm_madd_epi16(cd, _mm_set1_epi16(20)));
+  return _mm_add_epi32(r, _mm_madd_epi16(ef, _mm_set1_epi32(0x0001FFFB)));  // (-5,  1)
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Centre half sample position with the unrounded horizontal pass kept
+ *    in 16 bits. tmp_res is not used.
+ ************************************************************************
+ */
+static void luma_filter_hv_8bit_sse41(imgpel **dst, const imgpel *src, int stride, int **tmp_res, int block_size_y, int block_size_x, int max_imgpel_value)
+{
+  ALIGNED(16) short tmp[MB_BLOCK_SIZE + 5][MB_BLOCK_SIZE];
+  __m128i max = _mm_set1_epi16((short) max_imgpel_value);
+  int i, j;
+
+  for (j = 0; j < block_size_y + 5; j++)
+  {
+    const imgpel *s = src + (j - 2) * stride - 2;
+    for (i = 0; i < block_size_x; i += 8)
+    {
+      __m128i v = tap6_h_8bit(s + i, block_size_x);
+      if (block_size_x == 4)
+        _mm_storel_epi64((__m128i *) &tmp[j][i], v);
+      else
+        _mm_store_si128((__m128i *) &tmp[j][i], v);
+    }
+  }
+
+  for (j = 0; j < block_size_y; j++)
+  {
+    for (i = 0; i < block_size_x; i += 8)
+    {
+      __m128i r0 = _mm_load_si128((const __m128i *) &tmp[j    ][i]);
+      __m128i r1 = _mm_load_si128((const __m128i *) &tmp[j + 1][i]);
+      __m128i r2 = _mm_load_si128((const __m128i *) &tmp[j + 2][i]);
+      __m128i r3 = _mm_load_si128((const __m128i *) &tmp[j + 3][i]);
+      __m128i r4 = _mm_load_si128((const __m128i *) &tmp[j + 4][i]);
+      __m128i r5 = _mm_load_si128((const __m128i *) &tmp[j + 5][i]);
+      __m128i lo = round_shift(tap6_madd(_mm_unpacklo_epi16(r0, r1), _mm_unpacklo_epi16(r2, r3), _mm_unpacklo_epi16(r4, r5)), 10);
+
+      if (block_size_x == 4)
+        store4_clip(dst[j] + i, lo, max);
+      else
+        store8_clip(dst[j] + i, lo, round_shift(tap6_madd(_mm_unpackhi_epi16(r0, r1), _mm_unpackhi_epi16(r2, r3), _mm_unpackhi_epi16(r4, r5)), 10), max);
+    }
+  }
+}
+
+/*
+ ************************************************************************
+ * AVX2 8 bit luma filters for 16 sample wide blocks
+ ************************************************************************
+ */
+static TARGET_AVX2 inline __m256i tap6_epi16_avx2(__m256i a, __m256i b, __m256i c, __m256i d, __m256i e, __m256i f)
+{
+  __m256i r = _mm256_add_epi16(a, f);
+
+  r = _mm256_add_epi16(r, _mm256_mullo_epi16(_mm256_add_epi16(c, d), _mm256_set1_epi16(20)));
+  return _mm256_sub_epi16(r, _mm256_mullo_epi16(_mm256_add_epi16(b, e), _mm256_set1_epi16(5)));
+}
+
+static TARGET_AVX2 inline __m256i load16_avx2(const imgpel *p)
+{
+  return _mm256_loadu_si256((const __m256i *) p);
+}
+
+static TARGET_AVX2 inline void store16_8bit_avx2(imgpel *dst, __m256i v, __m256i max)
+{
+  v = _mm256_srai_epi16(_mm256_add_epi16(v, _mm256_set1_epi16(16)), 5);
+  _mm256_storeu_si256((__m256i *) dst, _mm256_min_epi16(_mm256_max_epi16(v, _mm256_setzero_si256()), max));
+}
+
+static TARGET_AVX2 void luma_filter_h_8bit_avx2(imgpel **dst, const imgpel *src, int stride, int block_size_y, int block_size_x, int max_imgpel_value)
+{
+  __m256i max = _mm256_set1_epi16((short) max_imgpel_value);
+  int j;
+
+  if (block_size_x != 16)
+  {
+    luma_filter_h_8bit_sse41(dst, src, stride, block_size_y, block_size_x, max_imgpel_value);
+    return;
+  }
+
+  for (j = 0; j < block_size_y; j++)
+  {
+    const imgpel *s = src + j * stride - 2;
+    store16_8bit_avx2(dst[j], tap6_epi16_avx2(load16_avx2(s), load16_avx2(s + 1), load16_avx2(s + 2),
+                                              load16_avx2(s + 3), load16_avx2(s + 4), load16_avx2(s + 5)), max);
+  }
+}
+
+static TARGET_AVX2 void luma_filter_v_8bit_avx2(imgpel **dst, const imgpel *src, int stride, int block_size_y, int block_size_x, int max_imgpel_value)
+{
+  __m256i max = _mm256_set1_epi16((short) max_imgpel_value);
+  int j;
+
+  if (block_size_x != 16)
+  {
+    luma_filter_v_8bit_sse41(dst, src, stride, block_size_y, block_size_x, max_imgpel_value);
+    return;
+  }
+
+  for (j = 0; j < block_size_y; j++)
+  {
+    const imgpel *s = src + j * stride;
+    store16_8bit_avx2(dst[j], tap6_epi16_avx2(load16_avx2(s - 2 * stride), load16_avx2(s - stride), load16_avx2(s),
+                                              load16_avx2(s + stride), load16_avx2(s + 2 * stride), load16_avx2(s + 3 * stride)), max);
+  }
+}
+
+// averaging and the centre position do not depend on the bit depth beyond these
+#define luma_average_8bit_sse41   luma_average_sse41
+#define luma_average_8bit_avx2    luma_average_avx2
+#define luma_filter_hv_8bit_avx2  luma_filter_hv_8bit_sse41
+
+DEFINE_LUMA_POSITIONS(8bit_sse41)
+DEFINE_LUMA_POSITIONS(8bit_avx2)
+
+/*
+ ************************************************************************
+ * Chroma bilinear interpolation. Samples and weights fit in 16 bits, so
+ * each pair of taps is one _mm_madd_epi16.
+ ************************************************************************
+ */
+static inline __m128i chroma_rnd_shift(__m128i v, __m128i rnd, __m128i shift)
+{
+  return _mm_sra_epi32(_mm_add_epi32(v, rnd), shift);
+}
+
+static inline __m128i chroma_load(const imgpel *p, int block_size_x)
+{
+  return (block_size_x == 4) ? _mm_loadl_epi64((const __m128i *) p) : _mm_loadu_si128((const __m128i *) p);
+}
+
+//! (w_a * a + w_b * b [+ w_c * c + w_d * d]) rounded and shifted by total_scale
+static void chroma_bilinear_sse41(imgpel *block, imgpel *a, imgpel *b, imgpel *c, imgpel *d, int span, int block_size_y, int block_size_x,
+                                  int w_a, int w_b, int w_c, int w_d, int total_scale)
+{
+  __m128i wab   = _mm_set1_epi32((w_b << 16) | (w_a & 0xFFFF));
+  __m128i wcd   = _mm_set1_epi32((w_d << 16) | (w_c & 0xFFFF));
+  __m128i rnd   = _mm_set1_epi32(1 << (total_scale - 1));
+  __m128i shift = _mm_cvtsi32_si128(total_scale);
+  int i, j;
+
+  for (j = 0; j < block_size_y; j++)
+  {
+    for (i = 0; i < block_size_x; i += 8)
+    {
+      __m128i va = chroma_load(a + i, block_size_x);
+      __m128i vb = chroma_load(b + i, block_size_x);
+      __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(va, vb), wab);
+      __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(va, vb), wab);
+
+      if (c != NULL)
+      {
+        __m128i vc = chroma_load(c + i, block_size_x);
+        __m128i vd = chroma_load(d + i, block_size_x);
+        lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(vc, vd), wcd));
+        hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(vc, vd), wcd));
+      }
+
+      lo = _mm_packus_epi32(chroma_rnd_shift(lo, rnd, shift), chroma_rnd_shift(hi, rnd, shift));
+      if (block_size_x == 4)
+        _mm_storel_epi64((__m128i *) (block + i), lo);
+      else
+        _mm_storeu_si128((__m128i *) (block + i), lo);
+    }
+    block += MB_BLOCK_SIZE;
+    a += span;
+    b += span;
+    if (c != NULL)
+    {
+      c += span;
+      d += span;
+    }
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    8 bit version of chroma_bilinear_sse41(): the weights sum to
+ *    1 << total_scale <= 64, so the weighted sum of 8 bit samples fits in
+ *    unsigned 16 bit lanes
+ ************************************************************************
+ */
+static void chroma_bilinear_8bit_sse41(imgpel *block, imgpel *a, imgpel *b, imgpel *c, imgpel *d, int span, int block_size_y, int block_size_x,
+                                       int w_a, int w_b, int w_c, int w_d, int total_scale)
+{
+  __m128i wa    = _mm_set1_epi16((short) w_a);
+  __m128i wb    = _mm_set1_epi16((short) w_b);
+  __m128i wc    = _mm_set1_epi16((short) w_c);
+  __m128i wd    = _mm_set1_epi16((short) w_d);
+  __m128i rnd   = _mm_set1_epi16((short) (1 << (total_scale - 1)));
+  __m128i shift = _mm_cvtsi32_si128(total_scale);
+  int i, j;
+
+  for (j = 0; j < block_size_y; j++)
+  {
+    for (i = 0; i < block_size_x; i += 8)
+    {
+      __m128i v = _mm_add_epi16(_mm_mullo_epi16(chroma_load(a + i, block_size_x), wa), _mm_mullo_epi16(chroma_load(b + i, block_size_x), wb));
+
+      if (c != NULL)
+      {
+        v = _mm_add_epi16(v, _mm_mullo_epi16(chroma_load(c + i, block_size_x), wc));
+        v = _mm_add_epi16(v, _mm_mullo_epi16(chroma_load(d + i, block_size_x), wd));
+      }
+
+      v = _mm_srl_epi16(_mm_add_epi16(v, rnd), shift);
+      if (block_size_x == 4)
+        _mm_storel_epi64((__m128i *) (block + i), v);
+      else
+        _mm_storeu_si128((__m128i *) (block + i), v);
+    }
+    block += MB_BLOCK_SIZE;
+    a += span;
+    b += span;
+    if (c != NULL)
+    {
+      c += span;
+      d += span;
+    }
+  }
+}
+
+static void get_chroma_0X_8bit_sse41(imgpel *block, imgpel *cur_img, int span, int block_size_y, int block_size_x, int w00, int w01, int total_scale)
+{
+  if (block_size_x < 4)
+    sse41_8bit_fallback.get_chroma_0X(block, cur_img, span, block_size_y, block_size_x, w00, w01, total_scale);
+  else
+    chroma_bilinear_8bit_sse41(block, cur_img, cur_img + span, NULL, NULL, span, block_size_y, block_size_x, w00, w01, 0, 0, total_scale);
+}
+
+static void get_chroma_X0_8bit_sse41(imgpel *block, imgpel *cur_img, int span, int block_size_y, int block_size_x, int w00, int w10, int total_scale)
+{
+  if (block_size_x < 4)
+    sse41_8bit_fallback.get_chroma_X0(block, cur_img, span, block_size_y, block_size_x, w00, w10, total_scale);
+  else
+    chroma_bilinear_8bit_sse41(block, cur_img, cur_img + 1, NULL, NULL, span, block_size_y, block_size_x, w00, w10, 0, 0, total_scale);
+}
+
+static void get_chroma_XY_8bit_sse41(imgpel *block, imgpel *cur_img, int span, int block_size_y, int block_size_x, int w00, int w01, int w10, int w11, int total_scale)
+{
+  if (block_size_x < 4)
+    sse41_8bit_fallback.get_chroma_XY(block, cur_img, span, block_size_y, block_size_x, w00, w01, w10, w11, total_scale);
+  else
+    chroma_bilinear_8bit_sse41(block, cur_img, cur_img + 1, cur_img + span, cur_img + span + 1, span, block_size_y, block_size_x, w00, w10, w01, w11, total_scale);
+}
+
+static void get_chroma_0X_sse41(imgpel *block, imgpel *cur_img, int span, int block_size_y, int block_size_x, int w00, int w01, int total_scale)
+{
+  if (block_size_x < 4)
+    sse41_fallback.get_chroma_0X(block, cur_img, span, block_size_y, block_size_x, w00, w01, total_scale);
+  else
+    chroma_bilinear_sse41(block, cur_img, cur_img + span, NULL, NULL, span, block_size_y, block_size_x, w00, w01, 0, 0, total_scale);
+}
+
+static void get_chroma_X0_sse41(imgpel *block, imgpel *cur_img, int span, int block_size_y, int block_size_x, int w00, int w10, int total_scale)
+{
+  if (block_size_x < 4)
+    sse41_fallback.get_chroma_X0(block, cur_img, span, block_size_y, block_size_x, w00, w10, total_scale);
+  else
+    chroma_bilinear_sse41(block, cur_img, cur_img + 1, NULL, NULL, span, block_size_y, block_size_x, w00, w10, 0, 0, total_scale);
+}
+
+static void get_chroma_XY_sse41(imgpel *block, imgpel *cur_img, int span, int block_size_y, int block_size_x, int w00, int w01, int w10, int w11, int total_scale)
+{
+  if (block_size_x < 4)
+    sse41_fallback.get_chroma_XY(block, cur_img, span, block_size_y, block_size_x, w00, w01, w10, w11, total_scale);
+  else
+    chroma_bilinear_sse41(block, cur_img, cur_img + 1, cur_img + span, cur_img + span + 1, span, block_size_y, block_size_x, w00, w10, w01, w11, total_scale);
+}
+
+/*
+ ************************************************************************
+ * Prediction averaging and weighting
+ ************************************************************************
+ */
+static void weighted_mc_prediction_sse41(imgpel **mb_pred, imgpel **block, int block_size_y, int block_size_x, int ioff,
+                                         int wp_scale, int wp_offset, int weight_denom, int color_clip)
+{
+  __m128i scale  = _mm_set1_epi32(wp_scale);
+  __m128i offset = _mm_set1_epi32(wp_offset);
+  __m128i rnd    = _mm_set1_epi32(weight_denom > 0 ? 1 << (weight_denom - 1) : 0);
+  __m128i shift  = _mm_cvtsi32_si128(weight_denom);
+  __m128i max    = _mm_set1_epi16((short) color_clip);
+  int i, j;
+
+  if (block_size_x < 4 || weight_denom < 0)
+  {
+    sse41_fallback.weighted_mc_prediction(mb_pred, block, block_size_y, block_size_x, ioff, wp_scale, wp_offset, weight_denom, color_clip);
+    return;
+  }
+
+  for (j = 0; j < block_size_y; j++)
+  {
+    for (i = 0; i < block_size_x; i += 4)
+    {
+      __m128i v = _mm_mullo_epi32(load4_epi32(&block[j][i]), scale);
+      v = _mm_add_epi32(_mm_sra_epi32(_mm_add_epi32(v, rnd), shift), offset);
+      store4_clip(&mb_pred[j][i + ioff], v, max);
+    }
+  }
+}
+
+static void bi_prediction_sse41(imgpel **mb_pred, imgpel **block_l0, imgpel **block_l1, int block_size_y, int block_size_x, int ioff)
+{
+  int i, j;
+
+  if (block_size_x < 4)
+  {
+    sse41_fallback.bi_prediction(mb_pred, block_l0, block_l1, block_size_y, block_size_x, ioff);
+    return;
+  }
+
+  for (j = 0; j < block_size_y; j++)
+  {
+    imgpel *mpr = &mb_pred[j][ioff];
+    imgpel *b0  = &block_l0[0][j * MB_BLOCK_SIZE];
+    imgpel *b1  = &block_l1[0][j * MB_BLOCK_SIZE];
+
+    if (block_size_x == 4)
+      _mm_storel_epi64((__m128i *) mpr, _mm_avg_epu16(_mm_loadl_epi64((const __m128i *) b0), _mm_loadl_epi64((const __m128i *) b1)));
+    else
+    {
+      for (i = 0; i < block_size_x; i += 8)
+        _mm_storeu_si128((__m128i *) (mpr + i), _mm_avg_epu16(_mm_loadu_si128((const __m128i *) (b0 + i)), _mm_loadu_si128((const __m128i *) (b1 + i))));
+    }
+  }
+}
+
+static TARGET_AVX2 void bi_prediction_avx2(imgpel **mb_pred, imgpel **block_l0, imgpel **block_l1, int block_size_y, int block_size_x, int ioff)
+{
+  int j;
+
+  if (block_size_x != 16)
+  {
+    avx2_fallback.bi_prediction(mb_pred, block_l0, block_l1, block_size_y, block_size_x, ioff);
+    return;
+  }
+
+  for (j = 0; j < block_size_y; j++)
+  {
+    imgpel *b0 = &block_l0[0][j * MB_BLOCK_SIZE];
+    imgpel *b1 = &block_l1[0][j * MB_BLOCK_SIZE];
+    _mm256_storeu_si256((__m256i *) &mb_pred[j][ioff], _mm256_avg_epu16(_mm256_loadu_si256((const __m256i *) b0), _mm256_loadu_si256((const __m256i *) b1)));
+  }
+}
+
+static void weighted_bi_prediction_sse41(imgpel *mb_pred, imgpel *block_l0, imgpel *block_l1, int block_size_y, int block_size_x,
+                                         int wp_scale_l0, int wp_scale_l1, int wp_offset, int weight_denom, int color_clip)
+{
+  __m128i w      = _mm_set1_epi32((wp_scale_l1 << 16) | (wp_scale_l0 & 0xFFFF));
+  __m128i rnd    = _mm_set1_epi32(1 << (weight_denom - 1));
+  __m128i shift  = _mm_cvtsi32_si128(weight_denom);
+  __m128i offset = _mm_set1_epi32(wp_offset);
+  __m128i max    = _mm_set1_epi16((short) color_clip);
+  int i, j;
+
+  if (block_size_x < 4)
+  {
+    sse41_fallback.weighted_bi_prediction(mb_pred, block_l0, block_l1, block_size_y, block_size_x, wp_scale_l0, wp_scale_l1, wp_offset, weight_denom, color_clip);
+    return;
+  }
+
+  for (j = 0; j < block_size_y; j++)
+  {
+    for (i = 0; i < block_size_x; i += 4)
+    {
+      __m128i pair = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *) (block_l0 + i)), _mm_loadl_epi64((const __m128i *) (block_l1 + i)));
+      __m128i v    = _mm_add_epi32(_mm_sra_epi32(_mm_add_epi32(_mm_madd_epi16(pair, w), rnd), shift), offset);
+      store4_clip(mb_pred + i, v, max);
+    }
+    mb_pred  += MB_BLOCK_SIZE;
+    block_l0 += MB_BLOCK_SIZE;
+    block_l1 += MB_BLOCK_SIZE;
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Installs the SSE4.1 kernels
+ ************************************************************************
+ */
+void init_mc_kernels_sse41(McKernels *kernels)
+{
+  sse41_fallback = *kernels;
+
+  set_luma_positions_sse41(kernels);
+  kernels->get_chroma_0X = get_chroma_0X_sse41;
+  kernels->get_chroma_X0 = get_chroma_X0_sse41;
+  kernels->get_chroma_XY = get_chroma_XY_sse41;
+  kernels->weighted_mc_prediction = weighted_mc_prediction_sse41;
+  kernels->bi_prediction          = bi_prediction_sse41;
+  kernels->weighted_bi_prediction = weighted_bi_prediction_sse41;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Installs the AVX2 kernels on top of the SSE4.1 ones
+ ************************************************************************
+ */
+void init_mc_kernels_avx2(McKernels *kernels)
+{
+  avx2_fallback = *kernels;
+
+  set_luma_positions_avx2(kernels);
+  kernels->bi_prediction = bi_prediction_avx2;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Installs the SSE4.1 kernels for 8 bit samples on top of the
+ *    kernels for any bit depth
+ ************************************************************************
+ */
+void init_mc_kernels_8bit_sse41(McKernels *kernels)
+{
+  sse41_8bit_fallback = *kernels;
+
+  set_luma_positions_8bit_sse41(kernels);
+  kernels->get_chroma_0X = get_chroma_0X_8bit_sse41;
+  kernels->get_chroma_X0 = get_chroma_X0_8bit_sse41;
+  kernels->get_chroma_XY = get_chroma_XY_8bit_sse41;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Installs the AVX2 kernels for 8 bit samples on top of the SSE4.1 ones
+ ************************************************************************
+ */
+void init_mc_kernels_8bit_avx2(McKernels *kernels)
+{
+  set_luma_positions_8bit_avx2(kernels);
+}
+
+#else
+
+void init_mc_kernels_sse41(McKernels *kernels)
+{
+}
+
+void init_mc_kernels_avx2(McKernels *kernels)
+{
+}
+
+void init_mc_kernels_8bit_sse41(McKernels *kernels)
+{
+}
+
+void init_mc_kernels_8bit_avx2(McKernels *kernels)
+{
+}
+
+#endif
@@ -61,7 +61,7 @@ int read_next_nalu(VideoParameters *p_Vid, NALU_t *nalu)
     ret = get_annex_b_NALU(p_Vid, nalu, p_Vid->annex_b);
     break;
   case PAR_OF_RTP:
-    ret = GetRTPNALU(p_Vid, nalu, p_Vid->BitStreamFile);
+    ret = GetRTPNALU(p_Vid, nalu, p_Vid->rtp);
     break;   
   }
 
@@ -76,6 +76,14 @@ int read_next_nalu(VideoParameters *p_Vid, NALU_t *nalu)
     return 0;
   }
 
+#if (MVC_EXTENSION_ENABLE)
+  // when only the base view is decoded (-views base) the slices and subset SPS
+  // of the other views are dropped here, before their RBSP is extracted
+  if (p_Inp->DecodeAllLayers == 0 &&
+    (nalu->nal_unit_type == NALU_TYPE_SLC_EXT || nalu->nal_unit_type == NALU_TYPE_SUB_SPS))
+    return read_next_nalu(p_Vid, nalu);
+#endif
+
   //In some cases, zero_byte shall be present. If current NALU is a VCL NALU, we can't tell
   //whether it is the first VCL NALU at this point, so only non-VCL NAL unit is checked here.
   CheckZeroByteNonVCL(p_Vid, nalu);
@@ -21,12 +21,36 @@
 #include "sei.h"
 #include "input.h"
 #include "fast_memory.h"
+#include "frame_pipeline.h"
+#include "yuv_writer.h"
+#include "frame_hash.h"
+#include "cpu_features.h"
+
+#if HAVE_X86_SIMD && (IMGTYPE == 1)
+#include <immintrin.h>
+#endif
 
 static void write_out_picture(VideoParameters *p_Vid, StorablePicture *p, int p_out);
 static void img2buf_byte   (imgpel** imgX, unsigned char* buf, int size_x, int size_y, int symbol_size_in_bytes, int crop_left, int crop_right, int crop_top, int crop_bottom, int iOutStride);
 static void img2buf_normal (imgpel** imgX, unsigned char* buf, int size_x, int size_y, int symbol_size_in_bytes, int crop_left, int crop_right, int crop_top, int crop_bottom, int iOutStride);
 static void img2buf_endian (imgpel** imgX, unsigned char* buf, int size_x, int size_y, int symbol_size_in_bytes, int crop_left, int crop_right, int crop_top, int crop_bottom, int iOutStride);
+static void img2buf_pack   (imgpel** imgX, unsigned char* buf, int size_x, int size_y, int symbol_size_in_bytes, int crop_left, int crop_right, int crop_top, int crop_bottom, int iOutStride);
+#if HAVE_X86_SIMD && (IMGTYPE == 1)
+static void img2buf_pack_sse41(imgpel** imgX, unsigned char* buf, int size_x, int size_y, int symbol_size_in_bytes, int crop_left, int crop_right, int crop_top, int crop_bottom, int iOutStride);
+#endif
 
+static int output_simd_level;   //!< SimdLevel of the output conversion, see init_output_kernels()
+
+/*!
+ ************************************************************************
+ * \brief
+ *      sets the SimdLevel init_output() may select conversions for
+ ************************************************************************
+ */
+void init_output_kernels(int simd_level)
+{
+  output_simd_level = simd_level;
+}
 
 /*!
  ************************************************************************
@@ -45,6 +69,16 @@ void init_output(CodingParameters *p_cps, int symbol_size_in_bytes)
     else
       p_cps->img2buf = img2buf_normal;
   }
+  else if ( sizeof(char) == symbol_size_in_bytes)
+  {
+    // 8 bit samples are narrowed to one byte each, independent of the endianness
+#if HAVE_X86_SIMD && (IMGTYPE == 1)
+    if (output_simd_level >= SIMD_SSE41)
+      p_cps->img2buf = img2buf_pack_sse41;
+    else
+#endif
+      p_cps->img2buf = img2buf_pack;
+  }
   else
   {
     if (testEndian())
@@ -176,6 +210,70 @@ static void img2buf_byte (imgpel** imgX, unsigned char* buf, int size_x, int siz
   }
 }
 
+/*!
+ ************************************************************************
+ * \brief
+ *    Convert image plane to temporary buffer for file writing, one byte
+ *    per sample. Used for 8 bit output of 16 bit sample planes.
+ ************************************************************************
+ */
+static void img2buf_pack (imgpel** imgX, unsigned char* buf, int size_x, int size_y, int symbol_size_in_bytes, int crop_left, int crop_right, int crop_top, int crop_bottom, int iOutStride)
+{
+  int twidth  = size_x - crop_left - crop_right;
+  int i, j;
+
+  // tone mapping may change the output sample size per picture
+  if (symbol_size_in_bytes != 1)
+  {
+    img2buf_normal(imgX, buf, size_x, size_y, symbol_size_in_bytes, crop_left, crop_right, crop_top, crop_bottom, iOutStride);
+    return;
+  }
+
+  for (j = crop_top; j < size_y - crop_bottom; j++)
+  {
+    imgpel *src = &imgX[j][crop_left];
+    unsigned char *dst = buf + (j - crop_top) * iOutStride;
+
+    for (i = 0; i < twidth; i++)
+      dst[i] = (unsigned char) src[i];
+  }
+}
+
+#if HAVE_X86_SIMD && (IMGTYPE == 1)
+/*!
+ ************************************************************************
+ * \brief
+ *    SSE4.1 version of img2buf_pack(), 16 samples per step
+ ************************************************************************
+ */
+static void img2buf_pack_sse41(imgpel** imgX, unsigned char* buf, int size_x, int size_y, int symbol_size_in_bytes, int crop_left, int crop_right, int crop_top, int crop_bottom, int iOutStride)
+{
+  int twidth  = size_x - crop_left - crop_right;
+  int i, j;
+
+  if (symbol_size_in_bytes != 1)
+  {
+    img2buf_normal(imgX, buf, size_x, size_y, symbol_size_in_bytes, crop_left, crop_right, crop_top, crop_bottom, iOutStride);
+    return;
+  }
+
+  for (j = crop_top; j < size_y - crop_bottom; j++)
+  {
+    imgpel *src = &imgX[j][crop_left];
+    unsigned char *dst = buf + (j - crop_top) * iOutStride;
+
+    for (i = 0; i + 16 <= twidth; i += 16)
+    {
+      __m128i lo = _mm_loadu_si128((const __m128i *) (src + i));
+      __m128i hi = _mm_loadu_si128((const __m128i *) (src + i + 8));
+      _mm_storeu_si128((__m128i *) (dst + i), _mm_packus_epi16(lo, hi));
+    }
+    for (; i < twidth; i++)
+      dst[i] = (unsigned char) src[i];
+  }
+}
+#endif
+
 /*!
  ************************************************************************
  * \brief
@@ -273,11 +371,15 @@ void clear_picture(VideoParameters *p_Vid, StorablePicture *p);
  */
 void flush_pending_output(VideoParameters *p_Vid, int p_out)
 {
+  MemTag prev_tag;
+
   if (p_Vid->pending_output_state != FRAME)
   {
     write_out_picture(p_Vid, p_Vid->pending_output, p_out);
   }
 
+  prev_tag = mem_set_tag(MEM_OUTPUT);
+
   if (p_Vid->pending_output->imgY)
   {
     free_mem2Dpel (p_Vid->pending_output->imgY);
@@ -288,6 +390,7 @@ void flush_pending_output(VideoParameters *p_Vid, int p_out)
     free_mem3Dpel (p_Vid->pending_output->imgUV);
     p_Vid->pending_output->imgUV=NULL;
   }
+  mem_set_tag(prev_tag);
 
   p_Vid->pending_output_state = FRAME;
 }
@@ -325,6 +428,8 @@ void write_picture(VideoParameters *p_Vid, StorablePicture *p, int p_out, int re
 
   if (p_Vid->pending_output_state == FRAME)
   {
+    MemTag prev_tag;
+
     p_Vid->pending_output->size_x = p->size_x;
     p_Vid->pending_output->size_y = p->size_y;
     p_Vid->pending_output->size_x_cr = p->size_x_cr;
@@ -341,8 +446,10 @@ void write_picture(VideoParameters *p_Vid, StorablePicture *p, int p_out, int re
       p_Vid->pending_output->frame_crop_bottom_offset = p->frame_crop_bottom_offset;
     }
 
+    prev_tag = mem_set_tag(MEM_OUTPUT);
     get_mem2Dpel (&(p_Vid->pending_output->imgY), p_Vid->pending_output->size_y, p_Vid->pending_output->size_x);
     get_mem3Dpel (&(p_Vid->pending_output->imgUV), 2, p_Vid->pending_output->size_y_cr, p_Vid->pending_output->size_x_cr);
+    mem_set_tag(prev_tag);
 
     clear_picture(p_Vid, p_Vid->pending_output);
 
@@ -437,11 +544,13 @@ void write_picture(VideoParameters *p_Vid, StorablePicture *p, int p_out, int re
 static void allocate_p_dec_pic(VideoParameters *p_Vid, DecodedPicList *pDecPic, StorablePicture *p, int iLumaSize, int iFrameSize, int iLumaSizeX, int iLumaSizeY, int iChromaSizeX, int iChromaSizeY)
 {
   int symbol_size_in_bytes = ((p_Vid->pic_unit_bitsize_on_disk+7) >> 3);
+  MemTag prev_tag = mem_set_tag(MEM_OUTPUT);
   
   if(pDecPic->pY)
     mem_free(pDecPic->pY);
   pDecPic->iBufSize = iFrameSize;
   pDecPic->pY = mem_malloc(pDecPic->iBufSize);
+  mem_set_tag(prev_tag);
   pDecPic->pU = pDecPic->pY+iLumaSize;
   pDecPic->pV = pDecPic->pU + ((iFrameSize-iLumaSize)>>1);
   //init;
@@ -454,6 +563,144 @@ static void allocate_p_dec_pic(VideoParameters *p_Vid, DecodedPicList *pDecPic,
   pDecPic->iUVBufStride = iChromaSizeX*symbol_size_in_bytes; //p->size_x_cr*symbol_size_in_bytes;
 }
 
+/*!
+ ************************************************************************
+ * \brief
+ *    Converts a picture into a buffer of the output writer and queues it
+ *    for writing. The planes are stored in the order and with the
+ *    cropping the synchronous path of write_out_picture() writes them.
+ ************************************************************************
+ */
+static void queue_out_picture(VideoParameters *p_Vid, StorablePicture *p, int p_out, int symbol_size_in_bytes, int rgb_output,
+                              int crop_left, int crop_right, int crop_top, int crop_bottom)
+{
+  int luma_width   = p->size_x - crop_left - crop_right;
+  int luma_height  = p->size_y - crop_top - crop_bottom;
+  int cr_crop_left   = p->frame_crop_left_offset;
+  int cr_crop_right  = p->frame_crop_right_offset;
+  int cr_crop_top    = ( 2 - p->frame_mbs_only_flag ) * p->frame_crop_top_offset;
+  int cr_crop_bottom = ( 2 - p->frame_mbs_only_flag ) * p->frame_crop_bottom_offset;
+  int cr_width     = p->size_x_cr - cr_crop_left - cr_crop_right;
+  int cr_height    = p->size_y_cr - cr_crop_top - cr_crop_bottom;
+  size_t luma_size = (size_t) luma_width * luma_height * symbol_size_in_bytes;
+  size_t cr_size   = (size_t) cr_width * cr_height * symbol_size_in_bytes;
+  size_t uv_size   = 0;
+  unsigned char *buf, *pos;
+
+  if (p->chroma_format_idc != YUV400)
+    uv_size = 2 * cr_size;
+  else if (p_Vid->p_Inp->write_uv)
+    uv_size = 2 * (size_t) (symbol_size_in_bytes * luma_height / 2 * luma_width / 2);
+
+  buf = pos = get_yuv_buffer(p_Vid->yuv_writer, luma_size + uv_size);
+
+  if (rgb_output)
+  {
+    p_Vid->img2buf (p->imgUV[1], pos, p->size_x_cr, p->size_y_cr, symbol_size_in_bytes, cr_crop_left, cr_crop_right, cr_crop_top, cr_crop_bottom, cr_width * symbol_size_in_bytes);
+    pos += cr_size;
+  }
+
+  p_Vid->img2buf (p->imgY, pos, p->size_x, p->size_y, symbol_size_in_bytes, crop_left, crop_right, crop_top, crop_bottom, luma_width * symbol_size_in_bytes);
+  pos += luma_size;
+
+  if (p->chroma_format_idc != YUV400)
+  {
+    p_Vid->img2buf (p->imgUV[0], pos, p->size_x_cr, p->size_y_cr, symbol_size_in_bytes, cr_crop_left, cr_crop_right, cr_crop_top, cr_crop_bottom, cr_width * symbol_size_in_bytes);
+    pos += cr_size;
+    if (!rgb_output)
+    {
+      p_Vid->img2buf (p->imgUV[1], pos, p->size_x_cr, p->size_y_cr, symbol_size_in_bytes, cr_crop_left, cr_crop_right, cr_crop_top, cr_crop_bottom, cr_width * symbol_size_in_bytes);
+      pos += cr_size;
+    }
+  }
+  else if (uv_size > 0)
+  {
+    // fake out U=V=128 to make a YUV 4:2:0 stream
+    imgpel cr_val = (imgpel) (1<<(p_Vid->bitdepth_luma - 1));
+    imgpel *cr_line = &cr_val;
+    size_t i;
+
+    p_Vid->img2buf (&cr_line, pos, 1, 1, symbol_size_in_bytes, 0, 0, 0, 0, symbol_size_in_bytes);
+    for (i = symbol_size_in_bytes; i < uv_size; ++i)
+      pos[i] = pos[i - symbol_size_in_bytes];
+    pos += uv_size;
+  }
+
+  queue_yuv_buffer(p_Vid->yuv_writer, p_out, pos - buf);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Adds the cropped samples of a plane to the digest of the output
+ *    file, converted to the bytes the YUV file would receive
+ ************************************************************************
+ */
+static void hash_plane(VideoParameters *p_Vid, int p_out, imgpel **imgX, int size_x, int size_y, int symbol_size_in_bytes,
+                       int crop_left, int crop_right, int crop_top, int crop_bottom)
+{
+  int row_size = (size_x - crop_left - crop_right) * symbol_size_in_bytes;
+  unsigned char *row = get_hash_row(p_Vid->frame_hash, row_size);
+  int j;
+
+  for (j = crop_top; j < size_y - crop_bottom; ++j)
+  {
+    p_Vid->img2buf (&imgX[j], row, size_x, 1, symbol_size_in_bytes, crop_left, crop_right, 0, 0, row_size);
+    hash_frame_data(p_Vid->frame_hash, p_out, row, row_size);
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Writes the digest of a picture instead of its samples. The planes
+ *    are hashed in the order and with the cropping write_out_picture()
+ *    writes them.
+ ************************************************************************
+ */
+static void hash_out_picture(VideoParameters *p_Vid, StorablePicture *p, int p_out, int symbol_size_in_bytes, int rgb_output,
+                             int crop_left, int crop_right, int crop_top, int crop_bottom)
+{
+  int cr_crop_left   = p->frame_crop_left_offset;
+  int cr_crop_right  = p->frame_crop_right_offset;
+  int cr_crop_top    = ( 2 - p->frame_mbs_only_flag ) * p->frame_crop_top_offset;
+  int cr_crop_bottom = ( 2 - p->frame_mbs_only_flag ) * p->frame_crop_bottom_offset;
+
+  if (rgb_output)
+    hash_plane(p_Vid, p_out, p->imgUV[1], p->size_x_cr, p->size_y_cr, symbol_size_in_bytes, cr_crop_left, cr_crop_right, cr_crop_top, cr_crop_bottom);
+
+  hash_plane(p_Vid, p_out, p->imgY, p->size_x, p->size_y, symbol_size_in_bytes, crop_left, crop_right, crop_top, crop_bottom);
+
+  if (p->chroma_format_idc != YUV400)
+  {
+    hash_plane(p_Vid, p_out, p->imgUV[0], p->size_x_cr, p->size_y_cr, symbol_size_in_bytes, cr_crop_left, cr_crop_right, cr_crop_top, cr_crop_bottom);
+    if (!rgb_output)
+      hash_plane(p_Vid, p_out, p->imgUV[1], p->size_x_cr, p->size_y_cr, symbol_size_in_bytes, cr_crop_left, cr_crop_right, cr_crop_top, cr_crop_bottom);
+  }
+  else if (p_Vid->p_Inp->write_uv)
+  {
+    // fake out U=V=128 to make a YUV 4:2:0 stream
+    int width = p->size_x - crop_left - crop_right;
+    size_t left = 2 * (size_t) (symbol_size_in_bytes * (p->size_y - crop_top - crop_bottom) / 2 * width / 2);
+    size_t row_size = (size_t) width * symbol_size_in_bytes;
+    unsigned char *row = get_hash_row(p_Vid->frame_hash, row_size);
+    imgpel cr_val = (imgpel) (1<<(p_Vid->bitdepth_luma - 1));
+    imgpel *cr_line = &cr_val;
+    size_t i;
+
+    p_Vid->img2buf (&cr_line, row, 1, 1, symbol_size_in_bytes, 0, 0, 0, 0, symbol_size_in_bytes);
+    for (i = symbol_size_in_bytes; i < row_size; ++i)
+      row[i] = row[i - symbol_size_in_bytes];
+    for (; left > 0; left -= i)
+    {
+      i = (left < row_size) ? left : row_size;
+      hash_frame_data(p_Vid->frame_hash, p_out, row, i);
+    }
+  }
+
+  finish_frame_hash(p_Vid->frame_hash, p_out);
+}
+
 /*!
 ************************************************************************
 * \brief
@@ -489,6 +736,8 @@ static void write_out_picture(VideoParameters *p_Vid, StorablePicture *p, int p_
   if (p->non_existing)
     return;
 
+  wait_picture_rows(p, PICTURE_READY);
+
 #if (ENABLE_OUTPUT_TONEMAPPING)
   // note: this tone-mapping is working for RGB format only. Sharp
   if (p->seiHasTone_mapping && rgb_output)
@@ -526,6 +775,17 @@ static void write_out_picture(VideoParameters *p_Vid, StorablePicture *p, int p_
   if (p_out == -1)
     return;
 
+  if (p_Vid->frame_hash != NULL)
+  {
+    hash_out_picture(p_Vid, p, p_out, symbol_size_in_bytes, rgb_output, crop_left, crop_right, crop_top, crop_bottom);
+    return;
+  }
+
+  if (p_Vid->yuv_writer != NULL)
+  {
+    queue_out_picture(p_Vid, p, p_out, symbol_size_in_bytes, rgb_output, crop_left, crop_right, crop_top, crop_bottom);
+    return;
+  }
 
 
   // KS: this buffer should actually be allocated only once, but this is still much faster than the previous version
@@ -23,4 +23,5 @@ extern void uninit_out_buffer (VideoParameters *p_Vid);
 extern void flush_pending_output(VideoParameters *p_Vid, int p_out);
 #endif
 extern void init_output(CodingParameters *p_CodingParams, int symbol_size_in_bytes);
+extern void init_output_kernels(int simd_level);
 #endif //_OUTPUT_H_
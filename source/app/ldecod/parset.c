@@ -23,6 +23,8 @@
 #include "vlc.h"
 #include "mbuffer.h"
 #include "erc_api.h"
+#include "frame_pipeline.h"
+#include "mc_prediction.h"
 
 #if TRACE
 #define SYMTRACESTRING(s) strncpy(sym->tracestring,s,TRACESTRING_SIZE)
@@ -911,10 +913,11 @@ static void set_coding_par(seq_parameter_set_rbsp_t *sps, CodingParameters *cps)
   cps->width = cps->PicWidthInMbs * MB_BLOCK_SIZE;
   cps->height = cps->FrameHeightInMbs * MB_BLOCK_SIZE;  
 
-  cps->iLumaPadX = MCBUF_LUMA_PAD_X;
-  cps->iLumaPadY = MCBUF_LUMA_PAD_Y;
-  cps->iChromaPadX = MCBUF_CHROMA_PAD_X;
-  cps->iChromaPadY = MCBUF_CHROMA_PAD_Y;
+  // motion compensation extends the reference borders itself, pictures are not padded
+  cps->iLumaPadX = 0;
+  cps->iLumaPadY = 0;
+  cps->iChromaPadX = 0;
+  cps->iChromaPadY = 0;
   if (sps->chroma_format_idc == YUV420)
   {
     cps->width_cr  = (cps->width  >> 1);
@@ -924,15 +927,12 @@ static void set_coding_par(seq_parameter_set_rbsp_t *sps, CodingParameters *cps)
   {
     cps->width_cr  = (cps->width >> 1);
     cps->height_cr = cps->height;
-    cps->iChromaPadY = MCBUF_CHROMA_PAD_Y*2;
   }
   else if (sps->chroma_format_idc == YUV444)
   {
     //YUV444
     cps->width_cr = cps->width;
     cps->height_cr = cps->height;
-    cps->iChromaPadX = cps->iLumaPadX;
-    cps->iChromaPadY = cps->iLumaPadY;
   }
   //pel bitdepth init
   cps->bitdepth_luma_qp_scale   = 6 * (cps->bitdepth_luma - 8);
@@ -1012,6 +1012,8 @@ void activate_sps (VideoParameters *p_Vid, seq_parameter_set_rbsp_t *sps)
       // this may only happen on slice loss
       exit_picture(p_Vid, &p_Vid->dec_picture);
     }
+    // the pipeline deblocks with the parameters of the old sps
+    drain_frame_pipeline(p_Vid);
     p_Vid->active_sps = sps;
 
     if(p_Vid->dpb_layer_id==0 && is_BL_profile(sps->profile_idc) && !p_Vid->p_Dpb_layer[0]->init_done)
@@ -1028,6 +1030,7 @@ void activate_sps (VideoParameters *p_Vid, seq_parameter_set_rbsp_t *sps)
 //to be removed in future;
     set_global_coding_par(p_Vid, p_Vid->p_EncodePar[p_Vid->dpb_layer_id]);
 //end;
+    select_mc_kernels(p_Vid->bitdepth_luma, p_Vid->bitdepth_chroma);
 
 #if (MVC_EXTENSION_ENABLE)
     //init_frext(p_Vid);
@@ -1089,12 +1092,7 @@ void activate_sps (VideoParameters *p_Vid, seq_parameter_set_rbsp_t *sps)
 #endif
 
 #if (DISABLE_ERC == 0)
-    ercInit(p_Vid, p_Vid->width, p_Vid->height, 1);
-    if(p_Vid->dec_picture)
-    {
-      ercReset(p_Vid->erc_errorVar, p_Vid->PicSizeInMbs, p_Vid->PicSizeInMbs, p_Vid->dec_picture->size_x);
-      p_Vid->erc_mvperMB = 0;
-    }
+    ercInit(p_Vid, 1);
 #endif
   }
   
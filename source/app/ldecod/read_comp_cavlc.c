@@ -21,6 +21,8 @@
 #include "transform.h"
 #include "mb_access.h"
 #include "Data_Extractor.h"
+#include "se_trace.h"
+#include "mb_meta.h"
 
 #if TRACE
 #define TRACE_STRING(s) strncpy(currSE.tracestring, s, TRACESTRING_SIZE)
@@ -71,15 +73,15 @@ static int predict_nnz(Macroblock *currMB, int block_type, int i,int j)
     switch (block_type)
     {
     case LUMA:
-      pred_nnz = p_Vid->nz_coeff [pix.mb_addr ][0][pix.y][pix.x];
+      pred_nnz = currSlice->nz_coeff [pix.mb_addr ][0][pix.y][pix.x];
       ++cnt;
       break;
     case CB:
-      pred_nnz = p_Vid->nz_coeff [pix.mb_addr ][1][pix.y][pix.x];
+      pred_nnz = currSlice->nz_coeff [pix.mb_addr ][1][pix.y][pix.x];
       ++cnt;
       break;
     case CR:
-      pred_nnz = p_Vid->nz_coeff [pix.mb_addr ][2][pix.y][pix.x];
+      pred_nnz = currSlice->nz_coeff [pix.mb_addr ][2][pix.y][pix.x];
       ++cnt;
       break;
     default:
@@ -103,15 +105,15 @@ static int predict_nnz(Macroblock *currMB, int block_type, int i,int j)
     switch (block_type)
     {
     case LUMA:
-      pred_nnz += p_Vid->nz_coeff [pix.mb_addr ][0][pix.y][pix.x];
+      pred_nnz += currSlice->nz_coeff [pix.mb_addr ][0][pix.y][pix.x];
       ++cnt;
       break;
     case CB:
-      pred_nnz += p_Vid->nz_coeff [pix.mb_addr ][1][pix.y][pix.x];
+      pred_nnz += currSlice->nz_coeff [pix.mb_addr ][1][pix.y][pix.x];
       ++cnt;
       break;
     case CR:
-      pred_nnz += p_Vid->nz_coeff [pix.mb_addr ][2][pix.y][pix.x];
+      pred_nnz += currSlice->nz_coeff [pix.mb_addr ][2][pix.y][pix.x];
       ++cnt;
       break;
     default:
@@ -164,7 +166,7 @@ static int predict_nnz_chroma(Macroblock *currMB, int i,int j)
 
     if (pix.available)
     {
-      pred_nnz = p_Vid->nz_coeff [pix.mb_addr ][1][pix.y][2 * (i>>1) + pix.x];
+      pred_nnz = currSlice->nz_coeff [pix.mb_addr ][1][pix.y][2 * (i>>1) + pix.x];
       ++cnt;
     }
 
@@ -180,7 +182,7 @@ static int predict_nnz_chroma(Macroblock *currMB, int i,int j)
 
     if (pix.available)
     {
-      pred_nnz += p_Vid->nz_coeff [pix.mb_addr ][1][pix.y][2 * (i>>1) + pix.x];
+      pred_nnz += currSlice->nz_coeff [pix.mb_addr ][1][pix.y][2 * (i>>1) + pix.x];
       ++cnt;
     }
 
@@ -233,37 +235,37 @@ void read_coeff_4x4_CAVLC (Macroblock *currMB,
     max_coeff_num = 16;
     TRACE_PRINTF("Luma");
     dptype = (currMB->is_intra_block == TRUE) ? SE_LUM_AC_INTRA : SE_LUM_AC_INTER;
-    p_Vid->nz_coeff[mb_nr][0][j][i] = 0; 
+    currSlice->nz_coeff[mb_nr][0][j][i] = 0; 
     break;
   case LUMA_INTRA16x16DC:
     max_coeff_num = 16;
     TRACE_PRINTF("Lum16DC");
     dptype = SE_LUM_DC_INTRA;
-    p_Vid->nz_coeff[mb_nr][0][j][i] = 0; 
+    currSlice->nz_coeff[mb_nr][0][j][i] = 0; 
     break;
   case LUMA_INTRA16x16AC:
     max_coeff_num = 15;
     TRACE_PRINTF("Lum16AC");
     dptype = SE_LUM_AC_INTRA;
-    p_Vid->nz_coeff[mb_nr][0][j][i] = 0; 
+    currSlice->nz_coeff[mb_nr][0][j][i] = 0; 
     break;
   case CHROMA_DC:
     max_coeff_num = p_Vid->num_cdc_coeff;
     cdc = 1;
     TRACE_PRINTF("ChrDC");
     dptype = (currMB->is_intra_block == TRUE) ? SE_CHR_DC_INTRA : SE_CHR_DC_INTER;
-    p_Vid->nz_coeff[mb_nr][0][j][i] = 0; 
+    currSlice->nz_coeff[mb_nr][0][j][i] = 0; 
     break;
   case CHROMA_AC:
     max_coeff_num = 15;
     cac = 1;
     TRACE_PRINTF("ChrAC");
     dptype = (currMB->is_intra_block == TRUE) ? SE_CHR_AC_INTRA : SE_CHR_AC_INTER;
-    p_Vid->nz_coeff[mb_nr][0][j][i] = 0; 
+    currSlice->nz_coeff[mb_nr][0][j][i] = 0; 
     break;
   default:
     error ("read_coeff_4x4_CAVLC: invalid block type", 600);
-    p_Vid->nz_coeff[mb_nr][0][j][i] = 0; 
+    currSlice->nz_coeff[mb_nr][0][j][i] = 0; 
     break;
   }
 
@@ -283,7 +285,7 @@ void read_coeff_4x4_CAVLC (Macroblock *currMB,
     numcoeff        =  currSE.value1;
     numtrailingones =  currSE.value2;
 
-    p_Vid->nz_coeff[mb_nr][0][j][i] = (byte) numcoeff;
+    currSlice->nz_coeff[mb_nr][0][j][i] = (byte) numcoeff;
   }
   else
   {
@@ -447,73 +449,73 @@ void read_coeff_4x4_CAVLC_444 (Macroblock *currMB,
     max_coeff_num = 16;
     TRACE_PRINTF("Luma");
     dptype = (currMB->is_intra_block == TRUE) ? SE_LUM_AC_INTRA : SE_LUM_AC_INTER;
-    p_Vid->nz_coeff[mb_nr][0][j][i] = 0; 
+    currSlice->nz_coeff[mb_nr][0][j][i] = 0; 
     break;
   case LUMA_INTRA16x16DC:
     max_coeff_num = 16;
     TRACE_PRINTF("Lum16DC");
     dptype = SE_LUM_DC_INTRA;
-    p_Vid->nz_coeff[mb_nr][0][j][i] = 0; 
+    currSlice->nz_coeff[mb_nr][0][j][i] = 0; 
     break;
   case LUMA_INTRA16x16AC:
     max_coeff_num = 15;
     TRACE_PRINTF("Lum16AC");
     dptype = SE_LUM_AC_INTRA;
-    p_Vid->nz_coeff[mb_nr][0][j][i] = 0; 
+    currSlice->nz_coeff[mb_nr][0][j][i] = 0; 
     break;
   case CB:
     max_coeff_num = 16;
     TRACE_PRINTF("Luma_add1");
     dptype = ((currMB->is_intra_block == TRUE)) ? SE_LUM_AC_INTRA : SE_LUM_AC_INTER;
-    p_Vid->nz_coeff[mb_nr][1][j][i] = 0; 
+    currSlice->nz_coeff[mb_nr][1][j][i] = 0; 
     break;
   case CB_INTRA16x16DC:
     max_coeff_num = 16;
     TRACE_PRINTF("Luma_add1_16DC");
     dptype = SE_LUM_DC_INTRA;
-    p_Vid->nz_coeff[mb_nr][1][j][i] = 0; 
+    currSlice->nz_coeff[mb_nr][1][j][i] = 0; 
     break;
   case CB_INTRA16x16AC:
     max_coeff_num = 15;
     TRACE_PRINTF("Luma_add1_16AC");
     dptype = SE_LUM_AC_INTRA;
-    p_Vid->nz_coeff[mb_nr][1][j][i] = 0; 
+    currSlice->nz_coeff[mb_nr][1][j][i] = 0; 
     break;
   case CR:
     max_coeff_num = 16;
     TRACE_PRINTF("Luma_add2");
     dptype = ((currMB->is_intra_block == TRUE)) ? SE_LUM_AC_INTRA : SE_LUM_AC_INTER;
-    p_Vid->nz_coeff[mb_nr][2][j][i] = 0; 
+    currSlice->nz_coeff[mb_nr][2][j][i] = 0; 
     break;
   case CR_INTRA16x16DC:
     max_coeff_num = 16;
     TRACE_PRINTF("Luma_add2_16DC");
     dptype = SE_LUM_DC_INTRA;
-    p_Vid->nz_coeff[mb_nr][2][j][i] = 0; 
+    currSlice->nz_coeff[mb_nr][2][j][i] = 0; 
     break;
   case CR_INTRA16x16AC:
     max_coeff_num = 15;
     TRACE_PRINTF("Luma_add1_16AC");
     dptype = SE_LUM_AC_INTRA;
-    p_Vid->nz_coeff[mb_nr][2][j][i] = 0; 
+    currSlice->nz_coeff[mb_nr][2][j][i] = 0; 
     break;        
   case CHROMA_DC:
     max_coeff_num = p_Vid->num_cdc_coeff;
     cdc = 1;
     TRACE_PRINTF("ChrDC");
     dptype = (currMB->is_intra_block == TRUE) ? SE_CHR_DC_INTRA : SE_CHR_DC_INTER;
-    p_Vid->nz_coeff[mb_nr][0][j][i] = 0; 
+    currSlice->nz_coeff[mb_nr][0][j][i] = 0; 
     break;
   case CHROMA_AC:
     max_coeff_num = 15;
     cac = 1;
     TRACE_PRINTF("ChrAC");
     dptype = (currMB->is_intra_block == TRUE) ? SE_CHR_AC_INTRA : SE_CHR_AC_INTER;
-    p_Vid->nz_coeff[mb_nr][0][j][i] = 0; 
+    currSlice->nz_coeff[mb_nr][0][j][i] = 0; 
     break;
   default:
     error ("read_coeff_4x4_CAVLC: invalid block type", 600);
-    p_Vid->nz_coeff[mb_nr][0][j][i] = 0; 
+    currSlice->nz_coeff[mb_nr][0][j][i] = 0; 
     break;
   }
 
@@ -545,11 +547,11 @@ void read_coeff_4x4_CAVLC_444 (Macroblock *currMB,
     numtrailingones =  currSE.value2;
 
     if(block_type==LUMA || block_type==LUMA_INTRA16x16DC || block_type==LUMA_INTRA16x16AC ||block_type==CHROMA_AC)
-      p_Vid->nz_coeff[mb_nr][0][j][i] = (byte) numcoeff;
+      currSlice->nz_coeff[mb_nr][0][j][i] = (byte) numcoeff;
     else if (block_type==CB || block_type==CB_INTRA16x16DC || block_type==CB_INTRA16x16AC)
-      p_Vid->nz_coeff[mb_nr][1][j][i] = (byte) numcoeff;
+      currSlice->nz_coeff[mb_nr][1][j][i] = (byte) numcoeff;
     else
-      p_Vid->nz_coeff[mb_nr][2][j][i] = (byte) numcoeff;        
+      currSlice->nz_coeff[mb_nr][2][j][i] = (byte) numcoeff;        
   }
   else
   {
@@ -698,6 +700,7 @@ static void read_comp_coeff_4x4_CAVLC (Macroblock *currMB, ColorPlane pl, int (*
   int block_y4, block_x4;
   int PLNZ;
   int x = -1;
+  byte *plnz = get_mb_meta_plnz(currMB, pl);
 
   if (IS_I16MB(currMB))
   {
@@ -719,7 +722,7 @@ static void read_comp_coeff_4x4_CAVLC (Macroblock *currMB, ColorPlane pl, int (*
   }
 
   if ((endInfo.FrameNum <= fna) && (endInfo.SliceMbNum < (((currSlice->end_mb_nr_plus1)*currSlice->current_slice_nr) + currMB->mbAddrX)))
-	  I_finish1 = 1;
+	  LogExtractFinish(currSlice, currMB->mbAddrX);
 
   for (block_y = 0; block_y < 4; block_y += 2) /* all modes */
   {
@@ -737,24 +740,19 @@ static void read_comp_coeff_4x4_CAVLC (Macroblock *currMB, ColorPlane pl, int (*
           {
             currSlice->read_coeff_4x4_CAVLC(currMB, cur_context, i >> 2, j >> 2, levarr, runarr, &numcoeff);
 			PLNZ = ReadPLNZV(numcoeff, runarr);
-			if ((PLNZ > endInfo.Threshold) && (cur_context == LUMA) && (I_finish1 == 0) && (Allow_MB <= currMB->mbAddrX))
+            if (plnz != NULL)
+              plnz[j + (i >> 2)] = (byte) PLNZ;
+			if ((PLNZ > endInfo.Threshold) && (cur_context == LUMA))
 			{
 				if ((InsertingSlice == currSlice->slice_type) || ((currSlice->slice_type == P_SLICE) && (InsertingSlice == SP_SLICE)))
 				{
-					Allow_MB = 0;
-					if ((InsertingSlice != I_SLICE) && (InsertingSlice != SP_SLICE))
+					LogExtractGate(currSlice, currMB->mbAddrX);
+					if (((InsertingSlice != I_SLICE) && (InsertingSlice != SP_SLICE)) || ((i == 12) && (j == 12)))
 					{
 						if (numcoeff != 16)
-							ExtractBitV(PLNZ, *currMB);
+							LogExtractBit(currSlice, MD_EVENT_BITV, PLNZ, currMB->mbAddrX, j + (i >> 2));
 						else
-							ExtractBit16(levarr, *currMB);
-					}
-					else if ((i == 12) && (j == 12))
-					{
-						if (numcoeff != 16)
-							ExtractBitV(PLNZ, *currMB);
-						else
-							ExtractBit16(levarr, *currMB);
+							LogExtractBit(currSlice, MD_EVENT_BIT16, levarr[15] < 0 ? -1 : 0, currMB->mbAddrX, j + (i >> 2));
 					}
 				}
 			}
@@ -1125,6 +1123,7 @@ static void read_CBP_and_coeffs_from_NAL_CAVLC_400(Macroblock *currMB)
       // read CAVLC transform_size_8x8_flag
       currSE.len = 1;
       readSyntaxElement_FLC(&currSE, dP->bitstream);
+      trace_cavlc_se(currMB, &currSE, dP);
 
       currMB->luma_transform_size_8x8_flag = (Boolean) currSE.value1;
     }
@@ -1216,16 +1215,16 @@ static void read_CBP_and_coeffs_from_NAL_CAVLC_400(Macroblock *currMB)
   {
     if (!currMB->luma_transform_size_8x8_flag) // 4x4 transform
     {
-      currMB->read_comp_coeff_4x4_CAVLC (currMB, PLANE_Y, InvLevelScale4x4, qp_per, cbp, p_Vid->nz_coeff[mb_nr][PLANE_Y]);
+      currMB->read_comp_coeff_4x4_CAVLC (currMB, PLANE_Y, InvLevelScale4x4, qp_per, cbp, currSlice->nz_coeff[mb_nr][PLANE_Y]);
     }
     else // 8x8 transform
     {
-      currMB->read_comp_coeff_8x8_CAVLC (currMB, PLANE_Y, InvLevelScale8x8, qp_per, cbp, p_Vid->nz_coeff[mb_nr][PLANE_Y]);
+      currMB->read_comp_coeff_8x8_CAVLC (currMB, PLANE_Y, InvLevelScale8x8, qp_per, cbp, currSlice->nz_coeff[mb_nr][PLANE_Y]);
     }
   }
   else
   {
-    fast_memset(p_Vid->nz_coeff[mb_nr][0][0], 0, BLOCK_PIXELS * sizeof(byte));
+    fast_memset(currSlice->nz_coeff[mb_nr][0][0], 0, BLOCK_PIXELS * sizeof(byte));
   }
 }
 
@@ -1309,6 +1308,7 @@ static void read_CBP_and_coeffs_from_NAL_CAVLC_422(Macroblock *currMB)
       // read CAVLC transform_size_8x8_flag
       currSE.len = 1;
       readSyntaxElement_FLC(&currSE, dP->bitstream);
+      trace_cavlc_se(currMB, &currSE, dP);
 
       currMB->luma_transform_size_8x8_flag = (Boolean) currSE.value1;
     }
@@ -1407,16 +1407,16 @@ static void read_CBP_and_coeffs_from_NAL_CAVLC_422(Macroblock *currMB)
   {
     if (!currMB->luma_transform_size_8x8_flag) // 4x4 transform
     {
-      currMB->read_comp_coeff_4x4_CAVLC (currMB, PLANE_Y, InvLevelScale4x4, qp_per, cbp, p_Vid->nz_coeff[mb_nr][PLANE_Y]);
+      currMB->read_comp_coeff_4x4_CAVLC (currMB, PLANE_Y, InvLevelScale4x4, qp_per, cbp, currSlice->nz_coeff[mb_nr][PLANE_Y]);
     }
     else // 8x8 transform
     {
-      currMB->read_comp_coeff_8x8_CAVLC (currMB, PLANE_Y, InvLevelScale8x8, qp_per, cbp, p_Vid->nz_coeff[mb_nr][PLANE_Y]);
+      currMB->read_comp_coeff_8x8_CAVLC (currMB, PLANE_Y, InvLevelScale8x8, qp_per, cbp, currSlice->nz_coeff[mb_nr][PLANE_Y]);
     }
   }
   else
   {
-    fast_memset(p_Vid->nz_coeff[mb_nr][0][0], 0, BLOCK_PIXELS * sizeof(byte));
+    fast_memset(currSlice->nz_coeff[mb_nr][0][0], 0, BLOCK_PIXELS * sizeof(byte));
   }
 
   //========================== CHROMA DC ============================
@@ -1509,7 +1509,7 @@ static void read_CBP_and_coeffs_from_NAL_CAVLC_422(Macroblock *currMB)
   // chroma AC coeff, all zero fram start_scan
   if (cbp<=31)
   {
-    fast_memset(p_Vid->nz_coeff [mb_nr ][1][0], 0, 2 * BLOCK_PIXELS * sizeof(byte));
+    fast_memset(currSlice->nz_coeff [mb_nr ][1][0], 0, 2 * BLOCK_PIXELS * sizeof(byte));
   }
   else
   {
@@ -1652,6 +1652,7 @@ static void read_CBP_and_coeffs_from_NAL_CAVLC_444(Macroblock *currMB)
       // read CAVLC transform_size_8x8_flag
       currSE.len = 1;
       readSyntaxElement_FLC(&currSE, dP->bitstream);
+      trace_cavlc_se(currMB, &currSE, dP);
 
       currMB->luma_transform_size_8x8_flag = (Boolean) currSE.value1;
     }
@@ -1750,16 +1751,16 @@ static void read_CBP_and_coeffs_from_NAL_CAVLC_444(Macroblock *currMB)
   {
     if (!currMB->luma_transform_size_8x8_flag) // 4x4 transform
     {
-      currMB->read_comp_coeff_4x4_CAVLC (currMB, PLANE_Y, InvLevelScale4x4, qp_per, cbp, p_Vid->nz_coeff[mb_nr][PLANE_Y]);
+      currMB->read_comp_coeff_4x4_CAVLC (currMB, PLANE_Y, InvLevelScale4x4, qp_per, cbp, currSlice->nz_coeff[mb_nr][PLANE_Y]);
     }
     else // 8x8 transform
     {
-      currMB->read_comp_coeff_8x8_CAVLC (currMB, PLANE_Y, InvLevelScale8x8, qp_per, cbp, p_Vid->nz_coeff[mb_nr][PLANE_Y]);
+      currMB->read_comp_coeff_8x8_CAVLC (currMB, PLANE_Y, InvLevelScale8x8, qp_per, cbp, currSlice->nz_coeff[mb_nr][PLANE_Y]);
     }
   }
   else
   {
-    fast_memset(p_Vid->nz_coeff[mb_nr][0][0], 0, BLOCK_PIXELS * sizeof(byte));
+    fast_memset(currSlice->nz_coeff[mb_nr][0][0], 0, BLOCK_PIXELS * sizeof(byte));
   }
 
   for (uv = PLANE_U; uv <= PLANE_V; ++uv )
@@ -1804,11 +1805,11 @@ static void read_CBP_and_coeffs_from_NAL_CAVLC_444(Macroblock *currMB)
 
     if (!currMB->luma_transform_size_8x8_flag) // 4x4 transform
     {
-      currMB->read_comp_coeff_4x4_CAVLC (currMB, (ColorPlane) (uv), InvLevelScale4x4, qp_per_uv[uv], cbp, p_Vid->nz_coeff[mb_nr][uv]);
+      currMB->read_comp_coeff_4x4_CAVLC (currMB, (ColorPlane) (uv), InvLevelScale4x4, qp_per_uv[uv], cbp, currSlice->nz_coeff[mb_nr][uv]);
     }
     else // 8x8 transform
     {
-      currMB->read_comp_coeff_8x8_CAVLC (currMB, (ColorPlane) (uv), InvLevelScale8x8, qp_per_uv[uv], cbp, p_Vid->nz_coeff[mb_nr][uv]);
+      currMB->read_comp_coeff_8x8_CAVLC (currMB, (ColorPlane) (uv), InvLevelScale8x8, qp_per_uv[uv], cbp, currSlice->nz_coeff[mb_nr][uv]);
     }   
   }   
 }
@@ -1892,6 +1893,7 @@ static void read_CBP_and_coeffs_from_NAL_CAVLC_420(Macroblock *currMB)
       // read CAVLC transform_size_8x8_flag
       currSE.len = 1;
       readSyntaxElement_FLC(&currSE, dP->bitstream);
+      trace_cavlc_se(currMB, &currSE, dP);
 
       currMB->luma_transform_size_8x8_flag = (Boolean) currSE.value1;
     }
@@ -1989,16 +1991,16 @@ static void read_CBP_and_coeffs_from_NAL_CAVLC_420(Macroblock *currMB)
   {
     if (!currMB->luma_transform_size_8x8_flag) // 4x4 transform
     {
-      currMB->read_comp_coeff_4x4_CAVLC (currMB, PLANE_Y, InvLevelScale4x4, qp_per, cbp, p_Vid->nz_coeff[mb_nr][PLANE_Y]);
+      currMB->read_comp_coeff_4x4_CAVLC (currMB, PLANE_Y, InvLevelScale4x4, qp_per, cbp, currSlice->nz_coeff[mb_nr][PLANE_Y]);
     }
     else // 8x8 transform
     {
-      currMB->read_comp_coeff_8x8_CAVLC (currMB, PLANE_Y, InvLevelScale8x8, qp_per, cbp, p_Vid->nz_coeff[mb_nr][PLANE_Y]);
+      currMB->read_comp_coeff_8x8_CAVLC (currMB, PLANE_Y, InvLevelScale8x8, qp_per, cbp, currSlice->nz_coeff[mb_nr][PLANE_Y]);
     }
   }
   else
   {
-    fast_memset(p_Vid->nz_coeff[mb_nr][0][0], 0, BLOCK_PIXELS * sizeof(byte));
+    fast_memset(currSlice->nz_coeff[mb_nr][0][0], 0, BLOCK_PIXELS * sizeof(byte));
   }
 
   //========================== CHROMA DC ============================
@@ -2061,7 +2063,7 @@ static void read_CBP_and_coeffs_from_NAL_CAVLC_420(Macroblock *currMB)
   // chroma AC coeff, all zero fram start_scan
   if (cbp<=31)
   {
-    fast_memset(p_Vid->nz_coeff [mb_nr ][1][0], 0, 2 * BLOCK_PIXELS * sizeof(byte));
+    fast_memset(currSlice->nz_coeff [mb_nr ][1][0], 0, 2 * BLOCK_PIXELS * sizeof(byte));
   }
   else
   {
@@ -19,7 +19,9 @@
 
   This module contains the RTP packetization, de-packetization, and the
   handling of Parameter Sets, see VCEG-N52 and accompanying documents.
-  Note: Compound packets are not yet implemented!
+  GetRTPNALU() depacketizes single NAL unit, STAP-A and FU-A packets (the
+  non-interleaved mode of RFC 6184), read from a dump file or received
+  live on a UDP socket (rtp_udp.c).
 
   The interface between every NAL (including the RTP NAL) and the VCL is
   based on Slices.  The slice data structure on which the VCL is working
@@ -99,49 +101,141 @@
 #include "fmo.h"
 #include "sei.h"
 #include "memalloc.h"
+#include "rtp_udp.h"
+
+struct rtp_reader
+{
+  int          BitStreamFile;    //!< RTP dump file, -1 for live input
+  RTPUdp      *udp;              //!< live input, NULL for a dump file
+  RTPpacket_t  packet;           //!< packet being depacketized
+  unsigned int offset;           //!< of the next NAL unit in a STAP-A packet, 0 if none is left
+  int          first_packet;     //!< triggers sequence number initialization on the first packet
+  uint16       old_seq;          //!< the last RTP sequence number for loss detection
+  uint16       lost_packets;     //!< packets lost since the last NAL unit
+};
 
 int RTPReadPacket (RTPpacket_t *p, int bitstream);
 
 /*!
  ************************************************************************
  * \brief
- *    Opens the bit stream file named fn
+ *    Opens the RTP dump file named fn, or the live input if fn is
+ *    "udp://[address]:port"
  * \return
- *    none
+ *    the reader of the packets
  ************************************************************************
  */
-void OpenRTPFile (char *fn, int *p_BitStreamFile)
+RTPReader *OpenRTPFile (char *fn, InputParameters *p_Inp)
 {
-  if (((*p_BitStreamFile) = open(fn, OPENFLAGS_READ)) == -1)
+  RTPReader *rtp = (RTPReader *) calloc(1, sizeof(RTPReader));
+
+  if (rtp == NULL)
+    no_mem_exit ("OpenRTPFile: rtp");
+  if ((rtp->packet.packet = (byte *) malloc (MAXRTPPACKETSIZE + 1)) == NULL)
+    no_mem_exit ("OpenRTPFile: packet");
+  rtp->first_packet = 1;
+  rtp->BitStreamFile = -1;
+
+  if (is_rtp_udp_address(fn))
+    rtp->udp = open_rtp_udp(fn, p_Inp->rtp_reorder_packets, p_Inp->rtp_jitter_ms, p_Inp->rtp_timeout_ms);
+  else if ((rtp->BitStreamFile = open(fn, OPENFLAGS_READ)) == -1)
   {
     snprintf (errortext, ET_SIZE, "Cannot open RTP file '%s'", fn);
     error(errortext,500);
   }
+  return rtp;
+}
+
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Closes the bit stream file or the live input
+ ************************************************************************
+ */
+void CloseRTPFile(RTPReader *rtp)
+{
+  if (rtp == NULL)
+    return;
+
+  if (rtp->BitStreamFile != -1)
+    close(rtp->BitStreamFile);
+  close_rtp_udp(rtp->udp);
+  free (rtp->packet.packet);
+  free (rtp);
+}
+
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Reads the next packet into rtp->packet and counts the packets lost
+ *    before it
+ * \return
+ *    size of the packet, 0 at the end of the stream
+ ************************************************************************
+ */
+static int read_packet (RTPReader *rtp, int *lost)
+{
+  RTPpacket_t *p = &rtp->packet;
+  int ret;
+
+  if (rtp->udp != NULL)
+    ret = read_rtp_udp(rtp->udp, p, lost);
+  else
+  {
+    ret = RTPReadPacket (p, rtp->BitStreamFile);
+    if (ret > 0)
+    {
+      if (rtp->first_packet)
+      {
+        rtp->first_packet = 0;
+        rtp->old_seq = (uint16) (p->seq - 1);
+      }
+      *lost = (uint16) ( p->seq - (rtp->old_seq + 1) );
+      rtp->old_seq = p->seq;
+    }
+  }
+
+  if (ret > 0)
+    rtp->lost_packets = (uint16) (rtp->lost_packets + *lost);
+  return ret;
 }
 
 
 /*!
  ************************************************************************
  * \brief
- *    Closes the bit stream file
+ *    Sets the NAL unit header fields of the NAL unit of len bytes in
+ *    nalu->buf
+ * \return
+ *    len
  ************************************************************************
  */
-void CloseRTPFile(int *p_BitStreamFile)
+static int finish_nalu (RTPReader *rtp, NALU_t *nalu, int len)
 {
-  if ((*p_BitStreamFile) != -1)
+  nalu->len = len;
+  nalu->forbidden_bit = (nalu->buf[0]>>7) & 1;
+  nalu->nal_reference_idc = (NalRefIdc) ((nalu->buf[0]>>5) & 3);
+  nalu->nal_unit_type = (NaluType) ((nalu->buf[0]) & 0x1f);
+  nalu->lost_packets = rtp->lost_packets;
+  rtp->lost_packets = 0;
+  if (nalu->lost_packets)
   {
-    close(*p_BitStreamFile);
-    (*p_BitStreamFile) = - 1;
+    printf ("Warning: RTP sequence number discontinuity detected\n");
   }
+  return len;
 }
 
 
 /*!
  ************************************************************************
  * \brief
- *    Fills nalu->buf and nalu->len with the payload of an RTP packet.
- *    Other fields in nalu-> remain uninitialized (will be taken care of
- *    by NALUtoRBSP.
+ *    Fills nalu->buf and nalu->len with the next NAL unit: the payload of
+ *    a single NAL unit packet, the next NAL unit of a STAP-A packet or the
+ *    fragments of an FU-A reassembled. A NAL unit with a fragment lost is
+ *    dropped. Other fields in nalu-> remain uninitialized (will be taken
+ *    care of by NALUtoRBSP.
  *
  * \return
  *     4 in case of ok (for compatibility with get_annex_b_NALU)
@@ -151,62 +245,90 @@ void CloseRTPFile(int *p_BitStreamFile)
  ************************************************************************
  */
 
-int GetRTPNALU (VideoParameters *p_Vid, NALU_t *nalu, int BitStreamFile)
+int GetRTPNALU (VideoParameters *p_Vid, NALU_t *nalu, RTPReader *rtp)
 {
-  static uint16 first_call = 1;  //!< triggers sequence number initialization on first call
-  static uint16 old_seq = 0;     //!< store the last RTP sequence number for loss detection
-
-  RTPpacket_t *p;
-  int ret;
+  RTPpacket_t *p = &rtp->packet;
+  int fu_len = -1;   //!< bytes of a fragmented NAL unit in nalu->buf, -1 if none is started
 
-  if ((p=malloc (sizeof (RTPpacket_t)))== NULL)
-    no_mem_exit ("GetRTPNALU-1");
-  if ((p->packet=malloc (MAXRTPPACKETSIZE))== NULL)
-    no_mem_exit ("GetRTPNALU-2");
-  if ((p->payload=malloc (MAXRTPPACKETSIZE))== NULL)
-    no_mem_exit ("GetRTPNALU-3");
-
-  ret = RTPReadPacket (p, BitStreamFile);
   nalu->forbidden_bit = 1;
   nalu->len = 0;
 
-  if (ret > 0) // we got a packet ( -1=error, 0=end of file )
+  for (;;)
   {
-    if (first_call)
+    int ret, lost = 0;
+
+    if (rtp->offset > 0)
     {
-      first_call = 0;
-      old_seq = (uint16) (p->seq - 1);
+      // next NAL unit of a STAP-A packet, preceded by its 16 bit size
+      unsigned int size = 0;
+
+      if (rtp->offset + 2 <= p->paylen)
+        size = (p->payload[rtp->offset] << 8) | p->payload[rtp->offset + 1];
+      if (size == 0 || rtp->offset + 2 + size > p->paylen)
+      {
+        rtp->offset = 0;
+        continue;
+      }
+      assert (size < nalu->max_size);
+
+      memcpy (nalu->buf, &p->payload[rtp->offset + 2], size);
+      rtp->offset += 2 + size;
+      return finish_nalu (rtp, nalu, size);
     }
 
-    nalu->lost_packets = (uint16) ( p->seq - (old_seq + 1) );
-    old_seq = p->seq;
+    ret = read_packet (rtp, &lost);
+    if (ret <= 0) // -1=error, 0=end of file
+      return ret;
+    if (p->paylen == 0)
+      continue;
 
-    assert (p->paylen < nalu->max_size);
-
-    nalu->len = p->paylen;
-    memcpy (nalu->buf, p->payload, p->paylen);
-    nalu->forbidden_bit = (nalu->buf[0]>>7) & 1;
-    nalu->nal_reference_idc = (NalRefIdc) ((nalu->buf[0]>>5) & 3);
-    nalu->nal_unit_type = (NaluType) ((nalu->buf[0]) & 0x1f);
-    if (nalu->lost_packets)
+    switch (p->payload[0] & 0x1f)
     {
-      printf ("Warning: RTP sequence number discontinuity detected\n");
+    case RTP_STAP_A:
+      rtp->offset = 1;
+      fu_len = -1;
+      break;
+
+    case RTP_FU_A:
+      if (p->paylen < 2)
+        break;
+      if (p->payload[1] & 0x80)
+      {
+        // start bit, the NAL unit header is rebuilt from the FU indicator and header
+        nalu->buf[0] = (byte) ((p->payload[0] & 0xe0) | (p->payload[1] & 0x1f));
+        fu_len = 1;
+      }
+      else if (lost)
+        fu_len = -1;
+      if (fu_len < 0)
+        break;
+
+      if (fu_len + p->paylen - 2 >= nalu->max_size)
+      {
+        printf ("Warning: fragmented NAL unit exceeds %u bytes, dropped\n", nalu->max_size);
+        fu_len = -1;
+        break;
+      }
+      memcpy (&nalu->buf[fu_len], &p->payload[2], p->paylen - 2);
+      fu_len += p->paylen - 2;
+      if (p->payload[1] & 0x40)   // end bit
+        return finish_nalu (rtp, nalu, fu_len);
+      break;
+
+    case RTP_STAP_B:
+    case RTP_MTAP16:
+    case RTP_MTAP24:
+    case RTP_FU_B:
+      printf ("Warning: RTP packet of payload structure %d not supported, dropped\n", p->payload[0] & 0x1f);
+      fu_len = -1;
+      break;
+
+    default:
+      assert (p->paylen < nalu->max_size);
+      memcpy (nalu->buf, p->payload, p->paylen);
+      return finish_nalu (rtp, nalu, p->paylen);
     }
   }
-
-  // free memory
-  free (p->payload);
-  free (p->packet);
-  free (p);
-
-//  printf ("Got an RTP NALU, len %d, first byte %x\n", nalu->len, nalu->buf[0]);
-  
-  if (ret>0)
-    // length of packet
-    return nalu->len;
-  else 
-    // error code
-    return ret;
 }
 
 
@@ -223,8 +345,9 @@ int GetRTPNALU (VideoParameters *p_Vid, NALU_t *nalu, int BitStreamFile)
  *    negative error code in case of failure
  *
  * \param p
- *    Caller is responsible to allocate enough memory for the generated payload
- *    in parameter->payload. Typically a malloc of paclen-12 bytes is sufficient
+ *    the packet of packlen bytes in p->packet. p->payload is set to the
+ *    payload in p->packet, after the CSRCs and the header extension and
+ *    without the padding
  *
  * \par Side effects
  *    none
@@ -239,10 +362,11 @@ int GetRTPNALU (VideoParameters *p_Vid, NALU_t *nalu, int BitStreamFile)
 int DecomposeRTPpacket (RTPpacket_t *p)
 
 {
+  unsigned int header_len, padding;
+
   // consistency check
   assert (p->packlen < 65536 - 28);  // IP, UDP headers
   assert (p->packlen >= 12);         // at least a complete RTP header
-  assert (p->payload != NULL);
   assert (p->packet != NULL);
 
   // Extract header information
@@ -263,18 +387,21 @@ int DecomposeRTPpacket (RTPpacket_t *p)
   memcpy (&p->ssrc, &p->packet[8], 4);// change to shifts for unified byte sex
   p->ssrc = ntohl(p->ssrc);
 
+  header_len = 12 + 4 * p->cc;
+  if (p->x)
+    header_len += (header_len + 4 <= p->packlen) ? 4 + 4 * ((p->packet[header_len + 2] << 8) | p->packet[header_len + 3]) : 4;
+  padding = p->p ? p->packet[p->packlen - 1] : 0;
+
   // header consistency checks
   if (     (p->v != 2)
-        || (p->p != 0)
-        || (p->x != 0)
-        || (p->cc != 0) )
+        || (header_len + padding > p->packlen) )
   {
     printf ("DecomposeRTPpacket, RTP header consistency problem, header follows\n");
     DumpRTPHeader (p);
     return -1;
   }
-  p->paylen = p->packlen-12;
-  memcpy (p->payload, &p->packet[12], p->paylen);
+  p->payload = &p->packet[header_len];
+  p->paylen = p->packlen - header_len - padding;
   return 0;
 }
 
@@ -352,7 +479,6 @@ int RTPReadPacket (RTPpacket_t *p, int bitstream)
 
   assert (p != NULL);
   assert (p->packet != NULL);
-  assert (p->payload != NULL);
 
   Filepos = tell (bitstream);
   if (4 != read (bitstream, &p->packlen, 4))
@@ -32,15 +32,26 @@ typedef struct
                                 each sent packet */
   unsigned int timestamp;  //!< timestamp, 27 MHz for H.264
   unsigned int ssrc;       //!< Synchronization Source, chosen randomly
-  byte *       payload;    //!< the payload including payload headers
+  byte *       payload;    //!< the payload including payload headers, points into packet
   unsigned int paylen;     //!< length of payload in bytes
   byte *       packet;     //!< complete packet including header and payload
   unsigned int packlen;    //!< length of packet, typically paylen+12
 } RTPpacket_t;
 
+// payload structures of RFC 6184 besides single NAL unit packets (NAL unit types 1-23)
+#define RTP_STAP_A  24                    //!< single-time aggregation packet
+#define RTP_STAP_B  25
+#define RTP_MTAP16  26
+#define RTP_MTAP24  27
+#define RTP_FU_A    28                    //!< fragmentation unit
+#define RTP_FU_B    29
+
+typedef struct rtp_reader RTPReader;
+
 void DumpRTPHeader (RTPpacket_t *p);
-int  GetRTPNALU  (VideoParameters *p_Vid, NALU_t *nalu, int BitStreamFile);
-void OpenRTPFile (char *fn, int *p_BitStreamFile);
-void CloseRTPFile(int *p_BitStreamFile);
+int  DecomposeRTPpacket (RTPpacket_t *p);
+int  GetRTPNALU  (VideoParameters *p_Vid, NALU_t *nalu, RTPReader *rtp);
+RTPReader *OpenRTPFile (char *fn, InputParameters *p_Inp);
+void CloseRTPFile(RTPReader *rtp);
 
 #endif
@@ -0,0 +1,431 @@
+
+/*!
+ *************************************************************************************
+ * \file rtp_udp.c
+ *
+ * \brief
+ *    Live RTP input received on a UDP socket, see rtp_udp.h
+ *
+ *    The reorder buffer is a ring of packets, slot head holding the packet
+ *    with sequence number next_seq. Packets change places by swapping the
+ *    RTPpacket_t structures, so a packet is received into its buffer once
+ *    and never copied.
+ *
+ *************************************************************************************
+ */
+
+#if defined(WIN32) || defined(WIN64)
+#include <Winsock2.h>
+#include <Ws2tcpip.h>
+#define close_socket closesocket
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+typedef int SOCKET;
+#define INVALID_SOCKET (-1)
+#define close_socket close
+#endif
+
+#include "global.h"
+#include "memalloc.h"
+#include "rtp_udp.h"
+
+#define RTP_UDP_RCVBUF  (4 << 20)  //!< socket receive buffer requested, holds the packets arriving while a picture is decoded
+
+struct rtp_udp
+{
+  SOCKET       sock;
+  int          num_slots;
+  RTPpacket_t *slots;              //!< packet with sequence number next_seq + d in slots[(head + d) % num_slots]
+  byte        *used;               //!< slot holds a packet
+  int          buffered;           //!< packets in the slots
+  int          head;
+  uint16       next_seq;           //!< sequence number of the next packet handed out
+  RTPpacket_t  recv;               //!< packet being received
+  RTPpacket_t  held;               //!< received packet too far ahead to fit into the slots
+  int          has_held;
+  int          started;            //!< the first packet was received, next_seq and ssrc are set
+  int          delivered;          //!< a packet was handed out
+  TIME_T       start;              //!< when the first packet arrived
+  unsigned int ssrc;               //!< source of the stream, packets of other sources are dropped
+  TIME_T       gap_start;          //!< when a packet arrived while the one at head is missing
+  int          gap_timer;          //!< gap_start is set
+  int          jitter_ms;
+  int          timeout_ms;         //!< 0: wait forever
+};
+
+static void alloc_packet(RTPpacket_t *p)
+{
+  // one byte more than any valid packet to tell oversized datagrams apart
+  if ((p->packet = (byte *) malloc(MAXRTPPACKETSIZE + 1)) == NULL)
+    no_mem_exit("alloc_packet: packet");
+}
+
+static void swap_packets(RTPpacket_t *a, RTPpacket_t *b)
+{
+  RTPpacket_t t = *a;
+
+  *a = *b;
+  *b = t;
+}
+
+static int elapsed_ms(TIME_T *start)
+{
+  TIME_T now;
+
+  gettime(&now);
+  return (int) timenorm(timediff(start, &now));
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    returns 1 if fn names live input ("udp://[address]:port")
+ ************************************************************************
+ */
+int is_rtp_udp_address(const char *fn)
+{
+  return 0 == strncmp(fn, RTP_UDP_PREFIX, strlen(RTP_UDP_PREFIX));
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    binds a UDP socket to "udp://[address]:port"
+ ************************************************************************
+ */
+static SOCKET bind_socket(const char *fn)
+{
+  const char *host = fn + strlen(RTP_UDP_PREFIX);
+  const char *colon = strrchr(host, ':');
+  char address[64];
+  struct sockaddr_storage sa;
+  socklen_t sa_len;
+  char *end = NULL;
+  int port = 0, rcvbuf = RTP_UDP_RCVBUF;
+  SOCKET sock;
+
+  if (colon != NULL)
+    port = (int) strtol(colon + 1, &end, 10);
+  if (colon == NULL || *end != '\0' || port <= 0 || port > 65535)
+  {
+    snprintf(errortext, ET_SIZE, "No port in the RTP input address '%s', expected udp://[address]:port", fn);
+    error(errortext, 500);
+  }
+  if (*host == '[' && colon > host && colon[-1] == ']')
+    ++host, --colon;
+  snprintf(address, sizeof(address), "%.*s", (int) (colon - host), host);
+
+  memset(&sa, 0, sizeof(sa));
+  if (strchr(address, ':') != NULL)
+  {
+    struct sockaddr_in6 *sa6 = (struct sockaddr_in6 *) &sa;
+
+    sa6->sin6_family = AF_INET6;
+    sa6->sin6_port   = htons((uint16) port);
+    sa_len = sizeof(*sa6);
+    if (inet_pton(AF_INET6, address, &sa6->sin6_addr) != 1)
+      sa_len = 0;
+  }
+  else
+  {
+    struct sockaddr_in *sa4 = (struct sockaddr_in *) &sa;
+
+    sa4->sin_family = AF_INET;
+    sa4->sin_port   = htons((uint16) port);
+    sa_len = sizeof(*sa4);
+    if (*address == '\0')
+      sa4->sin_addr.s_addr = htonl(INADDR_ANY);
+    else if (inet_pton(AF_INET, address, &sa4->sin_addr) != 1)
+      sa_len = 0;
+  }
+  if (sa_len == 0)
+  {
+    snprintf(errortext, ET_SIZE, "Invalid address '%s' of the RTP input, expected a numeric IPv4 or IPv6 address", address);
+    error(errortext, 500);
+  }
+
+  if ((sock = socket(sa.ss_family, SOCK_DGRAM, IPPROTO_UDP)) == INVALID_SOCKET
+    || bind(sock, (struct sockaddr *) &sa, sa_len) != 0)
+  {
+    snprintf(errortext, ET_SIZE, "Cannot bind a UDP socket to '%s' for the RTP input", fn);
+    error(errortext, 500);
+  }
+  // the default buffer can overflow while a picture is decoded, a smaller one is no error
+  setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (const char *) &rcvbuf, sizeof(rcvbuf));
+
+  return sock;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    opens the live RTP input fn
+ ************************************************************************
+ */
+RTPUdp *open_rtp_udp(const char *fn, int reorder_packets, int jitter_ms, int timeout_ms)
+{
+  RTPUdp *u = (RTPUdp *) calloc(1, sizeof(RTPUdp));
+  int i;
+
+#if defined(WIN32) || defined(WIN64)
+  WSADATA wsa_data;
+
+  if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+    error("open_rtp_udp: cannot initialize Winsock", 500);
+#endif
+
+  if (u == NULL)
+    no_mem_exit("open_rtp_udp: u");
+
+  u->sock       = bind_socket(fn);
+  u->num_slots  = reorder_packets;
+  u->jitter_ms  = jitter_ms;
+  u->timeout_ms = timeout_ms;
+
+  if ((u->slots = (RTPpacket_t *) calloc(u->num_slots, sizeof(RTPpacket_t))) == NULL)
+    no_mem_exit("open_rtp_udp: slots");
+  if ((u->used = (byte *) calloc(u->num_slots, sizeof(byte))) == NULL)
+    no_mem_exit("open_rtp_udp: used");
+  for (i = 0; i < u->num_slots; ++i)
+    alloc_packet(&u->slots[i]);
+  alloc_packet(&u->recv);
+  alloc_packet(&u->held);
+
+  return u;
+}
+
+void close_rtp_udp(RTPUdp *u)
+{
+  int i;
+
+  if (u == NULL)
+    return;
+
+  close_socket(u->sock);
+#if defined(WIN32) || defined(WIN64)
+  WSACleanup();
+#endif
+  for (i = 0; i < u->num_slots; ++i)
+    free(u->slots[i].packet);
+  free(u->recv.packet);
+  free(u->held.packet);
+  free(u->slots);
+  free(u->used);
+  free(u);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    returns 1 if next_seq can move n packets back without pushing
+ *    buffered packets out of the slots
+ ************************************************************************
+ */
+static int can_move_back(RTPUdp *u, int n)
+{
+  int d;
+
+  for (d = u->num_slots - n; d < u->num_slots; ++d)
+  {
+    if (u->used[(u->head + d) % u->num_slots])
+      return 0;
+  }
+  return 1;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    puts the packet p into its slot, into u->held if it is too
+ *    far ahead. Late and duplicate packets are dropped. Of two packets
+ *    too far ahead the nearer one is held and the other one dropped;
+ *    it is counted as lost when the window moves past its sequence number.
+ ************************************************************************
+ */
+static void buffer_packet(RTPUdp *u, RTPpacket_t *p)
+{
+  int d = (int16) (p->seq - u->next_seq);
+  int slot;
+
+  if (d < 0 && !u->delivered && -d < u->num_slots && can_move_back(u, -d))
+  {
+    // sent before the first packet received, the stream starts with it
+    u->head = (u->head + d + u->num_slots) % u->num_slots;
+    u->next_seq = p->seq;
+    u->gap_timer = 0;
+    d = 0;
+  }
+  if (d < 0)
+    return;
+  if (d >= u->num_slots)
+  {
+    if (u->has_held && (uint16) (u->held.seq - u->next_seq) <= (uint16) d)
+    {
+      printf("Warning: RTP packet %d too far ahead of %d dropped\n", p->seq, u->next_seq);
+      return;
+    }
+    if (u->has_held)
+      printf("Warning: RTP packet %d too far ahead of %d dropped\n", u->held.seq, u->next_seq);
+    swap_packets(p, &u->held);
+    u->has_held = 1;
+    return;
+  }
+
+  slot = (u->head + d) % u->num_slots;
+  if (u->used[slot])
+    return;
+  swap_packets(p, &u->slots[slot]);
+  u->used[slot] = 1;
+  ++u->buffered;
+
+  if (!u->used[u->head] && !u->gap_timer)
+  {
+    gettime(&u->gap_start);
+    u->gap_timer = 1;
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    moves head n packets on, the held packet into the slots once it fits
+ ************************************************************************
+ */
+static void advance(RTPUdp *u, int n)
+{
+  u->head = (u->head + n) % u->num_slots;
+  u->next_seq = (uint16) (u->next_seq + n);
+  u->gap_timer = 0;
+
+  if (u->has_held && (int16) (u->held.seq - u->next_seq) < u->num_slots)
+  {
+    u->has_held = 0;
+    buffer_packet(u, &u->held);
+  }
+  if (u->buffered > 0 && !u->used[u->head])
+  {
+    gettime(&u->gap_start);
+    u->gap_timer = 1;
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    waits up to wait_ms (forever if negative) for a packet and buffers it
+ *
+ * \return
+ *    1 if a datagram was received, 0 if none arrived in time
+ ************************************************************************
+ */
+static int receive_packet(RTPUdp *u, int wait_ms)
+{
+  RTPpacket_t *p = &u->recv;
+  struct timeval tv;
+  fd_set fds;
+  int n;
+
+  FD_ZERO(&fds);
+  FD_SET(u->sock, &fds);
+  tv.tv_sec  = wait_ms / 1000;
+  tv.tv_usec = (wait_ms % 1000) * 1000;
+  n = select((int) u->sock + 1, &fds, NULL, NULL, wait_ms < 0 ? NULL : &tv);
+  if (n < 0)
+    error("receive_packet: select() failed on the RTP input socket", 500);
+  if (n == 0)
+    return 0;
+
+  n = recv(u->sock, (char *) p->packet, MAXRTPPACKETSIZE + 1, 0);
+  if (n < 0)
+    error("receive_packet: recv() failed on the RTP input socket", 500);
+
+  p->packlen = n;
+  if (n < 12 || n >= MAXRTPPACKETSIZE || DecomposeRTPpacket(p) < 0)
+  {
+    printf("Warning: invalid RTP packet of %d bytes dropped\n", n);
+    return 1;
+  }
+
+  if (!u->started)
+  {
+    u->started  = 1;
+    u->next_seq = p->seq;
+    u->ssrc     = p->ssrc;
+    gettime(&u->start);
+  }
+  if (p->ssrc == u->ssrc)
+    buffer_packet(u, p);
+  return 1;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    hands out the next packet in sequence number order in p, which
+ *    gets a packet buffer of the reorder buffer in exchange for its own
+ *
+ * \return
+ *    size of the packet, 0 at the end of the stream. lost_packets is set
+ *    to the number of packets skipped before it.
+ ************************************************************************
+ */
+int read_rtp_udp(RTPUdp *u, RTPpacket_t *p, int *lost_packets)
+{
+  *lost_packets = 0;
+
+  for (;;)
+  {
+    int wait_ms;
+
+    if (!u->delivered && u->started && !u->has_held && (wait_ms = u->jitter_ms - elapsed_ms(&u->start)) > 0)
+    {
+      // packets sent before the first one received may still arrive
+      receive_packet(u, wait_ms);
+      continue;
+    }
+
+    if (u->used[u->head])
+    {
+      swap_packets(p, &u->slots[u->head]);
+      u->used[u->head] = 0;
+      --u->buffered;
+      u->delivered = 1;
+      advance(u, 1);
+      return p->packlen;
+    }
+
+    if (u->buffered == 0 && u->has_held)
+    {
+      // nothing buffered before the held packet, start over at it
+      *lost_packets += (uint16) (u->held.seq - u->next_seq);
+      u->next_seq  = u->held.seq;
+      u->has_held  = 0;
+      u->gap_timer = 0;
+      buffer_packet(u, &u->held);
+      continue;
+    }
+
+    if (u->buffered > 0 && (u->has_held || elapsed_ms(&u->gap_start) >= u->jitter_ms))
+    {
+      // give up waiting for the packets up to the next buffered one
+      int d = 1;
+
+      while (!u->used[(u->head + d) % u->num_slots])
+        ++d;
+      *lost_packets += d;
+      advance(u, d);
+      continue;
+    }
+
+    if (u->buffered > 0)
+      wait_ms = imax(0, u->jitter_ms - elapsed_ms(&u->gap_start));
+    else
+      wait_ms = (u->started && u->timeout_ms > 0) ? u->timeout_ms : -1;
+
+    if (!receive_packet(u, wait_ms) && u->buffered == 0)
+      return 0;
+  }
+}
@@ -0,0 +1,37 @@
+
+/*!
+ *************************************************************************************
+ * \file rtp_udp.h
+ *
+ * \brief
+ *    Live RTP input received on a UDP socket
+ *
+ *    InputFile "udp://[address]:port" with FileFormat = 1 binds a UDP
+ *    socket to the numeric address (any address if empty, IPv6 addresses
+ *    in brackets) and the port. The packets pass a reorder buffer of
+ *    RTPReorderPackets packets that hands them out in sequence number
+ *    order. A missing packet is counted as lost when it did not arrive
+ *    within RTPJitterMs of a later one, or at once when a packet arrives
+ *    that does not fit into the buffer. The first packet is held for
+ *    RTPJitterMs as well, so that packets sent before it can still arrive.
+ *    The stream ends when no packet was received for RTPTimeoutMs after
+ *    the first one.
+ *
+ *************************************************************************************
+ */
+
+#ifndef _RTP_UDP_H_
+#define _RTP_UDP_H_
+
+#include "rtp.h"
+
+#define RTP_UDP_PREFIX  "udp://"
+
+typedef struct rtp_udp RTPUdp;
+
+extern int     is_rtp_udp_address(const char *fn);
+extern RTPUdp *open_rtp_udp      (const char *fn, int reorder_packets, int jitter_ms, int timeout_ms);
+extern void    close_rtp_udp     (RTPUdp *u);
+extern int     read_rtp_udp      (RTPUdp *u, RTPpacket_t *p, int *lost_packets);
+
+#endif
@@ -0,0 +1,325 @@
+
+/*!
+ *************************************************************************************
+ * \file se_trace.c
+ *
+ * \brief
+ *    Binary trace of the macroblock layer syntax elements (-trace bin)
+ *
+ *    Tracing replaces the readSyntaxElement() methods of the data
+ *    partitions and read_coeff_4x4_CAVLC() of a slice by versions that
+ *    append a record for every element to a buffer of the slice, so
+ *    decoding without -trace runs the same code as before. The few CAVLC
+ *    elements read directly from the bitstream are recorded with
+ *    trace_cavlc_se(). A CAVLC residual block gives one record for the
+ *    whole block.
+ *
+ *    Slices decoded one after the other write their records when the
+ *    buffer is full and at the end of the slice. Slices decoded in
+ *    parallel keep their records until the end of the picture, except
+ *    for the first one, so the file is in decoding order whatever the
+ *    number of threads.
+ *
+ *************************************************************************************
+ */
+
+#include "global.h"
+#include "memalloc.h"
+#include "elements.h"
+#include "biaridecod.h"
+#include "cabac.h"
+#include "vlc.h"
+#include "se_trace.h"
+
+#define SE_TRACE_RECORDS  4096   //!< records buffered by a slice before they are written
+
+extern void read_coeff_4x4_CAVLC    (Macroblock *currMB, int block_type, int i, int j, int levarr[16], int runarr[16], int *number_coefficients);
+extern void read_coeff_4x4_CAVLC_444(Macroblock *currMB, int block_type, int i, int j, int levarr[16], int runarr[16], int *number_coefficients);
+
+struct se_trace
+{
+  FILE   *file;
+  uint32  num_pics;              //!< pictures whose records are complete in the file
+  int     next_slice;            //!< first slice of the current picture with records not written yet
+};
+
+struct se_trace_buffer
+{
+  SETraceRecord *records;
+  int            size;           //!< records buffered
+  int            capacity;
+  uint32         pic;            //!< picture of the slice
+};
+
+static void write_records(SETrace *t, SETraceBuffer *buf)
+{
+  if (buf->size > 0 && fwrite(buf->records, sizeof(SETraceRecord), buf->size, t->file) != (size_t) buf->size)
+    error ("write_records: error writing the syntax element trace", 500);
+  buf->size = 0;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    makes room for a record in the full buffer of a slice: writes the
+ *    records if all slices before it are written, enlarges the buffer
+ *    otherwise
+ ************************************************************************
+ */
+static void make_room(Slice *currSlice)
+{
+  SETrace *t = currSlice->p_Vid->se_trace;
+  SETraceBuffer *buf = currSlice->se_trace_buf;
+
+  if (currSlice->current_slice_nr == t->next_slice)
+    write_records(t, buf);
+  else
+  {
+    MemTag prev_tag = mem_set_tag(MEM_SLICE);
+    SETraceRecord *records = (SETraceRecord *) mem_malloc(2 * buf->capacity * sizeof(SETraceRecord));
+
+    memcpy(records, buf->records, buf->size * sizeof(SETraceRecord));
+    mem_free(buf->records);
+    buf->records = records;
+    buf->capacity *= 2;
+    mem_set_tag(prev_tag);
+  }
+}
+
+static int is_residual_se(int type)
+{
+  return (type >= SE_LUM_DC_INTRA && type <= SE_CHR_AC_INTRA) || (type >= SE_LUM_DC_INTER && type <= SE_CHR_AC_INTER);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    appends a record to the buffer of the slice of currMB.
+ *
+ *    The parser leaves value2 and context of most elements as they were
+ *    before reading them, so they are only kept for the motion vector
+ *    differences, reference indices and residuals that set or use them.
+ *    CAVLC elements other than residual blocks pass neither.
+ ************************************************************************
+ */
+void put_se_trace(Macroblock *currMB, int type, DataPartition *dP, int pos, int len,
+                  int value1, int value2, int context, int flags)
+{
+  Slice *currSlice = currMB->p_Slice;
+  SETraceBuffer *buf = currSlice->se_trace_buf;
+  SETraceRecord *rec;
+
+  if (type != SE_MVD && type != SE_REFFRAME && !is_residual_se(type))
+  {
+    value2  = 0;
+    context = -1;
+  }
+
+  if (buf->size == buf->capacity)
+    make_room(currSlice);
+
+  rec = &buf->records[buf->size++];
+  rec->pic      = buf->pic;
+  rec->mb       = currMB->mbAddrX;
+  rec->pos      = pos;
+  rec->len      = len;
+  rec->value1   = value1;
+  rec->value2   = value2;
+  rec->context  = (int16) context;
+  rec->slice    = (uint16) currSlice->current_slice_nr;
+  rec->type     = (byte) type;
+  rec->flags    = (byte) ((dP - currSlice->partArr) | flags);
+  rec->reserved = 0;
+}
+
+static int readSyntaxElement_UVLC_traced(Macroblock *currMB, SyntaxElement *currSE, DataPartition *dP)
+{
+  int pos = dP->bitstream->frame_bitoffset;
+  int ret = readSyntaxElement_UVLC(currMB, currSE, dP);
+
+  put_se_trace(currMB, currSE->type, dP, pos, dP->bitstream->frame_bitoffset - pos,
+               currSE->value1, 0, -1, 0);
+  return ret;
+}
+
+static int readSyntaxElement_CABAC_traced(Macroblock *currMB, SyntaxElement *currSE, DataPartition *dP)
+{
+  int pos = arideco_bits_read(&dP->de_cabac);
+  int ret = readSyntaxElement_CABAC(currMB, currSE, dP);
+
+  put_se_trace(currMB, currSE->type, dP, pos, currSE->len,
+               currSE->value1, currSE->value2, currSE->context, SE_TRACE_CABAC);
+  return ret;
+}
+
+//! syntax element type read_coeff_4x4_CAVLC() uses for a block, selecting its partition
+static int cavlc_block_se_type(Macroblock *currMB, int block_type)
+{
+  switch (block_type)
+  {
+  case LUMA_INTRA16x16DC:
+  case CB_INTRA16x16DC:
+  case CR_INTRA16x16DC:
+    return SE_LUM_DC_INTRA;
+  case LUMA_INTRA16x16AC:
+  case CB_INTRA16x16AC:
+  case CR_INTRA16x16AC:
+    return SE_LUM_AC_INTRA;
+  case CHROMA_DC:
+    return currMB->is_intra_block ? SE_CHR_DC_INTRA : SE_CHR_DC_INTER;
+  case CHROMA_AC:
+    return currMB->is_intra_block ? SE_CHR_AC_INTRA : SE_CHR_AC_INTER;
+  default:
+    return currMB->is_intra_block ? SE_LUM_AC_INTRA : SE_LUM_AC_INTER;
+  }
+}
+
+static void trace_coeff_block(Macroblock *currMB, int block_type, int i, int j, int pos, int numcoeff)
+{
+  Slice *currSlice = currMB->p_Slice;
+  int type = cavlc_block_se_type(currMB, block_type);
+  DataPartition *dP = &currSlice->partArr[assignSE2partition[currSlice->dp_mode][type]];
+
+  put_se_trace(currMB, type, dP, pos, dP->bitstream->frame_bitoffset - pos,
+               numcoeff, (j << 4) | i, block_type, SE_TRACE_BLOCK);
+}
+
+static void read_coeff_4x4_CAVLC_traced(Macroblock *currMB, int block_type, int i, int j,
+                                        int levarr[16], int runarr[16], int *number_coefficients)
+{
+  Slice *currSlice = currMB->p_Slice;
+  int pos = currSlice->partArr[assignSE2partition[currSlice->dp_mode][cavlc_block_se_type(currMB, block_type)]].bitstream->frame_bitoffset;
+
+  read_coeff_4x4_CAVLC(currMB, block_type, i, j, levarr, runarr, number_coefficients);
+  trace_coeff_block(currMB, block_type, i, j, pos, *number_coefficients);
+}
+
+static void read_coeff_4x4_CAVLC_444_traced(Macroblock *currMB, int block_type, int i, int j,
+                                            int levarr[16], int runarr[16], int *number_coefficients)
+{
+  Slice *currSlice = currMB->p_Slice;
+  int pos = currSlice->partArr[assignSE2partition[currSlice->dp_mode][cavlc_block_se_type(currMB, block_type)]].bitstream->frame_bitoffset;
+
+  read_coeff_4x4_CAVLC_444(currMB, block_type, i, j, levarr, runarr, number_coefficients);
+  trace_coeff_block(currMB, block_type, i, j, pos, *number_coefficients);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    opens the trace file and writes its header
+ ************************************************************************
+ */
+SETrace *open_se_trace(const char *filename)
+{
+  SETrace *t = (SETrace *) calloc(1, sizeof(SETrace));
+  SETraceHeader header;
+
+  if (t == NULL)
+    no_mem_exit("open_se_trace: t");
+  if ((t->file = fopen(filename, "wb")) == NULL)
+  {
+    snprintf(errortext, ET_SIZE, "Error open file %s for writing the syntax element trace", filename);
+    error(errortext, 500);
+  }
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SE_TRACE_MAGIC, sizeof(header.magic));
+  header.record_size = sizeof(SETraceRecord);
+  if (fwrite(&header, sizeof(header), 1, t->file) != 1)
+    error ("open_se_trace: error writing the syntax element trace", 500);
+
+  return t;
+}
+
+void close_se_trace(SETrace *t)
+{
+  if (t == NULL)
+    return;
+
+  fclose(t->file);
+  free(t);
+}
+
+void free_se_trace_buffer(SETraceBuffer *buf)
+{
+  MemTag prev_tag = mem_set_tag(MEM_SLICE);
+
+  if (buf != NULL)
+  {
+    mem_free(buf->records);
+    mem_free(buf);
+  }
+  mem_set_tag(prev_tag);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    prepares a slice of the current picture for tracing its elements,
+ *    after its entropy decoding methods are set up
+ ************************************************************************
+ */
+void start_se_trace(Slice *currSlice)
+{
+  SETraceBuffer *buf = currSlice->se_trace_buf;
+  int i;
+
+  if (buf == NULL)
+  {
+    MemTag prev_tag = mem_set_tag(MEM_SLICE);
+
+    buf = currSlice->se_trace_buf = (SETraceBuffer *) mem_calloc(1, sizeof(SETraceBuffer));
+    buf->records  = (SETraceRecord *) mem_malloc(SE_TRACE_RECORDS * sizeof(SETraceRecord));
+    buf->capacity = SE_TRACE_RECORDS;
+    mem_set_tag(prev_tag);
+  }
+  buf->size = 0;
+  buf->pic  = currSlice->p_Vid->se_trace->num_pics;
+
+  for (i = 0; i < 3; ++i)
+  {
+    DataPartition *dP = &currSlice->partArr[i];
+
+    if (dP->readSyntaxElement == readSyntaxElement_UVLC)
+      dP->readSyntaxElement = readSyntaxElement_UVLC_traced;
+    else if (dP->readSyntaxElement == readSyntaxElement_CABAC)
+      dP->readSyntaxElement = readSyntaxElement_CABAC_traced;
+  }
+
+  if (currSlice->read_coeff_4x4_CAVLC == read_coeff_4x4_CAVLC)
+    currSlice->read_coeff_4x4_CAVLC = read_coeff_4x4_CAVLC_traced;
+  else if (currSlice->read_coeff_4x4_CAVLC == read_coeff_4x4_CAVLC_444)
+    currSlice->read_coeff_4x4_CAVLC = read_coeff_4x4_CAVLC_444_traced;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    writes the records of a slice decoded after all slices before it
+ ************************************************************************
+ */
+void end_se_trace_slice(Slice *currSlice)
+{
+  SETrace *t = currSlice->p_Vid->se_trace;
+
+  write_records(t, currSlice->se_trace_buf);
+  t->next_slice = currSlice->current_slice_nr + 1;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    writes the records of the current picture still buffered
+ ************************************************************************
+ */
+void end_se_trace_picture(VideoParameters *p_Vid)
+{
+  SETrace *t = p_Vid->se_trace;
+  int i;
+
+  for (i = t->next_slice; i < p_Vid->iSliceNumOfCurrPic; ++i)
+    write_records(t, p_Vid->ppSliceList[i]->se_trace_buf);
+  t->next_slice = 0;
+  ++t->num_pics;
+}
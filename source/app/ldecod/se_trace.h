@@ -0,0 +1,82 @@
+
+/*!
+ *************************************************************************************
+ * \file se_trace.h
+ *
+ * \brief
+ *    Binary trace of the macroblock layer syntax elements (-trace bin)
+ *
+ *    The file starts with an SETraceHeader followed by one SETraceRecord
+ *    per syntax element in decoding order. tracedump prints and filters it.
+ *
+ *************************************************************************************
+ */
+
+#ifndef _SE_TRACE_H_
+#define _SE_TRACE_H_
+
+#include "global.h"
+
+#define SE_TRACE_MAGIC      "JMSETRC1"
+
+// flags of a trace record
+#define SE_TRACE_PART_MASK  0x03   //!< data partition the element was read from
+#define SE_TRACE_CABAC      0x04   //!< element decoded with CABAC
+#define SE_TRACE_BLOCK      0x08   //!< CAVLC residual block, value1: coefficients, value2: block position (j << 4) | i
+
+//! trace mode selected with -trace
+typedef enum {
+  SE_TRACE_OFF = 0,
+  SE_TRACE_BIN = 1
+} SETraceMode;
+
+typedef struct se_trace_header
+{
+  char   magic[8];                 //!< SE_TRACE_MAGIC without the terminating zero
+  uint32 record_size;              //!< sizeof(SETraceRecord)
+  uint32 reserved;
+} SETraceHeader;
+
+//! one syntax element, in the byte order of the decoding machine
+typedef struct se_trace_record
+{
+  uint32 pic;                      //!< picture in decoding order, counting from 0
+  uint32 mb;                       //!< macroblock address
+  uint32 pos;                      //!< bit position in the partition before the element
+  uint32 len;                      //!< bits read
+  int32  value1;
+  int32  value2;                   //!< CABAC: run, list and component of an MVD, list of a reference index, or 0
+  int16  context;                  //!< CABAC: context of an MVD, reference index or residual, CAVLC: block type, or -1
+  uint16 slice;                    //!< slice of the picture
+  byte   type;                     //!< SE_HEADER ... SE_EOS
+  byte   flags;                    //!< SE_TRACE_PART_MASK, SE_TRACE_CABAC, SE_TRACE_BLOCK
+  uint16 reserved;
+} SETraceRecord;
+
+typedef struct se_trace SETrace;
+typedef struct se_trace_buffer SETraceBuffer;
+
+extern SETrace *open_se_trace       (const char *filename);
+extern void     close_se_trace      (SETrace *t);
+extern void     start_se_trace      (Slice *currSlice);
+extern void     end_se_trace_slice  (Slice *currSlice);
+extern void     end_se_trace_picture(VideoParameters *p_Vid);
+extern void     free_se_trace_buffer(SETraceBuffer *buf);
+extern void     put_se_trace        (Macroblock *currMB, int type, DataPartition *dP, int pos, int len,
+                                     int value1, int value2, int context, int flags);
+
+/*!
+ ************************************************************************
+ * \brief
+ *    records a CAVLC element that was read directly from the bitstream
+ *    instead of through readSyntaxElement(). Called after reading it.
+ ************************************************************************
+ */
+static inline void trace_cavlc_se(Macroblock *currMB, SyntaxElement *currSE, DataPartition *dP)
+{
+  if (currMB->p_Slice->se_trace_buf != NULL)
+    put_se_trace(currMB, currSE->type, dP, dP->bitstream->frame_bitoffset - currSE->len, currSE->len,
+                 currSE->value1, 0, -1, 0);
+}
+
+#endif
@@ -57,6 +57,61 @@
 // #define PRINT_FRAME_PACKING_ARRANGEMENT_INFO       // uncomment to print frame packing arrangement SEI info
 // #define PRINT_GREEN_METADATA_INFO      // uncomment to print Green Metadata SEI info
 
+/*!
+ ************************************************************************
+ *  \brief
+ *     Convert the SEITypes parameter to the mask of interpreted payload
+ *     types: bit type % 64 of mask[type / 64]. Bit SEI_TYPE_COUNT stands
+ *     for all larger, reserved types and is only set by "all".
+ *  \param mask
+ *     SEI_TYPE_WORDS words
+ *  \param types
+ *     "all", "none" or a comma separated list of payload types
+ *
+ ************************************************************************
+ */
+void parse_sei_types(uint64 *mask, const char *types)
+{
+  const char *p = types;
+  int all = (types[0] == '\0' || strcmp(types, "all") == 0);
+
+  memset(mask, all ? 0xFF : 0, SEI_TYPE_WORDS * sizeof(uint64));
+  if (all || strcmp(types, "none") == 0)
+    return;
+
+  while (*p != '\0')
+  {
+    char *end;
+    long type = strtol(p, &end, 10);
+
+    if (end == p || type < 0 || (*end != ',' && *end != '\0'))
+    {
+      snprintf(errortext, ET_SIZE, "Invalid SEITypes '%s', expected all, none or a list of payload types like 5,6", types);
+      error(errortext, 300);
+    }
+    if (type >= SEI_TYPE_COUNT)
+    {
+      snprintf(errortext, ET_SIZE, "Invalid SEITypes '%s', payload type %ld is reserved, only types below %d can be listed", types, type, SEI_TYPE_COUNT);
+      error(errortext, 300);
+    }
+    mask[type >> 6] |= (uint64) 1 << (type & 63);
+    p = (*end == ',') ? end + 1 : end;
+  }
+}
+
+/*!
+ ************************************************************************
+ *  \brief
+ *     Returns whether SEI messages of a payload type are interpreted
+ ************************************************************************
+ */
+static int sei_type_enabled(const uint64 *mask, int type)
+{
+  if (type > SEI_TYPE_COUNT)
+    type = SEI_TYPE_COUNT;
+  return (int) ((mask[type >> 6] >> (type & 63)) & 1);
+}
+
 /*!
  ************************************************************************
  *  \brief
@@ -98,6 +153,13 @@ void InterpretSEIMessage(byte* msg, int size, VideoParameters *p_Vid, Slice *pSl
     }
     payload_size += tmp_byte;   // this is the last byte
 
+    // messages not listed in SEITypes are skipped unparsed
+    if (!sei_type_enabled(p_Vid->sei_types, payload_type))
+    {
+      offset += payload_size;
+      continue;
+    }
+
     switch ( payload_type )     // sei_payload( type, size );
     {
     case  SEI_BUFFERING_PERIOD:
@@ -116,6 +178,8 @@ void InterpretSEIMessage(byte* msg, int size, VideoParameters *p_Vid, Slice *pSl
       interpret_user_data_registered_itu_t_t35_info( msg+offset, payload_size, p_Vid );
       break;
     case  SEI_USER_DATA_UNREGISTERED:
+      if (p_Vid->sei_user_data_callback != NULL && payload_size >= 16)
+        p_Vid->sei_user_data_callback(p_Vid->sei_user_data_opaque, msg+offset, msg+offset+16, payload_size-16);
       interpret_user_data_unregistered_info( msg+offset, payload_size, p_Vid );
       break;
     case  SEI_RECOVERY_POINT:
@@ -126,6 +126,7 @@ typedef struct
 } Green_metadata_information_struct;
 
 
+void parse_sei_types                                   ( uint64 *mask, const char *types );
 void InterpretSEIMessage                                ( byte* payload, int size, VideoParameters *p_Vid, Slice *pSlice );
 void interpret_spare_pic                                ( byte* payload, int size, VideoParameters *p_Vid );
 void interpret_subsequence_info                         ( byte* payload, int size, VideoParameters *p_Vid );
@@ -0,0 +1,719 @@
+
+/*!
+ *************************************************************************************
+ * \file kernel_test.c
+ *
+ * \brief
+ *    Checks the SIMD sample kernels of the decoder against the C reference
+ *
+ *    For every SimdLevel the CPU supports, each entry of the motion compensation,
+ *    inverse transform, deblocking and intra prediction kernel tables is run next
+ *    to its C version on identical random input, at the bit depths the kernel
+ *    serves, and the outputs are compared sample by sample. Source blocks are
+ *    placed at random positions including the edges of exactly sized buffers, so
+ *    that reads beyond the samples the C kernel reads show up under a memory
+ *    checker. Output buffers are prefilled identically and compared in full, which
+ *    also catches writes outside of the block.
+ *
+ *    Usage: ldecod_kernel_test [iterations [seed]]
+ *
+ *************************************************************************************
+ */
+
+#include "global.h"
+#include "memalloc.h"
+#include "mc_prediction.h"
+#include "block.h"
+#include "loop_filter.h"
+#include "intra_pred_common.h"
+#include "cpu_features.h"
+
+#define MAX_REPORTS  20   //!< mismatches printed in full
+
+static unsigned int rnd_state = 1;
+static int          checks    = 0;
+static int          failures  = 0;
+
+/*!
+ ************************************************************************
+ * \brief
+ *    xorshift32 random numbers, reproducible for a given seed
+ ************************************************************************
+ */
+static unsigned int rnd(void)
+{
+  rnd_state ^= rnd_state << 13;
+  rnd_state ^= rnd_state >> 17;
+  rnd_state ^= rnd_state << 5;
+  return rnd_state;
+}
+
+//! random integer in [low, high]
+static int rnd_range(int low, int high)
+{
+  return low + (int) (rnd() % (unsigned int) (high - low + 1));
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Fills n samples with random values up to max. Every fourth buffer
+ *    only holds 0 and max, which drives the filter sums to their extremes.
+ ************************************************************************
+ */
+static void fill_samples(imgpel *buf, int n, int max)
+{
+  int extremes = (rnd() & 3) == 0;
+  int i;
+
+  for (i = 0; i < n; ++i)
+    buf[i] = (imgpel) (extremes ? ((rnd() & 1) ? max : 0) : rnd_range(0, max));
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Counts one comparison of n samples and reports the first mismatch
+ ************************************************************************
+ */
+static void check(const char *kernel, int simd_level, int bitdepth, const char *params, const imgpel *ref, const imgpel *tst, int n)
+{
+  int i;
+
+  ++checks;
+  for (i = 0; i < n; ++i)
+  {
+    if (ref[i] != tst[i])
+    {
+      if (failures < MAX_REPORTS)
+        printf("FAIL %s (SimdLevel %d, %d bit, %s): sample %d is %d, expected %d\n", kernel, simd_level, bitdepth, params, i, tst[i], ref[i]);
+      ++failures;
+      return;
+    }
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Allocates an exactly sized plane of rows x stride samples with
+ *    random content
+ ************************************************************************
+ */
+static imgpel *alloc_plane(int rows, int stride, int max)
+{
+  imgpel *plane = (imgpel *) malloc(rows * stride * sizeof(imgpel));
+
+  if (plane == NULL)
+    no_mem_exit("alloc_plane: plane");
+  fill_samples(plane, rows * stride, max);
+  return plane;
+}
+
+//! random horizontal offset of a block of the given width in a line of stride samples, biased towards both ends
+static int rnd_offset(int stride, int width)
+{
+  switch (rnd() & 3)
+  {
+  case 0:
+    return 0;
+  case 1:
+    return stride - width;
+  default:
+    return rnd_range(0, stride - width);
+  }
+}
+
+//! 16x16 block whose rows are consecutive, as the prediction buffers of a slice
+static imgpel **alloc_block(int max)
+{
+  imgpel **block;
+
+  get_mem2Dpel(&block, MB_BLOCK_SIZE, MB_BLOCK_SIZE);
+  fill_samples(block[0], MB_BLOCK_SIZE * MB_BLOCK_SIZE, max);
+  return block;
+}
+
+static imgpel **copy_block(imgpel **src)
+{
+  imgpel **block;
+
+  get_mem2Dpel(&block, MB_BLOCK_SIZE, MB_BLOCK_SIZE);
+  memcpy(block[0], src[0], MB_BLOCK_SIZE * MB_BLOCK_SIZE * sizeof(imgpel));
+  return block;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Quarter sample luma interpolation at all 15 fractional positions
+ *    and all block sizes. The 6 tap filter reads two samples before
+ *    and three after the block in both directions.
+ ************************************************************************
+ */
+static void test_mc_luma(McKernels *ref, McKernels *tst, int simd_level, int bitdepth)
+{
+  static const int sizes[3] = { 4, 8, 16 };
+  int max = (1 << bitdepth) - 1;
+  int dx, dy, sx, sy;
+  char params[64];
+
+  for (dy = 0; dy < 4; ++dy)
+  {
+    for (dx = 0; dx < 4; ++dx)
+    {
+      if (dx == 0 && dy == 0)
+        continue;
+      for (sy = 0; sy < 3; ++sy)
+      {
+        for (sx = 0; sx < 3; ++sx)
+        {
+          int bsx = sizes[sx], bsy = sizes[sy];
+          int stride = bsx + 5 + ((rnd() & 1) ? 0 : rnd_range(1, 16));
+          imgpel *plane = alloc_plane(bsy + 5, stride, max);
+          imgpel *cur_img = plane + 2 * stride + 2 + rnd_offset(stride - 5, bsx);
+          imgpel **block_ref = alloc_block(max);
+          imgpel **block_tst = copy_block(block_ref);
+          int **tmp_res;
+
+          get_mem2Dint(&tmp_res, MB_BLOCK_SIZE + 5, MB_BLOCK_SIZE + 5);
+          ref->get_luma[dy][dx](block_ref, cur_img, stride, tmp_res, bsy, bsx, max);
+          tst->get_luma[dy][dx](block_tst, cur_img, stride, tmp_res, bsy, bsx, max);
+
+          snprintf(params, sizeof(params), "%dx%d, position (%d,%d)", bsx, bsy, dx, dy);
+          check("get_luma", simd_level, bitdepth, params, block_ref[0], block_tst[0], MB_BLOCK_SIZE * MB_BLOCK_SIZE);
+
+          free_mem2Dint(tmp_res);
+          free_mem2Dpel(block_tst);
+          free_mem2Dpel(block_ref);
+          free(plane);
+        }
+      }
+    }
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Bilinear chroma interpolation for the 4:2:0 and 4:2:2 eighth
+ *    sample positions, weights set up as in get_block_chroma()
+ ************************************************************************
+ */
+static void test_mc_chroma(McKernels *ref, McKernels *tst, int simd_level, int bitdepth)
+{
+  static const int sizes_x[3] = { 2, 4, 8 };
+  static const int sizes_y[4] = { 2, 4, 8, 16 };
+  int max = (1 << bitdepth) - 1;
+  int yuv_format, sx, sy;
+  char params[64];
+
+  for (yuv_format = YUV420; yuv_format <= YUV422; ++yuv_format)
+  {
+    int subpel_x = 7;
+    int subpel_y = (yuv_format == YUV420) ? 7 : 3;
+    int total_scale = (yuv_format == YUV420) ? 6 : 5;
+
+    for (sy = 0; sy < 4; ++sy)
+    {
+      for (sx = 0; sx < 3; ++sx)
+      {
+        int bsx = sizes_x[sx], bsy = sizes_y[sy];
+        int dx = rnd_range(0, subpel_x);
+        int dy = rnd_range((dx == 0) ? 1 : 0, subpel_y);
+        int dxcur = subpel_x + 1 - dx;
+        int dycur = subpel_y + 1 - dy;
+        int stride = bsx + 1 + ((rnd() & 1) ? 0 : rnd_range(1, 16));
+        imgpel *plane = alloc_plane(bsy + 1, stride, max);
+        imgpel *cur_img = plane + rnd_offset(stride - 1, bsx);
+        imgpel **block_ref = alloc_block(max);
+        imgpel **block_tst = copy_block(block_ref);
+        const char *kernel;
+
+        if (dx == 0)
+        {
+          kernel = "get_chroma_0X";
+          ref->get_chroma_0X(block_ref[0], cur_img, stride, bsy, bsx, dxcur * dycur, dxcur * dy, total_scale);
+          tst->get_chroma_0X(block_tst[0], cur_img, stride, bsy, bsx, dxcur * dycur, dxcur * dy, total_scale);
+        }
+        else if (dy == 0)
+        {
+          kernel = "get_chroma_X0";
+          ref->get_chroma_X0(block_ref[0], cur_img, stride, bsy, bsx, dxcur * dycur, dx * dycur, total_scale);
+          tst->get_chroma_X0(block_tst[0], cur_img, stride, bsy, bsx, dxcur * dycur, dx * dycur, total_scale);
+        }
+        else
+        {
+          kernel = "get_chroma_XY";
+          ref->get_chroma_XY(block_ref[0], cur_img, stride, bsy, bsx, dxcur * dycur, dxcur * dy, dx * dycur, dx * dy, total_scale);
+          tst->get_chroma_XY(block_tst[0], cur_img, stride, bsy, bsx, dxcur * dycur, dxcur * dy, dx * dycur, dx * dy, total_scale);
+        }
+
+        snprintf(params, sizeof(params), "%dx%d, position (%d,%d)", bsx, bsy, dx, dy);
+        check(kernel, simd_level, bitdepth, params, block_ref[0], block_tst[0], MB_BLOCK_SIZE * MB_BLOCK_SIZE);
+
+        free_mem2Dpel(block_tst);
+        free_mem2Dpel(block_ref);
+        free(plane);
+      }
+    }
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Weighted, averaged and weighted bi-predicted blocks of all luma
+ *    and chroma partition sizes at the offsets they take in a
+ *    macroblock, with weights in the range the standard allows
+ ************************************************************************
+ */
+static void test_mc_pred(McKernels *ref, McKernels *tst, int simd_level, int bitdepth)
+{
+  static const int sizes[4] = { 2, 4, 8, 16 };
+  int max = (1 << bitdepth) - 1;
+  int sx, sy;
+  char params[96];
+
+  for (sy = 0; sy < 4; ++sy)
+  {
+    for (sx = 0; sx < 4; ++sx)
+    {
+      int bsx = sizes[sx], bsy = sizes[sy];
+      int step_x = imin(bsx, 4), step_y = imin(bsy, 4);
+      int ioff = step_x * rnd_range(0, (MB_BLOCK_SIZE - bsx) / step_x);
+      int joff = step_y * rnd_range(0, (MB_BLOCK_SIZE - bsy) / step_y);
+      int log_wd = rnd_range(0, 7);
+      int w0 = rnd_range(-128, 127);
+      int w1 = iClip3(-128, 127, rnd_range(-128, (log_wd == 7) ? 127 : 128) - w0);
+      int o0 = rnd_range(-128, 127) << (bitdepth - 8);
+      int o1 = rnd_range(-128, 127) << (bitdepth - 8);
+      imgpel **block_l0 = alloc_block(max);
+      imgpel **block_l1 = alloc_block(max);
+      imgpel **pred_ref = alloc_block(max);
+      imgpel **pred_tst = copy_block(pred_ref);
+
+      snprintf(params, sizeof(params), "%dx%d at (%d,%d), weights %d/%d, offset %d, denominator %d", bsx, bsy, ioff, joff, w0, w1, o0, log_wd);
+
+      ref->weighted_mc_prediction(&pred_ref[joff], block_l0, bsy, bsx, ioff, w0, o0, log_wd, max);
+      tst->weighted_mc_prediction(&pred_tst[joff], block_l0, bsy, bsx, ioff, w0, o0, log_wd, max);
+      check("weighted_mc_prediction", simd_level, bitdepth, params, pred_ref[0], pred_tst[0], MB_BLOCK_SIZE * MB_BLOCK_SIZE);
+
+      ref->bi_prediction(&pred_ref[joff], block_l0, block_l1, bsy, bsx, ioff);
+      tst->bi_prediction(&pred_tst[joff], block_l0, block_l1, bsy, bsx, ioff);
+      check("bi_prediction", simd_level, bitdepth, params, pred_ref[0], pred_tst[0], MB_BLOCK_SIZE * MB_BLOCK_SIZE);
+
+      ref->weighted_bi_prediction(&pred_ref[joff][ioff], block_l0[0], block_l1[0], bsy, bsx, w0, w1, (o0 + o1 + 1) >> 1, log_wd + 1, max);
+      tst->weighted_bi_prediction(&pred_tst[joff][ioff], block_l0[0], block_l1[0], bsy, bsx, w0, w1, (o0 + o1 + 1) >> 1, log_wd + 1, max);
+      check("weighted_bi_prediction", simd_level, bitdepth, params, pred_ref[0], pred_tst[0], MB_BLOCK_SIZE * MB_BLOCK_SIZE);
+
+      free_mem2Dpel(pred_tst);
+      free_mem2Dpel(pred_ref);
+      free_mem2Dpel(block_l1);
+      free_mem2Dpel(block_l0);
+    }
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Fills an n x n block of dequantized coefficients: all zero, DC
+ *    only, sparse or dense
+ ************************************************************************
+ */
+static void fill_coefficients(int **cof, int pos_y, int pos_x, int n, int bitdepth)
+{
+  int range = 1 << (bitdepth + 6);
+  int mode = rnd() & 3;
+  int i, j;
+
+  for (j = pos_y; j < pos_y + n; ++j)
+  {
+    for (i = pos_x; i < pos_x + n; ++i)
+    {
+      int dc = (j == pos_y && i == pos_x);
+
+      if (mode == 0 || (mode == 1 && !dc) || (mode == 2 && !dc && (rnd() & 3) != 0))
+        cof[j][i] = 0;
+      else
+        cof[j][i] = rnd_range(-range, range);
+    }
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Fused 4x4 and 8x8 inverse transform, prediction add and clipping
+ *    for every block position of a macroblock
+ ************************************************************************
+ */
+static void test_itrans(ITransKernels *ref, ITransKernels *tst, int simd_level, int bitdepth)
+{
+  int max = (1 << bitdepth) - 1;
+  int n;
+  char params[64];
+
+  for (n = BLOCK_SIZE; n <= BLOCK_SIZE_8x8; n <<= 1)
+  {
+    int pos_y = n * rnd_range(0, MB_BLOCK_SIZE / n - 1);
+    int pos_x = n * rnd_range(0, MB_BLOCK_SIZE / n - 1);
+    imgpel **pred = alloc_block(max);
+    imgpel **rec_ref = alloc_block(max);
+    imgpel **rec_tst = copy_block(rec_ref);
+    int **cof_ref, **cof_tst;
+
+    get_mem2Dint(&cof_ref, MB_BLOCK_SIZE, MB_BLOCK_SIZE);
+    get_mem2Dint(&cof_tst, MB_BLOCK_SIZE, MB_BLOCK_SIZE);
+    fill_coefficients(cof_ref, pos_y, pos_x, n, bitdepth);
+    memcpy(cof_tst[0], cof_ref[0], MB_BLOCK_SIZE * MB_BLOCK_SIZE * sizeof(int));
+
+    snprintf(params, sizeof(params), "block at (%d,%d)", pos_x, pos_y);
+    if (n == BLOCK_SIZE)
+    {
+      ref->itrans_add_4x4(rec_ref, pred, cof_ref, pos_y, pos_x, max);
+      tst->itrans_add_4x4(rec_tst, pred, cof_tst, pos_y, pos_x, max);
+      check("itrans_add_4x4", simd_level, bitdepth, params, rec_ref[0], rec_tst[0], MB_BLOCK_SIZE * MB_BLOCK_SIZE);
+    }
+    else
+    {
+      ref->itrans_add_8x8(rec_ref, pred, cof_ref, pos_y, pos_x, max);
+      tst->itrans_add_8x8(rec_tst, pred, cof_tst, pos_y, pos_x, max);
+      check("itrans_add_8x8", simd_level, bitdepth, params, rec_ref[0], rec_tst[0], MB_BLOCK_SIZE * MB_BLOCK_SIZE);
+    }
+
+    free_mem2Dint(cof_tst);
+    free_mem2Dint(cof_ref);
+    free_mem2Dpel(rec_tst);
+    free_mem2Dpel(rec_ref);
+    free_mem2Dpel(pred);
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Fills the lines across an edge with a smooth ramp plus noise and
+ *    a step at the edge, both sized relative to alpha and beta so that
+ *    every filter decision is taken both ways
+ ************************************************************************
+ */
+static void fill_edge_line(imgpel *p, int inc, int len, int edge, int alpha, int beta, int max)
+{
+  int base = rnd_range(0, max);
+  int slope = rnd_range(-2, 2);
+  int step = rnd_range(-(alpha + alpha / 2) - 1, alpha + alpha / 2 + 1);
+  int noise = imax(beta, 1);
+  int i;
+
+  if ((rnd() & 7) == 0)
+  {
+    for (i = 0; i < len; ++i)
+      p[i * inc] = (imgpel) ((rnd() & 1) ? max : 0);
+    return;
+  }
+  for (i = 0; i < len; ++i)
+  {
+    int v = base + slope * i + rnd_range(-noise, noise) + ((i >= edge) ? step : 0);
+    p[i * inc] = (imgpel) iClip3(0, max, v);
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Luma and chroma edge filters on vertical and horizontal edges with
+ *    random bS, alpha and beta. The luma filters read and write four
+ *    samples on each side of the edge, the chroma filters two.
+ ************************************************************************
+ */
+static void test_deblock_edges(DeblockKernels *ref, DeblockKernels *tst, int simd_level, int bitdepth)
+{
+  int max = (1 << bitdepth) - 1;
+  int bitdepth_scale = 1 << (bitdepth - 8);
+  int indexA = rnd_range(0, MAX_QP);
+  int indexB = rnd_range(0, MAX_QP);
+  int Alpha = ALPHA_TABLE[indexA] * bitdepth_scale;
+  int Beta  = BETA_TABLE [indexB] * bitdepth_scale;
+  const byte *ClipTab = CLIP_TAB[indexA];
+  byte Strength[MB_BLOCK_SIZE];
+  int dir, chroma, i;
+  char params[64];
+
+  for (i = 0; i < MB_BLOCK_SIZE; ++i)
+    Strength[i] = (byte) rnd_range(0, 4);
+
+  for (chroma = 0; chroma <= 1; ++chroma)
+  {
+    for (dir = 0; dir <= 1; ++dir)
+    {
+      int side   = chroma ? 2 : 4;                                     // samples on each side of the edge
+      int PelNum = chroma ? ((rnd() & 1) ? 8 : 16) : MB_BLOCK_SIZE;    // lines along the edge
+      int across = 2 * side;
+      int stride = (dir ? PelNum : across) + ((rnd() & 1) ? 0 : rnd_range(1, 16));
+      int rows   = dir ? across : PelNum;
+      imgpel *buf_ref = alloc_plane(rows, stride, max);
+      imgpel *buf_tst = (imgpel *) malloc(rows * stride * sizeof(imgpel));
+      imgpel *imgP_ref, *imgP_tst;
+      int offset;
+      const char *kernel;
+
+      if (buf_tst == NULL)
+        no_mem_exit("test_deblock_edges: buf_tst");
+
+      if (dir == 0)
+      {
+        offset = rnd_offset(stride, across);
+        for (i = 0; i < PelNum; ++i)
+          fill_edge_line(buf_ref + i * stride + offset, 1, across, side, Alpha, Beta, max);
+        offset += side - 1;
+      }
+      else
+      {
+        offset = rnd_offset(stride, PelNum);
+        for (i = 0; i < PelNum; ++i)
+          fill_edge_line(buf_ref + offset + i, stride, across, side, Alpha, Beta, max);
+        offset += (side - 1) * stride;
+      }
+      memcpy(buf_tst, buf_ref, rows * stride * sizeof(imgpel));
+      imgP_ref = buf_ref + offset;
+      imgP_tst = buf_tst + offset;
+
+      if (!chroma && !dir)
+      {
+        kernel = "luma_ver";
+        ref->luma_ver(imgP_ref, stride, Strength, Alpha, Beta, ClipTab, bitdepth_scale, max);
+        tst->luma_ver(imgP_tst, stride, Strength, Alpha, Beta, ClipTab, bitdepth_scale, max);
+      }
+      else if (!chroma)
+      {
+        kernel = "luma_hor";
+        ref->luma_hor(imgP_ref, stride, Strength, Alpha, Beta, ClipTab, bitdepth_scale, max);
+        tst->luma_hor(imgP_tst, stride, Strength, Alpha, Beta, ClipTab, bitdepth_scale, max);
+      }
+      else if (!dir)
+      {
+        kernel = "chroma_ver";
+        ref->chroma_ver(imgP_ref, stride, PelNum, Strength, Alpha, Beta, ClipTab, bitdepth_scale, max);
+        tst->chroma_ver(imgP_tst, stride, PelNum, Strength, Alpha, Beta, ClipTab, bitdepth_scale, max);
+      }
+      else
+      {
+        kernel = "chroma_hor";
+        ref->chroma_hor(imgP_ref, stride, PelNum, Strength, Alpha, Beta, ClipTab, bitdepth_scale, max);
+        tst->chroma_hor(imgP_tst, stride, PelNum, Strength, Alpha, Beta, ClipTab, bitdepth_scale, max);
+      }
+
+      snprintf(params, sizeof(params), "%d lines, bS %d%d%d%d, indexA %d, indexB %d", PelNum, Strength[0], Strength[1], Strength[2], Strength[3], indexA, indexB);
+      check(kernel, simd_level, bitdepth, params, buf_ref, buf_tst, rows * stride);
+
+      free(buf_tst);
+      free(buf_ref);
+    }
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Motion vector comparison of the four block pairs of an edge, with
+ *    component differences around the frame and field limits
+ ************************************************************************
+ */
+static void test_deblock_mvs(DeblockKernels *ref, DeblockKernels *tst, int simd_level)
+{
+  PicMotionParams mv_p[BLOCK_SIZE], mv_q[BLOCK_SIZE];
+  PicMotionParams *p[BLOCK_SIZE], *q[BLOCK_SIZE];
+  int mvlimit = (rnd() & 1) ? 4 : 2;
+  int straight_ref, cross_ref, straight_tst, cross_tst;
+  int i, list;
+
+  memset(mv_p, 0, sizeof(mv_p));
+  memset(mv_q, 0, sizeof(mv_q));
+  for (i = 0; i < BLOCK_SIZE; ++i)
+  {
+    for (list = LIST_0; list <= LIST_1; ++list)
+    {
+      mv_p[i].mv[list].mv_x = (short) rnd_range(-2048, 2047);
+      mv_p[i].mv[list].mv_y = (short) rnd_range(-512, 511);
+    }
+    for (list = LIST_0; list <= LIST_1; ++list)
+    {
+      int other = (rnd() & 1) ? list : 1 - list;
+
+      mv_q[i].mv[list].mv_x = (short) (mv_p[i].mv[other].mv_x + rnd_range(-5, 5));
+      mv_q[i].mv[list].mv_y = (short) (mv_p[i].mv[other].mv_y + rnd_range(-5, 5));
+    }
+    p[i] = &mv_p[i];
+    q[i] = &mv_q[i];
+  }
+
+  ref->mv_compare4(p, q, mvlimit, &straight_ref, &cross_ref);
+  tst->mv_compare4(p, q, mvlimit, &straight_tst, &cross_tst);
+
+  ++checks;
+  if (straight_ref != straight_tst || cross_ref != cross_tst)
+  {
+    if (failures < MAX_REPORTS)
+      printf("FAIL mv_compare4 (SimdLevel %d, mvlimit %d): straight %x cross %x, expected %x %x\n",
+             simd_level, mvlimit, straight_tst, cross_tst, straight_ref, cross_ref);
+    ++failures;
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Directional 4x4 and 8x8 prediction from a random neighbour vector
+ *    at every block position of a macroblock, and the 8x8 reference
+ *    sample filter for all neighbour availabilities
+ ************************************************************************
+ */
+static void test_intra_blocks(IntraKernels *ref, IntraKernels *tst, int simd_level, int bitdepth)
+{
+  int max = (1 << bitdepth) - 1;
+  imgpel nb[NB_SIZE], nb_ref[NB_SIZE], nb_tst[NB_SIZE];
+  int n, mode, avail;
+  char params[64];
+
+  for (n = BLOCK_SIZE; n <= BLOCK_SIZE_8x8; n <<= 1)
+  {
+    for (mode = 0; mode < 9; ++mode)
+    {
+      int ioff = n * rnd_range(0, MB_BLOCK_SIZE / n - 1);
+      int joff = n * rnd_range(0, MB_BLOCK_SIZE / n - 1);
+      imgpel **pred_ref = alloc_block(max);
+      imgpel **pred_tst = copy_block(pred_ref);
+
+      fill_samples(nb, NB_SIZE, max);
+      if (n == BLOCK_SIZE)
+      {
+        ref->pred_4x4[mode](pred_ref, ioff, joff, nb);
+        tst->pred_4x4[mode](pred_tst, ioff, joff, nb);
+      }
+      else
+      {
+        ref->pred_8x8[mode](pred_ref, ioff, joff, nb);
+        tst->pred_8x8[mode](pred_tst, ioff, joff, nb);
+      }
+
+      snprintf(params, sizeof(params), "%s, block at (%d,%d)", intra_block_mode_name[mode], ioff, joff);
+      check((n == BLOCK_SIZE) ? "pred_4x4" : "pred_8x8", simd_level, bitdepth, params, pred_ref[0], pred_tst[0], MB_BLOCK_SIZE * MB_BLOCK_SIZE);
+
+      free_mem2Dpel(pred_tst);
+      free_mem2Dpel(pred_ref);
+    }
+  }
+
+  for (avail = 0; avail < 8; ++avail)
+  {
+    int block_up_left = avail & 1, block_up = (avail >> 1) & 1, block_left = (avail >> 2) & 1;
+
+    fill_samples(nb_ref, NB_SIZE, max);
+    memcpy(nb_tst, nb_ref, sizeof(nb_ref));
+    ref->lowpass_8x8(nb_ref, block_up_left, block_up, block_left);
+    tst->lowpass_8x8(nb_tst, block_up_left, block_up, block_left);
+
+    snprintf(params, sizeof(params), "available up left %d, up %d, left %d", block_up_left, block_up, block_left);
+    check("lowpass_8x8", simd_level, bitdepth, params, nb_ref, nb_tst, NB_USED(BLOCK_SIZE_8x8));
+  }
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Plane prediction of 16x16 luma and 8x8 and 8x16 chroma blocks,
+ *    parameters derived from random neighbours as the decoder does
+ ************************************************************************
+ */
+static void test_intra_plane(IntraKernels *ref, IntraKernels *tst, int simd_level, int bitdepth)
+{
+  static const int sizes[3][2] = { { 16, 16 }, { 8, 8 }, { 8, 16 } };
+  int max = (1 << bitdepth) - 1;
+  int s, i;
+  char params[64];
+
+  for (s = 0; s < 3; ++s)
+  {
+    int width = sizes[s][0], height = sizes[s][1];
+    imgpel edge[2 * MB_BLOCK_SIZE + 1];    // above left corner, above row, left column
+    imgpel *top = edge + 1, *left = edge + 1 + MB_BLOCK_SIZE;
+    int ih = 0, iv = 0, ib, ic, iaa;
+    imgpel **pred_ref = alloc_block(max);
+    imgpel **pred_tst = copy_block(pred_ref);
+
+    fill_samples(edge, 2 * MB_BLOCK_SIZE + 1, max);
+    for (i = 1; i <= width / 2; ++i)
+      ih += i * (top[width / 2 - 1 + i] - top[width / 2 - 1 - i]);
+    for (i = 1; i <= height / 2; ++i)
+      iv += i * (left[height / 2 - 1 + i] - left[height / 2 - 1 - i]);
+    ib  = ((width  == 8 ? 17 : 5) * ih + 2 * width ) >> (width  == 8 ? 5 : 6);
+    ic  = ((height == 8 ? 17 : 5) * iv + 2 * height) >> (height == 8 ? 5 : 6);
+    iaa = 16 * (top[width - 1] + left[height - 1]);
+
+    ref->plane(pred_ref, width, height, iaa, ib, ic, max);
+    tst->plane(pred_tst, width, height, iaa, ib, ic, max);
+
+    snprintf(params, sizeof(params), "%dx%d, iaa %d, ib %d, ic %d", width, height, iaa, ib, ic);
+    check("plane", simd_level, bitdepth, params, pred_ref[0], pred_tst[0], MB_BLOCK_SIZE * MB_BLOCK_SIZE);
+
+    free_mem2Dpel(pred_tst);
+    free_mem2Dpel(pred_ref);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  int iterations = (argc > 1) ? atoi(argv[1]) : 200;
+  int max_level  = get_cpu_simd_level();
+  int max_bitdepth = (IMGTYPE == 0) ? 8 : 14;
+  int simd_level, it, bitdepth;
+
+  rnd_state = (argc > 2) ? (unsigned int) strtoul(argv[2], NULL, 0) : 0x2545F491;
+  if (rnd_state == 0)
+    rnd_state = 1;
+
+  printf("Checking the kernels of SimdLevel 1 to %d against C, %d iterations\n", max_level, iterations);
+
+  for (simd_level = SIMD_SSE41; simd_level <= max_level; ++simd_level)
+  {
+    McKernels      mc_ref, mc_tst, mc_tst_8bit;
+    ITransKernels  itrans_ref, itrans_tst;
+    DeblockKernels db_ref, db_tst;
+    IntraKernels   intra_ref, intra_tst;
+
+    // the SIMD initializers keep the kernels they replace, so each level is set up right before its run
+    set_mc_kernels     (&mc_ref,      SIMD_NONE,  0);
+    set_mc_kernels     (&mc_tst,      simd_level, 0);
+    set_mc_kernels     (&mc_tst_8bit, simd_level, 1);
+    set_itrans_kernels (&itrans_ref,  SIMD_NONE);
+    set_itrans_kernels (&itrans_tst,  simd_level);
+    set_deblock_kernels(&db_ref,      SIMD_NONE);
+    set_deblock_kernels(&db_tst,      simd_level);
+    set_intra_kernels  (&intra_ref,   SIMD_NONE);
+    set_intra_kernels  (&intra_tst,   simd_level);
+
+    for (it = 0; it < iterations; ++it)
+    {
+      test_mc_luma  (&mc_ref,      &mc_tst_8bit, simd_level, 8);
+      test_mc_chroma(&mc_ref,      &mc_tst_8bit, simd_level, 8);
+      test_mc_pred  (&mc_ref,      &mc_tst_8bit, simd_level, 8);
+
+      for (bitdepth = 8; bitdepth <= max_bitdepth; ++bitdepth)
+      {
+        test_mc_luma      (&mc_ref,     &mc_tst,     simd_level, bitdepth);
+        test_mc_chroma    (&mc_ref,     &mc_tst,     simd_level, bitdepth);
+        test_mc_pred      (&mc_ref,     &mc_tst,     simd_level, bitdepth);
+        test_itrans       (&itrans_ref, &itrans_tst, simd_level, bitdepth);
+        test_deblock_edges(&db_ref,     &db_tst,     simd_level, bitdepth);
+        test_intra_blocks (&intra_ref,  &intra_tst,  simd_level, bitdepth);
+        test_intra_plane  (&intra_ref,  &intra_tst,  simd_level, bitdepth);
+      }
+      test_deblock_mvs(&db_ref, &db_tst, simd_level);
+    }
+  }
+
+  printf("%d checks, %d failed\n", checks, failures);
+  return (failures != 0);
+}
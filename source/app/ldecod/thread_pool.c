@@ -0,0 +1,235 @@
+
+/*!
+ *************************************************************************************
+ * \file thread_pool.c
+ *
+ * \brief
+ *    Fixed size pool of worker threads running batches of independent jobs
+ *
+ *    run_thread_jobs() hands out the job indices of one batch to the workers and
+ *    the calling thread on a first come basis and returns when all of them are
+ *    finished, so that the caller sees every result of the batch afterwards.
+ *    Jobs that depend on each other inside a batch synchronize through
+ *    ThreadProgress counters.
+ *
+ *************************************************************************************
+ */
+
+#include "global.h"
+#include "memalloc.h"
+#include "thread_pool.h"
+
+struct thread_pool
+{
+  Thread         *threads;
+  int             num_workers;    //!< threads besides the caller of run_thread_jobs()
+  Mutex           lock;
+  CondVar         batch_ready;    //!< signalled when a batch is started or the pool shuts down
+  CondVar         batch_done;     //!< signalled when the last job of a batch is finished
+  ThreadJobFunc   func;
+  void           *arg;
+  int             num_jobs;
+  int             next_job;       //!< next job index to hand out
+  int             pending;        //!< jobs of the batch not finished yet
+  unsigned        batch;          //!< number of batches started
+  int             shutdown;
+};
+
+/*!
+ ************************************************************************
+ * \brief
+ *    runs jobs of the current batch until none is left. Called with
+ *    pool->lock held, returns with it held.
+ ************************************************************************
+ */
+static void run_pending_jobs(ThreadPool *pool)
+{
+  while (pool->next_job < pool->num_jobs)
+  {
+    ThreadJobFunc func = pool->func;
+    void *arg = pool->arg;
+    int job = pool->next_job++;
+
+    unlock_mutex(&pool->lock);
+    func(arg, job);
+    lock_mutex(&pool->lock);
+
+    if (--pool->pending == 0)
+      signal_cond(&pool->batch_done);
+  }
+}
+
+static void worker_main(void *param)
+{
+  ThreadPool *pool = (ThreadPool *) param;
+  unsigned batch = 0;
+
+  lock_mutex(&pool->lock);
+  for (;;)
+  {
+    while (!pool->shutdown && pool->batch == batch)
+      wait_cond(&pool->batch_ready, &pool->lock);
+    if (pool->shutdown)
+      break;
+    batch = pool->batch;
+    run_pending_jobs(pool);
+  }
+  unlock_mutex(&pool->lock);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    creates a pool that runs jobs on num_threads threads, the thread
+ *    calling run_thread_jobs() included
+ ************************************************************************
+ */
+ThreadPool *create_thread_pool(int num_threads)
+{
+  ThreadPool *pool = (ThreadPool *) calloc(1, sizeof(ThreadPool));
+  int i;
+
+  if (pool == NULL)
+    no_mem_exit("create_thread_pool: pool");
+
+  init_mutex(&pool->lock);
+  init_cond(&pool->batch_ready);
+  init_cond(&pool->batch_done);
+
+  if (num_threads > 1)
+  {
+    if ((pool->threads = (Thread *) calloc(num_threads - 1, sizeof(Thread))) == NULL)
+      no_mem_exit("create_thread_pool: threads");
+
+    for (i = 0; i < num_threads - 1; ++i)
+    {
+      if (create_thread(&pool->threads[i], worker_main, pool) != 0)
+        break;
+    }
+    pool->num_workers = i;
+  }
+
+  return pool;
+}
+
+void free_thread_pool(ThreadPool *pool)
+{
+  int i;
+
+  if (pool == NULL)
+    return;
+
+  lock_mutex(&pool->lock);
+  pool->shutdown = 1;
+  broadcast_cond(&pool->batch_ready);
+  unlock_mutex(&pool->lock);
+
+  for (i = 0; i < pool->num_workers; ++i)
+    join_thread(pool->threads[i]);
+
+  free_cond(&pool->batch_done);
+  free_cond(&pool->batch_ready);
+  free_mutex(&pool->lock);
+  free(pool->threads);
+  free(pool);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    returns the number of threads jobs are run on
+ ************************************************************************
+ */
+int thread_pool_size(ThreadPool *pool)
+{
+  return pool ? pool->num_workers + 1 : 1;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    calls func(arg, job) for job = 0 .. num_jobs - 1 in parallel and
+ *    waits until all calls have returned
+ ************************************************************************
+ */
+void run_thread_jobs(ThreadPool *pool, ThreadJobFunc func, void *arg, int num_jobs)
+{
+  int job;
+
+  if (pool == NULL || pool->num_workers == 0 || num_jobs < 2)
+  {
+    for (job = 0; job < num_jobs; ++job)
+      func(arg, job);
+    return;
+  }
+
+  lock_mutex(&pool->lock);
+  pool->func     = func;
+  pool->arg      = arg;
+  pool->num_jobs = num_jobs;
+  pool->next_job = 0;
+  pool->pending  = num_jobs;
+  ++pool->batch;
+  broadcast_cond(&pool->batch_ready);
+
+  run_pending_jobs(pool);
+  while (pool->pending > 0)
+    wait_cond(&pool->batch_done, &pool->lock);
+  unlock_mutex(&pool->lock);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    initializes a progress counter
+ ************************************************************************
+ */
+void init_thread_progress(ThreadProgress *progress, int value)
+{
+  init_mutex(&progress->lock);
+  init_cond(&progress->changed);
+  progress->value = value;
+}
+
+void free_thread_progress(ThreadProgress *progress)
+{
+  free_cond(&progress->changed);
+  free_mutex(&progress->lock);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    stores a new counter value and wakes up the jobs waiting on it.
+ *    Everything the caller wrote before is visible to a job that sees
+ *    the value in wait_thread_progress().
+ ************************************************************************
+ */
+void set_thread_progress(ThreadProgress *progress, int value)
+{
+  lock_mutex(&progress->lock);
+  atomic_store_int(&progress->value, value);
+  broadcast_cond(&progress->changed);
+  unlock_mutex(&progress->lock);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    waits until the counter has reached at least value and returns
+ *    the counter value seen
+ ************************************************************************
+ */
+int wait_thread_progress(ThreadProgress *progress, int value)
+{
+  int current = atomic_load_int(&progress->value);
+
+  if (current < value)
+  {
+    lock_mutex(&progress->lock);
+    while ((current = progress->value) < value)
+      wait_cond(&progress->changed, &progress->lock);
+    unlock_mutex(&progress->lock);
+  }
+  return current;
+}
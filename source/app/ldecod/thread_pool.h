@@ -0,0 +1,41 @@
+
+/*!
+ *************************************************************************************
+ * \file thread_pool.h
+ *
+ * \brief
+ *    Fixed size pool of worker threads running batches of independent jobs
+ *    and progress counters jobs of a batch can wait on
+ *
+ *************************************************************************************
+ */
+
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+#include "threading.h"
+
+//! Job callback, called once for every job index of a batch
+typedef void (*ThreadJobFunc)(void *arg, int job);
+
+typedef struct thread_pool ThreadPool;
+
+extern ThreadPool *create_thread_pool(int num_threads);
+extern void        free_thread_pool  (ThreadPool *pool);
+extern int         thread_pool_size  (ThreadPool *pool);
+extern void        run_thread_jobs   (ThreadPool *pool, ThreadJobFunc func, void *arg, int num_jobs);
+
+//! Counter one job advances and other jobs wait on
+typedef struct thread_progress
+{
+  Mutex           lock;
+  CondVar         changed;
+  int             value;
+} ThreadProgress;
+
+extern void init_thread_progress(ThreadProgress *progress, int value);
+extern void free_thread_progress(ThreadProgress *progress);
+extern void set_thread_progress (ThreadProgress *progress, int value);
+extern int  wait_thread_progress(ThreadProgress *progress, int value);
+
+#endif
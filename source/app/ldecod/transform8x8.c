@@ -22,33 +22,10 @@
 #include "mb_access.h"
 #include "elements.h"
 #include "transform8x8.h"
+#include "block.h"
 #include "transform.h"
 #include "quant.h"
 
-static void recon8x8(int **m7, imgpel **mb_rec, imgpel **mpr, int max_imgpel_value, int ioff)
-{
-  int j;
-  int    *m_tr  = NULL;
-  imgpel *m_rec = NULL;
-  imgpel *m_prd = NULL;
-
-  for( j = 0; j < 8; j++)
-  {
-    m_tr = (*m7++) + ioff;
-    m_rec = (*mb_rec++) + ioff;
-    m_prd = (*mpr++) + ioff;
-
-    *m_rec++ = (imgpel) iClip1(max_imgpel_value, (*m_prd++) + rshift_rnd_sf(*m_tr++, DQ_BITS_8)); 
-    *m_rec++ = (imgpel) iClip1(max_imgpel_value, (*m_prd++) + rshift_rnd_sf(*m_tr++, DQ_BITS_8)); 
-    *m_rec++ = (imgpel) iClip1(max_imgpel_value, (*m_prd++) + rshift_rnd_sf(*m_tr++, DQ_BITS_8)); 
-    *m_rec++ = (imgpel) iClip1(max_imgpel_value, (*m_prd++) + rshift_rnd_sf(*m_tr++, DQ_BITS_8)); 
-    *m_rec++ = (imgpel) iClip1(max_imgpel_value, (*m_prd++) + rshift_rnd_sf(*m_tr++, DQ_BITS_8)); 
-    *m_rec++ = (imgpel) iClip1(max_imgpel_value, (*m_prd++) + rshift_rnd_sf(*m_tr++, DQ_BITS_8)); 
-    *m_rec++ = (imgpel) iClip1(max_imgpel_value, (*m_prd++) + rshift_rnd_sf(*m_tr++, DQ_BITS_8)); 
-    *m_rec   = (imgpel) iClip1(max_imgpel_value, (*m_prd  ) + rshift_rnd_sf(*m_tr  , DQ_BITS_8)); 
-  }
-}
-
 static void copy8x8(imgpel **mb_rec, imgpel **mpr, int ioff)
 {
   int j;
@@ -93,8 +70,7 @@ void itrans8x8(Macroblock *currMB,   //!< current macroblock
   }
   else
   {
-    inverse8x8(&m7[joff], &m7[joff], ioff);
-    recon8x8  (&m7[joff], &currSlice->mb_rec[pl][joff], &currSlice->mb_pred[pl][joff], currMB->p_Vid->max_pel_value_comp[pl], ioff);
+    itrans_kernels.itrans_add_8x8(currSlice->mb_rec[pl], currSlice->mb_pred[pl], m7, joff, ioff, currMB->p_Vid->max_pel_value_comp[pl]);
   }
 }
 
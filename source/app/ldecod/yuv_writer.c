@@ -0,0 +1,359 @@
+
+/*!
+ *************************************************************************************
+ * \file yuv_writer.c
+ *
+ * \brief
+ *    Writing of the output YUV files on a separate thread
+ *
+ *    write_out_picture() converts a picture into one of a few recycled
+ *    buffers and queues it. The writer thread writes every buffer with a
+ *    single large write() in the order they were queued, so the decoder
+ *    only waits when all buffers are in flight.
+ *
+ *    With OutputDirect the files are written with O_DIRECT where the file
+ *    system supports it. Such writes need aligned buffers, lengths and
+ *    file offsets, so the data of a file is collected in chunks of
+ *    DIRECT_CHUNK bytes and the rest is written without O_DIRECT when the
+ *    file is flushed.
+ *
+ *************************************************************************************
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE     // O_DIRECT
+#endif
+
+#include <errno.h>
+
+#include "global.h"
+#include "memalloc.h"
+#include "threading.h"
+#include "yuv_writer.h"
+
+#define YUV_ALIGNMENT     4096        //!< alignment of the buffers, and of the file offsets and lengths of O_DIRECT writes
+#define DIRECT_CHUNK      (1 << 20)   //!< bytes of one O_DIRECT write
+#define MAX_DIRECT_FILES  4           //!< files written with O_DIRECT at the same time
+
+typedef struct yuv_buffer
+{
+  unsigned char *data;
+  size_t         capacity;
+  size_t         size;             //!< bytes to write
+  int            fd;               //!< file to write to
+} YuvBuffer;
+
+//! file written with O_DIRECT
+typedef struct direct_file
+{
+  int            fd;               //!< -1 for an unused entry
+  unsigned char *chunk;
+  size_t         fill;             //!< bytes in chunk not written yet
+} DirectFile;
+
+struct yuv_writer
+{
+  Thread          thread;
+  Mutex           lock;
+  CondVar         changed;         //!< signalled when a buffer is queued or written, or on shutdown
+  int             shutdown;
+
+  YuvBuffer      *buffers;         //!< ring of buffers, the one after the queued ones is filled by the decoder
+  int             num_buffers;
+  int             head;            //!< next buffer to write
+  int             queued;          //!< buffers queued and not written yet
+
+  int             direct;          //!< try O_DIRECT on the files written
+  DirectFile      files[MAX_DIRECT_FILES];
+};
+
+static unsigned char *alloc_aligned(size_t size)
+{
+  MemTag prev_tag = mem_set_tag(MEM_OUTPUT);
+  void *p = mem_malloc_aligned(size, YUV_ALIGNMENT);
+
+  mem_set_tag(prev_tag);
+  return (unsigned char *) p;
+}
+
+static void write_all(int fd, const unsigned char *data, size_t size)
+{
+  while (size > 0)
+  {
+    long ret = (long) write(fd, data, size);
+
+    if (ret < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      error ("write_all: error writing to YUV file", 500);
+    }
+    data += ret;
+    size -= (size_t) ret;
+  }
+}
+
+#ifdef O_DIRECT
+/*!
+ ************************************************************************
+ * \brief
+ *    returns the O_DIRECT state of a file, switching the file to
+ *    O_DIRECT on first use. Returns NULL if the file has to be written
+ *    without it.
+ ************************************************************************
+ */
+static DirectFile *get_direct_file(YuvWriter *w, int fd)
+{
+  DirectFile *unused = NULL;
+  int flags, i;
+
+  for (i = 0; i < MAX_DIRECT_FILES; ++i)
+  {
+    if (w->files[i].fd == fd)
+      return &w->files[i];
+    if (w->files[i].fd == -1 && unused == NULL)
+      unused = &w->files[i];
+  }
+
+  if (unused == NULL || lseek(fd, 0, SEEK_CUR) % YUV_ALIGNMENT != 0)
+    return NULL;
+  flags = fcntl(fd, F_GETFL);
+  if (flags == -1 || fcntl(fd, F_SETFL, flags | O_DIRECT) == -1)
+    return NULL;
+
+  if (unused->chunk == NULL)
+    unused->chunk = alloc_aligned(DIRECT_CHUNK);
+  unused->fd   = fd;
+  unused->fill = 0;
+  return unused;
+}
+
+static void write_direct(DirectFile *f, const unsigned char *data, size_t size)
+{
+  while (size > 0)
+  {
+    size_t n = DIRECT_CHUNK - f->fill;
+
+    if (n > size)
+      n = size;
+    memcpy(f->chunk + f->fill, data, n);
+    f->fill += n;
+    data += n;
+    size -= n;
+
+    if (f->fill == DIRECT_CHUNK)
+    {
+      write_all(f->fd, f->chunk, DIRECT_CHUNK);
+      f->fill = 0;
+    }
+  }
+}
+
+//! writes the rest of the chunk without O_DIRECT and releases the entry
+static void finish_direct_file(DirectFile *f)
+{
+  int flags = fcntl(f->fd, F_GETFL);
+
+  if (flags != -1)
+    fcntl(f->fd, F_SETFL, flags & ~O_DIRECT);
+  write_all(f->fd, f->chunk, f->fill);
+  f->fd   = -1;
+  f->fill = 0;
+}
+#endif
+
+static void write_buffer(YuvWriter *w, YuvBuffer *buf)
+{
+#ifdef O_DIRECT
+  DirectFile *f = w->direct ? get_direct_file(w, buf->fd) : NULL;
+
+  if (f != NULL)
+  {
+    write_direct(f, buf->data, buf->size);
+    return;
+  }
+#endif
+  write_all(buf->fd, buf->data, buf->size);
+}
+
+static void writer_main(void *param)
+{
+  YuvWriter *w = (YuvWriter *) param;
+
+  lock_mutex(&w->lock);
+  for (;;)
+  {
+    YuvBuffer *buf;
+
+    while (!w->shutdown && w->queued == 0)
+      wait_cond(&w->changed, &w->lock);
+    // the queue is written completely before shutting down
+    if (w->queued == 0)
+      break;
+
+    buf = &w->buffers[w->head];
+    unlock_mutex(&w->lock);
+    write_buffer(w, buf);
+    lock_mutex(&w->lock);
+
+    w->head = (w->head + 1) % w->num_buffers;
+    --w->queued;
+    broadcast_cond(&w->changed);
+  }
+  unlock_mutex(&w->lock);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    creates a writer with num_buffers buffers and its thread
+ *
+ * \return
+ *    the writer or NULL if no thread could be started
+ ************************************************************************
+ */
+YuvWriter *create_yuv_writer(int num_buffers, int direct)
+{
+  YuvWriter *w = (YuvWriter *) calloc(1, sizeof(YuvWriter));
+  int i;
+
+  if (w == NULL)
+    no_mem_exit("create_yuv_writer: w");
+  if ((w->buffers = (YuvBuffer *) calloc(num_buffers, sizeof(YuvBuffer))) == NULL)
+    no_mem_exit("create_yuv_writer: buffers");
+  w->num_buffers = num_buffers;
+  w->direct = direct;
+  for (i = 0; i < MAX_DIRECT_FILES; ++i)
+    w->files[i].fd = -1;
+
+  init_mutex(&w->lock);
+  init_cond(&w->changed);
+
+  if (create_thread(&w->thread, writer_main, w) != 0)
+  {
+    free_cond(&w->changed);
+    free_mutex(&w->lock);
+    free(w->buffers);
+    free(w);
+    return NULL;
+  }
+
+  return w;
+}
+
+static void wait_yuv_writer_idle(YuvWriter *w)
+{
+  lock_mutex(&w->lock);
+  while (w->queued > 0)
+    wait_cond(&w->changed, &w->lock);
+  unlock_mutex(&w->lock);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    writes everything queued and stops the writer
+ ************************************************************************
+ */
+void free_yuv_writer(YuvWriter *w)
+{
+  int i;
+
+  if (w == NULL)
+    return;
+
+  lock_mutex(&w->lock);
+  w->shutdown = 1;
+  broadcast_cond(&w->changed);
+  unlock_mutex(&w->lock);
+  join_thread(w->thread);
+
+  for (i = 0; i < MAX_DIRECT_FILES; ++i)
+  {
+#ifdef O_DIRECT
+    if (w->files[i].fd != -1)
+      finish_direct_file(&w->files[i]);
+#endif
+    mem_free(w->files[i].chunk);
+  }
+  for (i = 0; i < w->num_buffers; ++i)
+    mem_free(w->buffers[i].data);
+
+  free_cond(&w->changed);
+  free_mutex(&w->lock);
+  free(w->buffers);
+  free(w);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    returns a buffer of at least size bytes to be filled and queued
+ *    with queue_yuv_buffer(). Waits while all buffers are queued.
+ ************************************************************************
+ */
+unsigned char *get_yuv_buffer(YuvWriter *w, size_t size)
+{
+  YuvBuffer *buf;
+
+  lock_mutex(&w->lock);
+  while (w->queued == w->num_buffers)
+    wait_cond(&w->changed, &w->lock);
+  buf = &w->buffers[(w->head + w->queued) % w->num_buffers];
+  unlock_mutex(&w->lock);
+
+  if (buf->capacity < size)
+  {
+    mem_free(buf->data);
+    buf->data = alloc_aligned(size);
+    buf->capacity = size;
+  }
+  return buf->data;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    queues the first size bytes of the buffer returned by the last
+ *    get_yuv_buffer() for writing to fd
+ ************************************************************************
+ */
+void queue_yuv_buffer(YuvWriter *w, int fd, size_t size)
+{
+  YuvBuffer *buf;
+
+  lock_mutex(&w->lock);
+  buf = &w->buffers[(w->head + w->queued) % w->num_buffers];
+  buf->fd   = fd;
+  buf->size = size;
+  ++w->queued;
+  broadcast_cond(&w->changed);
+  unlock_mutex(&w->lock);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    waits until everything queued is written. Must be called before
+ *    fd is closed.
+ ************************************************************************
+ */
+void flush_yuv_file(YuvWriter *w, int fd)
+{
+#ifdef O_DIRECT
+  int i;
+#endif
+
+  if (w == NULL)
+    return;
+
+  wait_yuv_writer_idle(w);
+#ifdef O_DIRECT
+  // the writer thread is idle and does not touch the files
+  for (i = 0; i < MAX_DIRECT_FILES; ++i)
+  {
+    if (w->files[i].fd == fd)
+      finish_direct_file(&w->files[i]);
+  }
+#endif
+}
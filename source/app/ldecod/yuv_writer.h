@@ -0,0 +1,25 @@
+
+/*!
+ *************************************************************************************
+ * \file yuv_writer.h
+ *
+ * \brief
+ *    Writing of the output YUV files on a separate thread
+ *
+ *************************************************************************************
+ */
+
+#ifndef _YUV_WRITER_H_
+#define _YUV_WRITER_H_
+
+#include "global.h"
+
+typedef struct yuv_writer YuvWriter;
+
+extern YuvWriter     *create_yuv_writer(int num_buffers, int direct);
+extern void           free_yuv_writer  (YuvWriter *w);
+extern unsigned char *get_yuv_buffer   (YuvWriter *w, size_t size);
+extern void           queue_yuv_buffer (YuvWriter *w, int fd, size_t size);
+extern void           flush_yuv_file   (YuvWriter *w, int fd);
+
+#endif
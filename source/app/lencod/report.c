@@ -23,6 +23,7 @@
 #include "image.h"
 #include "intrarefresh.h"
 #include "leaky_bucket.h"
+#include "memalloc.h"
 #include "me_epzs.h"
 #include "me_epzs_int.h"
 #include "output.h"
@@ -997,6 +998,7 @@ void report( VideoParameters *p_Vid, InputParameters *p_Inp, StatParameters *p_S
     fprintf(stdout,"-------------------------------------------------------------------------------------------------------\n");
     break;
   }  
+  report_mem_usage(stdout);
   fprintf(stdout,"Exit JM %s encoder ver %s ", JM, VERSION);
   fprintf(stdout,"\n");
 
@@ -0,0 +1,223 @@
+
+/*!
+ *************************************************************************************
+ * \file tracedump.c
+ *
+ * \brief
+ *    Prints and filters the binary syntax element trace of ldecod (-trace bin)
+ *
+ *************************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define SE_TRACE_MAGIC      "JMSETRC1"
+#define SE_TRACE_PART_MASK  0x03
+#define SE_TRACE_CABAC      0x04
+#define SE_TRACE_BLOCK      0x08
+
+#define NUM_SE_TYPES        20
+#define READ_RECORDS        4096
+
+//! record layout of ldecod/se_trace.h
+typedef struct se_trace_record
+{
+  uint32_t pic;
+  uint32_t mb;
+  uint32_t pos;
+  uint32_t len;
+  int32_t  value1;
+  int32_t  value2;
+  int16_t  context;
+  uint16_t slice;
+  uint8_t  type;
+  uint8_t  flags;
+  uint16_t reserved;
+} SETraceRecord;
+
+//! names of SE_HEADER ... SE_EOS of ldecod/elements.h
+static const char *se_names[NUM_SE_TYPES] =
+{
+  "HEADER", "PTYPE", "MBTYPE", "REFFRAME", "INTRAPREDMODE", "MVD",
+  "CBP_INTRA", "LUM_DC_INTRA", "CHR_DC_INTRA", "LUM_AC_INTRA", "CHR_AC_INTRA",
+  "CBP_INTER", "LUM_DC_INTER", "CHR_DC_INTER", "LUM_AC_INTER", "CHR_AC_INTER",
+  "DELTA_QUANT_INTER", "DELTA_QUANT_INTRA", "BFRAME", "EOS"
+};
+
+typedef struct filter
+{
+  uint32_t pic_first, pic_last;
+  uint32_t mb_first, mb_last;
+  int      slice;                 //!< -1 for all slices
+  int      types[NUM_SE_TYPES];   //!< types printed, all if none is set
+  int      any_type;
+} Filter;
+
+static void print_usage(char *argv[])
+{
+  printf ("This tool prints the syntax elements of a binary trace written by ldecod -trace bin.\n");
+  printf ("Usage: %s [-pic first[:last]] [-mb first[:last]] [-slice n] [-type t[,t...]] [-summary] trace_file\n", argv[0]);
+  printf ("  -pic, -mb   only elements of these pictures (decoding order) or macroblock addresses\n");
+  printf ("  -slice      only elements of this slice of the pictures\n");
+  printf ("  -type       only elements of these types, given by number or name (MBTYPE, MVD, ...)\n");
+  printf ("  -summary    print the number of elements and bits per type instead of the elements\n");
+  exit (-1);
+}
+
+static void parse_range(char *arg, uint32_t *first, uint32_t *last)
+{
+  char *colon = strchr(arg, ':');
+
+  *first = (uint32_t) strtoul(arg, NULL, 10);
+  *last  = colon ? (uint32_t) strtoul(colon + 1, NULL, 10) : *first;
+}
+
+static void parse_types(char *arg, Filter *f, char *argv[])
+{
+  char *t;
+
+  for (t = strtok(arg, ","); t != NULL; t = strtok(NULL, ","))
+  {
+    int i;
+
+    for (i = 0; i < NUM_SE_TYPES && strcmp(t, se_names[i]) != 0; ++i)
+      ;
+    if (i == NUM_SE_TYPES)
+    {
+      char *end;
+
+      i = (int) strtol(t, &end, 10);
+      if (*end != '\0' || i < 0 || i >= NUM_SE_TYPES)
+      {
+        printf ("Unknown syntax element type %s\n", t);
+        print_usage(argv);
+      }
+    }
+    f->types[i] = 1;
+    f->any_type = 1;
+  }
+}
+
+static int passes(const Filter *f, const SETraceRecord *rec)
+{
+  return rec->pic >= f->pic_first && rec->pic <= f->pic_last
+    && rec->mb >= f->mb_first && rec->mb <= f->mb_last
+    && (f->slice < 0 || rec->slice == f->slice)
+    && (!f->any_type || (rec->type < NUM_SE_TYPES && f->types[rec->type]));
+}
+
+static void print_record(const SETraceRecord *rec)
+{
+  const char *name = rec->type < NUM_SE_TYPES ? se_names[rec->type] : "?";
+
+  printf ("%6u %5u %6u  %-17s %-5s %c %c %9u %5u %8d ",
+    rec->pic, rec->slice, rec->mb, name, (rec->flags & SE_TRACE_BLOCK) ? "block" : "",
+    'A' + (rec->flags & SE_TRACE_PART_MASK), (rec->flags & SE_TRACE_CABAC) ? 'c' : 'v',
+    rec->pos, rec->len, rec->value1);
+  if (rec->flags & SE_TRACE_BLOCK)
+    printf ("   %2d,%-2d %4d\n", rec->value2 & 0x0F, rec->value2 >> 4, rec->context);
+  else
+    printf ("%8d %4d\n", rec->value2, rec->context);
+}
+
+int main(int argc, char* argv[])
+{
+  static SETraceRecord records[READ_RECORDS];
+  uint64_t count[NUM_SE_TYPES + 1], bits[NUM_SE_TYPES + 1];
+  char magic[8];
+  uint32_t header[2];
+  Filter f;
+  int summary = 0;
+  size_t n;
+  int i;
+  FILE *fr;
+
+  memset(&f, 0, sizeof(f));
+  f.pic_last = f.mb_last = UINT32_MAX;
+  f.slice = -1;
+  memset(count, 0, sizeof(count));
+  memset(bits, 0, sizeof(bits));
+
+  for (i = 1; i < argc - 1; ++i)
+  {
+    if (0 == strcmp(argv[i], "-pic") && i + 2 < argc)
+      parse_range(argv[++i], &f.pic_first, &f.pic_last);
+    else if (0 == strcmp(argv[i], "-mb") && i + 2 < argc)
+      parse_range(argv[++i], &f.mb_first, &f.mb_last);
+    else if (0 == strcmp(argv[i], "-slice") && i + 2 < argc)
+      f.slice = atoi(argv[++i]);
+    else if (0 == strcmp(argv[i], "-type") && i + 2 < argc)
+      parse_types(argv[++i], &f, argv);
+    else if (0 == strcmp(argv[i], "-summary"))
+      summary = 1;
+    else
+      print_usage(argv);
+  }
+  if (i != argc - 1)
+    print_usage(argv);
+
+  if (NULL == (fr = fopen(argv[argc - 1], "rb")))
+  {
+    printf ("%s: cannot open trace file %s for reading\n", argv[0], argv[argc - 1]);
+    return -2;
+  }
+  if (1 != fread(magic, sizeof(magic), 1, fr) || 1 != fread(header, sizeof(header), 1, fr)
+    || 0 != memcmp(magic, SE_TRACE_MAGIC, sizeof(magic)))
+  {
+    printf ("%s is not a syntax element trace of ldecod\n", argv[argc - 1]);
+    return -3;
+  }
+  if (header[0] != sizeof(SETraceRecord))
+  {
+    printf ("Records of %u bytes are not supported, expected %u\n", header[0], (unsigned) sizeof(SETraceRecord));
+    return -3;
+  }
+
+  if (!summary)
+    printf ("   pic slice     mb  type                    P E       pos   len   value1   value2  ctx\n");
+
+  while ((n = fread(records, sizeof(SETraceRecord), READ_RECORDS, fr)) > 0)
+  {
+    size_t k;
+
+    for (k = 0; k < n; ++k)
+    {
+      const SETraceRecord *rec = &records[k];
+
+      if (!passes(&f, rec))
+        continue;
+      if (summary)
+      {
+        int t = rec->type < NUM_SE_TYPES ? rec->type : NUM_SE_TYPES;
+
+        ++count[t];
+        bits[t] += rec->len;
+      }
+      else
+        print_record(rec);
+    }
+  }
+  fclose(fr);
+
+  if (summary)
+  {
+    uint64_t total_count = 0, total_bits = 0;
+
+    printf ("type                  elements          bits\n");
+    for (i = 0; i <= NUM_SE_TYPES; ++i)
+    {
+      if (count[i] == 0)
+        continue;
+      printf ("%-17s %12llu %13llu\n", i < NUM_SE_TYPES ? se_names[i] : "?",
+        (unsigned long long) count[i], (unsigned long long) bits[i]);
+      total_count += count[i];
+      total_bits  += bits[i];
+    }
+    printf ("%-17s %12llu %13llu\n", "total", (unsigned long long) total_count, (unsigned long long) total_bits);
+  }
+
+  return 0;
+}
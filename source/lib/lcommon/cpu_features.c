@@ -0,0 +1,75 @@
+
+/*!
+ *************************************************************************************
+ * \file cpu_features.c
+ *
+ * \brief
+ *    Run-time detection of the SIMD instruction sets supported by CPU and OS
+ *
+ *************************************************************************************
+ */
+
+#include "cpu_features.h"
+
+#if HAVE_X86_SIMD
+#if defined(_MSC_VER)
+# include <intrin.h>
+#else
+# include <cpuid.h>
+#endif
+
+static void cpuid(int leaf, int subleaf, unsigned int regs[4])
+{
+#if defined(_MSC_VER)
+  __cpuidex((int *) regs, leaf, subleaf);
+#else
+  __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static unsigned long long xgetbv0(void)
+{
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  unsigned int eax, edx;
+  __asm__ volatile ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+  return ((unsigned long long) edx << 32) | eax;
+#endif
+}
+#endif
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Returns the highest SimdLevel usable on the running machine
+ ************************************************************************
+ */
+int get_cpu_simd_level(void)
+{
+  int level = SIMD_NONE;
+#if HAVE_X86_SIMD
+  unsigned int regs[4];
+
+  cpuid(0, 0, regs);
+  if (regs[0] >= 1)
+  {
+    unsigned int max_leaf = regs[0];
+
+    cpuid(1, 0, regs);
+    if (regs[2] & (1 << 19))                      // SSE4.1
+    {
+      level = SIMD_SSE41;
+
+      // AVX2 needs OS support for the YMM state (OSXSAVE and XCR0 bits 1, 2)
+      if (max_leaf >= 7 && (regs[2] & (1 << 27)) && (regs[2] & (1 << 28)) && ((xgetbv0() & 6) == 6))
+      {
+        cpuid(7, 0, regs);
+        if (regs[1] & (1 << 5))                   // AVX2
+          level = SIMD_AVX2;
+      }
+    }
+  }
+#endif
+  return level;
+}
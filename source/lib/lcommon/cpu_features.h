@@ -0,0 +1,44 @@
+
+/*!
+ ************************************************************************
+ * \file cpu_features.h
+ *
+ * \brief
+ *    Run-time detection of the SIMD instruction sets available to the
+ *    sample processing kernels
+ *
+ ************************************************************************
+ */
+
+#ifndef _CPU_FEATURES_H_
+#define _CPU_FEATURES_H_
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+# define HAVE_X86_SIMD 1   //!< SSE4.1/AVX2 kernels can be compiled on this target
+#else
+# define HAVE_X86_SIMD 0
+#endif
+
+#if defined(_MSC_VER)
+# define TARGET_AVX2                                 //!< no per-function target needed
+#else
+# define TARGET_AVX2 __attribute__((target("avx2")))  //!< compile this function for AVX2
+#endif
+
+#if defined(_MSC_VER)
+# define ALIGNED(n) __declspec(align(n))             //!< aligns a local or static array
+#else
+# define ALIGNED(n) __attribute__((aligned(n)))
+#endif
+
+typedef enum
+{
+  SIMD_NONE  = 0,  //!< plain C kernels
+  SIMD_SSE41 = 1,  //!< SSE4.1 kernels
+  SIMD_AVX2  = 2   //!< AVX2 kernels (SSE4.1 where no AVX2 version exists)
+} SimdLevel;
+
+extern int get_cpu_simd_level(void);
+
+#endif
+
@@ -12,6 +12,8 @@
 #ifndef _FRAME_H_
 #define _FRAME_H_
 
+#include "typedefs.h"
+
 typedef enum {
   CM_UNKNOWN = -1,
   CM_YUV     =  0,
@@ -63,4 +65,19 @@ typedef struct frame_format
   int         pic_unit_size_shift3;          //!< pic_unit_size_on_disk >> 3
 } FrameFormat;
 
+#define PLANE_ALIGNMENT 64                   //!< byte alignment of the first sample of every plane row
+
+//! Padded sample plane in a single allocation
+typedef struct pic_plane
+{
+  imgpel  *mem;                              //!< start of the allocation, for freeing
+  imgpel  *data;                             //!< sample (0, 0)
+  imgpel **rows;                             //!< row pointer view of data, rows[-pad_y .. height + pad_y - 1]
+  int      width;                            //!< width without padding
+  int      height;                           //!< height without padding
+  int      stride;                           //!< distance between rows in samples
+  int      pad_x;                            //!< samples of padding left and right
+  int      pad_y;                            //!< rows of padding above and below
+} PicPlane;
+
 #endif
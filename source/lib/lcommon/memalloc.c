@@ -18,6 +18,201 @@
 #include "global.h"
 #include "memalloc.h"
 
+#include "threading.h"
+
+#if defined(_MSC_VER)
+#define MEM_THREAD_LOCAL   __declspec(thread)
+#else
+#define MEM_THREAD_LOCAL   __thread
+#endif
+
+typedef struct mem_counter
+{
+  int64 current;                   //!< bytes allocated and not freed yet
+  int64 peak;                      //!< largest value of current
+} MemCounter;
+
+//! stored in the MEM_HEADER_SIZE bytes in front of every block of mem_malloc()
+typedef struct mem_header
+{
+  int64 size;                      //!< bytes requested
+  int   tag;                       //!< tag the block is counted for
+  int   offset;                    //!< bytes from the start of the heap block to the header
+} MemHeader;
+
+static MemCounter mem_counters[MEM_NUM_TAGS];
+static MemCounter mem_total;
+
+//! tag the allocations of the calling thread are counted for
+static MEM_THREAD_LOCAL MemTag mem_tag = MEM_OTHER;
+
+static const char *mem_tag_name[MEM_NUM_TAGS] = {
+  "other", "dpb_planes", "motion_fields", "slice_scratch", "cabac_contexts", "erc", "output_buffers"
+};
+
+static const char *mem_tag_label[MEM_NUM_TAGS] = {
+  "Other", "DPB planes", "Motion fields", "Slice scratch", "CABAC contexts", "ERC", "Output buffers"
+};
+
+static void add_mem_usage(MemCounter *c, int64 size)
+{
+  int64 current = atomic_add_int64(&c->current, size);
+  int64 peak    = atomic_load_int64(&c->peak);
+
+  while (current > peak && !atomic_cas_int64(&c->peak, &peak, current))
+    ;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    sets the tag the following allocations of the calling thread are
+ *    counted for. A block is removed from the counters of the tag it was
+ *    allocated with when it is freed, whatever tag is set then.
+ *
+ * \return
+ *    the previous tag, to be restored when the subsystem is done
+ ************************************************************************
+ */
+MemTag mem_set_tag(MemTag tag)
+{
+  MemTag prev = mem_tag;
+
+  mem_tag = tag;
+  return prev;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    counts a block of size bytes for the current tag
+ *
+ * \param block
+ *    heap block of at least size + alignment - 1 + MEM_HEADER_SIZE bytes
+ * \param size
+ *    bytes requested
+ * \param alignment
+ *    power of two the returned address is a multiple of, 0 for the
+ *    alignment of malloc()
+ *
+ * \return
+ *    the memory handed out, to be released with mem_free()
+ ************************************************************************
+ */
+void *mem_count_alloc(void *block, size_t size, size_t alignment)
+{
+  byte *p = (byte *) block + MEM_HEADER_SIZE;
+  MemHeader *h;
+
+  if (alignment > 1)
+    p = (byte *) (((uintptr_t) p + alignment - 1) & ~(uintptr_t) (alignment - 1));
+  h = (MemHeader *) p - 1;
+  h->size   = (int64) size;
+  h->tag    = mem_tag;
+  h->offset = (int) ((byte *) h - (byte *) block);
+
+  add_mem_usage(&mem_counters[h->tag], h->size);
+  add_mem_usage(&mem_total, h->size);
+  return p;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    removes the memory p of mem_count_alloc() from the counters of the
+ *    tag it was allocated with
+ *
+ * \return
+ *    the heap block to free
+ ************************************************************************
+ */
+void *mem_count_free(void *p)
+{
+  MemHeader *h = (MemHeader *) p - 1;
+
+  atomic_add_int64(&mem_counters[h->tag].current, -h->size);
+  atomic_add_int64(&mem_total.current, -h->size);
+  return (byte *) h - h->offset;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    allocates size bytes at an address that is a multiple of alignment,
+ *    a power of two. Released with mem_free().
+ ************************************************************************
+ */
+void *mem_malloc_aligned(size_t size, size_t alignment)
+{
+  void *d;
+
+  if ((d = malloc(size + alignment - 1 + MEM_HEADER_SIZE)) == NULL)
+  {
+    no_mem_exit("mem_malloc_aligned: malloc failed.\n");
+    return NULL;
+  }
+  return mem_count_alloc(d, size, alignment);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    returns the bytes currently allocated for a tag and their peak.
+ *    MEM_NUM_TAGS returns the totals.
+ ************************************************************************
+ */
+void get_mem_usage(MemTag tag, int64 *current, int64 *peak)
+{
+  MemCounter *c = (tag == MEM_NUM_TAGS) ? &mem_total : &mem_counters[tag];
+
+  *current = atomic_load_int64(&c->current);
+  *peak    = atomic_load_int64(&c->peak);
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    prints the current and peak memory of every tag that was used
+ ************************************************************************
+ */
+void report_mem_usage(FILE *f)
+{
+  int64 current, peak;
+  int tag;
+
+  fprintf(f, "-------------------- Memory usage (current / peak) -----------------------\n");
+  for (tag = 0; tag <= MEM_NUM_TAGS; ++tag)
+  {
+    get_mem_usage((MemTag) tag, &current, &peak);
+    if (peak == 0 && tag != MEM_NUM_TAGS)
+      continue;
+    fprintf(f, " %-20s: %10.3f MB / %10.3f MB\n", (tag == MEM_NUM_TAGS) ? "Total" : mem_tag_label[tag],
+      current / 1048576.0, peak / 1048576.0);
+  }
+  fprintf(f, "--------------------------------------------------------------------------\n");
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    writes the current and peak bytes of every tag as a JSON object
+ ************************************************************************
+ */
+void write_mem_usage_json(FILE *f)
+{
+  int64 current, peak;
+  int tag;
+
+  fprintf(f, "{\n  \"memory\": {\n");
+  for (tag = 0; tag <= MEM_NUM_TAGS; ++tag)
+  {
+    get_mem_usage((MemTag) tag, &current, &peak);
+    fprintf(f, "    \"%s\": { \"current\": %lld, \"peak\": %lld }%s\n", (tag == MEM_NUM_TAGS) ? "total" : mem_tag_name[tag],
+      (long long) current, (long long) peak, (tag == MEM_NUM_TAGS) ? "" : ",");
+  }
+  fprintf(f, "  }\n}\n");
+}
+
 /*!
  ************************************************************************
  * \brief
@@ -903,6 +1098,107 @@ int get_mem2Dpel_pad(imgpel ***array2D, int dim0, int dim1, int iPadY, int iPadX
   return iHeight * (sizeof(imgpel*) + iWidth * sizeof(imgpel));
 }
 
+//! samples left of x = 0 in a PicPlane row: the padding rounded up so that x = 0 is aligned
+static inline int pic_plane_margin(int iPadX)
+{
+  int align = PLANE_ALIGNMENT / (int) sizeof(imgpel);
+  return (iPadX + align - 1) / align * align;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Allocate a padded sample plane -> plane->data[y * plane->stride + x]
+ *    with -iPadY <= y < height + iPadY and -iPadX <= x < width + iPadX
+ *
+ *    All rows live in one zeroed allocation. The stride is a multiple of
+ *    PLANE_ALIGNMENT bytes and sample (0, y) of every row is aligned to
+ *    it. plane->rows gives the same samples as the row pointer arrays of
+ *    get_mem2Dpel_pad().
+ *
+ * \par Output:
+ *    memory size in bytes
+ ************************************************************************
+ */
+int get_pic_plane(PicPlane *plane, int height, int width, int iPadY, int iPadX)
+{
+  int align   = PLANE_ALIGNMENT / (int) sizeof(imgpel);
+  int margin  = pic_plane_margin(iPadX);
+  int stride  = (margin + width + iPadX + align - 1) / align * align;
+  int iHeight = height + 2 * iPadY;
+  size_t size = (size_t) iHeight * stride * sizeof(imgpel);
+  imgpel *base;
+  int i;
+
+  if ((plane->mem = (imgpel *) mem_calloc(size + PLANE_ALIGNMENT, 1)) == NULL)
+    no_mem_exit("get_pic_plane: plane->mem");
+  base = (imgpel *) (((intptr_t) plane->mem + PLANE_ALIGNMENT - 1) & ~(intptr_t) (PLANE_ALIGNMENT - 1));
+
+  if ((plane->rows = (imgpel **) mem_malloc(iHeight * sizeof(imgpel *))) == NULL)
+    no_mem_exit("get_pic_plane: plane->rows");
+  for (i = 0; i < iHeight; i++)
+    plane->rows[i] = base + i * stride + margin;
+  plane->rows += iPadY;
+
+  plane->data   = plane->rows[0];
+  plane->width  = width;
+  plane->height = height;
+  plane->stride = stride;
+  plane->pad_x  = iPadX;
+  plane->pad_y  = iPadY;
+
+  return (int) (size + PLANE_ALIGNMENT + iHeight * sizeof(imgpel *));
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Allocate only the row pointer array of a plane that is a view of the
+ *    samples of another plane, see set_pic_plane_field(). plane->mem stays
+ *    NULL as the samples are not owned.
+ *
+ * \par Output:
+ *    memory size in bytes
+ ************************************************************************
+ */
+int get_pic_plane_rows(PicPlane *plane, int height, int iPadY)
+{
+  int iHeight = height + 2 * iPadY;
+
+  memset(plane, 0, sizeof(PicPlane));
+  if ((plane->rows = (imgpel **) mem_calloc(iHeight, sizeof(imgpel *))) == NULL)
+    no_mem_exit("get_pic_plane_rows: plane->rows");
+  plane->rows  += iPadY;
+  plane->height = height;
+  plane->pad_y  = iPadY;
+
+  return (int) (iHeight * sizeof(imgpel *));
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    Point a plane allocated with get_pic_plane_rows() at the even
+ *    (bottom == 0) or odd (bottom == 1) rows of the frame plane, so the
+ *    field samples are read and written in place. The view has twice the
+ *    stride of the frame and half its height and vertical padding.
+ ************************************************************************
+ */
+void set_pic_plane_field(PicPlane *field, const PicPlane *frame, int bottom)
+{
+  int i;
+
+  assert(2 * field->height == frame->height && 2 * field->pad_y <= frame->pad_y);
+
+  for (i = -field->pad_y; i < field->height + field->pad_y; i++)
+    field->rows[i] = frame->rows[2 * i + bottom];
+
+  field->data   = field->rows[0];
+  field->width  = frame->width;
+  field->stride = 2 * frame->stride;
+  field->pad_x  = frame->pad_x;
+}
+
 
 /*!
  ************************************************************************
@@ -917,7 +1213,7 @@ int get_mem3Dpel(imgpel ****array3D, int dim0, int dim1, int dim2)
 {
   int i, mem_size = dim0 * sizeof(imgpel**);
 
-  if(((*array3D) = (imgpel***)malloc(dim0 * sizeof(imgpel**))) == NULL)
+  if(((*array3D) = (imgpel***)mem_malloc(dim0 * sizeof(imgpel**))) == NULL)
     no_mem_exit("get_mem3Dpel: array3D");
 
   mem_size += get_mem2Dpel(*array3D, dim0 * dim1, dim2);
@@ -1083,6 +1379,35 @@ void free_mem2Dpel_pad(imgpel **array2D, int iPadY, int iPadX)
   }
 }
 
+/*!
+ ************************************************************************
+ * \brief
+ *    free a sample plane allocated with get_pic_plane() or the row
+ *    pointers of a view allocated with get_pic_plane_rows()
+ ************************************************************************
+ */
+void free_pic_plane(PicPlane *plane)
+{
+  if (plane->rows)
+    mem_free(&plane->rows[-plane->pad_y]);
+  if (plane->mem)
+    mem_free(plane->mem);
+  memset(plane, 0, sizeof(PicPlane));
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    zero all samples of a plane including its padding
+ ************************************************************************
+ */
+void clear_pic_plane(PicPlane *plane)
+{
+  imgpel *base = plane->rows[-plane->pad_y] - pic_plane_margin(plane->pad_x);
+
+  memset(base, 0, (size_t) (plane->height + 2 * plane->pad_y) * plane->stride * sizeof(imgpel));
+}
+
 /*!
  ************************************************************************
  * \brief
@@ -2713,7 +3038,7 @@ void free_mem2Ddistblk(distblk **array2D)
       mem_free (*array2D);
     else 
       error ("free_mem2Ddistblk: trying to free unused memory",100);
-    free (array2D);
+    mem_free (array2D);
   } 
   else
   {
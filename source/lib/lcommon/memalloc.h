@@ -76,6 +76,9 @@ extern int  get_mem7Dshort(short ********array7D, int dim0, int dim1, int dim2,
 extern int  get_mem1Dpel(imgpel **array2D, int dim0);
 extern int  get_mem2Dpel(imgpel ***array2D, int dim0, int dim1);
 extern int  get_mem2Dpel_pad(imgpel ***array2D, int dim0, int dim1, int iPadY, int iPadX);
+extern int  get_pic_plane   (PicPlane *plane, int height, int width, int iPadY, int iPadX);
+extern int  get_pic_plane_rows(PicPlane *plane, int height, int iPadY);
+extern void set_pic_plane_field(PicPlane *field, const PicPlane *frame, int bottom);
 
 extern int  get_mem3Dpel    (imgpel ****array3D, int dim0, int dim1, int dim2);
 extern int  get_mem3Dpel_pad(imgpel ****array3D, int dim0, int dim1, int dim2, int iPadY, int iPadX);
@@ -155,6 +158,8 @@ extern void free_mem7Dshort(short *******array7D);
 extern void free_mem1Dpel    (imgpel     *array1D);
 extern void free_mem2Dpel    (imgpel    **array2D);
 extern void free_mem2Dpel_pad(imgpel **array2D, int iPadY, int iPadX);
+extern void free_pic_plane   (PicPlane *plane);
+extern void clear_pic_plane  (PicPlane *plane);
 extern void free_mem3Dpel    (imgpel   ***array3D);
 extern void free_mem3Dpel_pad(imgpel ***array3D, int iDim12, int iPadY, int iPadX);
 extern void free_mem4Dpel    (imgpel  ****array4D);
@@ -184,15 +189,38 @@ extern void free_mem2Dpel_2SLayers(imgpel ***buf0, imgpel ***buf1);
 extern void free_mem3Dpel_2SLayers(imgpel ****buf0, imgpel ****buf1);
 
 
+//! subsystems the memory allocated through mem_malloc() is counted for
+typedef enum {
+  MEM_OTHER  = 0,     //!< everything allocated outside a tagged subsystem
+  MEM_DPB,            //!< sample planes of the stored pictures
+  MEM_MOTION,         //!< motion fields of the stored pictures
+  MEM_SLICE,          //!< slice structures and their scratch buffers
+  MEM_CABAC,          //!< CABAC context models
+  MEM_ERC,            //!< error concealment
+  MEM_OUTPUT,         //!< output and writer buffers
+  MEM_NUM_TAGS
+} MemTag;
+
+extern MemTag mem_set_tag     (MemTag tag);
+extern void  *mem_count_alloc (void *block, size_t size, size_t alignment);
+extern void  *mem_count_free  (void *p);
+extern void  *mem_malloc_aligned(size_t size, size_t alignment);
+extern void   get_mem_usage   (MemTag tag, int64 *current, int64 *peak);
+extern void   report_mem_usage(FILE *f);
+extern void   write_mem_usage_json(FILE *f);
+
+//! bytes mem_malloc() allocates in front of every block for the counters
+#define MEM_HEADER_SIZE  16
+
 static inline void* mem_malloc(size_t nitems)
 {
   void *d;
-  if((d = malloc(nitems)) == NULL)
+  if((d = malloc(nitems + MEM_HEADER_SIZE)) == NULL)
   {
     no_mem_exit("malloc failed.\n");
     return NULL;
   }
-  return d;
+  return mem_count_alloc(d, nitems, 0);
 }
 
 /*!
@@ -211,7 +239,8 @@ static inline void* mem_calloc(size_t nitems, size_t size)
 
 static inline void mem_free(void *a)
 {
-  free_pointer(a);
+  if (a != NULL)
+    free(mem_count_free(a));
 }
 
 #endif
@@ -0,0 +1,197 @@
+
+/*!
+ *************************************************************************************
+ * \file threading.c
+ *
+ * \brief
+ *    Threads, locks and condition variables on top of POSIX threads or
+ *    the Win32 API
+ *
+ *************************************************************************************
+ */
+
+#include "global.h"
+#include "threading.h"
+
+typedef struct thread_start
+{
+  ThreadFunc func;
+  void      *arg;
+} ThreadStart;
+
+#ifdef _WIN32
+#include <process.h>
+
+static unsigned __stdcall thread_main(void *param)
+{
+  ThreadStart start = *(ThreadStart *) param;
+
+  free(param);
+  start.func(start.arg);
+  return 0;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    starts func(arg) on a new thread
+ *
+ * \return
+ *    0 on success
+ ************************************************************************
+ */
+int create_thread(Thread *thread, ThreadFunc func, void *arg)
+{
+  ThreadStart *start = (ThreadStart *) malloc(sizeof(ThreadStart));
+
+  if (start == NULL)
+    return -1;
+  start->func = func;
+  start->arg  = arg;
+  *thread = (HANDLE) _beginthreadex(NULL, 0, thread_main, start, 0, NULL);
+  if (*thread == NULL)
+  {
+    free(start);
+    return -1;
+  }
+  return 0;
+}
+
+void join_thread(Thread thread)
+{
+  WaitForSingleObject(thread, INFINITE);
+  CloseHandle(thread);
+}
+
+void init_mutex(Mutex *mutex)
+{
+  InitializeCriticalSection(mutex);
+}
+
+void free_mutex(Mutex *mutex)
+{
+  DeleteCriticalSection(mutex);
+}
+
+void lock_mutex(Mutex *mutex)
+{
+  EnterCriticalSection(mutex);
+}
+
+void unlock_mutex(Mutex *mutex)
+{
+  LeaveCriticalSection(mutex);
+}
+
+void init_cond(CondVar *cond)
+{
+  InitializeConditionVariable(cond);
+}
+
+void free_cond(CondVar *cond)
+{
+  (void) cond;
+}
+
+void wait_cond(CondVar *cond, Mutex *mutex)
+{
+  SleepConditionVariableCS(cond, mutex, INFINITE);
+}
+
+void signal_cond(CondVar *cond)
+{
+  WakeConditionVariable(cond);
+}
+
+void broadcast_cond(CondVar *cond)
+{
+  WakeAllConditionVariable(cond);
+}
+
+#else
+
+static void *thread_main(void *param)
+{
+  ThreadStart start = *(ThreadStart *) param;
+
+  free(param);
+  start.func(start.arg);
+  return NULL;
+}
+
+/*!
+ ************************************************************************
+ * \brief
+ *    starts func(arg) on a new thread
+ *
+ * \return
+ *    0 on success
+ ************************************************************************
+ */
+int create_thread(Thread *thread, ThreadFunc func, void *arg)
+{
+  ThreadStart *start = (ThreadStart *) malloc(sizeof(ThreadStart));
+
+  if (start == NULL)
+    return -1;
+  start->func = func;
+  start->arg  = arg;
+  if (pthread_create(thread, NULL, thread_main, start) != 0)
+  {
+    free(start);
+    return -1;
+  }
+  return 0;
+}
+
+void join_thread(Thread thread)
+{
+  pthread_join(thread, NULL);
+}
+
+void init_mutex(Mutex *mutex)
+{
+  pthread_mutex_init(mutex, NULL);
+}
+
+void free_mutex(Mutex *mutex)
+{
+  pthread_mutex_destroy(mutex);
+}
+
+void lock_mutex(Mutex *mutex)
+{
+  pthread_mutex_lock(mutex);
+}
+
+void unlock_mutex(Mutex *mutex)
+{
+  pthread_mutex_unlock(mutex);
+}
+
+void init_cond(CondVar *cond)
+{
+  pthread_cond_init(cond, NULL);
+}
+
+void free_cond(CondVar *cond)
+{
+  pthread_cond_destroy(cond);
+}
+
+void wait_cond(CondVar *cond, Mutex *mutex)
+{
+  pthread_cond_wait(cond, mutex);
+}
+
+void signal_cond(CondVar *cond)
+{
+  pthread_cond_signal(cond);
+}
+
+void broadcast_cond(CondVar *cond)
+{
+  pthread_cond_broadcast(cond);
+}
+
+#endif
@@ -0,0 +1,113 @@
+
+/*!
+ ************************************************************************
+ *  \file
+ *     threading.h
+ *
+ *  \brief
+ *     Threads, locks, condition variables and atomic integers on top of
+ *     POSIX threads or the Win32 API
+ *
+ *     The atomic int loads acquire and the stores release, the 64 bit
+ *     counters are relaxed. atomic_add_int64() returns the new value,
+ *     atomic_cas_int64() stores desired if *p equals *expected and loads
+ *     *p into *expected otherwise.
+ *
+ ************************************************************************
+ */
+#ifndef _THREADING_H_
+#define _THREADING_H_
+
+#include "win32.h"
+
+#ifdef _WIN32
+# include <windows.h>
+
+typedef CRITICAL_SECTION   Mutex;
+typedef CONDITION_VARIABLE CondVar;
+typedef HANDLE             Thread;
+#else
+# include <pthread.h>
+
+typedef pthread_mutex_t    Mutex;
+typedef pthread_cond_t     CondVar;
+typedef pthread_t          Thread;
+#endif
+
+//! Thread entry function
+typedef void (*ThreadFunc)(void *arg);
+
+extern int  create_thread   (Thread *thread, ThreadFunc func, void *arg);
+extern void join_thread     (Thread thread);
+
+extern void init_mutex      (Mutex *mutex);
+extern void free_mutex      (Mutex *mutex);
+extern void lock_mutex      (Mutex *mutex);
+extern void unlock_mutex    (Mutex *mutex);
+
+extern void init_cond       (CondVar *cond);
+extern void free_cond       (CondVar *cond);
+extern void wait_cond       (CondVar *cond, Mutex *mutex);
+extern void signal_cond     (CondVar *cond);
+extern void broadcast_cond  (CondVar *cond);
+
+#if defined(_MSC_VER)
+# include <intrin.h>
+
+static inline int atomic_load_int(volatile int *p)
+{
+  return (int) _InterlockedCompareExchange((volatile long *) p, 0, 0);
+}
+
+static inline void atomic_store_int(volatile int *p, int value)
+{
+  _InterlockedExchange((volatile long *) p, (long) value);
+}
+
+static inline int64 atomic_load_int64(volatile int64 *p)
+{
+  return _InterlockedCompareExchange64(p, 0, 0);
+}
+
+static inline int64 atomic_add_int64(volatile int64 *p, int64 value)
+{
+  return _InterlockedExchangeAdd64(p, value) + value;
+}
+
+static inline int atomic_cas_int64(volatile int64 *p, int64 *expected, int64 desired)
+{
+  int64 prev = _InterlockedCompareExchange64(p, desired, *expected);
+
+  if (prev == *expected)
+    return 1;
+  *expected = prev;
+  return 0;
+}
+#else
+static inline int atomic_load_int(volatile int *p)
+{
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void atomic_store_int(volatile int *p, int value)
+{
+  __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+static inline int64 atomic_load_int64(volatile int64 *p)
+{
+  return __atomic_load_n(p, __ATOMIC_RELAXED);
+}
+
+static inline int64 atomic_add_int64(volatile int64 *p, int64 value)
+{
+  return __atomic_add_fetch(p, value, __ATOMIC_RELAXED);
+}
+
+static inline int atomic_cas_int64(volatile int64 *p, int64 *expected, int64 desired)
+{
+  return __atomic_compare_exchange_n(p, expected, desired, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+#endif
+
+#endif